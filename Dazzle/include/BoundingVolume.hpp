@@ -0,0 +1,30 @@
+#ifndef _BOUNDING_VOLUME_HPP_
+#define _BOUNDING_VOLUME_HPP_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Dazzle
+{
+    // Axis aligned box and bounding sphere of a geometry, in object space.
+    struct BoundingVolume
+    {
+        glm::vec3 mMin = glm::vec3(0.0f);
+        glm::vec3 mMax = glm::vec3(0.0f);
+        glm::vec3 mCenter = glm::vec3(0.0f);
+        float mRadius = -1.0f;              // Negative while the volume is empty
+
+        bool IsValid() const { return mRadius >= 0.0f; }
+
+        // Bounds of tightly packed xyz positions.
+        static BoundingVolume Compute(const std::vector<float>& positions);
+        // Conservative bounds of the volume after applying transform.
+        BoundingVolume Transform(const glm::mat4& transform) const;
+        // Pixels covered by an object space unit at the point of the sphere closest to the camera, through a perspective
+        // projection onto a viewport viewportHeight pixels high. Infinite when the camera is inside the sphere.
+        float GetProjectedScale(const glm::mat4& modelView, const glm::mat4& projection, float viewportHeight) const;
+    };
+}
+
+#endif // _BOUNDING_VOLUME_HPP_
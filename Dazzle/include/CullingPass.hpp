@@ -0,0 +1,81 @@
+#ifndef _CULLING_PASS_HPP_
+#define _CULLING_PASS_HPP_
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include "DazzleEngine.hpp"
+#include "DepthPyramid.hpp"
+#include "RenderQueue.hpp"
+#include "RenderSystem.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // GPU culling of the objects of a RenderQueue.
+            // A compute shader tests the bounds of every object against the view frustum and, optionally, against
+            // the depth pyramid of the previous frame, then appends the draw commands of the survivors to its own
+            // indirect buffer. Submit() draws them with glMultiDrawElementsIndirectCount, so the CPU never learns
+            // which objects are visible. The counters are read back a few frames late to avoid stalling.
+            class CullingPass
+            {
+            public:
+                static const GLuint kCommandsBinding = 5;           // SSBO binding of the queue's draw commands
+                // Below the 8 bindings GL guarantees. 0 and 2 are left to the examples and 7 holds the luminance of
+                // LuminanceReduction, 6 is only shared with its partial sums, which are rebound on every Compute().
+                static const GLuint kVisibleCommandsBinding = 1;    // SSBO binding of the surviving draw commands
+                static const GLuint kVisibleCountBinding = 6;       // SSBO binding of the number of survivors
+                static const unsigned int kReadbackLatency = 3;     // Frames between a culling and its counters
+
+                CullingPass();
+                CullingPass(const CullingPass& other) = delete;
+                ~CullingPass();
+
+                CullingPass& operator=(const CullingPass& other) = delete;
+
+                // Builds the compute program and the buffers.
+                void Initialize();
+                // Culls every object of queue, call it after queue.Upload(). When pyramid holds the depth of the
+                // previous frame, objects hidden behind it are culled too, using the view-projection of the last call.
+                void Cull(const RenderQueue& queue, const glm::mat4& viewProjection, const DepthPyramid* pyramid = nullptr);
+                // Draws the objects of queue that survived the last Cull().
+                void Submit(const RenderQueue& queue) const;
+
+                void SetFrustumCulling(bool enabled) { mFrustumCulling = enabled; }
+                void SetOcclusionCulling(bool enabled) { mOcclusionCulling = enabled; }
+
+                // Objects tested and objects drawn, kReadbackLatency frames behind
+                GLuint GetSubmittedCount() const { return mSubmittedCount; }
+                GLuint GetVisibleCount() const { return mVisibleCount; }
+                bool IsValid() const;
+
+            private:
+                ProgramObject mProgram;
+                GLint mViewProjectionLocation;
+                GLint mPreviousViewProjectionLocation;
+                GLint mObjectCountLocation;
+                GLint mFrustumCullingLocation;
+                GLint mOcclusionCullingLocation;
+
+                GLuint mVisibleCommandBuffer;   // GL_DRAW_INDIRECT_BUFFER
+                GLsizeiptr mCapacity;           // Size of mVisibleCommandBuffer, in bytes
+                GLuint mCountBuffer;            // GL_PARAMETER_BUFFER
+                GLuint mReadbackBuffers[kReadbackLatency];
+                GLuint mReadbackSubmitted[kReadbackLatency];
+                unsigned int mFrameIndex;
+
+                GLuint mSubmittedCount;
+                GLuint mVisibleCount;
+                glm::mat4 mPreviousViewProjection;
+                bool mHasPrevious;
+                bool mFrustumCulling;
+                bool mOcclusionCulling;
+            };
+        }
+    }
+}
+
+#endif // _CULLING_PASS_HPP_
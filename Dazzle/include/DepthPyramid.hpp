@@ -0,0 +1,59 @@
+#ifndef _DEPTH_PYRAMID_HPP_
+#define _DEPTH_PYRAMID_HPP_
+
+#include <GL/gl3w.h>
+
+#include "DazzleEngine.hpp"
+#include "RenderSystem.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // Hierarchical depth buffer (Hi-Z) used for occlusion culling.
+            // Level 0 is a copy of a depth texture, every other level stores the farthest depth of the texels it
+            // covers in the level below, so a single fetch tells whether anything behind a depth could be visible.
+            class DepthPyramid
+            {
+            public:
+                static const GLuint kDepthTextureUnit = 8;  // Texture unit used to read the source depth texture
+                static const GLuint kSourceImageUnit = 6;   // Image units used internally to reduce the levels
+                static const GLuint kTargetImageUnit = 7;
+
+                DepthPyramid();
+                DepthPyramid(const DepthPyramid& other) = delete;
+                ~DepthPyramid();
+
+                DepthPyramid& operator=(const DepthPyramid& other) = delete;
+
+                // Allocates the pyramid for a depth buffer of the given size and builds the compute programs.
+                void Initialize(GLsizei width, GLsizei height);
+                // Rebuilds every level from depthTexture, which must have the size given to Initialize().
+                void Build(GLuint depthTexture);
+
+                GLuint GetTexture() const { return mTexture; }
+                GLsizei GetWidth() const { return mWidth; }
+                GLsizei GetHeight() const { return mHeight; }
+                GLint GetLevelCount() const { return mLevelCount; }
+                // False until Build() has been called at least once
+                bool IsBuilt() const { return mBuilt; }
+                bool IsValid() const;
+
+            private:
+                GLsizei mWidth;
+                GLsizei mHeight;
+                GLint mLevelCount;
+                bool mBuilt;
+
+                GLuint mTexture;                // GL_R32F, one level per halving of the size
+
+                ProgramObject mCopyProgram;
+                ProgramObject mReduceProgram;
+            };
+        }
+    }
+}
+
+#endif // _DEPTH_PYRAMID_HPP_
@@ -15,6 +15,33 @@ namespace Dazzle
         static void WriteFile(const std::string& path, const std::string& data);
         static void WriteBinary(const std::string& path, const char* data, const size_t length);
     };
+
+    // Read-only mapping of a whole file, pages are brought in by the OS on first access instead of being copied
+    // into heap memory up front.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        MappedFile(const MappedFile& other) = delete;
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile& other) = delete;
+
+        bool Open(const std::string& path);
+        void Close();
+
+        const char* GetData() const { return mData; }
+        size_t GetSize() const { return mSize; }
+        bool IsOpen() const { return mData != nullptr; }
+
+    private:
+        const char* mData;
+        size_t mSize;
+#ifdef _WIN32
+        void* mFile;        // HANDLE of the file
+        void* mMapping;     // HANDLE of the file mapping object
+#endif
+    };
 }
 
 #endif // _FILE_MANAGER_HPP_
\ No newline at end of file
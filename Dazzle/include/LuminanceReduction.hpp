@@ -0,0 +1,81 @@
+#ifndef _LUMINANCE_REDUCTION_HPP_
+#define _LUMINANCE_REDUCTION_HPP_
+
+#include <cstddef>
+
+#include <GL/gl3w.h>
+
+#include "DazzleEngine.hpp"
+#include "RenderSystem.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // Computes the logarithmic average luminance of an HDR texture on the GPU.
+            // A compute shader reduces every 16x16 tile of the texture into a partial sum of log(luminance),
+            // a second single-group dispatch reduces the partial sums and stores the result in a shader storage
+            // buffer, which stays bound at kResultBinding so tone-mapping shaders can read it directly:
+            //
+            //     layout(std430, binding = 7) readonly buffer LuminanceBuffer
+            //     {
+            //         float AverageLuminance;     // Log-average luminance of the last reduced frame
+            //         float AdaptedLuminance;     // Luminance after temporal eye adaptation
+            //     };
+            //
+            // No data is read back to the CPU.
+            class LuminanceReduction
+            {
+            public:
+                static const GLuint kPartialsBinding = 6;   // SSBO binding used internally for partial sums
+                static const GLuint kResultBinding = 7;     // SSBO binding where the result is left bound
+                static const GLuint kTextureUnit = 7;       // Texture unit used to sample the HDR input
+
+                LuminanceReduction();
+                LuminanceReduction(const LuminanceReduction& other) = delete;
+                ~LuminanceReduction();
+
+                LuminanceReduction& operator=(const LuminanceReduction& other) = delete;
+
+                // Allocates the reduction buffers for a texture of the given size and builds the compute programs.
+                void Initialize(GLsizei width, GLsizei height);
+                // Reduces the level 0 of hdrTexture. deltaTime (in seconds) drives the eye adaptation.
+                void Compute(GLuint hdrTexture, float deltaTime = 0.0f);
+                // Overwrites the result buffer with a value computed elsewhere (e.g. by the CPU reference).
+                void SetAverageLuminance(float luminance);
+                // Rate of the exponential eye adaptation, in 1/seconds. A rate of 0 disables adaptation.
+                void SetAdaptationRate(float rate) { mAdaptationRate = rate; }
+
+                // Reads the result back from the GPU. This stalls the pipeline and is intended for debugging only.
+                float ReadAverageLuminance() const;
+                GLuint GetResultBuffer() const { return mResultBuffer; }
+                bool IsValid() const;
+
+                // CPU reference implementation: log-average luminance of a tightly packed RGB float image.
+                static float CalculateReference(const float* rgb, size_t pixelCount);
+                // CPU reference implementation: reads the whole texture back and reduces it on the CPU.
+                static float CalculateReference(GLuint hdrTexture, GLsizei width, GLsizei height);
+
+            private:
+                GLsizei mWidth;
+                GLsizei mHeight;
+                GLuint mGroupsX;
+                GLuint mGroupsY;
+                float mAdaptationRate;
+
+                GLuint mPartialsBuffer;
+                GLuint mResultBuffer;
+
+                ProgramObject mTileProgram;
+                ProgramObject mFinalProgram;
+                GLint mPartialCountLocation;
+                GLint mPixelCountLocation;
+                GLint mAdaptationLocation;
+            };
+        }
+    }
+}
+
+#endif // _LUMINANCE_REDUCTION_HPP_
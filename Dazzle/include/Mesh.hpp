@@ -4,14 +4,10 @@
 #include <memory>
 #include <vector>
 
+#include "MeshFile.hpp"
+#include "MeshOptimizer.hpp"
 #include "Object3D.hpp"
-
-namespace RenderSystem::GL
-{
-    class VAO;
-    class VBO;
-    class EBO;
-}
+#include "VertexLayout.hpp"
 
 namespace Dazzle
 {
@@ -23,31 +19,58 @@ namespace Dazzle
         ~Mesh() override {}
 
         void Draw() const override;
-        std::vector<float> GetVertices() const override { return mVertices; }
-        std::vector<float> GetNormals() const override { return mNormals; }
-        std::vector<float> GetTangents() const override { return mTangents; }
-        std::vector<float> GetBitangents() const override { return mBitangents; }
-        std::vector<float> GetTextureCoordinates() const override { return mTextureCoordinates; }
-        std::vector<unsigned int> GetIndices() const override { return std::vector<unsigned int>(); }
+        const std::vector<float>& GetVertices() const override { return mVertices; }
+        const std::vector<float>& GetNormals() const override { return mNormals; }
+        const std::vector<float>& GetTangents() const override { return mTangents; }
+        const std::vector<float>& GetBitangents() const override { return mBitangents; }
+        const std::vector<float>& GetTextureCoordinates() const override { return mTextureCoordinates; }
+        const std::vector<unsigned int>& GetIndices() const override { return mIndices; }
+        unsigned int GetDrawCount() const override { return mDrawCount; }
         glm::mat4 GetTransform() const override { return mTransform; }
+        const BoundingVolume& GetBounds() const override { return mBounds; }
 
         void SetName(const std::string& name) { mName = name; }
         void SetVertices(std::vector<float>&& vertices) { mVertices = std::move(vertices); }
         void SetNormals(std::vector<float>&& normals) { mNormals = std::move(normals); }
         void SetTextureCoordinates(std::vector<float>&& textureCoordinates) { mTextureCoordinates = std::move(textureCoordinates); }
         void SetTangents(std::vector<float>&& tangents) { mTangents = std::move(tangents); }
+        void SetIndices(std::vector<unsigned int>&& indices) { mIndices = std::move(indices); }
 
         void SetPosition(glm::vec3 position);
         void Translate(glm::vec3 position);
         void Rotate(glm::vec3 axis, float degrees);
 
-        void InitializeBuffers();
+        // Reorders the indexed geometry for the post-transform cache, overdraw and vertex fetches (see MeshOptimizer.hpp).
+        // Call it after setting the geometry and before InitializeBuffers() or Save().
+        const MeshOptimizationReport& Optimize();
+        void InitializeBuffers(const RenderSystem::GL::VertexPacking& packing = RenderSystem::GL::VertexPacking());
         RenderSystem::GL::VAO* GetVAO() const { return mVAO.get(); }
         RenderSystem::GL::VBO* GetVBO() const { return mVBO.get(); }
-        RenderSystem::GL::VBO* GetNVBO() const { return mNVBO.get(); }
-        RenderSystem::GL::VBO* GetTCVBO() const { return mTCVBO.get(); }
-        RenderSystem::GL::VBO* GetTVBO() const { return mTVBO.get(); }
-        RenderSystem::GL::VBO* GetBVBO() const { return mBVBO.get(); }
+        RenderSystem::GL::EBO* GetEBO() const { return mEBO.get(); }
+        const RenderSystem::GL::VertexMemoryReport& GetMemoryReport() const { return mMemoryReport; }
+        const MeshOptimizationReport& GetOptimizationReport() const { return mOptimizationReport; }
+
+        // Precooked meshes (see MeshFile.hpp). Save() cooks the geometry set on the mesh, Load() replaces
+        // InitializeBuffers(): the file is mapped and uploaded as is, the CPU side attribute arrays stay empty.
+        bool Save(const std::string& path, const RenderSystem::GL::VertexPacking& packing = RenderSystem::GL::VertexPacking(),
+                  const std::vector<MeshLOD>& lods = {}) const;
+        bool Load(const std::string& path);
+
+        // Levels of detail of indexed meshes, Draw() and DrawInstanced() use the selected one. Level 0 is the mesh itself.
+        // GenerateLODs() simplifies the geometry set on the mesh, after Optimize(); InitializeBuffers() and Save() store
+        // the levels after the full resolution indices, in the same element buffer.
+        void GenerateLODs(unsigned int levelCount = 4, float maxError = 0.05f);
+        void SetLOD(unsigned int level);
+        // Selects the coarsest level whose error, projected through modelView and projection, stays under threshold pixels.
+        unsigned int SelectLOD(const glm::mat4& modelView, const glm::mat4& projection, float viewportHeight, float threshold = 1.0f);
+        unsigned int GetLODCount() const { return static_cast<unsigned int>(mLODs.size()); }
+        unsigned int GetLOD() const { return mLOD; }
+
+        // Instancing: one draw call renders a copy of the object per transform, applied on top of GetTransform().
+        void SetInstanceTransforms(const std::vector<glm::mat4>& transforms);
+        // Draws instanceCount instances starting at firstInstance, or every instance by default.
+        void DrawInstanced(GLuint firstInstance = 0, GLsizei instanceCount = -1) const;
+        GLsizei GetInstanceCount() const { return mInstances ? mInstances->GetCount() : 0; }
 
     private:
         std::vector<float> mVertices;
@@ -55,15 +78,23 @@ namespace Dazzle
         std::vector<float> mTangents;
         std::vector<float> mBitangents;
         std::vector<float> mTextureCoordinates;
+        std::vector<unsigned int> mIndices;
+        unsigned int mDrawCount;    // Number of indices, or vertices if the mesh isn't indexed, submitted per draw call
+        unsigned int mFirstIndex;   // First index of the selected level of detail
+        unsigned int mLOD;
+        std::vector<MeshFileLOD> mLODs;
+        std::vector<MeshLOD> mLODIndices;   // Generated levels, until InitializeBuffers() uploads them
         glm::mat4 mTransform;
+        BoundingVolume mBounds;
         std::string mName;
 
         std::unique_ptr<RenderSystem::GL::VAO> mVAO;    // Vertex Array Object
         std::unique_ptr<RenderSystem::GL::VBO> mVBO;    // Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mNVBO;   // Normal Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mTCVBO;  // Texture Coordinates Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mTVBO;   // Tangents Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mBVBO;   // Bitangents Vertex Buffer Object
+        std::unique_ptr<RenderSystem::GL::EBO> mEBO;    // Elements Buffer Object, only for indexed meshes
+        GLenum mIndexType;                              // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        RenderSystem::GL::VertexMemoryReport mMemoryReport;
+        MeshOptimizationReport mOptimizationReport;     // Set by Optimize()
+        std::unique_ptr<RenderSystem::GL::InstanceBuffer> mInstances;  // Per-instance transforms, created on demand
     };
 }
 
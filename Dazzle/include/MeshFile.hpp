@@ -0,0 +1,117 @@
+#ifndef _MESH_FILE_HPP_
+#define _MESH_FILE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/gl3w.h>
+
+#include "DazzleEngine.hpp"
+#include "BoundingVolume.hpp"
+#include "FileManager.hpp"
+#include "MeshOptimizer.hpp"
+#include "Object3D.hpp"
+#include "VertexLayout.hpp"
+
+namespace Dazzle
+{
+    const char kMeshFileMagic[4] = {'D', 'Z', 'M', 'S'};
+    const std::uint32_t kMeshFileVersion = 2;       // 2: levels of detail, errors relative to the bounding sphere radius
+    const std::uint64_t kMeshFileAlignment = 16;    // Alignment of the vertex and index blobs within the file
+
+    // Precooked mesh (.dzmesh), vertices and indices are stored in their GPU format so loading is a memory mapping
+    // handed to glNamedBufferStorage. All offsets are relative to the start of the file:
+    //
+    //     MeshFileHeader
+    //     MeshFileAttribute[mAttributeCount]
+    //     MeshFileLOD[mLODCount]
+    //     Interleaved vertices                                    (mVertexOffset, aligned)
+    //     Indices of every LOD, one after the other               (mIndexOffset, aligned)
+    //
+    // mChecksum is the FNV-1a hash of everything after the header.
+    struct MeshFileHeader
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        std::uint64_t mChecksum;
+        std::uint64_t mFileSize;
+
+        std::uint32_t mAttributeCount;
+        std::uint32_t mLODCount;                // 0 for meshes drawn without indices
+        std::uint32_t mVertexCount;
+        std::uint32_t mStride;                  // Size of a vertex, in bytes
+        std::uint32_t mIndexType;               // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        std::uint32_t mIndexCount;              // Indices of all LODs
+
+        std::uint64_t mVertexOffset;
+        std::uint64_t mVertexSize;
+        std::uint64_t mIndexOffset;
+        std::uint64_t mIndexSize;
+
+        float mBoundsMin[3];
+        float mBoundsMax[3];
+        float mBoundsCenter[3];
+        float mBoundsRadius;
+    };
+
+    // Mirror of RenderSystem::GL::VertexAttributeFormat with fixed size members.
+    struct MeshFileAttribute
+    {
+        std::uint32_t mLocation;
+        std::int32_t mSize;
+        std::uint32_t mType;
+        std::uint32_t mNormalized;
+        std::uint32_t mRelativeOffset;
+    };
+
+    // Range of the index blob drawn at a level of detail, level 0 is the full resolution mesh.
+    struct MeshFileLOD
+    {
+        std::uint32_t mFirstIndex;
+        std::uint32_t mIndexCount;
+        float mError;                           // Simplification error, relative to the bounding sphere radius
+        std::uint32_t mPadding;
+    };
+
+    static_assert(sizeof(MeshFileHeader) == 120, "MeshFileHeader must not contain implicit padding");
+    static_assert(sizeof(MeshFileAttribute) == 20, "MeshFileAttribute must not contain implicit padding");
+    static_assert(sizeof(MeshFileLOD) == 16, "MeshFileLOD must not contain implicit padding");
+
+    class MeshFile
+    {
+    public:
+        MeshFile();
+        MeshFile(const MeshFile& other) = delete;
+
+        MeshFile& operator=(const MeshFile& other) = delete;
+
+        // Cooks object into path, with its vertices interleaved and packed like Mesh::InitializeBuffers() does.
+        // The indices of object are LOD 0, lods are appended after them.
+        static bool Write( const std::string& path, const Object3D& object,
+                           const RenderSystem::GL::VertexPacking& packing = RenderSystem::GL::VertexPacking(),
+                           const std::vector<MeshLOD>& lods = {});
+
+        // Maps path and validates its header, the checksum reads the whole file once.
+        bool Open(const std::string& path, bool verifyChecksum = true);
+        void Close();
+
+        const MeshFileHeader& GetHeader() const { return *mHeader; }
+        const MeshFileAttribute* GetAttributes() const { return mAttributes; }
+        const MeshFileLOD* GetLODs() const { return mLODs; }
+        const void* GetVertexData() const { return mFile.GetData() + mHeader->mVertexOffset; }
+        const void* GetIndexData() const { return mFile.GetData() + mHeader->mIndexOffset; }
+
+        RenderSystem::GL::VertexLayout GetLayout() const;
+        BoundingVolume GetBounds() const;
+        bool IsOpen() const { return mHeader != nullptr; }
+
+    private:
+        MappedFile mFile;
+        const MeshFileHeader* mHeader;
+        const MeshFileAttribute* mAttributes;
+        const MeshFileLOD* mLODs;
+    };
+}
+
+#endif // _MESH_FILE_HPP_
@@ -0,0 +1,89 @@
+#ifndef _MESH_OPTIMIZER_HPP_
+#define _MESH_OPTIMIZER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Dazzle
+{
+    const unsigned int kVertexCacheSize = 16;      // FIFO post-transform cache simulated by the optimizer
+
+    // Post-transform cache efficiency of an index list, measured on a simulated FIFO cache.
+    struct VertexCacheStatistics
+    {
+        float mACMR = 0.0f;     // Average cache miss ratio, vertices transformed per triangle: 3 at worst, ~0.5 on large grids
+        float mATVR = 0.0f;     // Average transform to vertex ratio, vertices transformed per referenced vertex: 1 at best
+    };
+
+    struct MeshOptimizationReport
+    {
+        VertexCacheStatistics mBefore;
+        VertexCacheStatistics mAfter;
+    };
+
+    // Hash of the positions keying unordered containers that weld vertices. Adding 0 turns -0 into +0, which compare
+    // equal and must hash the same.
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& p) const
+        {
+            const glm::vec3 normalized = p + glm::vec3(0.0f);
+            std::uint32_t bits[3];
+            std::memcpy(bits, &normalized, sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    // Level of detail of an indexed mesh, indices address the vertices of the full resolution mesh.
+    struct MeshLOD
+    {
+        std::vector<unsigned int> mIndices;
+        float mError = 0.0f;                // Geometric error, relative to the bounding sphere radius
+    };
+
+    // Load or cook time reordering of indexed triangle lists, the rendered image is unchanged:
+    //
+    //     OptimizeVertexCache()   Triangle order for the post-transform cache (Tipsify)
+    //     OptimizeOverdraw()      Clusters of that order sorted so outward facing ones are drawn first
+    //     OptimizeVertexFetch()   Vertices renumbered in first use order, for linear vertex fetches
+    //
+    // Optimize() runs the three passes in that order and remaps the vertex attributes. Simplify() and GenerateLODs()
+    // only ever remove triangles, levels of detail share the vertices of the mesh.
+    class MeshOptimizer
+    {
+    public:
+        static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = kVertexCacheSize);
+        // Expects cache optimized indices. threshold is the ACMR increase accepted to split the order into more clusters.
+        static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& positions, float threshold = 1.05f,
+                                     unsigned int cacheSize = kVertexCacheSize);
+        // Returns the old to new vertex table, vertices no triangle references map to kUnusedVertex and are dropped.
+        static std::vector<unsigned int> OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount);
+        // Applies an OptimizeVertexFetch() table to an attribute of any component count, empty attributes are left as is.
+        static void RemapVertexAttribute(std::vector<float>& attribute, const std::vector<unsigned int>& remap, size_t vertexCount);
+
+        static VertexCacheStatistics AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                                        unsigned int cacheSize = kVertexCacheSize);
+
+        // positions are tightly packed xyz, attributes hold the other per vertex arrays to keep in sync with them.
+        static MeshOptimizationReport Optimize(std::vector<unsigned int>& indices, std::vector<float>& positions,
+                                               const std::vector<std::vector<float>*>& attributes);
+
+        // Quadric error edge collapses (Garland and Heckbert) onto existing vertices until targetIndexCount is reached or
+        // a collapse would move the surface by more than targetError, relative to the bounding sphere radius. Open
+        // borders and attribute seams are kept in place. resultError receives the error of the returned indices.
+        static std::vector<unsigned int> Simplify(const std::vector<unsigned int>& indices, const std::vector<float>& positions,
+                                                  size_t targetIndexCount, float targetError, float* resultError = nullptr);
+        // Up to levelCount levels, each with about reduction times the triangles of the previous one, simplified from
+        // the full resolution indices and cache optimized. Stops early once a level can't be reduced within maxError.
+        static std::vector<MeshLOD> GenerateLODs(const std::vector<unsigned int>& indices, const std::vector<float>& positions,
+                                                 unsigned int levelCount = 4, float reduction = 0.5f, float maxError = 0.05f);
+
+        static const unsigned int kUnusedVertex = ~0u;
+    };
+}
+
+#endif // _MESH_OPTIMIZER_HPP_
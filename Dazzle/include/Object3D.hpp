@@ -6,6 +6,8 @@
 
 #include <glm/glm.hpp>
 
+#include "BoundingVolume.hpp"
+
 namespace Dazzle
 {
     class Object3D
@@ -14,13 +16,19 @@ namespace Dazzle
         virtual ~Object3D() {}
 
         virtual void Draw() const = 0;
-        virtual std::vector<float> GetVertices() const = 0;
-        virtual std::vector<float> GetNormals() const = 0;
-        virtual std::vector<float> GetTangents() const = 0;
-        virtual std::vector<float> GetBitangents() const = 0;
-        virtual std::vector<float> GetTextureCoordinates() const = 0;
-        virtual std::vector<unsigned int> GetIndices() const = 0;
+
+        // Geometry accessors return views into the object's own storage, no copies are made.
+        virtual const std::vector<float>& GetVertices() const = 0;
+        virtual const std::vector<float>& GetNormals() const = 0;
+        virtual const std::vector<float>& GetTangents() const = 0;
+        virtual const std::vector<float>& GetBitangents() const = 0;
+        virtual const std::vector<float>& GetTextureCoordinates() const = 0;
+        virtual const std::vector<unsigned int>& GetIndices() const = 0;
+        // Number of elements (indices or vertices) submitted by Draw(), cached when the geometry is built.
+        virtual unsigned int GetDrawCount() const = 0;
         virtual glm::mat4 GetTransform() const = 0;
+        // Object space bounds of the geometry, computed by InitializeBuffers().
+        virtual const BoundingVolume& GetBounds() const = 0;
     };
 }
 
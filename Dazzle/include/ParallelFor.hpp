@@ -0,0 +1,36 @@
+#ifndef _PARALLEL_FOR_HPP_
+#define _PARALLEL_FOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Dazzle
+{
+    // Runs task(0) .. task(count - 1) on up to threadCount threads, the calling thread included. Tasks are handed out
+    // one at a time, a threadCount of 0 uses every hardware thread.
+    template <typename Task>
+    void ParallelFor(size_t count, unsigned int threadCount, const Task& task)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+        std::atomic<size_t> next(0);
+        auto run = [&]()
+        {
+            for (size_t i = next++; i < count; i = next++)
+                task(i);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < std::min<size_t>(threadCount, count); ++i)
+            threads.emplace_back(run);
+        run();
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
+
+#endif // _PARALLEL_FOR_HPP_
@@ -4,14 +4,9 @@
 #include <memory>
 #include <vector>
 
+#include "MeshOptimizer.hpp"
 #include "Object3D.hpp"
-
-namespace RenderSystem::GL
-{
-    class VAO;
-    class VBO;
-    class EBO;
-}
+#include "VertexLayout.hpp"
 
 namespace Dazzle
 {
@@ -24,13 +19,15 @@ namespace Dazzle
         ~Plane() override {}
 
         void Draw() const override;
-        std::vector<float> GetVertices() const override { return mVertices; }
-        std::vector<float> GetNormals() const override { return mNormals; }
-        std::vector<float> GetTangents() const override { return mTangents; }
-        std::vector<float> GetBitangents() const override { return mBitangents; }
-        std::vector<float> GetTextureCoordinates() const override { return mTextureCoordinates; }
-        std::vector<unsigned int> GetIndices() const override { return mIndices; }
+        const std::vector<float>& GetVertices() const override { return mVertices; }
+        const std::vector<float>& GetNormals() const override { return mNormals; }
+        const std::vector<float>& GetTangents() const override { return mTangents; }
+        const std::vector<float>& GetBitangents() const override { return mBitangents; }
+        const std::vector<float>& GetTextureCoordinates() const override { return mTextureCoordinates; }
+        const std::vector<unsigned int>& GetIndices() const override { return mIndices; }
+        unsigned int GetDrawCount() const override { return mDrawCount; }
         glm::mat4 GetTransform() const override { return mTransform; }
+        const BoundingVolume& GetBounds() const override { return mBounds; }
 
         void SetPosition(glm::vec3 position);
 
@@ -38,13 +35,12 @@ namespace Dazzle
         void Rotate(glm::vec3 axis, float degrees);
         /// TODO: void Scale(glm::vec3 factor);
 
-        void InitializeBuffers();
+        void InitializeBuffers(const RenderSystem::GL::VertexPacking& packing = RenderSystem::GL::VertexPacking());
         RenderSystem::GL::VAO* GetVAO() const { return mVAO.get(); }
         RenderSystem::GL::VBO* GetVBO() const { return mVBO.get(); }
-        RenderSystem::GL::VBO* GetNVBO() const { return mNVBO.get(); }
-        RenderSystem::GL::VBO* GetTCVBO() const { return mTCVBO.get(); }
-        RenderSystem::GL::VBO* GetTVBO() const { return mTVBO.get(); }
         RenderSystem::GL::EBO* GetEBO() const { return mEBO.get(); }
+        const RenderSystem::GL::VertexMemoryReport& GetMemoryReport() const { return mMemoryReport; }
+        const MeshOptimizationReport& GetOptimizationReport() const { return mOptimizationReport; }
 
     private:
         std::vector<float> mVertices;
@@ -53,14 +49,16 @@ namespace Dazzle
         std::vector<float> mBitangents;
         std::vector<float> mTextureCoordinates;
         std::vector<unsigned int> mIndices;
+        unsigned int mDrawCount;    // Number of indices submitted per draw call
         glm::mat4 mTransform;
+        BoundingVolume mBounds;
 
         std::unique_ptr<RenderSystem::GL::VAO> mVAO;    // Vertex Array Object
         std::unique_ptr<RenderSystem::GL::VBO> mVBO;    // Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mNVBO;   // Normal Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mTCVBO;  // Texture Coordinates Vertex Buffer Object
-        std::unique_ptr<RenderSystem::GL::VBO> mTVBO;   // Tangents Vertex Buffer Object
         std::unique_ptr<RenderSystem::GL::EBO> mEBO;    // Elements Buffer Object
+        GLenum mIndexType;                              // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        RenderSystem::GL::VertexMemoryReport mMemoryReport;
+        MeshOptimizationReport mOptimizationReport;     // Generated indices before and after reordering
     };
 }
 
@@ -0,0 +1,144 @@
+#ifndef _RENDER_QUEUE_HPP_
+#define _RENDER_QUEUE_HPP_
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include "DazzleEngine.hpp"
+#include "Object3D.hpp"
+#include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // Shader storage binding of the per-object data read with gl_BaseInstance. Materials are bound by each
+            // example to kMaterialBlockBinding (see UniformBuffer.hpp) and indexed with ObjectData::mMaterial.
+            const GLuint kObjectDataBinding = 3;
+            // Shader storage binding of the per-object bounds, only read by the culling pass.
+            const GLuint kObjectBoundsBinding = 4;
+
+            // Layout of the commands read by glMultiDrawElementsIndirect.
+            struct DrawElementsIndirectCommand
+            {
+                GLuint mCount;              // Number of indices
+                GLuint mInstanceCount;
+                GLuint mFirstIndex;         // First index within the index arena
+                GLint mBaseVertex;          // First vertex within the vertex arena
+                GLuint mBaseInstance;
+            };
+
+            // std430 layout of the per-object data:
+            //
+            //     struct ObjectData
+            //     {
+            //         mat4 Model;
+            //         mat4 Normal;        // Upper 3x3 is the world space normal matrix
+            //         uint Material;
+            //     };
+            //
+            //     layout(std430, binding = 3) readonly buffer ObjectDataBlock { ObjectData objects[]; };
+            //
+            // The base instance of every draw command is the id of its object, so objects[gl_BaseInstance] stays
+            // correct once culling has compacted the commands (gl_DrawID only matches when nothing is culled).
+            struct ObjectData
+            {
+                glm::mat4 mModel;
+                glm::mat4 mNormal;
+                GLuint mMaterial;
+                GLuint mPadding[3];
+            };
+
+            // Object space axis aligned box of the geometry of an object, w is unused.
+            struct ObjectBounds
+            {
+                glm::vec4 mMin;
+                glm::vec4 mMax;
+            };
+
+            static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must be tightly packed");
+            static_assert(sizeof(ObjectData) == 144, "ObjectData must match the std430 layout of ObjectData");
+
+            // Batches many objects into a single glMultiDrawElementsIndirect call. The geometry of every object is
+            // copied into shared vertex and index arenas, so one vertex array serves the whole queue, and each object
+            // gets a draw command plus an ObjectData entry that shaders fetch with gl_BaseInstance.
+            class RenderQueue
+            {
+            public:
+                static const unsigned int kInvalidID = std::numeric_limits<unsigned int>::max();
+
+                RenderQueue();
+                RenderQueue(const RenderQueue& other) = delete;
+                ~RenderQueue();
+
+                RenderQueue& operator=(const RenderQueue& other) = delete;
+
+                // Creates the buffers and the vertex array, needs the GL context. Geometries and objects can be added
+                // before, they're uploaded by the next Upload().
+                void Initialize();
+                bool IsValid() const { return mVAO != nullptr; }
+
+                // Copies the geometry of object into the arenas. Returns its id, or kInvalidID on failure.
+                // Every geometry shares the same vertex format: missing normals and texture coordinates are zero filled.
+                unsigned int AddGeometry(const Object3D& object);
+                // Adds an object drawn with a geometry. Returns its id, which is also the gl_BaseInstance of its draw.
+                unsigned int AddObject(unsigned int geometry, const glm::mat4& transform, GLuint material = 0);
+                void SetTransform(unsigned int object, const glm::mat4& transform);
+                void SetMaterial(unsigned int object, GLuint material);
+                // Removes every object, geometries are kept.
+                void ClearObjects();
+
+                // Uploads whatever changed since the last call. Call it before Submit().
+                void Upload();
+                // Binds the vertex array and the object data, used by Submit() and by the culling pass.
+                void Bind() const;
+                // Draws every object with a single call.
+                void Submit() const;
+
+                GLsizei GetObjectCount() const { return static_cast<GLsizei>(mCommands.size()); }
+                unsigned int GetGeometryCount() const { return static_cast<unsigned int>(mGeometries.size()); }
+                // Size of the vertex and index arenas, in bytes
+                size_t GetArenaSize() const { return mVertexData.size() + mIndices.size() * sizeof(GLuint); }
+                GLuint GetCommandBuffer() const { return mCommandBuffer; }
+                GLuint GetBoundsBuffer() const { return mBoundsBuffer; }
+
+            private:
+                struct Geometry
+                {
+                    GLuint mIndexCount;
+                    GLuint mFirstIndex;
+                    GLint mBaseVertex;
+                    ObjectBounds mBounds;
+                };
+
+                std::vector<Geometry> mGeometries;
+                std::vector<unsigned char> mVertexData;
+                std::vector<GLuint> mIndices;
+                std::vector<DrawElementsIndirectCommand> mCommands;
+                std::vector<ObjectData> mObjects;
+                std::vector<ObjectBounds> mBounds;
+                VertexLayout mLayout;
+
+                std::unique_ptr<VAO> mVAO;
+                std::unique_ptr<VBO> mVBO;      // Vertex arena
+                std::unique_ptr<EBO> mEBO;      // Index arena
+                GLuint mCommandBuffer;          // GL_DRAW_INDIRECT_BUFFER
+                GLuint mObjectBuffer;           // GL_SHADER_STORAGE_BUFFER
+                GLuint mBoundsBuffer;           // GL_SHADER_STORAGE_BUFFER
+
+                bool mArenasDirty;
+                bool mCommandsDirty;
+                bool mObjectsDirty;
+            };
+        }
+    }
+}
+
+#endif // _RENDER_QUEUE_HPP_
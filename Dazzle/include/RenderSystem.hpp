@@ -1,6 +1,8 @@
 #ifndef _RENDER_SYSTEM_HPP_
 #define _RENDER_SYSTEM_HPP_
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -141,6 +143,111 @@ namespace Dazzle
                 GLenum mBinaryFormat;
             };
 
+            // Source code of one stage of a program
+            struct ShaderSource
+            {
+                GLenum mType;
+                std::string mSourceCode;
+            };
+
+            // Disk cache of linked program binaries.
+            // Programs are keyed by a hash of their sources, their defines, the driver (vendor, renderer and version)
+            // and its binary formats, so editing a shader or updating the driver simply misses the cache. A binary
+            // the driver refuses to load is compiled again from source and overwritten.
+            class ShaderCache
+            {
+            public:
+                // Time is accumulated in milliseconds
+                struct Statistics
+                {
+                    unsigned int mHits = 0;         // Programs loaded from a binary
+                    unsigned int mMisses = 0;       // Programs compiled from source
+                    double mLoadTime = 0.0;
+                    double mCompileTime = 0.0;
+                };
+
+                // Cache used by ProgramBuilder, stored in kDefaultDirectory under the working directory.
+                static ShaderCache& GetInstance();
+                static const char* const kDefaultDirectory;
+
+                explicit ShaderCache(const std::string& directory = kDefaultDirectory);
+
+                // Links program from sources, defines ("NAME" or "NAME VALUE") are inserted after each #version line.
+                // Returns the linkage status of the program.
+                bool Build(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines = {});
+
+                // A disabled cache neither reads nor writes binaries, programs are always compiled.
+                void SetEnabled(bool enabled) { mEnabled = enabled; }
+                bool IsEnabled() const { return mEnabled; }
+                const std::string& GetDirectory() const { return mDirectory; }
+                const Statistics& GetStatistics() const { return mStatistics; }
+                void ResetStatistics() { mStatistics = Statistics(); }
+
+            private:
+                friend class AsyncProgramBuilder;
+
+                // Inserts the defines into sources and finds the cache file of the program. key is a second hash,
+                // independent of the one naming the file, that Load() checks. path stays empty when the program
+                // can't be cached.
+                void Prepare(std::vector<ShaderSource>& sources, const std::vector<std::string>& defines, std::string& path, unsigned long long& key);
+                bool Load(ProgramObject& program, const std::string& path, unsigned long long key) const;
+                void Store(ProgramObject& program, const std::string& path, unsigned long long key) const;
+                const std::string& GetDriverKey();
+
+                std::string mDirectory;
+                std::string mDriverKey;             // Queried from the driver on first use
+                bool mEnabled;
+                Statistics mStatistics;
+            };
+
+            // Builds several programs at once, through a ShaderCache.
+            // Every compile and link job is handed to the driver before any status is queried. With
+            // GL_KHR_parallel_shader_compile the driver builds them on its own threads and Poll() checks their
+            // completion without blocking. Other drivers (e.g. Mesa llvmpipe) still get every job up front, but
+            // Poll() then blocks on each program in turn, like ProgramBuilder does.
+            class AsyncProgramBuilder
+            {
+            public:
+                explicit AsyncProgramBuilder(ShaderCache& cache = ShaderCache::GetInstance());
+                AsyncProgramBuilder(const AsyncProgramBuilder& other) = delete;
+                // Waits for every queued program
+                ~AsyncProgramBuilder();
+
+                AsyncProgramBuilder& operator=(const AsyncProgramBuilder& other) = delete;
+
+                // Queues an initialized program, which must outlive the build. Defines work as in ShaderCache::Build().
+                void Add(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines = {});
+                // Loads the cached programs and submits the compile and link jobs of the others.
+                void Submit();
+                // Finishes the programs whose link completed. Returns true once every submitted program is done.
+                bool Poll();
+                // Submits whatever is queued and blocks until every program is done.
+                void Wait();
+
+                size_t GetPendingCount() const;
+                // Also raises the driver's compiler thread count the first time it finds the extension.
+                static bool IsParallelCompileSupported();
+
+            private:
+                struct Job
+                {
+                    ProgramObject* mProgram;
+                    std::vector<ShaderSource> mSources;
+                    std::vector<std::unique_ptr<ShaderObject>> mShaders;
+                    std::string mPath;                  // Cache file, empty when the program can't be cached
+                    unsigned long long mKey;
+                    bool mSubmitted;
+                    bool mDone;
+                };
+
+                void Finish(Job& job);
+
+                ShaderCache& mCache;
+                std::vector<Job> mJobs;
+                size_t mCompiling;                      // Jobs in the hands of the driver
+                std::chrono::steady_clock::time_point mCompileStart;
+            };
+
             namespace ShaderBuilder
             {
                 void Build(ShaderObject& shader, const GLenum& type, const std::string& source);
@@ -149,6 +256,8 @@ namespace Dazzle
             namespace ProgramBuilder
             {
                 void Build(ProgramObject& program, const std::vector<ShaderObject*>& shaders);
+                // Builds program through ShaderCache::GetInstance(), compiling the sources only on a cache miss.
+                void Build(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines = {});
             };
         }
     }
@@ -1,9 +1,18 @@
 #ifndef _SHADER_MANAGER_HPP_
 #define _SHADER_MANAGER_HPP_
 
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include <GL/gl3w.h>
 
 #include "DazzleEngine.hpp"
+#include "RenderSystem.hpp"
 #include "ShadingEffects.hpp"
 #include "Singleton.hpp"
 
@@ -73,15 +82,66 @@ namespace Dazzle
     //     kUVGrid
     // };
 
+    // GLSL file of one stage of a program
+    struct ShaderFile
+    {
+        GLenum mType;
+        std::string mPath;
+    };
+
     class ShaderManager
     {
     public:
+        using ReloadCallback = std::function<void(RenderSystem::GL::ProgramObject& program)>;
+
         ShaderManager();
+        ShaderManager(const ShaderManager& other) = delete;
+        ~ShaderManager();
+
+        ShaderManager& operator=(const ShaderManager& other) = delete;
+
         void UseEffect(const IShadingEffect& shader);
         
         IShadingEffect& GetSimpleShader();
         // IShadingEffect& GetStandardShader();
         // ...
+
+        // Hot reload: program, already built from files, is rebuilt whenever one of them changes on disk.
+        // The rebuilt program replaces it only if it links, after inheriting its uniform values and block bindings,
+        // otherwise the previous program stays in use. onReload runs after a swap, to refresh uniform locations.
+        void Watch( RenderSystem::GL::ProgramObject& program, const std::vector<ShaderFile>& files,
+                    const ReloadCallback& onReload = nullptr, const std::vector<std::string>& defines = {});
+        void Unwatch(const RenderSystem::GL::ProgramObject& program);
+        // Picks up file changes, submits rebuilds and swaps in the finished programs, without blocking on the driver.
+        // Call it once per frame.
+        void Update();
+
+    private:
+        struct WatchedProgram
+        {
+            RenderSystem::GL::ProgramObject* mProgram;
+            std::vector<ShaderFile> mFiles;
+            std::vector<std::string> mDefines;
+            ReloadCallback mOnReload;
+            bool mChanged;                                                  // A file changed since the last rebuild
+            std::unique_ptr<RenderSystem::GL::ProgramObject> mPending;      // Program being rebuilt
+            std::unique_ptr<RenderSystem::GL::AsyncProgramBuilder> mBuilder;
+        };
+
+        void WatchFile(const std::string& path);
+        std::vector<std::string> PollChangedFiles();
+        void Rebuild(WatchedProgram& watched);
+        void Swap(WatchedProgram& watched);
+
+        std::vector<std::unique_ptr<WatchedProgram>> mPrograms;
+
+        // inotify on Linux: one watch per directory, editors often replace files instead of writing them in place
+        int mNotifyHandle;
+        std::unordered_map<int, std::string> mWatchedDirectories;         // Watch descriptor to directory
+
+        // Elsewhere: modification times, polled at most every kPollInterval
+        std::unordered_map<std::string, std::filesystem::file_time_type> mWriteTimes;
+        std::chrono::steady_clock::time_point mLastPoll;
     };
 }
 
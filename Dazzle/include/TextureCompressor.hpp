@@ -0,0 +1,53 @@
+#ifndef _TEXTURE_COMPRESSOR_HPP_
+#define _TEXTURE_COMPRESSOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/gl3w.h>
+
+#include "DazzleEngine.hpp"
+
+namespace Dazzle
+{
+    // Block compressed formats, valued as their VkFormat so KTX2 files store them as they are.
+    enum class TextureFormat : std::uint32_t
+    {
+        BC1_RGB_UNORM = 131,
+        BC1_RGB_SRGB = 132,
+        BC4_UNORM = 139,
+        BC5_UNORM = 141,
+        BC6H_UFLOAT = 143,
+        BC7_UNORM = 145,
+        BC7_SRGB = 146
+    };
+
+    // CPU encoder of 4x4 blocks, rows of blocks are spread over threads. Images whose size isn't a multiple of 4 get
+    // their edge texels repeated in the partial blocks.
+    //
+    //     BC1      RGB, 8 bytes a block, endpoints along the principal axis of the block refined by least squares
+    //     BC4      Red, 8 bytes a block
+    //     BC5      Red and green, 16 bytes a block: two BC4 blocks, for tangent space normal maps
+    //     BC6H     Unsigned half float RGB, 16 bytes a block, mode 11 only (one subset, 10 bit endpoints)
+    //     BC7      RGBA, 16 bytes a block, mode 6 only (one subset, 7 bit endpoints with a p-bit)
+    class TextureCompressor
+    {
+    public:
+        static bool IsHDR(TextureFormat format) { return format == TextureFormat::BC6H_UFLOAT; }
+        static bool IsSRGB(TextureFormat format) { return format == TextureFormat::BC1_RGB_SRGB || format == TextureFormat::BC7_SRGB; }
+
+        // Bytes of a 4x4 block, 0 for unknown formats.
+        static unsigned int GetBlockSize(TextureFormat format);
+        static size_t GetCompressedSize(TextureFormat format, int width, int height);
+        // 0 for unknown formats.
+        static GLenum GetInternalFormat(TextureFormat format);
+
+        // rgba holds width * height RGBA8 texels. Every format but BC6H, empty for BC6H.
+        static std::vector<unsigned char> Compress(const unsigned char* rgba, int width, int height, TextureFormat format, unsigned int threadCount = 0);
+        // rgb holds width * height RGB float texels, negative values are encoded as 0. BC6H only.
+        static std::vector<unsigned char> CompressHDR(const float* rgb, int width, int height, unsigned int threadCount = 0);
+    };
+}
+
+#endif // _TEXTURE_COMPRESSOR_HPP_
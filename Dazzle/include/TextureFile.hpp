@@ -0,0 +1,96 @@
+#ifndef _TEXTURE_FILE_HPP_
+#define _TEXTURE_FILE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/gl3w.h>
+
+#include "DazzleEngine.hpp"
+#include "FileManager.hpp"
+#include "TextureCompressor.hpp"
+
+namespace Dazzle
+{
+    const unsigned char kTextureFileIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    // KTX2 container (.ktx2) of a block compressed 2D texture or cube map, with its whole mip chain and no
+    // supercompression. Loading is a memory mapping handed to glCompressedTextureSubImage*D. All offsets are relative
+    // to the start of the file:
+    //
+    //     TextureFileHeader
+    //     TextureFileLevel[mLevelCount]                           (level 0, the largest, first)
+    //     Data Format Descriptor                                  (mDFDOffset)
+    //     Key/value data, sorted by key                           (mKVDOffset, absent when mKVDSize is 0)
+    //     Levels, smallest first, faces one after the other       (TextureFileLevel::mOffset, aligned to a block)
+    struct TextureFileHeader
+    {
+        unsigned char mIdentifier[12];
+        std::uint32_t mFormat;                  // VkFormat, one of TextureFormat
+        std::uint32_t mTypeSize;
+        std::uint32_t mWidth;
+        std::uint32_t mHeight;
+        std::uint32_t mDepth;                   // 0 for 2D textures and cube maps
+        std::uint32_t mLayerCount;              // 0 when not an array
+        std::uint32_t mFaceCount;               // 1, or 6 for cube maps
+        std::uint32_t mLevelCount;
+        std::uint32_t mSupercompression;        // 0, none
+
+        std::uint32_t mDFDOffset;
+        std::uint32_t mDFDSize;
+        std::uint32_t mKVDOffset;
+        std::uint32_t mKVDSize;
+        std::uint64_t mSGDOffset;
+        std::uint64_t mSGDSize;
+    };
+
+    struct TextureFileLevel
+    {
+        std::uint64_t mOffset;
+        std::uint64_t mSize;                    // Every face of the level
+        std::uint64_t mUncompressedSize;        // mSize without supercompression
+    };
+
+    static_assert(sizeof(TextureFileHeader) == 80, "TextureFileHeader must match the KTX2 header");
+    static_assert(sizeof(TextureFileLevel) == 24, "TextureFileLevel must match the KTX2 level index");
+
+    class TextureFile
+    {
+    public:
+        TextureFile();
+        TextureFile(const TextureFile& other) = delete;
+
+        TextureFile& operator=(const TextureFile& other) = delete;
+
+        // levels[i] holds the compressed faces of level i one after the other, level 0 being width x height.
+        // keyValues are stored as NUL terminated strings in the key/value data.
+        static bool Write( const std::string& path, TextureFormat format, int width, int height, unsigned int faceCount,
+                           const std::vector<std::vector<unsigned char>>& levels, const std::map<std::string, std::string>& keyValues = {});
+
+        // Maps path and validates the header, level index and key/value data against the file size.
+        bool Open(const std::string& path);
+        void Close();
+
+        const TextureFileHeader& GetHeader() const { return *mHeader; }
+        TextureFormat GetFormat() const { return static_cast<TextureFormat>(mHeader->mFormat); }
+        const unsigned char* GetLevelData(unsigned int level) const;
+        size_t GetLevelSize(unsigned int level) const { return static_cast<size_t>(mLevels[level].mSize); }
+        // Value stored under key, empty when the file has none.
+        std::string GetValue(const std::string& key) const;
+        bool IsCubemap() const { return mHeader->mFaceCount == 6; }
+        bool IsOpen() const { return mHeader != nullptr; }
+
+        // Immutable GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP with every level of the file, 0 on failure. Filtering and
+        // wrapping are left to the caller.
+        GLuint CreateTexture() const;
+
+    private:
+        MappedFile mFile;
+        const TextureFileHeader* mHeader;
+        const TextureFileLevel* mLevels;
+    };
+}
+
+#endif // _TEXTURE_FILE_HPP_
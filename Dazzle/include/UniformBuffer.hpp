@@ -0,0 +1,130 @@
+#ifndef _UNIFORM_BUFFER_HPP_
+#define _UNIFORM_BUFFER_HPP_
+
+#include <cstddef>
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include "DazzleEngine.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // Uniform block binding points shared by the examples' shaders.
+            const GLuint kFrameBlockBinding = 0;        // FrameUniforms, written once per frame
+            const GLuint kObjectBlockBinding = 1;       // ObjectUniforms, one per draw
+            const GLuint kMaterialBlockBinding = 2;     // Material, layout defined by each shader
+
+            const unsigned int kMaxLights = 4;
+
+            // The structs below match the std140 layout of their GLSL counterparts:
+            // vec3 members are followed by a float (or padding) and mat3 is stored as three vec4 columns.
+            //
+            //     struct Light
+            //     {
+            //         vec4 mPosition;             // Light Position In View Coordinates, w = 0 for directional lights
+            //         vec3 mAmbient;              // Ambient Intensity
+            //         vec3 mIntensity;            // Diffuse & Specular Intensity
+            //     };
+            struct LightUniforms
+            {
+                glm::vec4 mPosition;
+                glm::vec3 mAmbient;
+                float mPadding0;
+                glm::vec3 mIntensity;
+                float mPadding1;
+            };
+
+            //     layout(std140, binding = 0) uniform FrameBlock
+            //     {
+            //         mat4 View;
+            //         mat4 Projection;
+            //         Light lights[4];
+            //         int LightCount;
+            //     };
+            struct FrameUniforms
+            {
+                glm::mat4 mView;
+                glm::mat4 mProjection;
+                LightUniforms mLights[kMaxLights];
+                GLint mLightCount;
+                GLint mPadding[3];
+            };
+
+            //     layout(std140, binding = 1) uniform ObjectBlock
+            //     {
+            //         mat4 Model;
+            //         mat4 ModelView;
+            //         mat4 MVP;
+            //         mat3 Normal;
+            //     };
+            struct ObjectUniforms
+            {
+                glm::mat4 mModel;
+                glm::mat4 mModelView;
+                glm::mat4 mMVP;
+                glm::vec4 mNormal[3];
+
+                static ObjectUniforms Create(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+            };
+
+            static_assert(sizeof(LightUniforms) == 48, "LightUniforms must match the std140 layout of Light");
+            static_assert(sizeof(FrameUniforms) == 336, "FrameUniforms must match the std140 layout of FrameBlock");
+            static_assert(sizeof(ObjectUniforms) == 240, "ObjectUniforms must match the std140 layout of ObjectBlock");
+
+            // A persistently mapped buffer split into one region per frame in flight. Uniform blocks are copied
+            // straight into the mapped memory and bound with glBindBufferRange, so per-draw updates don't go
+            // through glUniform* calls. A fence per region keeps the CPU from overwriting data still in use.
+            class UniformRingBuffer
+            {
+            public:
+                static const unsigned int kFrameCount = 3;  // Number of frames in flight
+
+                UniformRingBuffer();
+                UniformRingBuffer(const UniformRingBuffer& other) = delete;
+                ~UniformRingBuffer();
+
+                UniformRingBuffer& operator=(const UniformRingBuffer& other) = delete;
+
+                // Allocates and maps the buffer, frameSize bytes are available to each frame.
+                void Initialize(GLsizeiptr frameSize);
+                // Waits until the GPU is done with the region of this frame and rewinds it.
+                void BeginFrame();
+                // Fences the region of this frame and moves on to the next one.
+                void EndFrame();
+
+                // Copies data into the current frame's region. Returns the offset of the copy, or -1 if the region is full.
+                GLintptr Write(const void* data, GLsizeiptr size);
+                template <typename T>
+                GLintptr Write(const T& block) { return Write(&block, sizeof(T)); }
+
+                // Binds a previously written range of the buffer to the indexed binding point of target.
+                void Bind(GLuint binding, GLintptr offset, GLsizeiptr size, GLenum target = GL_UNIFORM_BUFFER) const;
+                template <typename T>
+                void Bind(GLuint binding, GLintptr offset, GLenum target = GL_UNIFORM_BUFFER) const { Bind(binding, offset, sizeof(T), target); }
+
+                // Writes a block and binds it right away.
+                template <typename T>
+                void Push(GLuint binding, const T& block, GLenum target = GL_UNIFORM_BUFFER) { Bind<T>(binding, Write(block), target); }
+
+                GLuint GetHandle() const { return mBuffer; }
+                bool IsValid() const { return mMappedData != nullptr; }
+
+            private:
+                GLuint mBuffer;
+                unsigned char* mMappedData;
+                GLsizeiptr mFrameSize;
+                GLsizeiptr mHead;               // Next free byte within the current region
+                GLint mAlignment;               // Offset alignment required by uniform and shader storage bindings
+                unsigned int mFrameIndex;
+                GLsync mFences[kFrameCount];
+            };
+        }
+    }
+}
+
+#endif // _UNIFORM_BUFFER_HPP_
@@ -0,0 +1,154 @@
+#ifndef _VERTEX_LAYOUT_HPP_
+#define _VERTEX_LAYOUT_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include "DazzleEngine.hpp"
+#include "RenderSystem.hpp"
+
+namespace Dazzle
+{
+    namespace RenderSystem
+    {
+        namespace GL
+        {
+            // Attribute locations shared by every Dazzle primitive and the example shaders.
+            const GLuint kPositionLocation = 0;
+            const GLuint kNormalLocation = 1;
+            const GLuint kTextureCoordinatesLocation = 2;
+            const GLuint kTangentLocation = 3;
+            const GLuint kBitangentLocation = 4;
+            const GLuint kInstanceTransformLocation = 5;    // mat4, one column per location from 5 to 8
+
+            // Buffer binding of the vertex arrays used by per-instance attributes.
+            const GLuint kInstanceBindingIndex = 1;
+
+            struct VertexAttributeFormat
+            {
+                GLuint mLocation;           // (Vertex) Attribute Index
+                GLint mSize;                // Number of components
+                GLenum mType;               // Data Type (GL_FLOAT, GL_HALF_FLOAT, GL_INT_2_10_10_10_REV...)
+                GLboolean mNormalized;      // Whether integer data is mapped to [-1, 1] / [0, 1]
+                GLuint mRelativeOffset;     // Offset of the attribute within a vertex, in bytes
+            };
+
+            // Describes how the attributes of a vertex are laid out within a single interleaved buffer.
+            class VertexLayout
+            {
+            public:
+                VertexLayout();
+
+                // Appends an attribute right after the previous one. Offsets are kept 4-byte aligned.
+                void Add(GLuint location, GLint size, GLenum type, GLboolean normalized = GL_FALSE);
+                // Adds an attribute at its own relative offset, for layouts built elsewhere (e.g. read from a file).
+                // The stride grows to cover it.
+                void Add(const VertexAttributeFormat& attribute);
+                // Specifies the format of every attribute and binds them to bindingIndex of the vertex array.
+                void Apply(GLuint vao, GLuint bindingIndex = 0) const;
+
+                GLuint GetStride() const { return mStride; }
+                const std::vector<VertexAttributeFormat>& GetAttributes() const { return mAttributes; }
+
+                // Size in bytes of a single attribute of the given type and number of components.
+                static GLuint GetAttributeSize(GLenum type, GLint size);
+
+            private:
+                std::vector<VertexAttributeFormat> mAttributes;
+                GLuint mStride;
+            };
+
+            // Optional packed formats. Positions are always stored as 32-bit floats.
+            struct VertexPacking
+            {
+                // Normals, tangents and bitangents as GL_INT_2_10_10_10_REV, expects unit vectors.
+                bool mPackedNormals = true;
+                // Texture coordinates as GL_HALF_FLOAT. Off by default: tiled coordinates lose precision quickly.
+                bool mHalfFloatTextureCoordinates = false;
+                // GL_UNSIGNED_SHORT indices when every vertex can be addressed with 16 bits.
+                bool mShortIndices = true;
+            };
+
+            // GPU memory used by a mesh before (one float VBO per attribute, 32-bit indices) and after interleaving.
+            struct VertexMemoryReport
+            {
+                size_t mBytesBefore = 0;
+                size_t mBytesAfter = 0;
+                unsigned int mBufferObjectsBefore = 0;
+                unsigned int mBufferObjectsAfter = 0;
+            };
+
+            // Interleaves separate float attribute arrays into a single vertex buffer, converting them to the
+            // packed formats selected in VertexPacking, and sets up the vertex array to source from it.
+            // The attribute arrays are referenced, not copied, so they must outlive Build().
+            class VertexBufferBuilder
+            {
+            public:
+                VertexBufferBuilder();
+
+                VertexBufferBuilder& SetPositions(const std::vector<float>& positions);
+                VertexBufferBuilder& SetNormals(const std::vector<float>& normals);
+                VertexBufferBuilder& SetTextureCoordinates(const std::vector<float>& textureCoordinates);
+                // Tangents may have 3 or 4 (handedness in w) components per vertex.
+                VertexBufferBuilder& SetTangents(const std::vector<float>& tangents);
+                VertexBufferBuilder& SetBitangents(const std::vector<float>& bitangents);
+                VertexBufferBuilder& SetIndices(const std::vector<unsigned int>& indices);
+                VertexBufferBuilder& SetPacking(const VertexPacking& packing);
+
+                // Uploads the vertex data into vbo (and the indices into ebo, if any) and configures vao.
+                bool Build(const VAO& vao, const VBO& vbo, const EBO* ebo = nullptr);
+                // Converts and interleaves the vertex data into vertexData without touching the GPU, sets up the layout.
+                bool Interleave(std::vector<unsigned char>& vertexData);
+
+                const VertexLayout& GetLayout() const { return mLayout; }
+                GLenum GetIndexType() const { return mIndexType; }
+                const VertexMemoryReport& GetMemoryReport() const { return mMemoryReport; }
+
+            private:
+                const std::vector<float>* mPositions;
+                const std::vector<float>* mNormals;
+                const std::vector<float>* mTextureCoordinates;
+                const std::vector<float>* mTangents;
+                const std::vector<float>* mBitangents;
+                const std::vector<unsigned int>* mIndices;
+                VertexPacking mPacking;
+
+                VertexLayout mLayout;
+                GLenum mIndexType;
+                VertexMemoryReport mMemoryReport;
+            };
+
+            // Per-instance model transforms sourced from a second buffer binding of a vertex array, advanced once
+            // per instance. Vertex shaders apply InstanceTransform on top of the object's Model matrix.
+            class InstanceBuffer
+            {
+            public:
+                InstanceBuffer();
+
+                // Sets up the instance transform attribute of vao to source from this buffer.
+                void Attach(const VAO& vao) const;
+                // Uploads one transform per instance, the buffer is only reallocated when it has to grow.
+                void SetTransforms(const std::vector<glm::mat4>& transforms);
+
+                GLsizei GetCount() const { return mCount; }
+                const VBO& GetVBO() const { return mVBO; }
+
+                // Sets the current value of the instance transform attribute to the identity. Vertex arrays
+                // without an instance buffer read it, so shaders can apply InstanceTransform unconditionally. A draw
+                // with the instance arrays enabled leaves the value undefined, so the primitives call this before
+                // each non-instanced draw.
+                static void SetIdentityDefault();
+
+            private:
+                VBO mVBO;
+                GLsizeiptr mCapacity;   // Allocated size, in bytes
+                GLsizei mCount;         // Number of instances
+            };
+        }
+    }
+}
+
+#endif // _VERTEX_LAYOUT_HPP_
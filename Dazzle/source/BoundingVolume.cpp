@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "BoundingVolume.hpp"
+
+Dazzle::BoundingVolume Dazzle::BoundingVolume::Compute(const std::vector<float>& positions)
+{
+    BoundingVolume volume;
+    if (positions.size() < 3)
+        return volume;
+
+    volume.mMin = volume.mMax = glm::vec3(positions[0], positions[1], positions[2]);
+    for (size_t i = 3; i + 2 < positions.size(); i += 3)
+    {
+        glm::vec3 position = glm::vec3(positions[i], positions[i + 1], positions[i + 2]);
+        volume.mMin = glm::min(volume.mMin, position);
+        volume.mMax = glm::max(volume.mMax, position);
+    }
+
+    // Centering the sphere on the box is not optimal, but it is tight enough for culling
+    volume.mCenter = 0.5f * (volume.mMin + volume.mMax);
+    float radiusSquared = 0.0f;
+    for (size_t i = 0; i + 2 < positions.size(); i += 3)
+    {
+        glm::vec3 offset = glm::vec3(positions[i], positions[i + 1], positions[i + 2]) - volume.mCenter;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    volume.mRadius = std::sqrt(radiusSquared);
+
+    return volume;
+}
+
+Dazzle::BoundingVolume Dazzle::BoundingVolume::Transform(const glm::mat4& transform) const
+{
+    if (!IsValid())
+        return *this;
+
+    // Arvo's method: the extents of the transformed box are the absolute linear part applied to the half extents
+    glm::mat3 linear = glm::mat3(transform);
+    glm::mat3 absolute = glm::mat3(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+    glm::vec3 center = glm::vec3(transform * glm::vec4(0.5f * (mMin + mMax), 1.0f));
+    glm::vec3 extents = absolute * (0.5f * (mMax - mMin));
+
+    float scale = std::max({glm::length(linear[0]), glm::length(linear[1]), glm::length(linear[2])});
+
+    BoundingVolume volume;
+    volume.mMin = center - extents;
+    volume.mMax = center + extents;
+    volume.mCenter = glm::vec3(transform * glm::vec4(mCenter, 1.0f));
+    volume.mRadius = mRadius * scale;
+    return volume;
+}
+
+float Dazzle::BoundingVolume::GetProjectedScale(const glm::mat4& modelView, const glm::mat4& projection, float viewportHeight) const
+{
+    glm::mat3 linear = glm::mat3(modelView);
+    float scale = std::max({glm::length(linear[0]), glm::length(linear[1]), glm::length(linear[2])});
+    glm::vec3 center = glm::vec3(modelView * glm::vec4(mCenter, 1.0f));
+
+    // View space depth of the nearest point, the camera looks down -z
+    float depth = -center.z - mRadius * scale;
+    if (depth <= 0.0f)
+        return std::numeric_limits<float>::infinity();
+
+    // projection[1][1] is cot(fovy / 2), the half viewport height spans depth / projection[1][1] units at depth
+    return scale * projection[1][1] * 0.5f * viewportHeight / depth;
+}
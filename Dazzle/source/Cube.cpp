@@ -1,11 +1,14 @@
+#include <iostream>
+
 #include <glm/gtc/constants.hpp>
 #include "glm/gtc/matrix_transform.hpp"
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Cube.hpp"
 
-Dazzle::Cube::Cube(float length) : mVAO(nullptr), mVBO(nullptr), mNVBO(nullptr), mTCVBO(nullptr), mEBO(nullptr)
+Dazzle::Cube::Cube(float length) : mVAO(nullptr), mVBO(nullptr), mEBO(nullptr), mIndexType(GL_UNSIGNED_INT)
 {
     // Half of the length of a cube's side.
     const float s = length / 2.0f;
@@ -149,6 +152,9 @@ Dazzle::Cube::Cube(float length) : mVAO(nullptr), mVBO(nullptr), mNVBO(nullptr),
         22, 23, 20,
     };
 
+    // Cache the number of indices so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
     // Transform
     mTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 }
@@ -158,15 +164,49 @@ void Dazzle::Cube::Draw() const
     if (!mVAO->IsValid())
         return;
 
+    // Without an instance buffer the shaders read the current InstanceTransform, which instanced draws leave undefined
+    if (mInstances == nullptr)
+        RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+
     // Draw
     glBindVertexArray(mVAO->GetHandle());
-    glDrawElements(GL_TRIANGLES, (GLsizei)GetIndices().size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0);
 
     // It's probably a good idea to unbind the VAO, to prevent making accidental changes to the
     // bound VAO in other places. However the driver complaints about a performance hit.
     // glBindVertexArray(0);
 }
 
+void Dazzle::Cube::SetInstanceTransforms(const std::vector<glm::mat4>& transforms)
+{
+    if (mVAO == nullptr)
+    {
+        std::cerr << "Cube: InitializeBuffers() must be called before setting instance transforms" << std::endl;
+        return;
+    }
+
+    if (mInstances == nullptr)
+    {
+        mInstances = std::make_unique<RenderSystem::GL::InstanceBuffer>();
+        mInstances->Attach(*mVAO);
+    }
+
+    mInstances->SetTransforms(transforms);
+}
+
+void Dazzle::Cube::DrawInstanced(GLuint firstInstance, GLsizei instanceCount) const
+{
+    if (!mVAO->IsValid() || mInstances == nullptr || mInstances->GetCount() == 0)
+        return;
+
+    if (instanceCount < 0)
+        instanceCount = mInstances->GetCount() - static_cast<GLsizei>(firstInstance);
+
+    // Draw the instances with a single call, the base instance offsets the per-instance attributes
+    glBindVertexArray(mVAO->GetHandle());
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0, instanceCount, firstInstance);
+}
+
 void Dazzle::Cube::SetPosition(glm::vec3 position)
 {
     mTransform[3] = glm::vec4(position, 1.0f);
@@ -183,96 +223,24 @@ void Dazzle::Cube::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Cube::InitializeBuffers()
+void Dazzle::Cube::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-    const GLuint kNormAttribIndex = 1;
-    const GLuint kNormBindingIndex = 1;
-    const GLuint kTexAttribIndex = 2;
-    const GLuint kTexBindingIndex = 2;
-
     mVAO = std::make_unique<RenderSystem::GL::VAO>();
     mVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mNVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mTCVBO = std::make_unique<RenderSystem::GL::VBO>();
     mEBO = std::make_unique<RenderSystem::GL::EBO>();
 
-    // Set up the data store for the Vertex Buffer Object
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Normals
-    glNamedBufferStorage(mNVBO->GetHandle(), GetNormals().size() * sizeof(float), GetNormals().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-    glNamedBufferStorage(mTCVBO->GetHandle(), GetTextureCoordinates().size() * sizeof(float), GetTextureCoordinates().data(), 0);
-
-    // Set up the data store for the Element Buffer Object
-    glNamedBufferStorage(mEBO->GetHandle(), GetIndices().size() * sizeof(unsigned int), GetIndices().data(), 0);
-
-    // Bind Vertex Buffer Object to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosBindingIndex,           // Binding Index
-                                mVBO->GetHandle(),          // Vertex Buffer Object
-                                kOffset,                    // Offset (Offset of the first element)
-                                3 * sizeof(float));         // Stride (Distance between elements within the buffer)
-
-    // Specify the format for the given attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex,            // (Vertex) Attribute Index
-                                kSize,                      // Size (Number of values per vertex that are stored in the array)
-                                kDataType,                  // Data Type
-                                kNormalized,                // Normalized (if parameter represents a normalized integer)
-                                kOffset);                   // Relative Offset
-
-    // Specify which vertex buffer binding to use for this attribute
-    glVertexArrayAttribBinding( mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex,            // (Vertex) Attribute Index
-                                kPosBindingIndex);          // Binding Index
-
-    // Enable the attribute
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex);           // (Vertex) Attribute Index
-
-    // Bind Vertex Buffer Object for Normals to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kNormBindingIndex, mNVBO->GetHandle(), kOffset, 3 * sizeof(float));
-
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kNormAttribIndex, kNormBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kNormAttribIndex);
-
-    // Bind Vertex Buffer Object for the Texture Coordinates to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTexBindingIndex, mTCVBO->GetHandle(), kOffset, 2 * sizeof(float));
-
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kTexAttribIndex, kTexBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTexAttribIndex);
-
-    // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
-    glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
-
-    // According to:
-    // https://www.khronos.org/opengl/wiki/Shader_Compilation#Program_setup
-    // "A number of parameters can be set up that will affect the linking process. This generally involves interfaces with the program. These include:"
-    // 1.Vertex shader input attribute locations.
-    // 2.Fragment shader output color numbers.
-    // 3. Transform feedback output capturing.
-    // 4. Program separation.
-    // "You cannot change these values after linking; if you don't set them before linking, you can't set them at all."
-    
-    // Thus, this cause the following warning call to the DebugMessageCallback:
-    // "Program/shader state performance warning: Vertex shader in program X is being recompiled based on GL state.""
-
-    // Since, DSA is being used to configure the VAO, there isn't anything bound to the state machine.
-    // So, a binding call should be made like: glEnableVertexAttribArray or glBindVertexArray. Before the linking process.
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetNormals(mNormals)
+           .SetTextureCoordinates(mTextureCoordinates)
+           .SetIndices(mIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
+
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
+
     glBindVertexArray(mVAO->GetHandle());
 }
\ No newline at end of file
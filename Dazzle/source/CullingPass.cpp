@@ -0,0 +1,256 @@
+#include <string>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "CullingPass.hpp"
+
+namespace
+{
+    const GLuint kGroupSize = 64; // Must match local_size_x in kCullingShaderSource
+
+    // One invocation per draw command of the queue. The base instance of a command is the id of its object.
+    const std::string kCullingShaderSource = R"(
+#version 460 core
+
+layout(local_size_x = 64) in;
+
+struct ObjectData
+{
+    mat4 Model;
+    mat4 Normal;
+    uint Material;
+};
+
+struct ObjectBounds
+{
+    vec4 Min;
+    vec4 Max;
+};
+
+struct DrawCommand
+{
+    uint Count;
+    uint InstanceCount;
+    uint FirstIndex;
+    int BaseVertex;
+    uint BaseInstance;
+};
+
+layout(std430, binding = 3) readonly buffer ObjectDataBlock { ObjectData objects[]; };
+layout(std430, binding = 4) readonly buffer ObjectBoundsBlock { ObjectBounds bounds[]; };
+layout(std430, binding = 5) readonly buffer CommandBlock { DrawCommand commands[]; };
+layout(std430, binding = 1) writeonly buffer VisibleCommandBlock { DrawCommand visibleCommands[]; };
+layout(std430, binding = 6) buffer VisibleCountBlock { uint VisibleCount; };
+
+layout(binding = 8) uniform sampler2D DepthPyramid;
+
+uniform mat4 ViewProjection;
+uniform mat4 PreviousViewProjection;    // View-projection the depth pyramid was rendered with
+uniform uint ObjectCount;
+uniform bool FrustumCulling;
+uniform bool OcclusionCulling;
+
+vec3 GetCorner(ObjectBounds box, int i)
+{
+    return vec3((i & 1) == 0 ? box.Min.x : box.Max.x,
+                (i & 2) == 0 ? box.Min.y : box.Max.y,
+                (i & 4) == 0 ? box.Min.z : box.Max.z);
+}
+
+// The box is outside when all of its corners are beyond the same clip plane
+bool IsInsideFrustum(ObjectBounds box, mat4 transform)
+{
+    bvec3 anyInsideMin = bvec3(false);
+    bvec3 anyInsideMax = bvec3(false);
+    for (int i = 0; i < 8; i++)
+    {
+        vec4 corner = transform * vec4(GetCorner(box, i), 1.0);
+        anyInsideMin = bvec3(ivec3(anyInsideMin) | ivec3(greaterThanEqual(corner.xyz, vec3(-corner.w))));
+        anyInsideMax = bvec3(ivec3(anyInsideMax) | ivec3(lessThanEqual(corner.xyz, vec3(corner.w))));
+    }
+
+    return all(anyInsideMin) && all(anyInsideMax);
+}
+
+// The box is hidden when its nearest depth is behind the farthest depth of every texel it covers
+bool IsOccluded(ObjectBounds box, mat4 transform)
+{
+    vec2 minimum = vec2(1.0);
+    vec2 maximum = vec2(0.0);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; i++)
+    {
+        vec4 corner = transform * vec4(GetCorner(box, i), 1.0);
+        if (corner.w <= 0.0)
+            return false; // The box crosses the camera plane
+
+        vec3 ndc = corner.xyz / corner.w;
+        minimum = min(minimum, ndc.xy * 0.5 + 0.5);
+        maximum = max(maximum, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+
+    ivec2 size = textureSize(DepthPyramid, 0);
+    vec2 first = clamp(minimum, 0.0, 1.0) * vec2(size);
+    vec2 last = clamp(maximum, 0.0, 1.0) * vec2(size);
+
+    // Pick the level where the footprint covers about two texels in each direction
+    vec2 extent = last - first;
+    int level = int(ceil(log2(max(max(extent.x, extent.y), 1.0))));
+    level = clamp(level, 0, textureQueryLevels(DepthPyramid) - 1);
+
+    ivec2 levelSize = textureSize(DepthPyramid, level);
+    ivec2 firstTexel = min(ivec2(first) >> level, levelSize - 1);
+    ivec2 lastTexel = min(ivec2(last) >> level, levelSize - 1);
+
+    float farthest = 0.0;
+    for (int y = firstTexel.y; y <= lastTexel.y; y++)
+    {
+        for (int x = firstTexel.x; x <= lastTexel.x; x++)
+            farthest = max(farthest, texelFetch(DepthPyramid, ivec2(x, y), level).r);
+    }
+
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= ObjectCount)
+        return;
+
+    DrawCommand command = commands[index];
+    uint object = command.BaseInstance;
+    mat4 model = objects[object].Model;
+    ObjectBounds box = bounds[object];
+
+    bool visible = true;
+    if (FrustumCulling)
+        visible = IsInsideFrustum(box, ViewProjection * model);
+    if (visible && OcclusionCulling)
+        visible = !IsOccluded(box, PreviousViewProjection * model);
+
+    if (visible)
+        visibleCommands[atomicAdd(VisibleCount, 1u)] = command;
+}
+)";
+}
+
+Dazzle::RenderSystem::GL::CullingPass::CullingPass() :  mViewProjectionLocation(-1), mPreviousViewProjectionLocation(-1), mObjectCountLocation(-1),
+                                                        mFrustumCullingLocation(-1), mOcclusionCullingLocation(-1),
+                                                        mVisibleCommandBuffer(0), mCapacity(0), mCountBuffer(0), mReadbackBuffers(), mReadbackSubmitted(),
+                                                        mFrameIndex(0), mSubmittedCount(0), mVisibleCount(0), mPreviousViewProjection(1.0f),
+                                                        mHasPrevious(false), mFrustumCulling(true), mOcclusionCulling(true)
+{
+
+}
+
+Dazzle::RenderSystem::GL::CullingPass::~CullingPass()
+{
+    if (mVisibleCommandBuffer > 0)
+        glDeleteBuffers(1, &mVisibleCommandBuffer);
+    if (mCountBuffer > 0)
+        glDeleteBuffers(1, &mCountBuffer);
+    if (mReadbackBuffers[0] > 0)
+        glDeleteBuffers(kReadbackLatency, mReadbackBuffers);
+}
+
+void Dazzle::RenderSystem::GL::CullingPass::Initialize()
+{
+    // Buffers
+    if (mCountBuffer == 0)
+    {
+        const GLuint zero = 0;
+        glCreateBuffers(1, &mVisibleCommandBuffer);
+        glCreateBuffers(1, &mCountBuffer);
+        glNamedBufferStorage(mCountBuffer, sizeof(GLuint), &zero, GL_DYNAMIC_STORAGE_BIT);
+
+        glCreateBuffers(kReadbackLatency, mReadbackBuffers);
+        for (GLuint buffer : mReadbackBuffers)
+            glNamedBufferStorage(buffer, sizeof(GLuint), &zero, GL_CLIENT_STORAGE_BIT);
+    }
+
+    // Compute Program
+    if (!mProgram.IsValid())
+    {
+        mProgram.Initialize();
+        ProgramBuilder::Build(mProgram, {{GL_COMPUTE_SHADER, kCullingShaderSource}});
+
+        mViewProjectionLocation = glGetUniformLocation(mProgram.GetHandle(), "ViewProjection");
+        mPreviousViewProjectionLocation = glGetUniformLocation(mProgram.GetHandle(), "PreviousViewProjection");
+        mObjectCountLocation = glGetUniformLocation(mProgram.GetHandle(), "ObjectCount");
+        mFrustumCullingLocation = glGetUniformLocation(mProgram.GetHandle(), "FrustumCulling");
+        mOcclusionCullingLocation = glGetUniformLocation(mProgram.GetHandle(), "OcclusionCulling");
+    }
+}
+
+void Dazzle::RenderSystem::GL::CullingPass::Cull(const RenderQueue& queue, const glm::mat4& viewProjection, const DepthPyramid* pyramid)
+{
+    if (!IsValid())
+        return;
+
+    // Counters of the culling issued kReadbackLatency frames ago, the GPU should be done with them by now
+    GLuint readback = mReadbackBuffers[mFrameIndex];
+    glGetNamedBufferSubData(readback, 0, sizeof(GLuint), &mVisibleCount);
+    mSubmittedCount = mReadbackSubmitted[mFrameIndex];
+
+    const GLuint objectCount = static_cast<GLuint>(queue.GetObjectCount());
+    const GLsizeiptr size = objectCount * sizeof(DrawElementsIndirectCommand);
+    if (size > mCapacity)
+    {
+        glNamedBufferData(mVisibleCommandBuffer, size, nullptr, GL_DYNAMIC_DRAW);
+        mCapacity = size;
+    }
+
+    // The occlusion test needs a pyramid and the view-projection it was rendered with
+    const bool occlusionCulling = mOcclusionCulling && mHasPrevious && pyramid != nullptr && pyramid->IsBuilt();
+
+    glProgramUniformMatrix4fv(mProgram.GetHandle(), mViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    glProgramUniformMatrix4fv(mProgram.GetHandle(), mPreviousViewProjectionLocation, 1, GL_FALSE, glm::value_ptr(mPreviousViewProjection));
+    glProgramUniform1ui(mProgram.GetHandle(), mObjectCountLocation, objectCount);
+    glProgramUniform1i(mProgram.GetHandle(), mFrustumCullingLocation, mFrustumCulling ? 1 : 0);
+    glProgramUniform1i(mProgram.GetHandle(), mOcclusionCullingLocation, occlusionCulling ? 1 : 0);
+
+    const GLuint zero = 0;
+    glClearNamedBufferData(mCountBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    // The caller's program is restored afterwards so its uniform state keeps working.
+    GLint currentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+    queue.Bind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandsBinding, queue.GetCommandBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleCommandsBinding, mVisibleCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVisibleCountBinding, mCountBuffer);
+    if (occlusionCulling)
+        glBindTextureUnit(DepthPyramid::kDepthTextureUnit, pyramid->GetTexture());
+
+    glUseProgram(mProgram.GetHandle());
+    glDispatchCompute((objectCount + kGroupSize - 1) / kGroupSize, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glCopyNamedBufferSubData(mCountBuffer, readback, 0, 0, sizeof(GLuint));
+    mReadbackSubmitted[mFrameIndex] = objectCount;
+    mFrameIndex = (mFrameIndex + 1) % kReadbackLatency;
+
+    glUseProgram(static_cast<GLuint>(currentProgram));
+
+    mPreviousViewProjection = viewProjection;
+    mHasPrevious = true;
+}
+
+void Dazzle::RenderSystem::GL::CullingPass::Submit(const RenderQueue& queue) const
+{
+    if (!IsValid() || queue.GetObjectCount() == 0)
+        return;
+
+    queue.Bind();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mVisibleCommandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, mCountBuffer);
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, queue.GetObjectCount(), 0);
+}
+
+bool Dazzle::RenderSystem::GL::CullingPass::IsValid() const
+{
+    return mCountBuffer > 0 && mProgram.IsValid();
+}
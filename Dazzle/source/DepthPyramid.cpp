@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "DepthPyramid.hpp"
+
+namespace
+{
+    const GLuint kGroupSize = 8; // Must match local_size_x/y of the shaders below
+
+    // Level 0: Copy of the depth texture.
+    const std::string kCopyShaderSource = R"(
+#version 460 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 8) uniform sampler2D DepthTexture;
+layout(r32f, binding = 7) writeonly uniform image2D Target;
+
+void main()
+{
+    ivec2 coordinates = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(coordinates, imageSize(Target))))
+        return;
+
+    imageStore(Target, coordinates, vec4(texelFetch(DepthTexture, coordinates, 0).r));
+}
+)";
+
+    // Level N: Farthest depth of the texels covered in level N - 1. When the size of the level below is odd,
+    // the last row and column of texels also cover its extra row and column, so no texel is ever skipped.
+    const std::string kReduceShaderSource = R"(
+#version 460 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 6) readonly uniform image2D Source;
+layout(r32f, binding = 7) writeonly uniform image2D Target;
+
+void main()
+{
+    ivec2 coordinates = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 targetSize = imageSize(Target);
+    if (any(greaterThanEqual(coordinates, targetSize)))
+        return;
+
+    ivec2 sourceSize = imageSize(Source);
+    ivec2 first = coordinates * 2;
+    ivec2 last = min(first + 1, sourceSize - 1);
+    if (coordinates.x == targetSize.x - 1)
+        last.x = sourceSize.x - 1;
+    if (coordinates.y == targetSize.y - 1)
+        last.y = sourceSize.y - 1;
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; y++)
+    {
+        for (int x = first.x; x <= last.x; x++)
+            depth = max(depth, imageLoad(Source, ivec2(x, y)).r);
+    }
+
+    imageStore(Target, coordinates, vec4(depth));
+}
+)";
+
+    GLuint GetGroupCount(GLsizei size)
+    {
+        return (static_cast<GLuint>(size) + kGroupSize - 1) / kGroupSize;
+    }
+}
+
+Dazzle::RenderSystem::GL::DepthPyramid::DepthPyramid() :   mWidth(0), mHeight(0), mLevelCount(0), mBuilt(false), mTexture(0)
+{
+
+}
+
+Dazzle::RenderSystem::GL::DepthPyramid::~DepthPyramid()
+{
+    if (mTexture > 0)
+        glDeleteTextures(1, &mTexture);
+}
+
+void Dazzle::RenderSystem::GL::DepthPyramid::Initialize(GLsizei width, GLsizei height)
+{
+    mWidth = std::max(width, 1);
+    mHeight = std::max(height, 1);
+    mLevelCount = static_cast<GLint>(std::floor(std::log2(std::max(mWidth, mHeight)))) + 1;
+    mBuilt = false;
+
+    // Texture
+    if (mTexture > 0)
+        glDeleteTextures(1, &mTexture);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &mTexture);
+    glTextureStorage2D(mTexture, mLevelCount, GL_R32F, mWidth, mHeight);
+    glTextureParameteri(mTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(mTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(mTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(mTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Compute Programs, both are submitted before waiting so the driver can compile them in parallel
+    AsyncProgramBuilder builder;
+    if (!mCopyProgram.IsValid())
+    {
+        mCopyProgram.Initialize();
+        builder.Add(mCopyProgram, {{GL_COMPUTE_SHADER, kCopyShaderSource}});
+    }
+
+    if (!mReduceProgram.IsValid())
+    {
+        mReduceProgram.Initialize();
+        builder.Add(mReduceProgram, {{GL_COMPUTE_SHADER, kReduceShaderSource}});
+    }
+    builder.Wait();
+}
+
+void Dazzle::RenderSystem::GL::DepthPyramid::Build(GLuint depthTexture)
+{
+    if (!IsValid())
+        return;
+
+    // The caller's program is restored afterwards so its uniform state keeps working.
+    GLint currentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+    glUseProgram(mCopyProgram.GetHandle());
+    glBindTextureUnit(kDepthTextureUnit, depthTexture);
+    glBindImageTexture(kTargetImageUnit, mTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute(GetGroupCount(mWidth), GetGroupCount(mHeight), 1);
+
+    glUseProgram(mReduceProgram.GetHandle());
+    for (GLint level = 1; level < mLevelCount; level++)
+    {
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        GLsizei width = std::max(mWidth >> level, 1);
+        GLsizei height = std::max(mHeight >> level, 1);
+        glBindImageTexture(kSourceImageUnit, mTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+        glBindImageTexture(kTargetImageUnit, mTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(GetGroupCount(width), GetGroupCount(height), 1);
+    }
+
+    // The culling pass samples the pyramid with texelFetch
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glUseProgram(static_cast<GLuint>(currentProgram));
+    mBuilt = true;
+}
+
+bool Dazzle::RenderSystem::GL::DepthPyramid::IsValid() const
+{
+    return mTexture > 0 && mCopyProgram.IsValid() && mReduceProgram.IsValid();
+}
@@ -1,7 +1,23 @@
 #include <stdexcept>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "FileManager.hpp"
 #include "Utilities.hpp"
 
@@ -52,3 +68,87 @@ void Dazzle::FileManager::WriteBinary(const std::string& path, const char* data,
     outputStream.write(data, length);
     outputStream.close();
 }
+
+#ifdef _WIN32
+Dazzle::MappedFile::MappedFile() : mData(nullptr), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(nullptr)
+#else
+Dazzle::MappedFile::MappedFile() : mData(nullptr), mSize(0)
+#endif
+{
+
+}
+
+Dazzle::MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool Dazzle::MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#ifdef _WIN32
+    mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER size = {};
+    if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+    {
+        std::cerr << "MappedFile: Unable to open " << path << std::endl;
+        Close();
+        return false;
+    }
+
+    mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping != nullptr)
+        mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    mSize = static_cast<size_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status = {};
+    if (file < 0 || fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        std::cerr << "MappedFile: Unable to open " << path << std::endl;
+        if (file >= 0)
+            close(file);
+        return false;
+    }
+
+    // The mapping keeps its own reference to the file, the descriptor isn't needed past mmap()
+    mSize = static_cast<size_t>(status.st_size);
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data != MAP_FAILED)
+    {
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<const char*>(data);
+    }
+#endif
+
+    if (mData == nullptr)
+    {
+        std::cerr << "MappedFile: Unable to map " << path << std::endl;
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void Dazzle::MappedFile::Close()
+{
+#ifdef _WIN32
+    if (mData != nullptr)
+        UnmapViewOfFile(mData);
+    if (mMapping != nullptr)
+        CloseHandle(mMapping);
+    if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = INVALID_HANDLE_VALUE;
+#else
+    if (mData != nullptr)
+        munmap(const_cast<char*>(mData), mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
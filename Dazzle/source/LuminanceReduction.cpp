@@ -0,0 +1,243 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "LuminanceReduction.hpp"
+
+namespace
+{
+    const GLuint kTileSize = 16; // Must match local_size_x/y in kTileShaderSource
+    const GLuint kFinalGroupSize = 256; // Must match local_size_x in kFinalShaderSource
+
+    // Pass #1: Every work group reduces a 16x16 tile of the HDR texture into a single sum of log(luminance).
+    const std::string kTileShaderSource = R"(
+#version 460 core
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 7) uniform sampler2D HDRTexture;
+
+layout(std430, binding = 6) writeonly buffer PartialsBuffer
+{
+    float Partials[];
+};
+
+shared float Samples[256];
+
+void main()
+{
+    ivec2 size = textureSize(HDRTexture, 0);
+    ivec2 coordinates = ivec2(gl_GlobalInvocationID.xy);
+    uint index = gl_LocalInvocationIndex;
+
+    // Calculate luminance using the Rec. 709 formula, texels outside of the texture don't contribute.
+    float value = 0.0;
+    if (all(lessThan(coordinates, size)))
+    {
+        vec3 color = texelFetch(HDRTexture, coordinates, 0).rgb;
+        value = log(dot(color, vec3(0.2126, 0.7152, 0.0722)) + 0.00001); // Avoid log(0)
+    }
+
+    Samples[index] = value;
+    barrier();
+
+    for (uint stride = 128u; stride > 0u; stride >>= 1u)
+    {
+        if (index < stride)
+            Samples[index] += Samples[index + stride];
+        barrier();
+    }
+
+    if (index == 0u)
+        Partials[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = Samples[0];
+}
+)";
+
+    // Pass #2: A single work group reduces all the partial sums and stores the log-average luminance.
+    const std::string kFinalShaderSource = R"(
+#version 460 core
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 6) readonly buffer PartialsBuffer
+{
+    float Partials[];
+};
+
+layout(std430, binding = 7) buffer LuminanceBuffer
+{
+    float AverageLuminance;
+    float AdaptedLuminance;
+};
+
+uniform uint PartialCount;  // Number of partial sums written by the first pass
+uniform float PixelCount;   // Number of texels reduced
+uniform float Adaptation;   // Blend factor towards the new luminance, 1.0 = no adaptation
+
+shared float Samples[256];
+
+void main()
+{
+    uint index = gl_LocalInvocationIndex;
+
+    float sum = 0.0;
+    for (uint i = index; i < PartialCount; i += 256u)
+        sum += Partials[i];
+
+    Samples[index] = sum;
+    barrier();
+
+    for (uint stride = 128u; stride > 0u; stride >>= 1u)
+    {
+        if (index < stride)
+            Samples[index] += Samples[index + stride];
+        barrier();
+    }
+
+    if (index == 0u)
+    {
+        float average = exp(Samples[0] / PixelCount);
+        float previous = AdaptedLuminance;
+        AverageLuminance = average;
+        AdaptedLuminance = (previous > 0.0) ? mix(previous, average, Adaptation) : average;
+    }
+}
+)";
+}
+
+Dazzle::RenderSystem::GL::LuminanceReduction::LuminanceReduction() :   mWidth(0), mHeight(0), mGroupsX(0), mGroupsY(0),
+                                                                        mAdaptationRate(0.0f), mPartialsBuffer(0), mResultBuffer(0),
+                                                                        mPartialCountLocation(-1), mPixelCountLocation(-1), mAdaptationLocation(-1)
+{
+
+}
+
+Dazzle::RenderSystem::GL::LuminanceReduction::~LuminanceReduction()
+{
+    if (mPartialsBuffer > 0)
+        glDeleteBuffers(1, &mPartialsBuffer);
+    if (mResultBuffer > 0)
+        glDeleteBuffers(1, &mResultBuffer);
+}
+
+void Dazzle::RenderSystem::GL::LuminanceReduction::Initialize(GLsizei width, GLsizei height)
+{
+    mWidth = width;
+    mHeight = height;
+    mGroupsX = (width + kTileSize - 1) / kTileSize;
+    mGroupsY = (height + kTileSize - 1) / kTileSize;
+
+    // Buffers
+    if (mPartialsBuffer > 0)
+        glDeleteBuffers(1, &mPartialsBuffer);
+    if (mResultBuffer > 0)
+        glDeleteBuffers(1, &mResultBuffer);
+
+    const float initialResult[2] = {1.0f, 0.0f}; // AdaptedLuminance = 0 makes the first frame adopt the average directly
+    glCreateBuffers(1, &mPartialsBuffer);
+    glNamedBufferStorage(mPartialsBuffer, mGroupsX * mGroupsY * sizeof(float), nullptr, 0);
+    glCreateBuffers(1, &mResultBuffer);
+    glNamedBufferStorage(mResultBuffer, sizeof(initialResult), initialResult, GL_DYNAMIC_STORAGE_BIT);
+
+    // Compute Programs, both are submitted before waiting so the driver can compile them in parallel
+    AsyncProgramBuilder builder;
+    if (!mTileProgram.IsValid())
+    {
+        mTileProgram.Initialize();
+        builder.Add(mTileProgram, {{GL_COMPUTE_SHADER, kTileShaderSource}});
+    }
+
+    if (!mFinalProgram.IsValid())
+    {
+        mFinalProgram.Initialize();
+        builder.Add(mFinalProgram, {{GL_COMPUTE_SHADER, kFinalShaderSource}});
+        builder.Wait();
+
+        mPartialCountLocation = glGetUniformLocation(mFinalProgram.GetHandle(), "PartialCount");
+        mPixelCountLocation = glGetUniformLocation(mFinalProgram.GetHandle(), "PixelCount");
+        mAdaptationLocation = glGetUniformLocation(mFinalProgram.GetHandle(), "Adaptation");
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kResultBinding, mResultBuffer);
+}
+
+void Dazzle::RenderSystem::GL::LuminanceReduction::Compute(GLuint hdrTexture, float deltaTime)
+{
+    if (!IsValid())
+        return;
+
+    // Exponential eye adaptation, framerate independent.
+    float adaptation = 1.0f;
+    if (mAdaptationRate > 0.0f && deltaTime > 0.0f)
+        adaptation = 1.0f - std::exp(-deltaTime * mAdaptationRate);
+
+    glProgramUniform1ui(mFinalProgram.GetHandle(), mPartialCountLocation, mGroupsX * mGroupsY);
+    glProgramUniform1f(mFinalProgram.GetHandle(), mPixelCountLocation, static_cast<float>(mWidth) * static_cast<float>(mHeight));
+    glProgramUniform1f(mFinalProgram.GetHandle(), mAdaptationLocation, adaptation);
+
+    // The caller's program is restored afterwards so its uniform state keeps working.
+    GLint currentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+    glBindTextureUnit(kTextureUnit, hdrTexture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPartialsBinding, mPartialsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kResultBinding, mResultBuffer);
+
+    glUseProgram(mTileProgram.GetHandle());
+    glDispatchCompute(mGroupsX, mGroupsY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(mFinalProgram.GetHandle());
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(static_cast<GLuint>(currentProgram));
+}
+
+void Dazzle::RenderSystem::GL::LuminanceReduction::SetAverageLuminance(float luminance)
+{
+    if (!IsValid())
+        return;
+
+    const float result[2] = {luminance, luminance};
+    glNamedBufferSubData(mResultBuffer, 0, sizeof(result), result);
+}
+
+float Dazzle::RenderSystem::GL::LuminanceReduction::ReadAverageLuminance() const
+{
+    float luminance = 0.0f;
+    if (IsValid())
+        glGetNamedBufferSubData(mResultBuffer, 0, sizeof(float), &luminance);
+    return luminance;
+}
+
+bool Dazzle::RenderSystem::GL::LuminanceReduction::IsValid() const
+{
+    return mResultBuffer > 0 && mTileProgram.IsValid() && mFinalProgram.IsValid();
+}
+
+float Dazzle::RenderSystem::GL::LuminanceReduction::CalculateReference(const float* rgb, size_t pixelCount)
+{
+    if (rgb == nullptr || pixelCount == 0)
+        return 0.0f;
+
+    // Accumulate in double precision so the reference doesn't drift on large images.
+    double sum = 0.0;
+    for (size_t i = 0; i < pixelCount * 3; i += 3)
+    {
+        // Calculate luminance using the Rec. 709 formula
+        float luminance = 0.2126f * rgb[i] + 0.7152f * rgb[i + 1] + 0.0722f * rgb[i + 2];
+        sum += std::log(luminance + 0.00001f); // Avoid log(0)
+    }
+
+    return static_cast<float>(std::exp(sum / static_cast<double>(pixelCount)));
+}
+
+float Dazzle::RenderSystem::GL::LuminanceReduction::CalculateReference(GLuint hdrTexture, GLsizei width, GLsizei height)
+{
+    size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+    std::vector<float> textureData(pixelCount * 3); // RGB data for each pixel
+    glGetTextureImage(hdrTexture, 0, GL_RGB, GL_FLOAT, static_cast<GLsizei>(textureData.size() * sizeof(float)), textureData.data());
+    return CalculateReference(textureData.data(), pixelCount);
+}
@@ -1,11 +1,23 @@
+#include <iostream>
+
 #include <glm/gtc/constants.hpp>
 #include "glm/gtc/matrix_transform.hpp"
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Mesh.hpp"
 
-Dazzle::Mesh::Mesh() : mTransform(glm::mat4(1.0))
+namespace
+{
+    const void* GetIndexOffset(unsigned int firstIndex, GLenum indexType)
+    {
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        return reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex) * indexSize);
+    }
+}
+
+Dazzle::Mesh::Mesh() : mDrawCount(0), mFirstIndex(0), mLOD(0), mTransform(glm::mat4(1.0)), mIndexType(GL_UNSIGNED_INT)
 {
 
 }
@@ -15,9 +27,49 @@ void Dazzle::Mesh::Draw() const
     if (mVAO == nullptr || !mVAO->IsValid())
         return;
 
+    // Without an instance buffer the shaders read the current InstanceTransform, which instanced draws leave undefined
+    if (mInstances == nullptr)
+        RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+
     // Draw
     glBindVertexArray(mVAO->GetHandle());
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)GetVertices().size());
+    if (mEBO != nullptr)
+        glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, GetIndexOffset(mFirstIndex, mIndexType));
+    else
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)mDrawCount);
+}
+
+void Dazzle::Mesh::SetInstanceTransforms(const std::vector<glm::mat4>& transforms)
+{
+    if (mVAO == nullptr)
+    {
+        std::cerr << "Mesh: InitializeBuffers() must be called before setting instance transforms" << std::endl;
+        return;
+    }
+
+    if (mInstances == nullptr)
+    {
+        mInstances = std::make_unique<RenderSystem::GL::InstanceBuffer>();
+        mInstances->Attach(*mVAO);
+    }
+
+    mInstances->SetTransforms(transforms);
+}
+
+void Dazzle::Mesh::DrawInstanced(GLuint firstInstance, GLsizei instanceCount) const
+{
+    if (mVAO == nullptr || !mVAO->IsValid() || mInstances == nullptr || mInstances->GetCount() == 0)
+        return;
+
+    if (instanceCount < 0)
+        instanceCount = mInstances->GetCount() - static_cast<GLsizei>(firstInstance);
+
+    // Draw the instances with a single call, the base instance offsets the per-instance attributes
+    glBindVertexArray(mVAO->GetHandle());
+    if (mEBO != nullptr)
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, GetIndexOffset(mFirstIndex, mIndexType), instanceCount, firstInstance);
+    else
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, (GLsizei)mDrawCount, instanceCount, firstInstance);
 }
 
 void Dazzle::Mesh::SetPosition(glm::vec3 position)
@@ -36,107 +88,137 @@ void Dazzle::Mesh::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Mesh::InitializeBuffers()
+const Dazzle::MeshOptimizationReport& Dazzle::Mesh::Optimize()
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    // Vertices
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-    // Normals
-    const GLuint kNormAttribIndex = 1;
-    const GLuint kNormBindingIndex = 1;
-    // Texture Coordinates
-    const GLuint kTexAttribIndex = 2;
-    const GLuint kTexBindingIndex = 2;
-    // Tangents
-    const GLuint kTangAttribIndex = 3;
-    const GLuint kTangBindingIndex = 3;
-    // Bitangents
-    const GLuint kBitanAttribIndex = 4;
-    const GLuint kBitanBindingIndex = 4;
+    if (mIndices.empty() || mVertices.empty())
+        return mOptimizationReport;
 
-    if (mVertices.empty())
+    // Levels generated before would address the vertices in their old order
+    mLODIndices.clear();
+    mOptimizationReport = MeshOptimizer::Optimize(mIndices, mVertices, {&mNormals, &mTextureCoordinates, &mTangents, &mBitangents});
+    return mOptimizationReport;
+}
+
+void Dazzle::Mesh::GenerateLODs(unsigned int levelCount, float maxError)
+{
+    if (mIndices.empty() || mVertices.empty())
         return;
 
-    mVAO = std::make_unique<RenderSystem::GL::VAO>();
-    mVBO = std::make_unique<RenderSystem::GL::VBO>();
+    mLODIndices = MeshOptimizer::GenerateLODs(mIndices, mVertices, levelCount, 0.5f, maxError);
+}
 
-    if (!mNormals.empty())
-        mNVBO = std::make_unique<RenderSystem::GL::VBO>();
-    if (!mTextureCoordinates.empty())
-        mTCVBO = std::make_unique<RenderSystem::GL::VBO>();
-    if (!mTangents.empty())
-        mTVBO = std::make_unique<RenderSystem::GL::VBO>();
-    if (!mBitangents.empty())
-        mBVBO = std::make_unique<RenderSystem::GL::VBO>();
+void Dazzle::Mesh::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
+{
+    if (mVertices.empty())
+        return;
 
+    // Cache the number of indices, or vertices (3 floats each) when the mesh isn't indexed, so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.empty() ? mVertices.size() / 3 : mIndices.size());
+    mFirstIndex = 0;
+    mLOD = 0;
+    mLODs.clear();
 
-    // Set up the data store for the Vertex Buffer Object
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
+    // Generated levels follow the full resolution indices in the element buffer
+    std::vector<unsigned int> lodIndices;
+    if (!mIndices.empty() && !mLODIndices.empty())
+    {
+        lodIndices = mIndices;
+        mLODs.push_back({0, static_cast<std::uint32_t>(mIndices.size()), 0.0f, 0});
+        for (const auto& lod : mLODIndices)
+        {
+            mLODs.push_back({static_cast<std::uint32_t>(lodIndices.size()), static_cast<std::uint32_t>(lod.mIndices.size()), lod.mError, 0});
+            lodIndices.insert(lodIndices.end(), lod.mIndices.begin(), lod.mIndices.end());
+        }
+    }
 
-    // Set up the data store for the Vertex Buffer Object for Normals
-    if (mNVBO != nullptr)
-        glNamedBufferStorage(mNVBO->GetHandle(), GetNormals().size() * sizeof(float), GetNormals().data(), 0);
+    mVAO = std::make_unique<RenderSystem::GL::VAO>();
+    mVBO = std::make_unique<RenderSystem::GL::VBO>();
+    mEBO = mIndices.empty() ? nullptr : std::make_unique<RenderSystem::GL::EBO>();
+
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetNormals(mNormals)
+           .SetTextureCoordinates(mTextureCoordinates)
+           .SetTangents(mTangents)
+           .SetBitangents(mBitangents)
+           .SetIndices(lodIndices.empty() ? mIndices : lodIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
+
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
 
-    // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-    if (mTCVBO != nullptr)
-        glNamedBufferStorage(mTCVBO->GetHandle(), GetTextureCoordinates().size() * sizeof(float), GetTextureCoordinates().data(), 0);
+    glBindVertexArray(mVAO->GetHandle());
+}
 
-    // Set up the data store for the Vertex Buffer Object for Tangents
-    if (mTVBO != nullptr)
-        glNamedBufferStorage(mTVBO->GetHandle(), GetTangents().size() * sizeof(float), GetTangents().data(), 0);
+bool Dazzle::Mesh::Save(const std::string& path, const RenderSystem::GL::VertexPacking& packing, const std::vector<MeshLOD>& lods) const
+{
+    return MeshFile::Write(path, *this, packing, lods.empty() ? mLODIndices : lods);
+}
 
-    // Set up the data store for the Vertex Buffer Object for Bitangents
-    if (mBVBO != nullptr)
-        glNamedBufferStorage(mBVBO->GetHandle(), GetBitangents().size() * sizeof(float), GetBitangents().data(), 0);
+bool Dazzle::Mesh::Load(const std::string& path)
+{
+    MeshFile file;
+    if (!file.Open(path))
+        return false;
 
-    // VBO
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kPosBindingIndex, mVBO->GetHandle(), kOffset, 3 * sizeof(float));
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kPosAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kPosAttribIndex, kPosBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kPosAttribIndex);
+    const MeshFileHeader& header = file.GetHeader();
+    RenderSystem::GL::VertexLayout layout = file.GetLayout();
 
-    // Normals
-    if (mNVBO != nullptr)
-    {
-        glVertexArrayVertexBuffer(  mVAO->GetHandle(), kNormBindingIndex, mNVBO->GetHandle(), kOffset, 3 * sizeof(float));
-        glVertexArrayAttribFormat(  mVAO->GetHandle(), kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding( mVAO->GetHandle(), kNormAttribIndex, kNormBindingIndex);
-        glEnableVertexArrayAttrib(  mVAO->GetHandle(), kNormAttribIndex);
-    }
+    mVAO = std::make_unique<RenderSystem::GL::VAO>();
+    mVBO = std::make_unique<RenderSystem::GL::VBO>();
+    mEBO = header.mIndexCount == 0 ? nullptr : std::make_unique<RenderSystem::GL::EBO>();
+    mInstances.reset();
 
-    // Texture Coordinates
-    if (mTCVBO != nullptr)
-    {
-        glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTexBindingIndex, mTCVBO->GetHandle(), kOffset, 2 * sizeof(float));
-        glVertexArrayAttribFormat(  mVAO->GetHandle(), kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding( mVAO->GetHandle(), kTexAttribIndex, kTexBindingIndex);
-        glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTexAttribIndex);
-    }
+    // Straight from the mapped file to the GPU, the driver does the only copy
+    glNamedBufferStorage(mVBO->GetHandle(), header.mVertexSize, file.GetVertexData(), 0);
+    glVertexArrayVertexBuffer(mVAO->GetHandle(), 0, mVBO->GetHandle(), 0, header.mStride);
+    layout.Apply(mVAO->GetHandle(), 0);
 
-    // Tangents
-    if (mTVBO != nullptr)
+    if (mEBO != nullptr)
     {
-        glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTangBindingIndex, mTVBO->GetHandle(), kOffset, 4 * sizeof(float));
-        glVertexArrayAttribFormat(  mVAO->GetHandle(), kTangAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding( mVAO->GetHandle(), kTangAttribIndex, kTangBindingIndex);
-        glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTangAttribIndex);
+        glNamedBufferStorage(mEBO->GetHandle(), header.mIndexSize, file.GetIndexData(), 0);
+        glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
     }
 
-    // Bitangents
-    if (mBVBO != nullptr)
-    {
-        glVertexArrayVertexBuffer(  mVAO->GetHandle(), kBitanBindingIndex, mBVBO->GetHandle(), kOffset, 3 * sizeof(float));
-        glVertexArrayAttribFormat(  mVAO->GetHandle(), kBitanAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding( mVAO->GetHandle(), kBitanAttribIndex, kBitanBindingIndex);
-        glEnableVertexArrayAttrib(  mVAO->GetHandle(), kBitanAttribIndex);
-    }
+    mIndexType = header.mIndexType;
+    mLODs.assign(file.GetLODs(), file.GetLODs() + header.mLODCount);
+    mFirstIndex = 0;
+    mLOD = 0;
+    mDrawCount = mLODs.empty() ? header.mVertexCount : mLODs[0].mIndexCount;
+    mBounds = file.GetBounds();
+
+    mMemoryReport = RenderSystem::GL::VertexMemoryReport();
+    mMemoryReport.mBytesAfter = header.mVertexSize + header.mIndexSize;
+    mMemoryReport.mBufferObjectsAfter = mEBO != nullptr ? 2 : 1;
 
     glBindVertexArray(mVAO->GetHandle());
-}
\ No newline at end of file
+    return true;
+}
+
+void Dazzle::Mesh::SetLOD(unsigned int level)
+{
+    if (level >= mLODs.size())
+        return;
+
+    mLOD = level;
+    mFirstIndex = mLODs[level].mFirstIndex;
+    mDrawCount = mLODs[level].mIndexCount;
+}
+
+unsigned int Dazzle::Mesh::SelectLOD(const glm::mat4& modelView, const glm::mat4& projection, float viewportHeight, float threshold)
+{
+    if (mLODs.empty())
+        return 0;
+
+    // Errors grow with the level, the first one too coarse ends the search
+    const float pixels = mBounds.mRadius * mBounds.GetProjectedScale(modelView, projection, viewportHeight);
+    unsigned int level = 0;
+    while (level + 1 < mLODs.size() && mLODs[level + 1].mError * pixels <= threshold)
+        ++level;
+
+    SetLOD(level);
+    return level;
+}
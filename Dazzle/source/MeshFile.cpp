@@ -0,0 +1,234 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "MeshFile.hpp"
+
+namespace
+{
+    const size_t kMaxShortIndexVertices = 65536;
+
+    // FNV-1a over raw bytes
+    std::uint64_t Checksum(const char* data, size_t size)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::uint64_t Align(std::uint64_t offset)
+    {
+        return (offset + Dazzle::kMeshFileAlignment - 1) / Dazzle::kMeshFileAlignment * Dazzle::kMeshFileAlignment;
+    }
+
+    template <typename T>
+    void Append(std::vector<char>& file, const T* data, size_t count)
+    {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        file.insert(file.end(), bytes, bytes + count * sizeof(T));
+    }
+}
+
+Dazzle::MeshFile::MeshFile() : mHeader(nullptr), mAttributes(nullptr), mLODs(nullptr)
+{
+
+}
+
+bool Dazzle::MeshFile::Write(const std::string& path, const Object3D& object, const RenderSystem::GL::VertexPacking& packing, const std::vector<MeshLOD>& lods)
+{
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(object.GetVertices())
+           .SetNormals(object.GetNormals())
+           .SetTextureCoordinates(object.GetTextureCoordinates())
+           .SetTangents(object.GetTangents())
+           .SetBitangents(object.GetBitangents())
+           .SetPacking(packing);
+
+    std::vector<unsigned char> vertexData;
+    if (!builder.Interleave(vertexData))
+        return false;
+
+    const size_t vertexCount = object.GetVertices().size() / 3;
+    const auto& layout = builder.GetLayout();
+
+    // LOD 0 is the object itself, every level shares the vertices
+    std::vector<MeshFileLOD> levels;
+    std::vector<unsigned int> indices;
+    auto addLevel = [&](const std::vector<unsigned int>& levelIndices, float error)
+    {
+        if (levelIndices.empty())
+            return;
+
+        MeshFileLOD level = {};
+        level.mFirstIndex = static_cast<std::uint32_t>(indices.size());
+        level.mIndexCount = static_cast<std::uint32_t>(levelIndices.size());
+        level.mError = error;
+        levels.push_back(level);
+        indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+    };
+
+    addLevel(object.GetIndices(), 0.0f);
+    if (!levels.empty())
+    {
+        for (const auto& lod : lods)
+            addLevel(lod.mIndices, lod.mError);
+    }
+
+    const bool shortIndices = packing.mShortIndices && vertexCount <= kMaxShortIndexVertices;
+    const size_t indexSize = shortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+    const BoundingVolume bounds = object.GetBounds().IsValid() ? object.GetBounds() : BoundingVolume::Compute(object.GetVertices());
+
+    MeshFileHeader header = {};
+    std::memcpy(header.mMagic, kMeshFileMagic, sizeof(kMeshFileMagic));
+    header.mVersion = kMeshFileVersion;
+    header.mAttributeCount = static_cast<std::uint32_t>(layout.GetAttributes().size());
+    header.mLODCount = static_cast<std::uint32_t>(levels.size());
+    header.mVertexCount = static_cast<std::uint32_t>(vertexCount);
+    header.mStride = layout.GetStride();
+    header.mIndexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    header.mIndexCount = static_cast<std::uint32_t>(indices.size());
+    for (int i = 0; i < 3; ++i)
+    {
+        header.mBoundsMin[i] = bounds.mMin[i];
+        header.mBoundsMax[i] = bounds.mMax[i];
+        header.mBoundsCenter[i] = bounds.mCenter[i];
+    }
+    header.mBoundsRadius = bounds.mRadius;
+
+    // Everything after the header, offsets still count the header in
+    std::vector<char> payload;
+    for (const auto& attribute : layout.GetAttributes())
+    {
+        MeshFileAttribute entry = {attribute.mLocation, attribute.mSize, attribute.mType, attribute.mNormalized, attribute.mRelativeOffset};
+        Append(payload, &entry, 1);
+    }
+    Append(payload, levels.data(), levels.size());
+
+    header.mVertexOffset = Align(sizeof(MeshFileHeader) + payload.size());
+    header.mVertexSize = vertexData.size();
+    payload.resize(header.mVertexOffset - sizeof(MeshFileHeader), 0);
+    Append(payload, vertexData.data(), vertexData.size());
+
+    header.mIndexOffset = Align(sizeof(MeshFileHeader) + payload.size());
+    header.mIndexSize = indices.size() * indexSize;
+    payload.resize(header.mIndexOffset - sizeof(MeshFileHeader), 0);
+    if (shortIndices)
+    {
+        std::vector<std::uint16_t> shorts(indices.begin(), indices.end());
+        Append(payload, shorts.data(), shorts.size());
+    }
+    else
+    {
+        Append(payload, indices.data(), indices.size());
+    }
+
+    header.mFileSize = sizeof(MeshFileHeader) + payload.size();
+    header.mChecksum = Checksum(payload.data(), payload.size());
+
+    std::ofstream outputStream(path, std::ios::binary | std::ios::trunc);
+    if (outputStream.fail())
+    {
+        std::cerr << "MeshFile: Unable to write " << path << std::endl;
+        return false;
+    }
+
+    outputStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outputStream.write(payload.data(), payload.size());
+    return outputStream.good();
+}
+
+bool Dazzle::MeshFile::Open(const std::string& path, bool verifyChecksum)
+{
+    Close();
+    if (!mFile.Open(path))
+        return false;
+
+    const char* data = mFile.GetData();
+    const size_t size = mFile.GetSize();
+    const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(data);
+
+    if (size < sizeof(MeshFileHeader) || std::memcmp(header->mMagic, kMeshFileMagic, sizeof(kMeshFileMagic)) != 0)
+    {
+        std::cerr << "MeshFile: " << path << " is not a mesh file" << std::endl;
+        Close();
+        return false;
+    }
+
+    if (header->mVersion != kMeshFileVersion)
+    {
+        std::cerr << "MeshFile: " << path << " has version " << header->mVersion << ", expected " << kMeshFileVersion << std::endl;
+        Close();
+        return false;
+    }
+
+    const std::uint64_t tablesEnd = sizeof(MeshFileHeader) + static_cast<std::uint64_t>(header->mAttributeCount) * sizeof(MeshFileAttribute) +
+                                    static_cast<std::uint64_t>(header->mLODCount) * sizeof(MeshFileLOD);
+    const std::uint64_t indexSize = header->mIndexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+    bool valid = header->mFileSize == size && tablesEnd <= header->mVertexOffset &&
+                 header->mVertexOffset + header->mVertexSize <= size &&
+                 header->mIndexOffset + header->mIndexSize <= size &&
+                 header->mVertexSize == static_cast<std::uint64_t>(header->mVertexCount) * header->mStride &&
+                 (header->mIndexType == GL_UNSIGNED_SHORT || header->mIndexType == GL_UNSIGNED_INT) &&
+                 header->mIndexSize == header->mIndexCount * indexSize;
+
+    // Every attribute has to fit in a vertex and every level of detail in the index blob, they are read without checks
+    const MeshFileAttribute* attributes = reinterpret_cast<const MeshFileAttribute*>(data + sizeof(MeshFileHeader));
+    const MeshFileLOD* lods = reinterpret_cast<const MeshFileLOD*>(attributes + header->mAttributeCount);
+    for (std::uint32_t i = 0; valid && i < header->mAttributeCount; ++i)
+    {
+        const MeshFileAttribute& attribute = attributes[i];
+        valid = attribute.mSize >= 1 && attribute.mSize <= 4 && static_cast<std::uint64_t>(attribute.mRelativeOffset) +
+                RenderSystem::GL::VertexLayout::GetAttributeSize(attribute.mType, attribute.mSize) <= header->mStride;
+    }
+    for (std::uint32_t i = 0; valid && i < header->mLODCount; ++i)
+        valid = static_cast<std::uint64_t>(lods[i].mFirstIndex) + lods[i].mIndexCount <= header->mIndexCount;
+
+    if (!valid || (verifyChecksum && Checksum(data + sizeof(MeshFileHeader), size - sizeof(MeshFileHeader)) != header->mChecksum))
+    {
+        std::cerr << "MeshFile: " << path << " is truncated or corrupted" << std::endl;
+        Close();
+        return false;
+    }
+
+    mHeader = header;
+    mAttributes = attributes;
+    mLODs = lods;
+    return true;
+}
+
+void Dazzle::MeshFile::Close()
+{
+    mFile.Close();
+    mHeader = nullptr;
+    mAttributes = nullptr;
+    mLODs = nullptr;
+}
+
+Dazzle::RenderSystem::GL::VertexLayout Dazzle::MeshFile::GetLayout() const
+{
+    // Attributes keep the offsets they were written with, Open() checked that they fit in mStride
+    RenderSystem::GL::VertexLayout layout;
+    for (std::uint32_t i = 0; i < mHeader->mAttributeCount; ++i)
+    {
+        const MeshFileAttribute& attribute = mAttributes[i];
+        layout.Add({attribute.mLocation, attribute.mSize, attribute.mType, static_cast<GLboolean>(attribute.mNormalized ? GL_TRUE : GL_FALSE),
+                    attribute.mRelativeOffset});
+    }
+
+    return layout;
+}
+
+Dazzle::BoundingVolume Dazzle::MeshFile::GetBounds() const
+{
+    BoundingVolume bounds;
+    bounds.mMin = glm::vec3(mHeader->mBoundsMin[0], mHeader->mBoundsMin[1], mHeader->mBoundsMin[2]);
+    bounds.mMax = glm::vec3(mHeader->mBoundsMax[0], mHeader->mBoundsMax[1], mHeader->mBoundsMax[2]);
+    bounds.mCenter = glm::vec3(mHeader->mBoundsCenter[0], mHeader->mBoundsCenter[1], mHeader->mBoundsCenter[2]);
+    bounds.mRadius = mHeader->mBoundsRadius;
+    return bounds;
+}
@@ -0,0 +1,568 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "BoundingVolume.hpp"
+#include "MeshOptimizer.hpp"
+
+namespace
+{
+    // FIFO cache of vertex timestamps: a vertex is cached while fewer than cacheSize misses happened since its own.
+    class VertexCache
+    {
+    public:
+        VertexCache(size_t vertexCount, unsigned int cacheSize) : mTimestamps(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize) {}
+
+        // Returns true on a miss, the vertex is then transformed and cached
+        bool Access(unsigned int vertex)
+        {
+            if (mTime - mTimestamps[vertex] <= mCacheSize)
+                return false;
+
+            mTimestamps[vertex] = mTime++;
+            return true;
+        }
+
+        void Flush() { mTime += mCacheSize + 1; }
+
+    private:
+        std::vector<unsigned int> mTimestamps;
+        unsigned int mTime;
+        unsigned int mCacheSize;
+    };
+
+    // Triangles using each vertex, as offsets into a single list
+    struct Adjacency
+    {
+        std::vector<unsigned int> mOffsets;     // vertexCount + 1
+        std::vector<unsigned int> mTriangles;
+
+        Adjacency(const std::vector<unsigned int>& indices, size_t vertexCount) : mOffsets(vertexCount + 1, 0), mTriangles(indices.size())
+        {
+            for (unsigned int index : indices)
+                ++mOffsets[index + 1];
+            std::partial_sum(mOffsets.begin(), mOffsets.end(), mOffsets.begin());
+
+            std::vector<unsigned int> fill(mOffsets.begin(), mOffsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i)
+                mTriangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+
+        unsigned int GetCount(unsigned int vertex) const { return mOffsets[vertex + 1] - mOffsets[vertex]; }
+    };
+
+    // Starts of the clusters of a cache optimized order: a triangle missing all three vertices begins a new cluster
+    // (hard boundary), and a cluster is cut early once its running ACMR is within threshold of its whole ACMR (soft
+    // boundary), so sorting the smaller clusters costs little cache efficiency.
+    std::vector<unsigned int> GenerateClusters(const std::vector<unsigned int>& indices, size_t vertexCount, float threshold, unsigned int cacheSize)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        VertexCache cache(vertexCount, cacheSize);
+
+        std::vector<unsigned int> hard;
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            int misses = 0;
+            for (size_t i = 0; i < 3; ++i)
+                misses += cache.Access(indices[triangle * 3 + i]);
+            if (misses == 3 || triangle == 0)
+                hard.push_back(static_cast<unsigned int>(triangle));
+        }
+        hard.push_back(static_cast<unsigned int>(triangleCount));
+
+        std::vector<unsigned int> clusters;
+        for (size_t h = 0; h + 1 < hard.size(); ++h)
+        {
+            const unsigned int start = hard[h];
+            const unsigned int end = hard[h + 1];
+
+            cache.Flush();
+            unsigned int clusterMisses = 0;
+            for (unsigned int triangle = start; triangle < end; ++triangle)
+                for (size_t i = 0; i < 3; ++i)
+                    clusterMisses += cache.Access(indices[triangle * 3 + i]);
+            const float clusterThreshold = threshold * clusterMisses / (end - start);
+
+            cache.Flush();
+            clusters.push_back(start);
+            unsigned int misses = 0;
+            unsigned int triangles = 0;
+            for (unsigned int triangle = start; triangle < end; ++triangle)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                    misses += cache.Access(indices[triangle * 3 + i]);
+                ++triangles;
+
+                if (triangle + 1 < end && static_cast<float>(misses) / triangles <= clusterThreshold)
+                {
+                    clusters.push_back(triangle + 1);
+                    cache.Flush();
+                    misses = 0;
+                    triangles = 0;
+                }
+            }
+        }
+
+        return clusters;
+    }
+
+    // Sum of squared distances to a set of planes, weighted by the area of the triangles they come from
+    struct Quadric
+    {
+        double mA2 = 0.0, mB2 = 0.0, mC2 = 0.0, mAB = 0.0, mAC = 0.0, mBC = 0.0, mAD = 0.0, mBD = 0.0, mCD = 0.0, mD2 = 0.0;
+        double mWeight = 0.0;
+
+        static Quadric FromPlane(const glm::dvec3& normal, double d, double weight)
+        {
+            Quadric q;
+            q.mA2 = normal.x * normal.x * weight; q.mB2 = normal.y * normal.y * weight; q.mC2 = normal.z * normal.z * weight;
+            q.mAB = normal.x * normal.y * weight; q.mAC = normal.x * normal.z * weight; q.mBC = normal.y * normal.z * weight;
+            q.mAD = normal.x * d * weight; q.mBD = normal.y * d * weight; q.mCD = normal.z * d * weight;
+            q.mD2 = d * d * weight;
+            q.mWeight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            mA2 += other.mA2; mB2 += other.mB2; mC2 += other.mC2; mAB += other.mAB; mAC += other.mAC; mBC += other.mBC;
+            mAD += other.mAD; mBD += other.mBD; mCD += other.mCD; mD2 += other.mD2; mWeight += other.mWeight;
+            return *this;
+        }
+
+        // Weighted sum of squared distances from p to the planes
+        double Evaluate(const glm::dvec3& p) const
+        {
+            return mA2 * p.x * p.x + mB2 * p.y * p.y + mC2 * p.z * p.z
+                 + 2.0 * (mAB * p.x * p.y + mAC * p.x * p.z + mBC * p.y * p.z + mAD * p.x + mBD * p.y + mCD * p.z) + mD2;
+        }
+    };
+
+    struct Collapse
+    {
+        double mCost;       // Mean squared distance the surface moves
+        unsigned int mFrom;
+        unsigned int mTo;
+    };
+}
+
+void Dazzle::MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // Tipsify (Sander et al. 2007): fan around a vertex, then continue from the vertex of the fan that is the most
+    // likely to still be cached with triangles left, or from the last dead-end when none is.
+    const Adjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+        liveTriangles[vertex] = adjacency.GetCount(vertex);
+
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    long long fanning = 0;
+    while (fanning >= 0)
+    {
+        const unsigned int vertex = static_cast<unsigned int>(fanning);
+        candidates.clear();
+        for (unsigned int a = adjacency.mOffsets[vertex]; a < adjacency.mOffsets[vertex + 1]; ++a)
+        {
+            const unsigned int triangle = adjacency.mTriangles[a];
+            if (emitted[triangle])
+                continue;
+
+            for (size_t i = 0; i < 3; ++i)
+            {
+                const unsigned int v = indices[triangle * 3 + i];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - timestamps[v] > cacheSize)
+                    timestamps[v] = time++;
+            }
+            emitted[triangle] = true;
+        }
+
+        // Candidate still in the cache after its remaining triangles are emitted, the oldest one first. Candidates
+        // that would leave it keep priority 0 and never win, the dead-end stack picks the next vertex instead
+        fanning = -1;
+        int bestPriority = 0;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+
+            int priority = 0;
+            if (time - timestamps[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = static_cast<int>(time - timestamps[v]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        while (fanning < 0 && !deadEnds.empty())
+        {
+            const unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+                fanning = v;
+        }
+
+        for (; fanning < 0 && cursor < vertexCount; ++cursor)
+        {
+            if (liveTriangles[cursor] > 0)
+                fanning = cursor;
+        }
+    }
+
+    indices.swap(output);
+}
+
+void Dazzle::MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<float>& positions, float threshold, unsigned int cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    const size_t vertexCount = positions.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    const std::vector<unsigned int> clusters = GenerateClusters(indices, vertexCount, threshold, cacheSize);
+    if (clusters.size() < 2)
+        return;
+
+    // Area weighted centroids and normals; a cluster facing away from the mesh center occludes more than it is
+    // occluded, so drawing it first lets depth testing reject more of the others
+    auto position = [&](unsigned int vertex) { return glm::vec3(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]); };
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(triangleCount);
+        float clusterArea = 0.0f;
+        for (unsigned int triangle = clusters[c]; triangle < end; ++triangle)
+        {
+            const glm::vec3 p0 = position(indices[triangle * 3]);
+            const glm::vec3 p1 = position(indices[triangle * 3 + 1]);
+            const glm::vec3 p2 = position(indices[triangle * 3 + 2]);
+
+            const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(normal);
+            centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+            normals[c] += normal;
+            clusterArea += area;
+        }
+
+        meshCentroid += centroids[c];
+        meshArea += clusterArea;
+        centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : position(indices[clusters[c] * 3]);
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+
+    std::vector<float> sortKeys(clusters.size());
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        const float length = glm::length(normals[c]);
+        sortKeys[c] = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c] / length) : 0.0f;
+    }
+
+    std::vector<unsigned int> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (unsigned int c : order)
+    {
+        const unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(triangleCount);
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+
+    indices.swap(output);
+}
+
+std::vector<unsigned int> Dazzle::MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    std::vector<unsigned int> remap(vertexCount, kUnusedVertex);
+    unsigned int next = 0;
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == kUnusedVertex)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    return remap;
+}
+
+void Dazzle::MeshOptimizer::RemapVertexAttribute(std::vector<float>& attribute, const std::vector<unsigned int>& remap, size_t vertexCount)
+{
+    if (attribute.empty() || vertexCount == 0)
+        return;
+
+    const size_t components = attribute.size() / vertexCount;
+    const size_t usedCount = remap.size() - std::count(remap.begin(), remap.end(), kUnusedVertex);
+
+    std::vector<float> remapped(usedCount * components);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        if (remap[vertex] != kUnusedVertex)
+            std::copy_n(attribute.begin() + vertex * components, components, remapped.begin() + remap[vertex] * components);
+    }
+
+    attribute.swap(remapped);
+}
+
+Dazzle::VertexCacheStatistics Dazzle::MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStatistics statistics;
+    if (indices.size() < 3)
+        return statistics;
+
+    VertexCache cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0;
+    size_t referencedCount = 0;
+    for (unsigned int index : indices)
+    {
+        misses += cache.Access(index);
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            ++referencedCount;
+        }
+    }
+
+    statistics.mACMR = static_cast<float>(misses) / (indices.size() / 3);
+    statistics.mATVR = static_cast<float>(misses) / referencedCount;
+    return statistics;
+}
+
+Dazzle::MeshOptimizationReport Dazzle::MeshOptimizer::Optimize(std::vector<unsigned int>& indices, std::vector<float>& positions,
+                                                               const std::vector<std::vector<float>*>& attributes)
+{
+    MeshOptimizationReport report;
+    const size_t vertexCount = positions.size() / 3;
+    report.mBefore = AnalyzeVertexCache(indices, vertexCount);
+
+    OptimizeVertexCache(indices, vertexCount);
+    OptimizeOverdraw(indices, positions);
+
+    const std::vector<unsigned int> remap = OptimizeVertexFetch(indices, vertexCount);
+    RemapVertexAttribute(positions, remap, vertexCount);
+    for (std::vector<float>* attribute : attributes)
+        RemapVertexAttribute(*attribute, remap, vertexCount);
+
+    report.mAfter = AnalyzeVertexCache(indices, positions.size() / 3);
+    return report;
+}
+
+std::vector<unsigned int> Dazzle::MeshOptimizer::Simplify(const std::vector<unsigned int>& indices, const std::vector<float>& positions,
+                                                          size_t targetIndexCount, float targetError, float* resultError)
+{
+    const size_t vertexCount = positions.size() / 3;
+    std::vector<unsigned int> result(indices);
+    if (resultError)
+        *resultError = 0.0f;
+    if (result.size() <= targetIndexCount || vertexCount == 0)
+        return result;
+
+    auto position = [&](unsigned int vertex) { return glm::vec3(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]); };
+
+    // Vertices sharing a position (attribute seams) share the quadric of that position and are locked, moving one
+    // copy would tear the seam open
+    std::vector<unsigned int> welded(vertexCount);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> firstVertex;
+        for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+        {
+            auto inserted = firstVertex.emplace(position(vertex), vertex);
+            welded[vertex] = inserted.first->second;
+            if (!inserted.second)
+                locked[vertex] = locked[welded[vertex]] = true;
+        }
+    }
+
+    // Edges of a single triangle are open borders, edges of more than two are non-manifold: both lock their ends
+    {
+        std::unordered_map<std::uint64_t, unsigned int> edgeTriangles;
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            for (size_t e = 0; e < 3; ++e)
+            {
+                const std::uint64_t a = welded[result[i + e]];
+                const std::uint64_t b = welded[result[i + (e + 1) % 3]];
+                ++edgeTriangles[std::min(a, b) << 32 | std::max(a, b)];
+            }
+        }
+
+        for (const auto& edge : edgeTriangles)
+        {
+            if (edge.second != 2)
+            {
+                locked[static_cast<unsigned int>(edge.first >> 32)] = true;
+                locked[static_cast<unsigned int>(edge.first & 0xffffffffu)] = true;
+            }
+        }
+
+        for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+            locked[vertex] = locked[vertex] || locked[welded[vertex]];
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i + 2 < result.size(); i += 3)
+    {
+        const glm::dvec3 p0 = glm::dvec3(position(result[i]));
+        const glm::dvec3 p1 = glm::dvec3(position(result[i + 1]));
+        const glm::dvec3 p2 = glm::dvec3(position(result[i + 2]));
+        const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const double area = glm::length(normal);
+        if (area == 0.0)
+            continue;
+
+        const glm::dvec3 unit = normal / area;
+        const Quadric quadric = Quadric::FromPlane(unit, -glm::dot(unit, p0), area);
+        for (size_t c = 0; c < 3; ++c)
+            quadrics[welded[result[i + c]]] += quadric;
+    }
+
+    const double radius = BoundingVolume::Compute(positions).mRadius;
+    const double maxCost = (targetError * radius) * (targetError * radius);
+    double worstCost = 0.0;
+
+    // Passes of independent collapses, cheapest first, until the target is met or every collapse is too expensive
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    while (result.size() > targetIndexCount)
+    {
+        const Adjacency adjacency(result, vertexCount);
+
+        // An unlocked vertex has a position of its own, so it is its own welded vertex
+        collapses.clear();
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            for (size_t e = 0; e < 3; ++e)
+            {
+                const unsigned int from = result[i + e];
+                const unsigned int to = result[i + (e + 1) % 3];
+                for (const auto& edge : {std::make_pair(from, to), std::make_pair(to, from)})
+                {
+                    if (locked[edge.first])
+                        continue;
+
+                    Quadric quadric = quadrics[edge.first];
+                    quadric += quadrics[welded[edge.second]];
+                    const double cost = quadric.mWeight > 0.0 ? std::max(0.0, quadric.Evaluate(glm::dvec3(position(edge.second)))) / quadric.mWeight : 0.0;
+                    collapses.push_back({cost, edge.first, edge.second});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.mCost < b.mCost; });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t removedIndices = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapse.mCost > maxCost || result.size() - removedIndices <= targetIndexCount)
+                break;
+            if (touched[collapse.mFrom] || touched[collapse.mTo])
+                continue;
+
+            // Reject collapses flipping a triangle around the moved vertex
+            const glm::vec3 target = position(collapse.mTo);
+            bool flips = false;
+            for (unsigned int a = adjacency.mOffsets[collapse.mFrom]; a < adjacency.mOffsets[collapse.mFrom + 1] && !flips; ++a)
+            {
+                const unsigned int* triangle = &result[adjacency.mTriangles[a] * 3];
+                if (triangle[0] == collapse.mTo || triangle[1] == collapse.mTo || triangle[2] == collapse.mTo)
+                    continue;
+
+                glm::vec3 corners[3] = {position(triangle[0]), position(triangle[1]), position(triangle[2])};
+                const glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                for (size_t c = 0; c < 3; ++c)
+                    if (triangle[c] == collapse.mFrom)
+                        corners[c] = target;
+                const glm::vec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                flips = glm::dot(before, before) > 0.0f && glm::dot(before, after) <= 0.0f;
+            }
+            if (flips)
+                continue;
+
+            // Every vertex around the collapse is left alone for the rest of the pass, so the checks above hold
+            for (unsigned int a = adjacency.mOffsets[collapse.mFrom]; a < adjacency.mOffsets[collapse.mFrom + 1]; ++a)
+                for (size_t c = 0; c < 3; ++c)
+                    touched[result[adjacency.mTriangles[a] * 3 + c]] = true;
+            touched[collapse.mTo] = true;
+
+            remap[collapse.mFrom] = collapse.mTo;
+            quadrics[welded[collapse.mTo]] += quadrics[collapse.mFrom];
+            worstCost = std::max(worstCost, collapse.mCost);
+            removedIndices += 6;    // An interior edge collapse removes its two triangles
+        }
+
+        if (removedIndices == 0)
+            break;
+
+        // Triangles of a collapsed edge are now degenerate
+        size_t write = 0;
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            const unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError)
+        *resultError = radius > 0.0 ? static_cast<float>(std::sqrt(worstCost) / radius) : 0.0f;
+    return result;
+}
+
+std::vector<Dazzle::MeshLOD> Dazzle::MeshOptimizer::GenerateLODs(const std::vector<unsigned int>& indices, const std::vector<float>& positions,
+                                                                 unsigned int levelCount, float reduction, float maxError)
+{
+    std::vector<MeshLOD> lods;
+    size_t previousCount = indices.size();
+    float previousError = 0.0f;
+    for (unsigned int level = 1; level <= levelCount; ++level)
+    {
+        // Every level starts from the full resolution quadrics, so errors don't compound
+        const size_t targetCount = static_cast<size_t>(previousCount / 3 * reduction) * 3;
+        MeshLOD lod;
+        lod.mIndices = Simplify(indices, positions, targetCount, maxError, &lod.mError);
+        if (lod.mIndices.empty() || lod.mIndices.size() > previousCount * 9 / 10)
+            break;
+
+        OptimizeVertexCache(lod.mIndices, positions.size() / 3);
+        lod.mError = std::max(lod.mError, previousError);
+        previousCount = lod.mIndices.size();
+        previousError = lod.mError;
+        lods.push_back(std::move(lod));
+    }
+
+    return lods;
+}
@@ -3,10 +3,11 @@
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Plane.hpp"
 
 Dazzle::Plane::Plane(float width, float depth, unsigned int widthSegments, unsigned int depthSegments)
-                    : mVAO(nullptr), mVBO(nullptr), mNVBO(nullptr), mTCVBO(nullptr), mEBO(nullptr)
+                    : mVAO(nullptr), mVBO(nullptr), mEBO(nullptr), mIndexType(GL_UNSIGNED_INT)
 {
     // Calculate the number of indices and vertices according to widthSegments and depthSegments
     unsigned int vertices = (widthSegments + 1) * (depthSegments + 1);
@@ -83,6 +84,12 @@ Dazzle::Plane::Plane(float width, float depth, unsigned int widthSegments, unsig
         }
     }
 
+    // Row by row indices reuse few cached vertices, reorder them for the post-transform cache and vertex fetches
+    mOptimizationReport = MeshOptimizer::Optimize(mIndices, mVertices, {&mNormals, &mTextureCoordinates, &mTangents, &mBitangents});
+
+    // Cache the number of indices so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
     // Transform
     mTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 }
@@ -92,11 +99,14 @@ void Dazzle::Plane::Draw() const
     if (!mVAO->IsValid())
         return;
 
+    // Shaders applying InstanceTransform read its current value, which instanced draws leave undefined
+    RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+
     // Bind VAO
     glBindVertexArray(mVAO->GetHandle());
 
     // Draw
-    glDrawElements(GL_TRIANGLES, (GLsizei)GetIndices().size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0);
 }
 
 void Dazzle::Plane::SetPosition(glm::vec3 position)
@@ -115,100 +125,25 @@ void Dazzle::Plane::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Plane::InitializeBuffers()
+void Dazzle::Plane::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    // Vertices
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-    // Normals
-    const GLuint kNormAttribIndex = 1;
-    const GLuint kNormBindingIndex = 1;
-    // Texture Coordinates
-    const GLuint kTexAttribIndex = 2;
-    const GLuint kTexBindingIndex = 2;
-    // Tangents
-    const GLuint kTangAttribIndex = 3;
-    const GLuint kTangBindingIndex = 3;
-
     mVAO = std::make_unique<RenderSystem::GL::VAO>();
     mVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mNVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mTCVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mTVBO = std::make_unique<RenderSystem::GL::VBO>();
     mEBO = std::make_unique<RenderSystem::GL::EBO>();
 
-    // Set up the data store for the Vertex Buffer Object
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Normals
-    glNamedBufferStorage(mNVBO->GetHandle(), GetNormals().size() * sizeof(float), GetNormals().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-    glNamedBufferStorage(mTCVBO->GetHandle(), GetTextureCoordinates().size() * sizeof(float), GetTextureCoordinates().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Tangents
-    glNamedBufferStorage(mTVBO->GetHandle(), GetTangents().size() * sizeof(float), GetTangents().data(), 0);
-
-    // Set up the data store for the Element Buffer Object
-    glNamedBufferStorage(mEBO->GetHandle(), GetIndices().size() * sizeof(unsigned int), GetIndices().data(), 0);
-
-    // Bind Vertex Buffer Object to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosBindingIndex,           // Binding Index
-                                mVBO->GetHandle(),          // Vertex Buffer Object
-                                kOffset,                    // Offset (Offset of the first element)
-                                3 * sizeof(float));         // Stride (Distance between elements within the buffer)
-
-    // Specify the format for the given attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex,            // (Vertex) Attribute Index
-                                kSize,                      // Size (Number of values per vertex that are stored in the array)
-                                kDataType,                  // Data Type
-                                kNormalized,                // Normalized (if parameter represents a normalized integer)
-                                kOffset);                   // Relative Offset
-
-    // Specify which vertex buffer binding to use for this attribute
-    glVertexArrayAttribBinding( mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex,            // (Vertex) Attribute Index
-                                kPosBindingIndex);          // Binding Index
-
-    // Enable the attribute
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(),          // Vertex Array Object
-                                kPosAttribIndex);           // (Vertex) Attribute Index
-
-    // Bind Vertex Buffer Object for Normals to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kNormBindingIndex, mNVBO->GetHandle(), kOffset, 3 * sizeof(float));
-
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kNormAttribIndex, kNormBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kNormAttribIndex);
-
-    // Bind Vertex Buffer Object for the Texture Coordinates to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTexBindingIndex, mTCVBO->GetHandle(), kOffset, 2 * sizeof(float));
-
-    // Specify the format for the Texture Coordinates attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kTexAttribIndex, kTexBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTexAttribIndex);
-
-    // Bind Vertex Buffer Object for the Tangents to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTangBindingIndex, mTVBO->GetHandle(), kOffset, 4 * sizeof(float));
-
-    // Specify the format for the Tangents attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kTangAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kTangAttribIndex, kTangBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTangAttribIndex);
-
-    // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
-    glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetNormals(mNormals)
+           .SetTextureCoordinates(mTextureCoordinates)
+           .SetTangents(mTangents)
+           .SetIndices(mIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
+
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
 
     glBindVertexArray(mVAO->GetHandle());
 }
\ No newline at end of file
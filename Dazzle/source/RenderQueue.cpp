@@ -0,0 +1,220 @@
+#include <iostream>
+
+#include "RenderQueue.hpp"
+
+namespace
+{
+    const GLuint kBindingIndex = 0;     // The vertex arena is the only buffer binding of the vertex array
+}
+
+Dazzle::RenderSystem::GL::RenderQueue::RenderQueue() :  mCommandBuffer(0), mObjectBuffer(0), mBoundsBuffer(0),
+                                                        mArenasDirty(false), mCommandsDirty(false), mObjectsDirty(false)
+{
+
+}
+
+Dazzle::RenderSystem::GL::RenderQueue::~RenderQueue()
+{
+    if (mCommandBuffer > 0)
+        glDeleteBuffers(1, &mCommandBuffer);
+    if (mObjectBuffer > 0)
+        glDeleteBuffers(1, &mObjectBuffer);
+    if (mBoundsBuffer > 0)
+        glDeleteBuffers(1, &mBoundsBuffer);
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::Initialize()
+{
+    if (IsValid())
+        return;
+
+    mVAO = std::make_unique<VAO>();
+    mVBO = std::make_unique<VBO>();
+    mEBO = std::make_unique<EBO>();
+    glCreateBuffers(1, &mCommandBuffer);
+    glCreateBuffers(1, &mObjectBuffer);
+    glCreateBuffers(1, &mBoundsBuffer);
+
+    // Whatever was added so far still has to reach the new buffers
+    mArenasDirty = !mGeometries.empty();
+    mCommandsDirty = true;
+    mObjectsDirty = true;
+}
+
+unsigned int Dazzle::RenderSystem::GL::RenderQueue::AddGeometry(const Object3D& object)
+{
+    const auto& positions = object.GetVertices();
+    const size_t vertexCount = positions.size() / 3;
+    if (vertexCount == 0)
+    {
+        std::cerr << "RenderQueue: Ignoring an object without vertices" << std::endl;
+        return kInvalidID;
+    }
+
+    // Fill in the attributes the object doesn't have, so every geometry ends up with the same layout
+    const std::vector<float>* normals = &object.GetNormals();
+    const std::vector<float>* textureCoordinates = &object.GetTextureCoordinates();
+    std::vector<float> zeroNormals;
+    std::vector<float> zeroTextureCoordinates;
+    if (normals->size() != vertexCount * 3)
+    {
+        zeroNormals.assign(vertexCount * 3, 0.0f);
+        normals = &zeroNormals;
+    }
+    if (textureCoordinates->size() != vertexCount * 2)
+    {
+        zeroTextureCoordinates.assign(vertexCount * 2, 0.0f);
+        textureCoordinates = &zeroTextureCoordinates;
+    }
+
+    VertexBufferBuilder builder;
+    builder.SetPositions(positions)
+           .SetNormals(*normals)
+           .SetTextureCoordinates(*textureCoordinates);
+
+    std::vector<unsigned char> vertexData;
+    if (!builder.Interleave(vertexData))
+        return kInvalidID;
+
+    if (mGeometries.empty())
+        mLayout = builder.GetLayout();
+
+    Geometry geometry;
+    geometry.mFirstIndex = static_cast<GLuint>(mIndices.size());
+    geometry.mBaseVertex = static_cast<GLint>(mVertexData.size() / mLayout.GetStride());
+
+    // Indices stay relative to the geometry, the base vertex of its draw command offsets them
+    const auto& indices = object.GetIndices();
+    if (indices.empty())
+    {
+        for (size_t i = 0; i < vertexCount; ++i)
+            mIndices.push_back(static_cast<GLuint>(i));
+    }
+    else
+    {
+        mIndices.insert(mIndices.end(), indices.begin(), indices.end());
+    }
+    geometry.mIndexCount = static_cast<GLuint>(mIndices.size()) - geometry.mFirstIndex;
+
+    // Bounds are computed by InitializeBuffers(), fall back to the positions for objects without buffers
+    BoundingVolume bounds = object.GetBounds().IsValid() ? object.GetBounds() : BoundingVolume::Compute(positions);
+    geometry.mBounds.mMin = glm::vec4(bounds.mMin, 1.0f);
+    geometry.mBounds.mMax = glm::vec4(bounds.mMax, 1.0f);
+
+    mVertexData.insert(mVertexData.end(), vertexData.begin(), vertexData.end());
+    mGeometries.push_back(geometry);
+    mArenasDirty = true;
+
+    return static_cast<unsigned int>(mGeometries.size() - 1);
+}
+
+unsigned int Dazzle::RenderSystem::GL::RenderQueue::AddObject(unsigned int geometry, const glm::mat4& transform, GLuint material)
+{
+    if (geometry >= mGeometries.size())
+    {
+        std::cerr << "RenderQueue: Unknown geometry " << geometry << std::endl;
+        return kInvalidID;
+    }
+
+    const Geometry& source = mGeometries[geometry];
+    const GLuint id = static_cast<GLuint>(mCommands.size());
+
+    DrawElementsIndirectCommand command;
+    command.mCount = source.mIndexCount;
+    command.mInstanceCount = 1;
+    command.mFirstIndex = source.mFirstIndex;
+    command.mBaseVertex = source.mBaseVertex;
+    command.mBaseInstance = id;
+    mCommands.push_back(command);
+
+    mObjects.push_back(ObjectData());
+    mObjects.back().mMaterial = material;
+    mBounds.push_back(source.mBounds);
+    SetTransform(id, transform);
+
+    mCommandsDirty = true;
+    return id;
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::SetTransform(unsigned int object, const glm::mat4& transform)
+{
+    if (object >= mObjects.size())
+        return;
+
+    ObjectData& data = mObjects[object];
+    data.mModel = transform;
+    data.mNormal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform))));
+    mObjectsDirty = true;
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::SetMaterial(unsigned int object, GLuint material)
+{
+    if (object >= mObjects.size())
+        return;
+
+    mObjects[object].mMaterial = material;
+    mObjectsDirty = true;
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::ClearObjects()
+{
+    mCommands.clear();
+    mObjects.clear();
+    mBounds.clear();
+    mCommandsDirty = true;
+    mObjectsDirty = true;
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::Upload()
+{
+    if (!IsValid())
+    {
+        std::cerr << "RenderQueue: Initialize() must be called before uploading" << std::endl;
+        return;
+    }
+
+    if (mArenasDirty)
+    {
+        // Re-specifying the data stores keeps the buffer names, so the vertex array only has to be set up once
+        glNamedBufferData(mVBO->GetHandle(), mVertexData.size(), mVertexData.data(), GL_STATIC_DRAW);
+        glNamedBufferData(mEBO->GetHandle(), mIndices.size() * sizeof(GLuint), mIndices.data(), GL_STATIC_DRAW);
+
+        glVertexArrayVertexBuffer(mVAO->GetHandle(), kBindingIndex, mVBO->GetHandle(), 0, mLayout.GetStride());
+        mLayout.Apply(mVAO->GetHandle(), kBindingIndex);
+        glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
+        mArenasDirty = false;
+    }
+
+    if (mCommandsDirty)
+    {
+        glNamedBufferData(mCommandBuffer, mCommands.size() * sizeof(DrawElementsIndirectCommand), mCommands.data(), GL_DYNAMIC_DRAW);
+        glNamedBufferData(mBoundsBuffer, mBounds.size() * sizeof(ObjectBounds), mBounds.data(), GL_DYNAMIC_DRAW);
+        mCommandsDirty = false;
+    }
+
+    if (mObjectsDirty)
+    {
+        glNamedBufferData(mObjectBuffer, mObjects.size() * sizeof(ObjectData), mObjects.data(), GL_DYNAMIC_DRAW);
+        mObjectsDirty = false;
+    }
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::Bind() const
+{
+    if (!IsValid())
+        return;
+
+    glBindVertexArray(mVAO->GetHandle());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kObjectDataBinding, mObjectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kObjectBoundsBinding, mBoundsBuffer);
+}
+
+void Dazzle::RenderSystem::GL::RenderQueue::Submit() const
+{
+    if (!IsValid() || mCommands.empty())
+        return;
+
+    Bind();
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommandBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(mCommands.size()), 0);
+}
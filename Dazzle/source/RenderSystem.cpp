@@ -1,9 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <thread>
 
+#include "FileManager.hpp"
 #include "RenderSystem.hpp"
+#include "Singleton.hpp"
 #include "Utilities.hpp"
 
+namespace
+{
+    // Header of the files written by ShaderCache, followed by the program binary
+    struct ProgramBinaryHeader
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        std::uint64_t mKey;                 // CheckHash() of everything the binary depends on, the file is named after Hash()
+        std::uint32_t mFormat;              // Binary format returned by glGetProgramBinary
+        std::uint32_t mLength;              // Size of the binary, in bytes
+    };
+
+    const char kProgramBinaryMagic[4] = {'D', 'Z', 'P', 'B'};
+    const std::uint32_t kProgramBinaryVersion = 2;
+
+    // FNV-1a, hashes are chained by passing the previous one as seed
+    std::uint64_t Hash(const std::string& data, std::uint64_t seed = 14695981039346656037ull)
+    {
+        std::uint64_t hash = seed;
+        for (unsigned char c : data)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        // Separator, so {"ab", "c"} and {"a", "bc"} don't hash the same
+        hash ^= 0xFF;
+        hash *= 1099511628211ull;
+        return hash;
+    }
+
+    // Second hash, unrelated to Hash() so two programs whose Hash() collides, and share a file, still differ here
+    std::uint64_t CheckHash(const std::string& data, std::uint64_t seed = 0x9E3779B97F4A7C15ull)
+    {
+        std::uint64_t hash = seed ^ data.size();
+        for (unsigned char c : data)
+        {
+            hash = (hash + c) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+
+    // Inserts the defines right after the #version directive, which must stay the first statement of the shader.
+    // A #line directive keeps the line numbers of compilation errors in sync with the file.
+    std::string InjectDefines(const std::string& source, const std::vector<std::string>& defines)
+    {
+        if (defines.empty())
+            return source;
+
+        std::string block;
+        for (const auto& define : defines)
+            block += "#define " + define + '\n';
+
+        size_t version = source.find("#version");
+        if (version == std::string::npos)
+            return block + "#line 1\n" + source;
+
+        size_t lineEnd = source.find('\n', version);
+        if (lineEnd == std::string::npos)
+            return source + '\n' + block;
+
+        size_t nextLine = static_cast<size_t>(std::count(source.begin(), source.begin() + lineEnd, '\n')) + 2;
+        return source.substr(0, lineEnd + 1) + block + "#line " + std::to_string(nextLine) + '\n' + source.substr(lineEnd + 1);
+    }
+}
+
 void Dazzle::RenderSystem::GL::SetupDebugMessageCallback(const std::vector<GLuint>& filterOutIDs)
 {
     GLint contextFlags;
@@ -561,4 +636,303 @@ void Dazzle::RenderSystem::GL::ProgramBuilder::Build(ProgramObject& program, con
 
     program.DetachAllShaders();
     assert_with_message(program.GetAttachedShaders().size() == 0, "OpenGL linked program still contains attached shaders.");
-}
\ No newline at end of file
+}
+
+void Dazzle::RenderSystem::GL::ProgramBuilder::Build(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines)
+{
+    ShaderCache::GetInstance().Build(program, sources, defines);
+}
+
+const char* const Dazzle::RenderSystem::GL::ShaderCache::kDefaultDirectory = "shadercache";
+
+Dazzle::RenderSystem::GL::ShaderCache& Dazzle::RenderSystem::GL::ShaderCache::GetInstance()
+{
+    return Singleton<ShaderCache, ShaderCache>::GetInstance();
+}
+
+Dazzle::RenderSystem::GL::ShaderCache::ShaderCache(const std::string& directory) : mDirectory(directory), mDriverKey(), mEnabled(true), mStatistics()
+{
+
+}
+
+bool Dazzle::RenderSystem::GL::ShaderCache::Build(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines)
+{
+    AsyncProgramBuilder builder(*this);
+    builder.Add(program, sources, defines);
+    builder.Wait();
+    return program.GetLinkageStatus() == GL_TRUE;
+}
+
+void Dazzle::RenderSystem::GL::ShaderCache::Prepare(std::vector<ShaderSource>& sources, const std::vector<std::string>& defines, std::string& path, unsigned long long& key)
+{
+    for (auto& source : sources)
+        source.mSourceCode = InjectDefines(source.mSourceCode, defines);
+
+    path.clear();
+    key = 0;
+    if (!mEnabled || GetDriverKey().empty())
+        return;
+
+    std::uint64_t hash = Hash(mDriverKey);
+    std::uint64_t check = CheckHash(mDriverKey);
+    for (const auto& source : sources)
+    {
+        hash = Hash(source.mSourceCode, Hash(std::to_string(source.mType), hash));
+        check = CheckHash(source.mSourceCode, CheckHash(std::to_string(source.mType), check));
+    }
+
+    std::ostringstream fileName;
+    fileName << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    path = (std::filesystem::path(mDirectory) / fileName.str()).string();
+    key = check;
+}
+
+bool Dazzle::RenderSystem::GL::ShaderCache::Load(ProgramObject& program, const std::string& path, unsigned long long key) const
+{
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error))
+        return false;
+
+    std::vector<char> file = FileManager::ReadBinary(path);
+    if (file.size() < sizeof(ProgramBinaryHeader))
+        return false;
+
+    ProgramBinaryHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.mMagic, kProgramBinaryMagic, sizeof(kProgramBinaryMagic)) != 0 ||
+        header.mVersion != kProgramBinaryVersion || header.mKey != key ||
+        header.mLength != file.size() - sizeof(header))
+        return false;
+
+    std::vector<char> binary(file.begin() + sizeof(header), file.end());
+    program.LoadBinary(binary, static_cast<GLenum>(header.mFormat));
+    return program.GetLinkageStatus() == GL_TRUE;
+}
+
+void Dazzle::RenderSystem::GL::ShaderCache::Store(ProgramObject& program, const std::string& path, unsigned long long key) const
+{
+    const std::vector<GLubyte> binary = program.GetBinary();
+    if (binary.empty())
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(mDirectory, error);
+    if (error)
+    {
+        std::cerr << "ShaderCache: Unable to create " << mDirectory << ": " << error.message() << std::endl;
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    std::memcpy(header.mMagic, kProgramBinaryMagic, sizeof(kProgramBinaryMagic));
+    header.mVersion = kProgramBinaryVersion;
+    header.mKey = key;
+    header.mFormat = static_cast<std::uint32_t>(program.GetBinaryFormat());
+    header.mLength = static_cast<std::uint32_t>(binary.size());
+
+    std::vector<char> file(sizeof(header) + binary.size());
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), binary.data(), binary.size());
+    FileManager::WriteBinary(path, file.data(), file.size());
+}
+
+const std::string& Dazzle::RenderSystem::GL::ShaderCache::GetDriverKey()
+{
+    if (!mDriverKey.empty())
+        return mDriverKey;
+
+    // Drivers without binary formats can't cache anything, the key stays empty
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats < 1)
+        return mDriverKey;
+
+    std::vector<GLint> formats(numFormats);
+    glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+
+    auto getString = [](GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+    };
+
+    std::ostringstream key;
+    key << getString(GL_VENDOR) << '|' << getString(GL_RENDERER) << '|' << getString(GL_VERSION) << '|';
+    for (GLint format : formats)
+        key << format << ',';
+    mDriverKey = key.str();
+    return mDriverKey;
+}
+
+Dazzle::RenderSystem::GL::AsyncProgramBuilder::AsyncProgramBuilder(ShaderCache& cache) : mCache(cache), mJobs(), mCompiling(0), mCompileStart()
+{
+
+}
+
+Dazzle::RenderSystem::GL::AsyncProgramBuilder::~AsyncProgramBuilder()
+{
+    // Programs queued but never waited for are built here, none is left half linked with shaders attached
+    Wait();
+}
+
+void Dazzle::RenderSystem::GL::AsyncProgramBuilder::Add(ProgramObject& program, const std::vector<ShaderSource>& sources, const std::vector<std::string>& defines)
+{
+    if (!program.IsValid())
+    {
+        std::cerr << "Unable to Build Program: Invalid Program Object.\n";
+        return;
+    }
+
+    Job job;
+    job.mProgram = &program;
+    job.mSources = sources;
+    job.mSubmitted = false;
+    job.mDone = false;
+    mCache.Prepare(job.mSources, defines, job.mPath, job.mKey);
+    mJobs.push_back(std::move(job));
+}
+
+void Dazzle::RenderSystem::GL::AsyncProgramBuilder::Submit()
+{
+    IsParallelCompileSupported();
+
+    std::vector<Job*> linkJobs;
+    for (auto& job : mJobs)
+    {
+        if (job.mSubmitted)
+            continue;
+
+        job.mSubmitted = true;
+
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!job.mPath.empty() && mCache.Load(*job.mProgram, job.mPath, job.mKey))
+        {
+            std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+            mCache.mStatistics.mHits++;
+            mCache.mStatistics.mLoadTime += loadTime.count();
+            job.mDone = true;
+            continue;
+        }
+
+        if (mCompiling == 0)
+            mCompileStart = std::chrono::steady_clock::now();
+        mCompiling++;
+
+        // The binary is requested before linking so the driver keeps it around for the cache
+        glProgramParameteri(job.mProgram->GetHandle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        // No status is queried here, glCompileShader returns as soon as the job is queued
+        for (const auto& source : job.mSources)
+        {
+            auto shader = std::make_unique<ShaderObject>();
+            shader->SetType(source.mType);
+            shader->SetSourceCode(source.mSourceCode);
+            shader->Initialize();
+            shader->Compile();
+            job.mShaders.push_back(std::move(shader));
+        }
+        linkJobs.push_back(&job);
+    }
+
+    // Links are issued once every shader is compiling, so the compilation of different programs overlaps
+    for (Job* job : linkJobs)
+    {
+        for (const auto& shader : job->mShaders)
+            job->mProgram->AttachShader(*shader);
+        job->mProgram->Link();
+    }
+}
+
+bool Dazzle::RenderSystem::GL::AsyncProgramBuilder::Poll()
+{
+    const bool parallel = IsParallelCompileSupported();
+    for (auto& job : mJobs)
+    {
+        if (!job.mSubmitted || job.mDone)
+            continue;
+
+        // Without the extension, the status queries of Finish() block until the program is linked
+        if (parallel)
+        {
+            GLint completed = GL_FALSE;
+            glGetProgramiv(job.mProgram->GetHandle(), GL_COMPLETION_STATUS_KHR, &completed);
+            if (completed != GL_TRUE)
+                continue;
+        }
+
+        Finish(job);
+    }
+
+    return mCompiling == 0;
+}
+
+void Dazzle::RenderSystem::GL::AsyncProgramBuilder::Wait()
+{
+    Submit();
+    while (!Poll())
+        std::this_thread::yield();
+}
+
+size_t Dazzle::RenderSystem::GL::AsyncProgramBuilder::GetPendingCount() const
+{
+    return static_cast<size_t>(std::count_if(mJobs.begin(), mJobs.end(), [](const Job& job) { return !job.mDone; }));
+}
+
+bool Dazzle::RenderSystem::GL::AsyncProgramBuilder::IsParallelCompileSupported()
+{
+    static const bool supported = []()
+    {
+        bool khr = false;
+        bool arb = false;
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            khr = khr || std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0;
+            arb = arb || std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0;
+        }
+
+        // 0xFFFFFFFF lets the driver pick its own maximum
+        if (khr && glMaxShaderCompilerThreadsKHR != nullptr)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        else if (arb && glMaxShaderCompilerThreadsARB != nullptr)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+        // GL_COMPLETION_STATUS_ARB and GL_COMPLETION_STATUS_KHR share the same value
+        return khr || arb;
+    }();
+
+    return supported;
+}
+
+void Dazzle::RenderSystem::GL::AsyncProgramBuilder::Finish(Job& job)
+{
+    if (job.mProgram->GetLinkageStatus() != GL_TRUE)
+    {
+        for (const auto& shader : job.mShaders)
+        {
+            if (shader->GetCompilationStatus() != GL_TRUE)
+                std::cerr   << "Shader Compilation Error:\n"
+                            << "Shader Handle: " << shader->GetHandle() << '\n'
+                            << "Shader Type: " << shader->GetShaderTypeAsString() << '\n'
+                            << "Log:\n" << shader->GetInfoLog() << std::endl;
+        }
+        std::cerr << job.mProgram->GetInfoLog();
+    }
+    else if (!job.mPath.empty())
+    {
+        mCache.Store(*job.mProgram, job.mPath, job.mKey);
+    }
+
+    job.mProgram->DetachAllShaders();
+    job.mShaders.clear();
+    job.mDone = true;
+
+    mCache.mStatistics.mMisses++;
+    if (--mCompiling == 0)
+    {
+        std::chrono::duration<double, std::milli> compileTime = std::chrono::steady_clock::now() - mCompileStart;
+        mCache.mStatistics.mCompileTime += compileTime.count();
+    }
+}
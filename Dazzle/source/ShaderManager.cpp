@@ -1,12 +1,197 @@
+#include <algorithm>
 #include <iostream>
+#include <system_error>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "FileManager.hpp"
 #include "ShaderManager.hpp"
 
-Dazzle::ShaderManager::ShaderManager()
+namespace
+{
+    const std::chrono::milliseconds kPollInterval(500);
+
+    // Absolute, normalized path, so the same file always gets the same key
+    std::string GetFileKey(const std::string& path)
+    {
+        std::error_code error;
+        std::filesystem::path absolute = std::filesystem::absolute(path, error);
+        return (error ? std::filesystem::path(path) : absolute).lexically_normal().string();
+    }
+
+    // Samplers and images, the uniforms set with a texture or image unit
+    bool IsOpaqueType(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_RECT:
+        case GL_SAMPLER_BUFFER: case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY:
+        case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_SAMPLER_1D_SHADOW:
+        case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_2D_RECT_SHADOW:
+        case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+        case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_2D_RECT: case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_1D_ARRAY:
+        case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_CUBE_MAP_ARRAY: case GL_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE: case GL_UNSIGNED_INT_SAMPLER_2D_RECT: case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+        case GL_IMAGE_1D: case GL_IMAGE_2D: case GL_IMAGE_3D: case GL_IMAGE_CUBE: case GL_IMAGE_2D_RECT:
+        case GL_IMAGE_BUFFER: case GL_IMAGE_1D_ARRAY: case GL_IMAGE_2D_ARRAY: case GL_IMAGE_CUBE_MAP_ARRAY:
+        case GL_IMAGE_2D_MULTISAMPLE: case GL_IMAGE_2D_MULTISAMPLE_ARRAY:
+        case GL_INT_IMAGE_1D: case GL_INT_IMAGE_2D: case GL_INT_IMAGE_3D: case GL_INT_IMAGE_CUBE:
+        case GL_INT_IMAGE_2D_RECT: case GL_INT_IMAGE_BUFFER: case GL_INT_IMAGE_1D_ARRAY: case GL_INT_IMAGE_2D_ARRAY:
+        case GL_INT_IMAGE_CUBE_MAP_ARRAY: case GL_INT_IMAGE_2D_MULTISAMPLE: case GL_INT_IMAGE_2D_MULTISAMPLE_ARRAY:
+        case GL_UNSIGNED_INT_IMAGE_1D: case GL_UNSIGNED_INT_IMAGE_2D: case GL_UNSIGNED_INT_IMAGE_3D:
+        case GL_UNSIGNED_INT_IMAGE_CUBE: case GL_UNSIGNED_INT_IMAGE_2D_RECT: case GL_UNSIGNED_INT_IMAGE_BUFFER:
+        case GL_UNSIGNED_INT_IMAGE_1D_ARRAY: case GL_UNSIGNED_INT_IMAGE_2D_ARRAY:
+        case GL_UNSIGNED_INT_IMAGE_CUBE_MAP_ARRAY: case GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Copies the values of the default block uniforms of source into the uniforms of target that have the same name.
+    void CopyUniforms(GLuint source, GLuint target)
+    {
+        GLint uniformCount = 0;
+        glGetProgramInterfaceiv(source, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+
+        const GLenum properties[] = {GL_BLOCK_INDEX, GL_TYPE, GL_ARRAY_SIZE, GL_NAME_LENGTH};
+        for (GLint i = 0; i < uniformCount; i++)
+        {
+            GLint values[4] = {};
+            glGetProgramResourceiv(source, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+            if (values[0] != -1)
+                continue; // Member of a uniform block, its buffer binding is copied instead
+
+            const GLenum type = static_cast<GLenum>(values[1]);
+            std::string name(values[3], '\0');
+            glGetProgramResourceName(source, GL_UNIFORM, i, values[3], nullptr, &name[0]);
+            name.resize(name.find('\0'));
+
+            // Arrays are reported as "name[0]", every element is copied on its own
+            const bool isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+            const std::string base = isArray ? name.substr(0, name.size() - 3) : name;
+            for (GLint element = 0; element < values[2]; element++)
+            {
+                const std::string elementName = isArray ? base + '[' + std::to_string(element) + ']' : name;
+                GLint from = glGetUniformLocation(source, elementName.c_str());
+                GLint to = glGetUniformLocation(target, elementName.c_str());
+                if (from < 0 || to < 0)
+                    continue;
+
+                GLfloat f[16] = {};
+                GLdouble d[16] = {};
+                GLint i32[4] = {};
+                GLuint u32[4] = {};
+                switch (type)
+                {
+                case GL_FLOAT:              glGetUniformfv(source, from, f); glProgramUniform1fv(target, to, 1, f); break;
+                case GL_FLOAT_VEC2:         glGetUniformfv(source, from, f); glProgramUniform2fv(target, to, 1, f); break;
+                case GL_FLOAT_VEC3:         glGetUniformfv(source, from, f); glProgramUniform3fv(target, to, 1, f); break;
+                case GL_FLOAT_VEC4:         glGetUniformfv(source, from, f); glProgramUniform4fv(target, to, 1, f); break;
+                case GL_FLOAT_MAT2:         glGetUniformfv(source, from, f); glProgramUniformMatrix2fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3:         glGetUniformfv(source, from, f); glProgramUniformMatrix3fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4:         glGetUniformfv(source, from, f); glProgramUniformMatrix4fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT2x3:       glGetUniformfv(source, from, f); glProgramUniformMatrix2x3fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT2x4:       glGetUniformfv(source, from, f); glProgramUniformMatrix2x4fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3x2:       glGetUniformfv(source, from, f); glProgramUniformMatrix3x2fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT3x4:       glGetUniformfv(source, from, f); glProgramUniformMatrix3x4fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4x2:       glGetUniformfv(source, from, f); glProgramUniformMatrix4x2fv(target, to, 1, GL_FALSE, f); break;
+                case GL_FLOAT_MAT4x3:       glGetUniformfv(source, from, f); glProgramUniformMatrix4x3fv(target, to, 1, GL_FALSE, f); break;
+                case GL_DOUBLE:             glGetUniformdv(source, from, d); glProgramUniform1dv(target, to, 1, d); break;
+                case GL_DOUBLE_VEC2:        glGetUniformdv(source, from, d); glProgramUniform2dv(target, to, 1, d); break;
+                case GL_DOUBLE_VEC3:        glGetUniformdv(source, from, d); glProgramUniform3dv(target, to, 1, d); break;
+                case GL_DOUBLE_VEC4:        glGetUniformdv(source, from, d); glProgramUniform4dv(target, to, 1, d); break;
+                case GL_DOUBLE_MAT2:        glGetUniformdv(source, from, d); glProgramUniformMatrix2dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT3:        glGetUniformdv(source, from, d); glProgramUniformMatrix3dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT4:        glGetUniformdv(source, from, d); glProgramUniformMatrix4dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT2x3:      glGetUniformdv(source, from, d); glProgramUniformMatrix2x3dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT2x4:      glGetUniformdv(source, from, d); glProgramUniformMatrix2x4dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT3x2:      glGetUniformdv(source, from, d); glProgramUniformMatrix3x2dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT3x4:      glGetUniformdv(source, from, d); glProgramUniformMatrix3x4dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT4x2:      glGetUniformdv(source, from, d); glProgramUniformMatrix4x2dv(target, to, 1, GL_FALSE, d); break;
+                case GL_DOUBLE_MAT4x3:      glGetUniformdv(source, from, d); glProgramUniformMatrix4x3dv(target, to, 1, GL_FALSE, d); break;
+                case GL_INT:
+                case GL_BOOL:               glGetUniformiv(source, from, i32); glProgramUniform1iv(target, to, 1, i32); break;
+                case GL_INT_VEC2:
+                case GL_BOOL_VEC2:          glGetUniformiv(source, from, i32); glProgramUniform2iv(target, to, 1, i32); break;
+                case GL_INT_VEC3:
+                case GL_BOOL_VEC3:          glGetUniformiv(source, from, i32); glProgramUniform3iv(target, to, 1, i32); break;
+                case GL_INT_VEC4:
+                case GL_BOOL_VEC4:          glGetUniformiv(source, from, i32); glProgramUniform4iv(target, to, 1, i32); break;
+                case GL_UNSIGNED_INT:       glGetUniformuiv(source, from, u32); glProgramUniform1uiv(target, to, 1, u32); break;
+                case GL_UNSIGNED_INT_VEC2:  glGetUniformuiv(source, from, u32); glProgramUniform2uiv(target, to, 1, u32); break;
+                case GL_UNSIGNED_INT_VEC3:  glGetUniformuiv(source, from, u32); glProgramUniform3uiv(target, to, 1, u32); break;
+                case GL_UNSIGNED_INT_VEC4:  glGetUniformuiv(source, from, u32); glProgramUniform4uiv(target, to, 1, u32); break;
+                case GL_UNSIGNED_INT_ATOMIC_COUNTER:
+                    break; // Bound to its buffer by the layout qualifier, nothing to copy
+                default:
+                    if (IsOpaqueType(type))
+                    {
+                        // Samplers and images hold their texture unit as a single integer
+                        glGetUniformiv(source, from, i32);
+                        glProgramUniform1iv(target, to, 1, i32);
+                    }
+                    else
+                        std::cerr << "ShaderManager: Uniform " << elementName << " has an unsupported type 0x" << std::hex << type << std::dec << ", not copied" << std::endl;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Copies the buffer bindings of the uniform or shader storage blocks of source to the blocks of target with the same name.
+    void CopyBlockBindings(GLuint source, GLuint target, GLenum interface)
+    {
+        GLint blockCount = 0;
+        glGetProgramInterfaceiv(source, interface, GL_ACTIVE_RESOURCES, &blockCount);
+
+        const GLenum properties[] = {GL_BUFFER_BINDING, GL_NAME_LENGTH};
+        for (GLint i = 0; i < blockCount; i++)
+        {
+            GLint values[2] = {};
+            glGetProgramResourceiv(source, interface, i, 2, properties, 2, nullptr, values);
+
+            std::string name(values[1], '\0');
+            glGetProgramResourceName(source, interface, i, values[1], nullptr, &name[0]);
+
+            GLuint index = glGetProgramResourceIndex(target, interface, name.c_str());
+            if (index == GL_INVALID_INDEX)
+                continue;
+
+            if (interface == GL_UNIFORM_BLOCK)
+                glUniformBlockBinding(target, index, values[0]);
+            else
+                glShaderStorageBlockBinding(target, index, values[0]);
+        }
+    }
+}
+
+Dazzle::ShaderManager::ShaderManager() : mNotifyHandle(-1), mLastPoll(std::chrono::steady_clock::now())
 {
 
 }
 
+Dazzle::ShaderManager::~ShaderManager()
+{
+    // Pending rebuilds are finished by their builders before the programs go away
+    mPrograms.clear();
+
+#ifdef __linux__
+    if (mNotifyHandle >= 0)
+        close(mNotifyHandle);
+#endif
+}
+
 void Dazzle::ShaderManager::UseEffect(const IShadingEffect& shader)
 {
 
@@ -16,3 +201,175 @@ Dazzle::IShadingEffect& Dazzle::ShaderManager::GetSimpleShader()
 {
     return Singleton<IShadingEffect, SimpleShader>::GetInstance();
 }
+
+void Dazzle::ShaderManager::Watch(RenderSystem::GL::ProgramObject& program, const std::vector<ShaderFile>& files, const ReloadCallback& onReload, const std::vector<std::string>& defines)
+{
+    Unwatch(program);
+
+    auto watched = std::make_unique<WatchedProgram>();
+    watched->mProgram = &program;
+    watched->mFiles = files;
+    watched->mDefines = defines;
+    watched->mOnReload = onReload;
+    watched->mChanged = false;
+
+    for (const auto& file : files)
+        WatchFile(file.mPath);
+
+    mPrograms.push_back(std::move(watched));
+}
+
+void Dazzle::ShaderManager::Unwatch(const RenderSystem::GL::ProgramObject& program)
+{
+    mPrograms.erase(std::remove_if(mPrograms.begin(), mPrograms.end(),
+                    [&program](const std::unique_ptr<WatchedProgram>& watched) { return watched->mProgram == &program; }),
+                    mPrograms.end());
+}
+
+void Dazzle::ShaderManager::Update()
+{
+    if (mPrograms.empty())
+        return;
+
+    std::vector<std::string> changedFiles = PollChangedFiles();
+    for (auto& watched : mPrograms)
+    {
+        for (const auto& file : watched->mFiles)
+        {
+            if (std::find(changedFiles.begin(), changedFiles.end(), GetFileKey(file.mPath)) != changedFiles.end())
+                watched->mChanged = true;
+        }
+
+        // Finish the rebuild in flight first, a newer edit is picked up right after
+        if (watched->mBuilder != nullptr)
+        {
+            if (!watched->mBuilder->Poll())
+                continue;
+
+            Swap(*watched);
+        }
+
+        if (watched->mChanged)
+            Rebuild(*watched);
+    }
+}
+
+void Dazzle::ShaderManager::WatchFile(const std::string& path)
+{
+    const std::string key = GetFileKey(path);
+
+#ifdef __linux__
+    if (mNotifyHandle < 0)
+        mNotifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mNotifyHandle < 0)
+    {
+        std::cerr << "ShaderManager: Unable to initialize inotify, shaders won't be reloaded" << std::endl;
+        return;
+    }
+
+    const std::string directory = std::filesystem::path(key).parent_path().string();
+    int descriptor = inotify_add_watch(mNotifyHandle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor < 0)
+        std::cerr << "ShaderManager: Unable to watch " << directory << std::endl;
+    else
+        mWatchedDirectories[descriptor] = directory;
+#else
+    std::error_code error;
+    mWriteTimes[key] = std::filesystem::last_write_time(key, error);
+#endif
+}
+
+std::vector<std::string> Dazzle::ShaderManager::PollChangedFiles()
+{
+    std::vector<std::string> changedFiles;
+
+#ifdef __linux__
+    if (mNotifyHandle < 0)
+        return changedFiles;
+
+    // The handle is non-blocking, read() fails with EAGAIN once the queue is empty
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length = 0;
+    while ((length = read(mNotifyHandle, buffer, sizeof(buffer))) > 0)
+    {
+        for (char* event = buffer; event < buffer + length; event += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(event)->len)
+        {
+            const inotify_event* notification = reinterpret_cast<inotify_event*>(event);
+            auto directory = mWatchedDirectories.find(notification->wd);
+            if (directory == mWatchedDirectories.end() || notification->len == 0)
+                continue;
+
+            changedFiles.push_back((std::filesystem::path(directory->second) / notification->name).lexically_normal().string());
+        }
+    }
+#else
+    auto now = std::chrono::steady_clock::now();
+    if (now - mLastPoll < kPollInterval)
+        return changedFiles;
+    mLastPoll = now;
+
+    for (auto& [path, writeTime] : mWriteTimes)
+    {
+        std::error_code error;
+        auto currentTime = std::filesystem::last_write_time(path, error);
+        if (!error && currentTime != writeTime)
+        {
+            writeTime = currentTime;
+            changedFiles.push_back(path);
+        }
+    }
+#endif
+
+    return changedFiles;
+}
+
+void Dazzle::ShaderManager::Rebuild(WatchedProgram& watched)
+{
+    // Files can be missing for a moment while an editor replaces them, the next event retries
+    std::vector<RenderSystem::GL::ShaderSource> sources;
+    for (const auto& file : watched.mFiles)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(file.mPath, error))
+            return;
+
+        sources.push_back({file.mType, FileManager::ReadFile(file.mPath)});
+    }
+
+    watched.mChanged = false;
+    watched.mPending = std::make_unique<RenderSystem::GL::ProgramObject>();
+    watched.mPending->Initialize();
+    watched.mBuilder = std::make_unique<RenderSystem::GL::AsyncProgramBuilder>();
+    watched.mBuilder->Add(*watched.mPending, sources, watched.mDefines);
+    watched.mBuilder->Submit();
+}
+
+void Dazzle::ShaderManager::Swap(WatchedProgram& watched)
+{
+    watched.mBuilder.reset();
+    std::unique_ptr<RenderSystem::GL::ProgramObject> pending = std::move(watched.mPending);
+
+    RenderSystem::GL::ProgramObject& program = *watched.mProgram;
+    if (pending->GetLinkageStatus() != GL_TRUE)
+    {
+        std::cerr << "ShaderManager: Reload of " << watched.mFiles.front().mPath << " failed, keeping the previous program" << std::endl;
+        return;
+    }
+
+    CopyUniforms(program.GetHandle(), pending->GetHandle());
+    CopyBlockBindings(program.GetHandle(), pending->GetHandle(), GL_UNIFORM_BLOCK);
+    CopyBlockBindings(program.GetHandle(), pending->GetHandle(), GL_SHADER_STORAGE_BLOCK);
+
+    GLint currentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+    // The previous program is deleted when it goes out of scope
+    RenderSystem::GL::ProgramObject previous = std::move(program);
+    program = std::move(*pending);
+    if (static_cast<GLuint>(currentProgram) == previous.GetHandle())
+        glUseProgram(program.GetHandle());
+
+    std::cout << "ShaderManager: Reloaded " << watched.mFiles.front().mPath << std::endl;
+    if (watched.mOnReload)
+        watched.mOnReload(program);
+}
@@ -3,9 +3,10 @@
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Skybox.hpp"
 
-Dazzle::Skybox::Skybox(float length) : mVAO(nullptr), mVBO(nullptr), mEBO(nullptr)
+Dazzle::Skybox::Skybox(float length) : mVAO(nullptr), mVBO(nullptr), mEBO(nullptr), mIndexType(GL_UNSIGNED_INT)
 {
     // Half of the length of a cube's side.
     const float s = length / 2.0f;
@@ -71,6 +72,9 @@ Dazzle::Skybox::Skybox(float length) : mVAO(nullptr), mVBO(nullptr), mEBO(nullpt
         22, 20, 23,
     };
 
+    // Cache the number of indices so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
     // Transform
     mTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 }
@@ -82,7 +86,7 @@ void Dazzle::Skybox::Draw() const
 
     // Draw
     glBindVertexArray(mVAO->GetHandle());
-    glDrawElements(GL_TRIANGLES, (GLsizei)GetIndices().size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0);
 }
 
 void Dazzle::Skybox::SetPosition(glm::vec3 position)
@@ -101,34 +105,22 @@ void Dazzle::Skybox::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Skybox::InitializeBuffers()
+void Dazzle::Skybox::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-
     mVAO = std::make_unique<RenderSystem::GL::VAO>();
     mVBO = std::make_unique<RenderSystem::GL::VBO>();
     mEBO = std::make_unique<RenderSystem::GL::EBO>();
 
-    // Set up the data store for the Vertex Buffer Object
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
-
-    // Set up the data store for the Element Buffer Object
-    glNamedBufferStorage(mEBO->GetHandle(), GetIndices().size() * sizeof(unsigned int), GetIndices().data(), 0);
-
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kPosBindingIndex, mVBO->GetHandle(), kOffset, 3 * sizeof(float));
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kPosAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kPosAttribIndex, kPosBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kPosAttribIndex);
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetIndices(mIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
 
-    // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
-    glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
 
     glBindVertexArray(mVAO->GetHandle());
 }
\ No newline at end of file
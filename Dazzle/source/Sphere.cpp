@@ -1,14 +1,25 @@
 #include <cmath>
+#include <iostream>
 
 #include "glm/gtc/matrix_transform.hpp"
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Sphere.hpp"
 
+namespace
+{
+    const void* GetIndexOffset(unsigned int firstIndex, GLenum indexType)
+    {
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        return reinterpret_cast<const void*>(static_cast<uintptr_t>(firstIndex) * indexSize);
+    }
+}
+
 Dazzle::Sphere::Sphere( float radius, unsigned int latitudeSegments, unsigned int longitudeSegments,
                         float thetaStart, float thetaEnd, float phiStart, float phiEnd)
-                        : mVAO(nullptr), mVBO(nullptr), mNVBO(nullptr), mTCVBO(nullptr), mEBO(nullptr)
+                        : mFirstIndex(0), mLOD(0), mVAO(nullptr), mVBO(nullptr), mEBO(nullptr), mIndexType(GL_UNSIGNED_INT)
 {
     // Calculate the number of indices and vertices according to latitudeSegments and longitudeSegments
     unsigned int vertices = (latitudeSegments + 1) * (longitudeSegments + 1);
@@ -82,6 +93,12 @@ Dazzle::Sphere::Sphere( float radius, unsigned int latitudeSegments, unsigned in
         }
     }
 
+    // Row by row indices reuse few cached vertices, reorder them for the post-transform cache and vertex fetches
+    mOptimizationReport = MeshOptimizer::Optimize(mIndices, mVertices, {&mNormals, &mTextureCoordinates, &mTangents, &mBitangents});
+
+    // Cache the number of indices so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
     // Transform
     mTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 }
@@ -91,11 +108,45 @@ void Dazzle::Sphere::Draw() const
     if (!mVAO->IsValid())
         return;
 
+    // Without an instance buffer the shaders read the current InstanceTransform, which instanced draws leave undefined
+    if (mInstances == nullptr)
+        RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+
     // Bind VAO
     glBindVertexArray(mVAO->GetHandle());
 
     // Draw
-    glDrawElements(GL_TRIANGLES, (GLsizei)GetIndices().size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, GetIndexOffset(mFirstIndex, mIndexType));
+}
+
+void Dazzle::Sphere::SetInstanceTransforms(const std::vector<glm::mat4>& transforms)
+{
+    if (mVAO == nullptr)
+    {
+        std::cerr << "Sphere: InitializeBuffers() must be called before setting instance transforms" << std::endl;
+        return;
+    }
+
+    if (mInstances == nullptr)
+    {
+        mInstances = std::make_unique<RenderSystem::GL::InstanceBuffer>();
+        mInstances->Attach(*mVAO);
+    }
+
+    mInstances->SetTransforms(transforms);
+}
+
+void Dazzle::Sphere::DrawInstanced(GLuint firstInstance, GLsizei instanceCount) const
+{
+    if (!mVAO->IsValid() || mInstances == nullptr || mInstances->GetCount() == 0)
+        return;
+
+    if (instanceCount < 0)
+        instanceCount = mInstances->GetCount() - static_cast<GLsizei>(firstInstance);
+
+    // Draw the instances with a single call, the base instance offsets the per-instance attributes
+    glBindVertexArray(mVAO->GetHandle());
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, GetIndexOffset(mFirstIndex, mIndexType), instanceCount, firstInstance);
 }
 
 void Dazzle::Sphere::SetPosition(glm::vec3 position)
@@ -114,66 +165,71 @@ void Dazzle::Sphere::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Sphere::InitializeBuffers()
+void Dazzle::Sphere::GenerateLODs(unsigned int levelCount, float maxError)
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-    const GLuint kNormAttribIndex = 1;
-    const GLuint kNormBindingIndex = 1;
-    const GLuint kTexAttribIndex = 2;
-    const GLuint kTexBindingIndex = 2;
-
-    mVAO = std::make_unique<RenderSystem::GL::VAO>();
-    mVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mNVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mTCVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mEBO = std::make_unique<RenderSystem::GL::EBO>();
-
-    // Set up the data store for the Vertex Buffer Object for Vertices
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Normals
-    glNamedBufferStorage(mNVBO->GetHandle(), GetNormals().size() * sizeof(float), GetNormals().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-    glNamedBufferStorage(mTCVBO->GetHandle(), GetTextureCoordinates().size() * sizeof(float), GetTextureCoordinates().data(), 0);
-
-    // Set up the data store for the Element Buffer Object for Indices
-    glNamedBufferStorage(mEBO->GetHandle(), GetIndices().size() * sizeof(unsigned int), GetIndices().data(), 0);
+    mLODIndices = MeshOptimizer::GenerateLODs(mIndices, mVertices, levelCount, 0.5f, maxError);
+}
 
-    // Bind Vertex Buffer Object for Vertices to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kPosBindingIndex, mVBO->GetHandle(), kOffset, 3 * sizeof(float));
+void Dazzle::Sphere::SetLOD(unsigned int level)
+{
+    if (level >= mLODs.size())
+        return;
 
-    // Specify the format for the Vertices attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kPosAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kPosAttribIndex, kPosBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kPosAttribIndex);
+    mLOD = level;
+    mFirstIndex = mLODs[level].mFirstIndex;
+    mDrawCount = mLODs[level].mIndexCount;
+}
 
-    // Bind Vertex Buffer Object for Normals to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kNormBindingIndex, mNVBO->GetHandle(), kOffset, 3 * sizeof(float));
+unsigned int Dazzle::Sphere::SelectLOD(const glm::mat4& modelView, const glm::mat4& projection, float viewportHeight, float threshold)
+{
+    if (mLODs.empty())
+        return 0;
 
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kNormAttribIndex, kNormBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kNormAttribIndex);
+    // Errors grow with the level, the first one too coarse ends the search
+    const float pixels = mBounds.mRadius * mBounds.GetProjectedScale(modelView, projection, viewportHeight);
+    unsigned int level = 0;
+    while (level + 1 < mLODs.size() && mLODs[level + 1].mError * pixels <= threshold)
+        ++level;
 
-    // Bind Vertex Buffer Object for the Texture Coordinates to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTexBindingIndex, mTCVBO->GetHandle(), kOffset, 2 * sizeof(float));
+    SetLOD(level);
+    return level;
+}
 
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kTexAttribIndex, kTexBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTexAttribIndex);
+void Dazzle::Sphere::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
+{
+    mVAO = std::make_unique<RenderSystem::GL::VAO>();
+    mVBO = std::make_unique<RenderSystem::GL::VBO>();
+    mEBO = std::make_unique<RenderSystem::GL::EBO>();
 
-    // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
-    glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
+    // Generated levels follow the full resolution indices in the element buffer
+    std::vector<unsigned int> lodIndices;
+    mLODs.clear();
+    if (!mLODIndices.empty())
+    {
+        lodIndices = mIndices;
+        mLODs.push_back({0, static_cast<std::uint32_t>(mIndices.size()), 0.0f, 0});
+        for (const auto& lod : mLODIndices)
+        {
+            mLODs.push_back({static_cast<std::uint32_t>(lodIndices.size()), static_cast<std::uint32_t>(lod.mIndices.size()), lod.mError, 0});
+            lodIndices.insert(lodIndices.end(), lod.mIndices.begin(), lod.mIndices.end());
+        }
+    }
+    mFirstIndex = 0;
+    mLOD = 0;
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetNormals(mNormals)
+           .SetTextureCoordinates(mTextureCoordinates)
+           .SetIndices(lodIndices.empty() ? mIndices : lodIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
+
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
 
     glBindVertexArray(mVAO->GetHandle());
 }
\ No newline at end of file
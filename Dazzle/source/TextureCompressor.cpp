@@ -0,0 +1,627 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "ParallelFor.hpp"
+#include "TextureCompressor.hpp"
+
+// Not part of the core profile, every desktop driver exposes them though
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+namespace
+{
+    const int kBlockTexels = 16;
+    const int kBPTCWeights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    const float kBC1Weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};  // Toward the second endpoint, by index
+    const int kBC6HMaxValue = 1023;                                         // 10 bit endpoints
+    const int kBC7MaxValue = 127;                                           // 7 bit endpoints, the p-bit completes them
+
+    // Texels of a block, RGBA for 8 bit images and the bits of their half floats for HDR ones
+    using BlockTexels = float[kBlockTexels][4];
+
+    // Fills a 128 bit block from its least significant bit up, as BC6H and BC7 lay their fields out
+    class BlockWriter
+    {
+    public:
+        explicit BlockWriter(unsigned char* output) : mOutput(output), mBit(0) { std::memset(mOutput, 0, 16); }
+
+        void Write(std::uint32_t value, int bitCount)
+        {
+            for (int i = 0; i < bitCount; ++i, ++mBit)
+                mOutput[mBit >> 3] |= static_cast<unsigned char>(((value >> i) & 1) << (mBit & 7));
+        }
+
+    private:
+        unsigned char* mOutput;
+        int mBit;
+    };
+
+    // Round to nearest, clamped to the finite unsigned range. BC6H interpolates these bits as integers
+    std::uint16_t FloatToHalf(float value)
+    {
+        if (!(value > 0.0f))
+            return 0;
+        if (value >= 65504.0f)
+            return 0x7BFF;
+
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+        std::uint32_t mantissa = bits & 0x7FFFFF;
+
+        if (exponent <= 0)
+        {
+            // Subnormal half, the implicit bit becomes explicit
+            if (exponent < -10)
+                return 0;
+            mantissa |= 0x800000;
+            const int shift = 14 - exponent;
+            return static_cast<std::uint16_t>((mantissa >> shift) + ((mantissa >> (shift - 1)) & 1));
+        }
+
+        // A carry out of the mantissa correctly bumps the exponent
+        const std::uint32_t half = (static_cast<std::uint32_t>(exponent) << 10 | mantissa >> 13) + ((mantissa >> 12) & 1);
+        return static_cast<std::uint16_t>(std::min<std::uint32_t>(half, 0x7BFF));
+    }
+
+    // Edge texels are repeated over the part of the block outside of the image
+    void LoadBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, BlockTexels& texels)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            const int sourceY = std::min(blockY * 4 + y, height - 1);
+            for (int x = 0; x < 4; ++x)
+            {
+                const int sourceX = std::min(blockX * 4 + x, width - 1);
+                const unsigned char* texel = rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4;
+                for (int c = 0; c < 4; ++c)
+                    texels[y * 4 + x][c] = texel[c];
+            }
+        }
+    }
+
+    void LoadHDRBlock(const float* rgb, int width, int height, int blockX, int blockY, BlockTexels& texels)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            const int sourceY = std::min(blockY * 4 + y, height - 1);
+            for (int x = 0; x < 4; ++x)
+            {
+                const int sourceX = std::min(blockX * 4 + x, width - 1);
+                const float* texel = rgb + (static_cast<size_t>(sourceY) * width + sourceX) * 3;
+                for (int c = 0; c < 3; ++c)
+                    texels[y * 4 + x][c] = FloatToHalf(texel[c]);
+                texels[y * 4 + x][3] = 0.0f;
+            }
+        }
+    }
+
+    // Mean of the texels and the direction they spread along the most, found by power iterations on their covariance.
+    // The axis is zero when every texel is the same
+    void FitLine(const BlockTexels& texels, int channels, float* mean, float* axis)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            mean[c] = 0.0f;
+            for (int i = 0; i < kBlockTexels; ++i)
+                mean[c] += texels[i][c];
+            mean[c] /= kBlockTexels;
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < kBlockTexels; ++i)
+        {
+            for (int a = 0; a < channels; ++a)
+                for (int b = 0; b < channels; ++b)
+                    covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+        }
+
+        // Starting from the row of the widest channel keeps the first guess away from being orthogonal to the axis
+        int widest = 0;
+        for (int c = 1; c < channels; ++c)
+            if (covariance[c][c] > covariance[widest][widest])
+                widest = c;
+
+        for (int c = 0; c < channels; ++c)
+            axis[c] = covariance[widest][c];
+
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float largest = 0.0f;
+            for (int a = 0; a < channels; ++a)
+            {
+                for (int b = 0; b < channels; ++b)
+                    next[a] += covariance[a][b] * axis[b];
+                largest = std::max(largest, std::fabs(next[a]));
+            }
+
+            if (largest <= 0.0f)
+                break;
+
+            for (int c = 0; c < channels; ++c)
+                axis[c] = next[c] / largest;
+        }
+
+        float length = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            length += axis[c] * axis[c];
+        length = std::sqrt(length);
+        for (int c = 0; c < channels; ++c)
+            axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+    }
+
+    // Endpoints at the extremes of the texels projected on their principal axis
+    void FitEndpoints(const BlockTexels& texels, int channels, float* endpoint0, float* endpoint1)
+    {
+        float mean[4], axis[4];
+        FitLine(texels, channels, mean, axis);
+
+        float minProjection = 0.0f, maxProjection = 0.0f;
+        for (int i = 0; i < kBlockTexels; ++i)
+        {
+            float projection = 0.0f;
+            for (int c = 0; c < channels; ++c)
+                projection += (texels[i][c] - mean[c]) * axis[c];
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        for (int c = 0; c < channels; ++c)
+        {
+            endpoint0[c] = mean[c] + axis[c] * maxProjection;
+            endpoint1[c] = mean[c] + axis[c] * minProjection;
+        }
+    }
+
+    // Least squares endpoints for the chosen indices, weights[index] being the share of the second endpoint.
+    // False when the indices don't tell the endpoints apart
+    bool RefineEndpoints(const BlockTexels& texels, int channels, const int* indices, const float* weights, float* endpoint0, float* endpoint1)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < kBlockTexels; ++i)
+        {
+            const float b = weights[indices[i]];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; ++c)
+            {
+                ax[c] += a * texels[i][c];
+                bx[c] += b * texels[i][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+            return false;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            endpoint0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            endpoint1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+        return true;
+    }
+
+    // Nearest palette entry of every texel, returns the squared error of the block
+    float SelectIndices(const BlockTexels& texels, int channels, const float palette[][4], int paletteSize, int* indices)
+    {
+        float error = 0.0f;
+        for (int i = 0; i < kBlockTexels; ++i)
+        {
+            float best = 0.0f;
+            for (int entry = 0; entry < paletteSize; ++entry)
+            {
+                float distance = 0.0f;
+                for (int c = 0; c < channels; ++c)
+                    distance += (texels[i][c] - palette[entry][c]) * (texels[i][c] - palette[entry][c]);
+
+                if (entry == 0 || distance < best)
+                {
+                    best = distance;
+                    indices[i] = entry;
+                }
+            }
+            error += best;
+        }
+        return error;
+    }
+
+    int Quantize(float value, int maxValue, float scale)
+    {
+        return std::clamp(static_cast<int>(std::floor(value * scale + 0.5f)), 0, maxValue);
+    }
+
+    std::uint16_t PackRGB565(const float* color)
+    {
+        return static_cast<std::uint16_t>(Quantize(color[0], 31, 31.0f / 255.0f) << 11 | Quantize(color[1], 63, 63.0f / 255.0f) << 5 |
+                                          Quantize(color[2], 31, 31.0f / 255.0f));
+    }
+
+    void UnpackRGB565(std::uint16_t packed, float* color)
+    {
+        const int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = static_cast<float>(r << 3 | r >> 2);
+        color[1] = static_cast<float>(g << 2 | g >> 4);
+        color[2] = static_cast<float>(b << 3 | b >> 2);
+        color[3] = 0.0f;
+    }
+
+    float EncodeBC1(const BlockTexels& texels, const float* endpoint0, const float* endpoint1, unsigned char* output, int* indices)
+    {
+        // The 4 color mode needs the first endpoint to be the greater one
+        std::uint16_t color0 = PackRGB565(endpoint0), color1 = PackRGB565(endpoint1);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        float palette[4][4];
+        UnpackRGB565(color0, palette[0]);
+        UnpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 4; ++c)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+
+        // Equal endpoints fall in the 3 color mode, where index 0 is still the first endpoint
+        const float error = SelectIndices(texels, 3, palette, color0 == color1 ? 1 : 4, indices);
+
+        std::uint32_t bits = 0;
+        for (int i = 0; i < kBlockTexels; ++i)
+            bits |= static_cast<std::uint32_t>(indices[i]) << (2 * i);
+
+        output[0] = static_cast<unsigned char>(color0);
+        output[1] = static_cast<unsigned char>(color0 >> 8);
+        output[2] = static_cast<unsigned char>(color1);
+        output[3] = static_cast<unsigned char>(color1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            output[4 + i] = static_cast<unsigned char>(bits >> (8 * i));
+        return error;
+    }
+
+    void CompressBC1(const BlockTexels& texels, unsigned char* output)
+    {
+        float endpoint0[4], endpoint1[4];
+        int indices[kBlockTexels];
+        FitEndpoints(texels, 3, endpoint0, endpoint1);
+        const float error = EncodeBC1(texels, endpoint0, endpoint1, output, indices);
+
+        unsigned char refined[8];
+        if (error > 0.0f && RefineEndpoints(texels, 3, indices, kBC1Weights, endpoint0, endpoint1) &&
+            EncodeBC1(texels, endpoint0, endpoint1, refined, indices) < error)
+            std::memcpy(output, refined, sizeof(refined));
+    }
+
+    // Always in the 8 value mode, the extremes of the channel are the endpoints
+    void CompressBC4(const BlockTexels& texels, int channel, unsigned char* output)
+    {
+        float minValue = texels[0][channel], maxValue = texels[0][channel];
+        for (int i = 1; i < kBlockTexels; ++i)
+        {
+            minValue = std::min(minValue, texels[i][channel]);
+            maxValue = std::max(maxValue, texels[i][channel]);
+        }
+
+        const int value0 = Quantize(maxValue, 255, 1.0f), value1 = Quantize(minValue, 255, 1.0f);
+        output[0] = static_cast<unsigned char>(value0);
+        output[1] = static_cast<unsigned char>(value1);
+
+        std::uint64_t bits = 0;
+        if (value0 > value1)
+        {
+            float palette[8];
+            palette[0] = static_cast<float>(value0);
+            palette[1] = static_cast<float>(value1);
+            for (int i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * value0 + (i - 1) * value1) / 7.0f;
+
+            for (int i = 0; i < kBlockTexels; ++i)
+            {
+                int best = 0;
+                for (int entry = 1; entry < 8; ++entry)
+                    if (std::fabs(texels[i][channel] - palette[entry]) < std::fabs(texels[i][channel] - palette[best]))
+                        best = entry;
+                bits |= static_cast<std::uint64_t>(best) << (3 * i);
+            }
+        }
+
+        for (int i = 0; i < 6; ++i)
+            output[2 + i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+
+    // Pairs every index with its interpolation weight out of 64, as BPTC formats do
+    void GetBPTCWeights(float* weights)
+    {
+        for (int i = 0; i < 16; ++i)
+            weights[i] = kBPTCWeights[i] / 64.0f;
+    }
+
+    // The index of texel 0 drops its top bit, so it must point at the first half of the palette
+    template <typename Endpoint>
+    void FixAnchor(Endpoint& endpoint0, Endpoint& endpoint1, int* indices)
+    {
+        if (indices[0] < 8)
+            return;
+
+        std::swap(endpoint0, endpoint1);
+        for (int i = 0; i < kBlockTexels; ++i)
+            indices[i] = 15 - indices[i];
+    }
+
+    struct BC7Endpoint
+    {
+        int mValue[4];
+        int mPBit;
+    };
+
+    // 7 bits a channel with a shared lowest bit, whichever p-bit lands closer
+    BC7Endpoint QuantizeBC7(const float* endpoint)
+    {
+        BC7Endpoint best = {};
+        float bestError = 0.0f;
+        for (int pBit = 0; pBit < 2; ++pBit)
+        {
+            BC7Endpoint candidate = {};
+            candidate.mPBit = pBit;
+            float error = 0.0f;
+            for (int c = 0; c < 4; ++c)
+            {
+                candidate.mValue[c] = Quantize((endpoint[c] - pBit) * 0.5f, kBC7MaxValue, 1.0f);
+                const float difference = static_cast<float>(candidate.mValue[c] * 2 + pBit) - endpoint[c];
+                error += difference * difference;
+            }
+
+            if (pBit == 0 || error < bestError)
+            {
+                best = candidate;
+                bestError = error;
+            }
+        }
+        return best;
+    }
+
+    float EncodeBC7(const BlockTexels& texels, const float* endpoint0, const float* endpoint1, unsigned char* output, int* indices)
+    {
+        BC7Endpoint quantized0 = QuantizeBC7(endpoint0), quantized1 = QuantizeBC7(endpoint1);
+
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                const int value0 = quantized0.mValue[c] * 2 + quantized0.mPBit, value1 = quantized1.mValue[c] * 2 + quantized1.mPBit;
+                palette[i][c] = static_cast<float>(((64 - kBPTCWeights[i]) * value0 + kBPTCWeights[i] * value1 + 32) >> 6);
+            }
+        }
+
+        const float error = SelectIndices(texels, 4, palette, 16, indices);
+        FixAnchor(quantized0, quantized1, indices);
+
+        // Mode 6: a single subset with RGBA endpoints and 4 bit indices
+        BlockWriter writer(output);
+        writer.Write(1 << 6, 7);
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.Write(quantized0.mValue[c], 7);
+            writer.Write(quantized1.mValue[c], 7);
+        }
+        writer.Write(quantized0.mPBit, 1);
+        writer.Write(quantized1.mPBit, 1);
+        writer.Write(indices[0], 3);
+        for (int i = 1; i < kBlockTexels; ++i)
+            writer.Write(indices[i], 4);
+        return error;
+    }
+
+    void CompressBC7(const BlockTexels& texels, unsigned char* output)
+    {
+        float endpoint0[4], endpoint1[4], weights[16];
+        int indices[kBlockTexels];
+        FitEndpoints(texels, 4, endpoint0, endpoint1);
+        const float error = EncodeBC7(texels, endpoint0, endpoint1, output, indices);
+
+        // Indices are relative to the endpoints as written, after the anchor fix
+        unsigned char refined[16];
+        GetBPTCWeights(weights);
+        if (error > 0.0f && RefineEndpoints(texels, 4, indices, weights, endpoint0, endpoint1) &&
+            EncodeBC7(texels, endpoint0, endpoint1, refined, indices) < error)
+            std::memcpy(output, refined, sizeof(refined));
+    }
+
+    // Unsigned BC6H endpoints are scaled to 16 bits before the interpolation
+    int UnquantizeBC6H(int value)
+    {
+        if (value == 0)
+            return 0;
+        if (value == kBC6HMaxValue)
+            return 0xFFFF;
+        return ((value << 16) + 0x8000) >> 10;
+    }
+
+    struct BC6HEndpoint
+    {
+        int mValue[3];
+    };
+
+    float EncodeBC6H(const BlockTexels& texels, const float* endpoint0, const float* endpoint1, unsigned char* output, int* indices)
+    {
+        // A decoded value is 31/64 of the unquantized one, so an endpoint is about a 31st of the half it decodes to
+        BC6HEndpoint quantized0, quantized1;
+        for (int c = 0; c < 3; ++c)
+        {
+            quantized0.mValue[c] = Quantize(endpoint0[c], kBC6HMaxValue, 1.0f / 31.0f);
+            quantized1.mValue[c] = Quantize(endpoint1[c], kBC6HMaxValue, 1.0f / 31.0f);
+        }
+
+        float palette[16][4];
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                const int value0 = UnquantizeBC6H(quantized0.mValue[c]), value1 = UnquantizeBC6H(quantized1.mValue[c]);
+                const int interpolated = ((64 - kBPTCWeights[i]) * value0 + kBPTCWeights[i] * value1 + 32) >> 6;
+                palette[i][c] = static_cast<float>((interpolated * 31) >> 6);
+            }
+        }
+
+        const float error = SelectIndices(texels, 3, palette, 16, indices);
+        FixAnchor(quantized0, quantized1, indices);
+
+        // Mode 11: a single subset with 10 bit endpoints stored as they are
+        BlockWriter writer(output);
+        writer.Write(0x03, 5);
+        for (int c = 0; c < 3; ++c)
+            writer.Write(quantized0.mValue[c], 10);
+        for (int c = 0; c < 3; ++c)
+            writer.Write(quantized1.mValue[c], 10);
+        writer.Write(indices[0], 3);
+        for (int i = 1; i < kBlockTexels; ++i)
+            writer.Write(indices[i], 4);
+        return error;
+    }
+
+    // Fitted on the bits of the halves, which is the space the format interpolates in
+    void CompressBC6H(const BlockTexels& texels, unsigned char* output)
+    {
+        float endpoint0[4], endpoint1[4], weights[16];
+        int indices[kBlockTexels];
+        FitEndpoints(texels, 3, endpoint0, endpoint1);
+        const float error = EncodeBC6H(texels, endpoint0, endpoint1, output, indices);
+
+        unsigned char refined[16];
+        GetBPTCWeights(weights);
+        if (error > 0.0f && RefineEndpoints(texels, 3, indices, weights, endpoint0, endpoint1) &&
+            EncodeBC6H(texels, endpoint0, endpoint1, refined, indices) < error)
+            std::memcpy(output, refined, sizeof(refined));
+    }
+
+    unsigned int GetThreadCount(unsigned int threadCount)
+    {
+        return threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount;
+    }
+}
+
+unsigned int Dazzle::TextureCompressor::GetBlockSize(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1_RGB_UNORM:
+    case TextureFormat::BC1_RGB_SRGB:
+    case TextureFormat::BC4_UNORM:
+        return 8;
+    case TextureFormat::BC5_UNORM:
+    case TextureFormat::BC6H_UFLOAT:
+    case TextureFormat::BC7_UNORM:
+    case TextureFormat::BC7_SRGB:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+size_t Dazzle::TextureCompressor::GetCompressedSize(TextureFormat format, int width, int height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+GLenum Dazzle::TextureCompressor::GetInternalFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1_RGB_UNORM:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureFormat::BC1_RGB_SRGB:
+        return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    case TextureFormat::BC4_UNORM:
+        return GL_COMPRESSED_RED_RGTC1;
+    case TextureFormat::BC5_UNORM:
+        return GL_COMPRESSED_RG_RGTC2;
+    case TextureFormat::BC6H_UFLOAT:
+        return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+    case TextureFormat::BC7_UNORM:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    case TextureFormat::BC7_SRGB:
+        return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    default:
+        return 0;
+    }
+}
+
+std::vector<unsigned char> Dazzle::TextureCompressor::Compress(const unsigned char* rgba, int width, int height, TextureFormat format, unsigned int threadCount)
+{
+    const unsigned int blockSize = GetBlockSize(format);
+    if (blockSize == 0 || IsHDR(format))
+    {
+        std::cerr << "TextureCompressor: Format " << static_cast<std::uint32_t>(format) << " can't be compressed from 8 bit texels" << std::endl;
+        return std::vector<unsigned char>();
+    }
+
+    if (rgba == nullptr || width <= 0 || height <= 0)
+        return std::vector<unsigned char>();
+
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<unsigned char> output(GetCompressedSize(format, width, height));
+
+    // A row of blocks per task, every block is independent of the others
+    ParallelFor(blocksY, GetThreadCount(threadCount), [&](size_t blockY)
+    {
+        BlockTexels texels;
+        for (int blockX = 0; blockX < blocksX; ++blockX)
+        {
+            LoadBlock(rgba, width, height, blockX, static_cast<int>(blockY), texels);
+            unsigned char* block = output.data() + (blockY * blocksX + blockX) * blockSize;
+
+            switch (format)
+            {
+            case TextureFormat::BC1_RGB_UNORM:
+            case TextureFormat::BC1_RGB_SRGB:
+                CompressBC1(texels, block);
+                break;
+            case TextureFormat::BC4_UNORM:
+                CompressBC4(texels, 0, block);
+                break;
+            case TextureFormat::BC5_UNORM:
+                CompressBC4(texels, 0, block);
+                CompressBC4(texels, 1, block + 8);
+                break;
+            default:
+                CompressBC7(texels, block);
+                break;
+            }
+        }
+    });
+
+    return output;
+}
+
+std::vector<unsigned char> Dazzle::TextureCompressor::CompressHDR(const float* rgb, int width, int height, unsigned int threadCount)
+{
+    if (rgb == nullptr || width <= 0 || height <= 0)
+        return std::vector<unsigned char>();
+
+    const TextureFormat format = TextureFormat::BC6H_UFLOAT;
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<unsigned char> output(GetCompressedSize(format, width, height));
+
+    ParallelFor(blocksY, GetThreadCount(threadCount), [&](size_t blockY)
+    {
+        BlockTexels texels;
+        for (int blockX = 0; blockX < blocksX; ++blockX)
+        {
+            LoadHDRBlock(rgb, width, height, blockX, static_cast<int>(blockY), texels);
+            CompressBC6H(texels, output.data() + (blockY * blocksX + blockX) * GetBlockSize(format));
+        }
+    });
+
+    return output;
+}
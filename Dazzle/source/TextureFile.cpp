@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "TextureFile.hpp"
+
+namespace
+{
+    // Khronos Data Format values of the descriptor, see the KTX2 and Data Format specifications
+    const std::uint32_t kDFDVersion = 2;
+    const std::uint32_t kDFDPrimariesBT709 = 1;
+    const std::uint32_t kDFDTransferLinear = 1;
+    const std::uint32_t kDFDTransferSRGB = 2;
+    const std::uint32_t kDFDSampleFloat = 0x80;
+
+    enum class ColorModel : std::uint32_t { BC1A = 128, BC4 = 131, BC5 = 132, BC6H = 133, BC7 = 134 };
+
+    std::uint64_t Align(std::uint64_t offset, std::uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    template <typename T>
+    void Append(std::vector<char>& file, const T* data, size_t count)
+    {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        file.insert(file.end(), bytes, bytes + count * sizeof(T));
+    }
+
+    // Basic descriptor block of a block compressed format: a 4x4 texel block with one sample per channel it stores
+    std::vector<std::uint32_t> BuildDFD(Dazzle::TextureFormat format)
+    {
+        ColorModel model = ColorModel::BC7;
+        std::uint32_t channels = 1, sampleFlags = 0, upper = 0xFFFFFFFF;
+        switch (format)
+        {
+        case Dazzle::TextureFormat::BC1_RGB_UNORM:
+        case Dazzle::TextureFormat::BC1_RGB_SRGB:
+            model = ColorModel::BC1A;
+            break;
+        case Dazzle::TextureFormat::BC4_UNORM:
+            model = ColorModel::BC4;
+            break;
+        case Dazzle::TextureFormat::BC5_UNORM:
+            model = ColorModel::BC5;
+            channels = 2;
+            break;
+        case Dazzle::TextureFormat::BC6H_UFLOAT:
+            model = ColorModel::BC6H;
+            sampleFlags = kDFDSampleFloat;
+            upper = 0x3F800000;     // 1.0f
+            break;
+        default:
+            break;
+        }
+
+        const std::uint32_t blockSize = Dazzle::TextureCompressor::GetBlockSize(format);
+        const std::uint32_t sampleBits = blockSize * 8 / channels;
+        const std::uint32_t transfer = Dazzle::TextureCompressor::IsSRGB(format) ? kDFDTransferSRGB : kDFDTransferLinear;
+        const std::uint32_t descriptorSize = 24 + 16 * channels;
+
+        std::vector<std::uint32_t> dfd = {
+            4 + descriptorSize,                                                     // Total size, this word included
+            0,                                                                      // Khronos vendor, basic descriptor
+            kDFDVersion | descriptorSize << 16,
+            static_cast<std::uint32_t>(model) | kDFDPrimariesBT709 << 8 | transfer << 16,
+            3 | 3 << 8,                                                             // 4x4x1x1 texels, stored minus one
+            blockSize,                                                              // Bytes of plane 0
+            0
+        };
+
+        for (std::uint32_t channel = 0; channel < channels; ++channel)
+        {
+            dfd.push_back(channel * sampleBits | (sampleBits - 1) << 16 | (channel | sampleFlags) << 24);
+            dfd.push_back(0);
+            dfd.push_back(0);
+            dfd.push_back(upper);
+        }
+        return dfd;
+    }
+
+    int GetLevelExtent(std::uint32_t extent, unsigned int level)
+    {
+        return std::max(1, static_cast<int>(extent >> level));
+    }
+
+    std::uint32_t GetMaxLevelCount(std::uint32_t width, std::uint32_t height)
+    {
+        std::uint32_t count = 1;
+        for (std::uint32_t extent = std::max(width, height); extent > 1; extent >>= 1)
+            ++count;
+        return count;
+    }
+
+    // Each pair is its byte length, the key and the value, both NUL terminated, then padding to 4 bytes
+    std::vector<char> BuildKVD(const std::map<std::string, std::string>& keyValues)
+    {
+        std::vector<char> kvd;
+        for (const auto& keyValue : keyValues)
+        {
+            const std::uint32_t length = static_cast<std::uint32_t>(keyValue.first.size() + keyValue.second.size() + 2);
+            Append(kvd, &length, 1);
+            Append(kvd, keyValue.first.c_str(), keyValue.first.size() + 1);
+            Append(kvd, keyValue.second.c_str(), keyValue.second.size() + 1);
+            kvd.resize(Align(kvd.size(), 4), 0);
+        }
+        return kvd;
+    }
+}
+
+Dazzle::TextureFile::TextureFile() : mHeader(nullptr), mLevels(nullptr)
+{
+
+}
+
+bool Dazzle::TextureFile::Write(const std::string& path, TextureFormat format, int width, int height, unsigned int faceCount,
+                                const std::vector<std::vector<unsigned char>>& levels, const std::map<std::string, std::string>& keyValues)
+{
+    const unsigned int blockSize = TextureCompressor::GetBlockSize(format);
+    if (blockSize == 0 || width <= 0 || height <= 0 || (faceCount != 1 && faceCount != 6) || levels.empty() ||
+        levels.size() > GetMaxLevelCount(static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height)))
+    {
+        std::cerr << "TextureFile: Invalid texture description for " << path << std::endl;
+        return false;
+    }
+
+    for (unsigned int level = 0; level < levels.size(); ++level)
+    {
+        const size_t expected = faceCount * TextureCompressor::GetCompressedSize(format, GetLevelExtent(width, level), GetLevelExtent(height, level));
+        if (levels[level].size() != expected)
+        {
+            std::cerr << "TextureFile: Level " << level << " of " << path << " has " << levels[level].size() << " bytes, expected " << expected << std::endl;
+            return false;
+        }
+    }
+
+    const std::vector<std::uint32_t> dfd = BuildDFD(format);
+    const std::vector<char> kvd = BuildKVD(keyValues);
+
+    TextureFileHeader header = {};
+    std::memcpy(header.mIdentifier, kTextureFileIdentifier, sizeof(kTextureFileIdentifier));
+    header.mFormat = static_cast<std::uint32_t>(format);
+    header.mTypeSize = 1;
+    header.mWidth = static_cast<std::uint32_t>(width);
+    header.mHeight = static_cast<std::uint32_t>(height);
+    header.mFaceCount = faceCount;
+    header.mLevelCount = static_cast<std::uint32_t>(levels.size());
+    header.mDFDOffset = static_cast<std::uint32_t>(sizeof(TextureFileHeader) + levels.size() * sizeof(TextureFileLevel));
+    header.mDFDSize = static_cast<std::uint32_t>(dfd.size() * sizeof(std::uint32_t));
+    header.mKVDOffset = kvd.empty() ? 0 : header.mDFDOffset + header.mDFDSize;
+    header.mKVDSize = static_cast<std::uint32_t>(kvd.size());
+
+    // The level index needs the offsets of the data, so it's filled in once the data is laid out
+    std::vector<TextureFileLevel> index(levels.size());
+    std::vector<char> payload;
+    Append(payload, index.data(), index.size());
+    Append(payload, dfd.data(), dfd.size());
+    Append(payload, kvd.data(), kvd.size());
+
+    // Smallest level first, so a reader streaming the file gets a usable texture early
+    for (size_t level = levels.size(); level-- > 0;)
+    {
+        const std::uint64_t offset = Align(sizeof(TextureFileHeader) + payload.size(), blockSize);
+        payload.resize(offset - sizeof(TextureFileHeader), 0);
+        Append(payload, levels[level].data(), levels[level].size());
+        index[level] = {offset, levels[level].size(), levels[level].size()};
+    }
+    std::memcpy(payload.data(), index.data(), index.size() * sizeof(TextureFileLevel));
+
+    std::ofstream outputStream(path, std::ios::binary | std::ios::trunc);
+    if (outputStream.fail())
+    {
+        std::cerr << "TextureFile: Unable to write " << path << std::endl;
+        return false;
+    }
+
+    outputStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outputStream.write(payload.data(), payload.size());
+    return outputStream.good();
+}
+
+bool Dazzle::TextureFile::Open(const std::string& path)
+{
+    Close();
+    if (!mFile.Open(path))
+        return false;
+
+    const char* data = mFile.GetData();
+    const size_t size = mFile.GetSize();
+    const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(data);
+
+    if (size < sizeof(TextureFileHeader) || std::memcmp(header->mIdentifier, kTextureFileIdentifier, sizeof(kTextureFileIdentifier)) != 0)
+    {
+        std::cerr << "TextureFile: " << path << " is not a KTX2 file" << std::endl;
+        Close();
+        return false;
+    }
+
+    // Only what Write() produces: no supercompression, arrays or 3D textures, and levels stored rather than left to be
+    // generated, no more of them than the mip chain of the size has
+    const TextureFormat format = static_cast<TextureFormat>(header->mFormat);
+    if (TextureCompressor::GetBlockSize(format) == 0 || header->mSupercompression != 0 || header->mDepth != 0 || header->mLayerCount > 1 ||
+        (header->mFaceCount != 1 && header->mFaceCount != 6) || header->mLevelCount == 0 || header->mWidth == 0 || header->mHeight == 0 ||
+        header->mLevelCount > GetMaxLevelCount(header->mWidth, header->mHeight))
+    {
+        std::cerr << "TextureFile: " << path << " has an unsupported format or layout" << std::endl;
+        Close();
+        return false;
+    }
+
+    const TextureFileLevel* levels = reinterpret_cast<const TextureFileLevel*>(data + sizeof(TextureFileHeader));
+    bool valid = sizeof(TextureFileHeader) + header->mLevelCount * sizeof(TextureFileLevel) <= size &&
+                 header->mKVDOffset <= size && header->mKVDSize <= size - header->mKVDOffset;
+    for (std::uint32_t level = 0; valid && level < header->mLevelCount; ++level)
+    {
+        const size_t expected = header->mFaceCount * TextureCompressor::GetCompressedSize(format, GetLevelExtent(header->mWidth, level),
+                                                                                          GetLevelExtent(header->mHeight, level));
+        valid = levels[level].mSize == expected && levels[level].mOffset <= size && levels[level].mSize <= size - levels[level].mOffset;
+    }
+
+    if (!valid)
+    {
+        std::cerr << "TextureFile: " << path << " is truncated or corrupted" << std::endl;
+        Close();
+        return false;
+    }
+
+    mHeader = header;
+    mLevels = levels;
+    return true;
+}
+
+void Dazzle::TextureFile::Close()
+{
+    mFile.Close();
+    mHeader = nullptr;
+    mLevels = nullptr;
+}
+
+const unsigned char* Dazzle::TextureFile::GetLevelData(unsigned int level) const
+{
+    return reinterpret_cast<const unsigned char*>(mFile.GetData() + mLevels[level].mOffset);
+}
+
+std::string Dazzle::TextureFile::GetValue(const std::string& key) const
+{
+    if (!IsOpen())
+        return std::string();
+
+    // Open() checked the key/value data lies in the file, each pair is bounded by it again
+    const char* p = mFile.GetData() + mHeader->mKVDOffset;
+    const char* end = p + mHeader->mKVDSize;
+    while (end - p >= static_cast<std::ptrdiff_t>(sizeof(std::uint32_t)))
+    {
+        std::uint32_t length;
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        if (length > static_cast<std::uint64_t>(end - p))
+            break;
+
+        // The key ends at its NUL, the value takes the rest of the pair without its terminator
+        const char* pair = p;
+        const char* keyEnd = static_cast<const char*>(std::memchr(pair, '\0', length));
+        if (keyEnd != nullptr && key.compare(0, std::string::npos, pair, keyEnd - pair) == 0)
+        {
+            const char* valueEnd = pair + length;
+            if (valueEnd > keyEnd + 1 && valueEnd[-1] == '\0')
+                --valueEnd;
+            return std::string(keyEnd + 1, valueEnd);
+        }
+
+        p += std::min<std::uint64_t>(Align(length, 4), end - p);
+    }
+
+    return std::string();
+}
+
+GLuint Dazzle::TextureFile::CreateTexture() const
+{
+    if (!IsOpen())
+        return 0;
+
+    const GLenum internalFormat = TextureCompressor::GetInternalFormat(GetFormat());
+    GLuint texture = 0;
+    glCreateTextures(IsCubemap() ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, mHeader->mLevelCount, internalFormat, mHeader->mWidth, mHeader->mHeight);
+
+    // The blocks go to the driver as they are, straight from the mapped file
+    for (unsigned int level = 0; level < mHeader->mLevelCount; ++level)
+    {
+        const GLsizei width = GetLevelExtent(mHeader->mWidth, level), height = GetLevelExtent(mHeader->mHeight, level);
+        const unsigned char* levelData = GetLevelData(level);
+
+        if (IsCubemap())
+        {
+            const GLsizei faceSize = static_cast<GLsizei>(GetLevelSize(level) / mHeader->mFaceCount);
+            for (GLint face = 0; face < static_cast<GLint>(mHeader->mFaceCount); ++face)
+                glCompressedTextureSubImage3D(texture, level, 0, 0, face, width, height, 1, internalFormat, faceSize, levelData + face * faceSize);
+        }
+        else
+        {
+            glCompressedTextureSubImage2D(texture, level, 0, 0, width, height, internalFormat, static_cast<GLsizei>(GetLevelSize(level)), levelData);
+        }
+    }
+
+    return texture;
+}
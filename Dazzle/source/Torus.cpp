@@ -6,11 +6,12 @@
 #include "GL/gl3w.h"
 
 #include "RenderSystem.hpp"
+#include "VertexLayout.hpp"
 #include "Torus.hpp"
 
 Dazzle::Torus::Torus(   float majorRadius, float minorRadius, unsigned int ringSegments, unsigned int tubeSegments,
                         float thetaStart, float thetaEnd, float phiStart, float phiEnd)
-                        : mVAO(nullptr), mVBO(nullptr), mNVBO(nullptr),  mTCVBO(nullptr), mEBO(nullptr)
+                        : mVAO(nullptr), mVBO(nullptr), mEBO(nullptr), mIndexType(GL_UNSIGNED_INT)
 {
     // Calculate the number of indices and vertices according to ringSegments and tubeSegments
     unsigned int vertices = (ringSegments + 1) * (tubeSegments + 1);
@@ -93,6 +94,12 @@ Dazzle::Torus::Torus(   float majorRadius, float minorRadius, unsigned int ringS
         }
     }
 
+    // Row by row indices reuse few cached vertices, reorder them for the post-transform cache and vertex fetches
+    mOptimizationReport = MeshOptimizer::Optimize(mIndices, mVertices, {&mNormals, &mTextureCoordinates, &mTangents, &mBitangents});
+
+    // Cache the number of indices so Draw() doesn't need to query the geometry
+    mDrawCount = static_cast<unsigned int>(mIndices.size());
+
     // Transform
     mTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 }
@@ -102,11 +109,45 @@ void Dazzle::Torus::Draw() const
     if (!mVAO->IsValid())
         return;
 
+    // Without an instance buffer the shaders read the current InstanceTransform, which instanced draws leave undefined
+    if (mInstances == nullptr)
+        RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+
     // Bind VAO
     glBindVertexArray(mVAO->GetHandle());
 
     // Draw
-    glDrawElements(GL_TRIANGLES, (GLsizei)GetIndices().size(), GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0);
+}
+
+void Dazzle::Torus::SetInstanceTransforms(const std::vector<glm::mat4>& transforms)
+{
+    if (mVAO == nullptr)
+    {
+        std::cerr << "Torus: InitializeBuffers() must be called before setting instance transforms" << std::endl;
+        return;
+    }
+
+    if (mInstances == nullptr)
+    {
+        mInstances = std::make_unique<RenderSystem::GL::InstanceBuffer>();
+        mInstances->Attach(*mVAO);
+    }
+
+    mInstances->SetTransforms(transforms);
+}
+
+void Dazzle::Torus::DrawInstanced(GLuint firstInstance, GLsizei instanceCount) const
+{
+    if (!mVAO->IsValid() || mInstances == nullptr || mInstances->GetCount() == 0)
+        return;
+
+    if (instanceCount < 0)
+        instanceCount = mInstances->GetCount() - static_cast<GLsizei>(firstInstance);
+
+    // Draw the instances with a single call, the base instance offsets the per-instance attributes
+    glBindVertexArray(mVAO->GetHandle());
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, (GLsizei)mDrawCount, mIndexType, 0, instanceCount, firstInstance);
 }
 
 void Dazzle::Torus::SetPosition(glm::vec3 position)
@@ -125,66 +166,24 @@ void Dazzle::Torus::Rotate(glm::vec3 axis, float degrees)
     mTransform = glm::rotate(mTransform, radians, axis);
 }
 
-void Dazzle::Torus::InitializeBuffers()
+void Dazzle::Torus::InitializeBuffers(const RenderSystem::GL::VertexPacking& packing)
 {
-    const GLintptr kOffset = 0;
-    const GLintptr kStride = 0;
-    const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-    const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-    const GLenum kDataType = GL_FLOAT;
-    const GLboolean kNormalized = GL_FALSE;
-
-    const GLuint kPosAttribIndex = 0;
-    const GLuint kPosBindingIndex = 0;
-    const GLuint kNormAttribIndex = 1;
-    const GLuint kNormBindingIndex = 1;
-    const GLuint kTexAttribIndex = 2;
-    const GLuint kTexBindingIndex = 2;
-
     mVAO = std::make_unique<RenderSystem::GL::VAO>();
     mVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mNVBO = std::make_unique<RenderSystem::GL::VBO>();
-    mTCVBO = std::make_unique<RenderSystem::GL::VBO>();
     mEBO = std::make_unique<RenderSystem::GL::EBO>();
 
-    // Set up the data store for the Vertex Buffer Object for Vertices
-    glNamedBufferStorage(mVBO->GetHandle(), GetVertices().size() * sizeof(float), GetVertices().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Normals
-    glNamedBufferStorage(mNVBO->GetHandle(), GetNormals().size() * sizeof(float), GetNormals().data(), 0);
-
-    // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-    glNamedBufferStorage(mTCVBO->GetHandle(), GetTextureCoordinates().size() * sizeof(float), GetTextureCoordinates().data(), 0);
-
-    // Set up the data store for the Element Buffer Object for Indices
-    glNamedBufferStorage(mEBO->GetHandle(), GetIndices().size() * sizeof(unsigned int), GetIndices().data(), 0);
-
-    // Bind Vertex Buffer Object for Vertices to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kPosBindingIndex, mVBO->GetHandle(), kOffset, 3 * sizeof(float));
-
-    // Specify the format for the Vertices attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kPosAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kPosAttribIndex, kPosBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kPosAttribIndex);
-
-    // Bind Vertex Buffer Object for Normals to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kNormBindingIndex, mNVBO->GetHandle(), kOffset, 3 * sizeof(float));
-
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kNormAttribIndex, kNormBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kNormAttribIndex);
-
-    // Bind Vertex Buffer Object for the Texture Coordinates to Vertex Array Object
-    glVertexArrayVertexBuffer(  mVAO->GetHandle(), kTexBindingIndex, mTCVBO->GetHandle(), kOffset, 2 * sizeof(float));
-
-    // Specify the format for the Normals attribute
-    glVertexArrayAttribFormat(  mVAO->GetHandle(), kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-    glVertexArrayAttribBinding( mVAO->GetHandle(), kTexAttribIndex, kTexBindingIndex);
-    glEnableVertexArrayAttrib(  mVAO->GetHandle(), kTexAttribIndex);
-
-    // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
-    glVertexArrayElementBuffer(mVAO->GetHandle(), mEBO->GetHandle());
+    // Interleave every attribute into a single Vertex Buffer Object
+    RenderSystem::GL::VertexBufferBuilder builder;
+    builder.SetPositions(mVertices)
+           .SetNormals(mNormals)
+           .SetTextureCoordinates(mTextureCoordinates)
+           .SetIndices(mIndices)
+           .SetPacking(packing)
+           .Build(*mVAO, *mVBO, mEBO.get());
+
+    mIndexType = builder.GetIndexType();
+    mMemoryReport = builder.GetMemoryReport();
+    mBounds = BoundingVolume::Compute(mVertices);
 
     glBindVertexArray(mVAO->GetHandle());
 }
\ No newline at end of file
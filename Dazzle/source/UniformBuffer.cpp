@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "UniformBuffer.hpp"
+
+namespace
+{
+    const GLbitfield kMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLuint64 kFenceTimeout = 1000000; // 1 ms, in nanoseconds
+}
+
+Dazzle::RenderSystem::GL::ObjectUniforms Dazzle::RenderSystem::GL::ObjectUniforms::Create(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection)
+{
+    ObjectUniforms object;
+    object.mModel = model;
+    object.mModelView = view * model;
+    object.mMVP = projection * object.mModelView;
+
+    glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(object.mModelView)));
+    for (int i = 0; i < 3; ++i)
+        object.mNormal[i] = glm::vec4(normal[i], 0.0f);
+
+    return object;
+}
+
+Dazzle::RenderSystem::GL::UniformRingBuffer::UniformRingBuffer() :  mBuffer(0), mMappedData(nullptr), mFrameSize(0), mHead(0),
+                                                                    mAlignment(256), mFrameIndex(0), mFences()
+{
+
+}
+
+Dazzle::RenderSystem::GL::UniformRingBuffer::~UniformRingBuffer()
+{
+    for (auto& fence : mFences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    }
+
+    if (mBuffer > 0)
+    {
+        glUnmapNamedBuffer(mBuffer);
+        glDeleteBuffers(1, &mBuffer);
+    }
+}
+
+void Dazzle::RenderSystem::GL::UniformRingBuffer::Initialize(GLsizeiptr frameSize)
+{
+    GLint uniformAlignment = 0;
+    GLint storageAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    mAlignment = std::max({uniformAlignment, storageAlignment, 16});
+
+    // Keep every region aligned so offsets stay valid across frames
+    mFrameSize = (frameSize + mAlignment - 1) / mAlignment * mAlignment;
+    mHead = 0;
+    mFrameIndex = 0;
+
+    glCreateBuffers(1, &mBuffer);
+    glNamedBufferStorage(mBuffer, mFrameSize * kFrameCount, nullptr, kMapFlags);
+    mMappedData = static_cast<unsigned char*>(glMapNamedBufferRange(mBuffer, 0, mFrameSize * kFrameCount, kMapFlags));
+
+    if (mMappedData == nullptr)
+        std::cerr << "UniformRingBuffer: Failed to map the uniform buffer" << std::endl;
+}
+
+void Dazzle::RenderSystem::GL::UniformRingBuffer::BeginFrame()
+{
+    GLsync& fence = mFences[mFrameIndex];
+    if (fence != nullptr)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, 0, kFenceTimeout);
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    mHead = 0;
+}
+
+void Dazzle::RenderSystem::GL::UniformRingBuffer::EndFrame()
+{
+    mFences[mFrameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    mFrameIndex = (mFrameIndex + 1) % kFrameCount;
+}
+
+GLintptr Dazzle::RenderSystem::GL::UniformRingBuffer::Write(const void* data, GLsizeiptr size)
+{
+    if (!IsValid())
+        return -1;
+
+    if (mHead + size > mFrameSize)
+    {
+        std::cerr << "UniformRingBuffer: Out of space, " << mFrameSize << " bytes per frame are not enough" << std::endl;
+        return -1;
+    }
+
+    GLintptr offset = mFrameIndex * mFrameSize + mHead;
+    std::memcpy(mMappedData + offset, data, size);
+    mHead = (mHead + size + mAlignment - 1) / mAlignment * mAlignment;
+    return offset;
+}
+
+void Dazzle::RenderSystem::GL::UniformRingBuffer::Bind(GLuint binding, GLintptr offset, GLsizeiptr size, GLenum target) const
+{
+    if (offset < 0)
+        return;
+
+    glBindBufferRange(target, binding, mBuffer, offset, size);
+}
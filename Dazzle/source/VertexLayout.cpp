@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+
+#include "VertexLayout.hpp"
+
+namespace
+{
+    const GLuint kBindingIndex = 0;     // All the attributes are sourced from the same buffer binding
+    const size_t kMaxShortIndexVertices = 65536;
+
+    // IEEE 754 single to half precision, rounding to nearest.
+    uint16_t ToHalfFloat(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFFu) - 127 + 15;
+        uint32_t mantissa = bits & 0x7FFFFFu;
+
+        // Infinity and NaN
+        if (((bits >> 23) & 0xFFu) == 0xFFu)
+            return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u));
+
+        // Too large, clamp to infinity
+        if (exponent >= 31)
+            return static_cast<uint16_t>(sign | 0x7C00u);
+
+        // Subnormal or zero
+        if (exponent <= 0)
+        {
+            if (exponent < -10)
+                return static_cast<uint16_t>(sign);
+
+            mantissa |= 0x800000u;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            if ((mantissa >> (shift - 1)) & 1u)
+                ++half;
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        // A carry out of the mantissa correctly bumps the exponent
+        if (mantissa & 0x1000u)
+            ++half;
+        return static_cast<uint16_t>(half);
+    }
+
+    // Signed normalized GL_INT_2_10_10_10_REV, x lives in the least significant bits.
+    uint32_t ToPackedSnorm(float x, float y, float z, float w)
+    {
+        auto pack = [](float value, float scale, uint32_t mask)
+        {
+            int32_t quantized = static_cast<int32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * scale));
+            return static_cast<uint32_t>(quantized) & mask;
+        };
+
+        return  pack(x, 511.0f, 0x3FFu) |
+               (pack(y, 511.0f, 0x3FFu) << 10) |
+               (pack(z, 511.0f, 0x3FFu) << 20) |
+               (pack(w, 1.0f, 0x3u) << 30);
+    }
+
+    enum class Encoding
+    {
+        Float,
+        HalfFloat,
+        PackedSnorm
+    };
+
+    struct Stream
+    {
+        const std::vector<float>* mData;
+        GLint mComponents;      // Number of floats per vertex in mData
+        Encoding mEncoding;
+        GLuint mOffset;         // Relative offset within the interleaved vertex
+    };
+}
+
+Dazzle::RenderSystem::GL::VertexLayout::VertexLayout() : mStride(0)
+{
+
+}
+
+void Dazzle::RenderSystem::GL::VertexLayout::Add(GLuint location, GLint size, GLenum type, GLboolean normalized)
+{
+    GLuint offset = (mStride + 3u) & ~3u;
+    mAttributes.push_back({location, size, type, normalized, offset});
+    mStride = (offset + GetAttributeSize(type, size) + 3u) & ~3u;
+}
+
+void Dazzle::RenderSystem::GL::VertexLayout::Add(const VertexAttributeFormat& attribute)
+{
+    mAttributes.push_back(attribute);
+    mStride = std::max(mStride, (attribute.mRelativeOffset + GetAttributeSize(attribute.mType, attribute.mSize) + 3u) & ~3u);
+}
+
+void Dazzle::RenderSystem::GL::VertexLayout::Apply(GLuint vao, GLuint bindingIndex) const
+{
+    for (const auto& attribute : mAttributes)
+    {
+        glVertexArrayAttribFormat(  vao,                            // Vertex Array Object
+                                    attribute.mLocation,            // (Vertex) Attribute Index
+                                    attribute.mSize,                // Size (Number of values per vertex)
+                                    attribute.mType,                // Data Type
+                                    attribute.mNormalized,          // Normalized
+                                    attribute.mRelativeOffset);     // Relative Offset
+        glVertexArrayAttribBinding( vao, attribute.mLocation, bindingIndex);
+        glEnableVertexArrayAttrib(  vao, attribute.mLocation);
+    }
+}
+
+GLuint Dazzle::RenderSystem::GL::VertexLayout::GetAttributeSize(GLenum type, GLint size)
+{
+    switch (type)
+    {
+    case GL_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        return 4;
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return static_cast<GLuint>(size);
+    case GL_HALF_FLOAT:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2 * static_cast<GLuint>(size);
+    case GL_FLOAT:
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+        return 4 * static_cast<GLuint>(size);
+    case GL_DOUBLE:
+        return 8 * static_cast<GLuint>(size);
+    default:
+        std::cerr << "VertexLayout: Unknown attribute type " << type << std::endl;
+        return 4 * static_cast<GLuint>(size);
+    }
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder::VertexBufferBuilder() :  mPositions(nullptr), mNormals(nullptr), mTextureCoordinates(nullptr),
+                                                                        mTangents(nullptr), mBitangents(nullptr), mIndices(nullptr),
+                                                                        mIndexType(GL_UNSIGNED_INT)
+{
+
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetPositions(const std::vector<float>& positions)
+{
+    mPositions = &positions;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetNormals(const std::vector<float>& normals)
+{
+    mNormals = &normals;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetTextureCoordinates(const std::vector<float>& textureCoordinates)
+{
+    mTextureCoordinates = &textureCoordinates;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetTangents(const std::vector<float>& tangents)
+{
+    mTangents = &tangents;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetBitangents(const std::vector<float>& bitangents)
+{
+    mBitangents = &bitangents;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetIndices(const std::vector<unsigned int>& indices)
+{
+    mIndices = &indices;
+    return *this;
+}
+
+Dazzle::RenderSystem::GL::VertexBufferBuilder& Dazzle::RenderSystem::GL::VertexBufferBuilder::SetPacking(const VertexPacking& packing)
+{
+    mPacking = packing;
+    return *this;
+}
+
+bool Dazzle::RenderSystem::GL::VertexBufferBuilder::Build(const VAO& vao, const VBO& vbo, const EBO* ebo)
+{
+    std::vector<unsigned char> vertexData;
+    if (!Interleave(vertexData))
+        return false;
+
+    const size_t vertexCount = mPositions->size() / 3;
+
+    glNamedBufferStorage(vbo.GetHandle(), vertexData.size(), vertexData.data(), 0);
+    mMemoryReport.mBytesAfter += vertexData.size();
+    mMemoryReport.mBufferObjectsAfter++;
+
+    glVertexArrayVertexBuffer(vao.GetHandle(), kBindingIndex, vbo.GetHandle(), 0, mLayout.GetStride());
+    mLayout.Apply(vao.GetHandle(), kBindingIndex);
+
+    // Indices
+    if (ebo != nullptr && mIndices != nullptr && !mIndices->empty())
+    {
+        mMemoryReport.mBytesBefore += mIndices->size() * sizeof(unsigned int);
+        mMemoryReport.mBufferObjectsBefore++;
+
+        if (mPacking.mShortIndices && vertexCount <= kMaxShortIndexVertices)
+        {
+            std::vector<uint16_t> shortIndices(mIndices->begin(), mIndices->end());
+            glNamedBufferStorage(ebo->GetHandle(), shortIndices.size() * sizeof(uint16_t), shortIndices.data(), 0);
+            mMemoryReport.mBytesAfter += shortIndices.size() * sizeof(uint16_t);
+            mIndexType = GL_UNSIGNED_SHORT;
+        }
+        else
+        {
+            glNamedBufferStorage(ebo->GetHandle(), mIndices->size() * sizeof(unsigned int), mIndices->data(), 0);
+            mMemoryReport.mBytesAfter += mIndices->size() * sizeof(unsigned int);
+            mIndexType = GL_UNSIGNED_INT;
+        }
+        mMemoryReport.mBufferObjectsAfter++;
+
+        // Bind Element Buffer Object to the element array buffer bind point of the Vertex Array Object
+        glVertexArrayElementBuffer(vao.GetHandle(), ebo->GetHandle());
+    }
+
+    return true;
+}
+
+bool Dazzle::RenderSystem::GL::VertexBufferBuilder::Interleave(std::vector<unsigned char>& vertexData)
+{
+    mLayout = VertexLayout();
+    mMemoryReport = VertexMemoryReport();
+    mIndexType = GL_UNSIGNED_INT;
+
+    if (mPositions == nullptr || mPositions->empty() || mPositions->size() % 3 != 0)
+    {
+        std::cerr << "VertexBufferBuilder: Positions are missing or not made of 3 components" << std::endl;
+        return false;
+    }
+
+    const size_t vertexCount = mPositions->size() / 3;
+    std::vector<Stream> streams;
+
+    // Skips empty attributes and the ones whose size doesn't match the number of vertices.
+    auto addStream = [&](const std::vector<float>* data, GLuint location, const char* name,
+                         std::initializer_list<GLint> validComponents, Encoding encoding)
+    {
+        if (data == nullptr || data->empty())
+            return;
+
+        GLint components = static_cast<GLint>(data->size() / vertexCount);
+        bool valid = data->size() % vertexCount == 0 &&
+                     std::find(validComponents.begin(), validComponents.end(), components) != validComponents.end();
+        if (!valid)
+        {
+            std::cerr << "VertexBufferBuilder: Ignoring " << name << ", " << data->size() << " values for " << vertexCount << " vertices" << std::endl;
+            return;
+        }
+
+        mMemoryReport.mBytesBefore += data->size() * sizeof(float);
+        mMemoryReport.mBufferObjectsBefore++;
+
+        switch (encoding)
+        {
+        case Encoding::Float:
+            mLayout.Add(location, components, GL_FLOAT);
+            break;
+        case Encoding::HalfFloat:
+            mLayout.Add(location, components, GL_HALF_FLOAT);
+            break;
+        case Encoding::PackedSnorm:
+            mLayout.Add(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE);
+            break;
+        }
+        streams.push_back({data, components, encoding, mLayout.GetAttributes().back().mRelativeOffset});
+    };
+
+    const Encoding vectorEncoding = mPacking.mPackedNormals ? Encoding::PackedSnorm : Encoding::Float;
+    const Encoding textureEncoding = mPacking.mHalfFloatTextureCoordinates ? Encoding::HalfFloat : Encoding::Float;
+
+    addStream(mPositions, kPositionLocation, "positions", {3}, Encoding::Float);
+    addStream(mNormals, kNormalLocation, "normals", {3}, vectorEncoding);
+    addStream(mTextureCoordinates, kTextureCoordinatesLocation, "texture coordinates", {2}, textureEncoding);
+    addStream(mTangents, kTangentLocation, "tangents", {3, 4}, vectorEncoding);
+    addStream(mBitangents, kBitangentLocation, "bitangents", {3}, vectorEncoding);
+
+    // Interleave
+    const GLuint stride = mLayout.GetStride();
+    vertexData.assign(vertexCount * stride, 0);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        unsigned char* destination = vertexData.data() + vertex * stride;
+        for (const auto& stream : streams)
+        {
+            const float* source = stream.mData->data() + vertex * stream.mComponents;
+            switch (stream.mEncoding)
+            {
+            case Encoding::Float:
+                std::memcpy(destination + stream.mOffset, source, stream.mComponents * sizeof(float));
+                break;
+            case Encoding::HalfFloat:
+                for (GLint i = 0; i < stream.mComponents; ++i)
+                {
+                    uint16_t half = ToHalfFloat(source[i]);
+                    std::memcpy(destination + stream.mOffset + i * sizeof(uint16_t), &half, sizeof(half));
+                }
+                break;
+            case Encoding::PackedSnorm:
+            {
+                // A missing w defaults to 1, as it does for float attributes
+                float w = stream.mComponents == 4 ? source[3] : 1.0f;
+                uint32_t packed = ToPackedSnorm(source[0], source[1], source[2], w);
+                std::memcpy(destination + stream.mOffset, &packed, sizeof(packed));
+                break;
+            }
+            }
+        }
+    }
+
+    return true;
+}
+
+Dazzle::RenderSystem::GL::InstanceBuffer::InstanceBuffer() : mCapacity(0), mCount(0)
+{
+
+}
+
+void Dazzle::RenderSystem::GL::InstanceBuffer::Attach(const VAO& vao) const
+{
+    // A mat4 attribute takes four consecutive locations, one per column
+    VertexLayout layout;
+    for (GLuint column = 0; column < 4; ++column)
+        layout.Add(kInstanceTransformLocation + column, 4, GL_FLOAT);
+
+    glVertexArrayVertexBuffer(vao.GetHandle(), kInstanceBindingIndex, mVBO.GetHandle(), 0, layout.GetStride());
+    glVertexArrayBindingDivisor(vao.GetHandle(), kInstanceBindingIndex, 1);
+    layout.Apply(vao.GetHandle(), kInstanceBindingIndex);
+}
+
+void Dazzle::RenderSystem::GL::InstanceBuffer::SetTransforms(const std::vector<glm::mat4>& transforms)
+{
+    GLsizeiptr size = static_cast<GLsizeiptr>(transforms.size() * sizeof(glm::mat4));
+    if (size > mCapacity)
+    {
+        // Re-specifying the data store keeps the buffer name, vertex arrays don't need to be attached again
+        glNamedBufferData(mVBO.GetHandle(), size, transforms.data(), GL_DYNAMIC_DRAW);
+        mCapacity = size;
+    }
+    else if (size > 0)
+    {
+        glNamedBufferSubData(mVBO.GetHandle(), 0, size, transforms.data());
+    }
+
+    mCount = static_cast<GLsizei>(transforms.size());
+}
+
+void Dazzle::RenderSystem::GL::InstanceBuffer::SetIdentityDefault()
+{
+    const glm::mat4 identity(1.0f);
+    for (GLuint column = 0; column < 4; ++column)
+        glVertexAttrib4fv(kInstanceTransformLocation + column, &identity[column][0]);
+}
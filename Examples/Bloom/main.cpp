@@ -8,12 +8,15 @@
 
 #include "RenderSystem.hpp"
 #include "FileManager.hpp"
+#include "LuminanceReduction.hpp"
 #include "Plane.hpp"
 #include "Sphere.hpp"
 #include "Torus.hpp"
+#include "UniformBuffer.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
+#include "GPUTimer.hpp"
 #include "Scene.hpp"
 #include "UserInterface.hpp"
 #include "Utils.hpp"
@@ -32,16 +35,19 @@ public:
         Dazzle::RenderSystem::GL::ProgramObject mProgram;
     };
 
+    // std140 layout of the MaterialBlock uniform block
     struct Material
     {
         glm::vec3 mAmbient;
+        float mPadding0;
         glm::vec3 mDiffuse;
+        float mPadding1;
         glm::vec3 mSpecular;
         float mShininess;
     };
+    static_assert(sizeof(Material) == 48, "Material must match the std140 layout of MaterialBlock");
 
-    SceneBloom() :  mMVP(), mModelView(), mNormalMtx(),
-                    mWidth(), mHeight() {}
+    SceneBloom() :  mTargetFormat(Utils::Texture::HDRFormat::R11F_G11F_B10F), mWidth(), mHeight() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
     {
@@ -63,6 +69,9 @@ public:
         CreateTexture(mHDRConfig.mTexture, mWidth, mHeight);
         mHDRFrameBuffer = CreateFramebufferObject(mHDRConfig);
 
+        // GPU reduction of the HDR texture's log-average luminance
+        mLuminance.Initialize(mHDRConfig.mWidth, mHDRConfig.mHeight);
+
         // Blur Framebuffer Object
         mBlurConfig.mWidth = mWidth / 8;
         mBlurConfig.mHeight = mHeight / 8;
@@ -103,6 +112,9 @@ public:
         mTorus->SetPosition(glm::vec3(2.0f, -3.0f, 2.0f));
         mTorus->InitializeBuffers();
 
+        // GPU timer queries, read back once available to avoid stalling the pipeline
+        mGPUTimer.Initialize();
+
         // -----------------------------------------------------------------------------------------
         // Textures for this scene:
         // Bind Texture Unit 0 to Texture Object
@@ -120,19 +132,73 @@ public:
 
     void Update(double time) override
     {
-
+        mDeltaTime = (mLastTime > 0.0) ? static_cast<float>(time - mLastTime) : 0.0f;
+        mLastTime = time;
     }
 
     void Render() override
     {
+        // Uniform blocks of this frame are written to its own region of the ring buffer
+        mUniforms.BeginFrame();
+
+        mGPUTimer.Begin();
+
         Pass1(); // Render Scene to Texture
-        CalculateLogarithmicAverageLuminance(); // Calculate average luminance from HDR texture
+        mLuminance.Compute(mHDRConfig.mTexture, mDeltaTime); // Calculate average luminance from HDR texture
         Pass2(); // Bright-pass filter
         Pass3(); // First Gaussian Blur Pass
         Pass4(); // Second Gaussian Blur Pass
         Pass5(); // Render Scene with HDR Tone Mapping
+
+        mGPUTimer.End();
+
+        mUniforms.EndFrame();
     }
 
+    // Recreates the render targets in format, the framebuffers and texture units are pointed at the new ones
+    void SetTargetFormat(Utils::Texture::HDRFormat format)
+    {
+        if (format == mTargetFormat)
+            return;
+
+        mTargetFormat = format;
+        GLuint textures[] = {mHDRConfig.mTexture, mBlurConfig.mTexture, mTexture1, mTexture2};
+        glDeleteTextures(4, textures);
+
+        CreateTexture(mHDRConfig.mTexture, mHDRConfig.mWidth, mHDRConfig.mHeight);
+        CreateTexture(mBlurConfig.mTexture, mBlurConfig.mWidth, mBlurConfig.mHeight);
+        CreateTexture(mTexture1, mBlurConfig.mWidth, mBlurConfig.mHeight);
+        CreateTexture(mTexture2, mBlurConfig.mWidth, mBlurConfig.mHeight);
+        glNamedFramebufferTexture(mHDRFrameBuffer, GL_COLOR_ATTACHMENT0, mHDRConfig.mTexture, mHDRConfig.mMipmapLevel);
+        glNamedFramebufferTexture(mBlurFrameBuffer, GL_COLOR_ATTACHMENT0, mBlurConfig.mTexture, mBlurConfig.mMipmapLevel);
+
+        glBindTextureUnit(0, mHDRConfig.mTexture);
+        glBindTextureUnit(1, mTexture1);
+        glBindTextureUnit(2, mTexture2);
+    }
+
+    Utils::Texture::HDRFormat GetTargetFormat() const { return mTargetFormat; }
+
+    // Bytes of the HDR render targets: the full resolution one and three at 1/8
+    size_t GetTargetMemory(Utils::Texture::HDRFormat format) const
+    {
+        const size_t fullSize = static_cast<size_t>(mHDRConfig.mWidth) * mHDRConfig.mHeight;
+        const size_t blurSize = static_cast<size_t>(mBlurConfig.mWidth) * mBlurConfig.mHeight;
+        return (fullSize + 3 * blurSize) * Utils::Texture::GetTexelSize(format);
+    }
+
+    // Estimate of the render target bytes written and read in a frame, each pass touching every texel once: the
+    // full resolution target is written by pass 1 and read by the luminance reduction and pass 5, the blur targets
+    // are written by passes 2 to 4 and read by passes 3 to 5, and pass 2 reads the HDR target at their resolution
+    size_t GetTargetTraffic(Utils::Texture::HDRFormat format) const
+    {
+        const size_t fullSize = static_cast<size_t>(mHDRConfig.mWidth) * mHDRConfig.mHeight;
+        const size_t blurSize = static_cast<size_t>(mBlurConfig.mWidth) * mBlurConfig.mHeight;
+        return (3 * fullSize + 7 * blurSize) * Utils::Texture::GetTexelSize(format);
+    }
+
+    double GetGPUTime() const { return mGPUTimer.GetTime(); }
+
     void SetExposure(float exposure)
     {
         glUniform1f(mShader.mLocations.at("Exposure"), exposure);
@@ -148,6 +214,19 @@ public:
         glUniform1f(mShader.mLocations.at("LuminanceThreshold"), threshold);
     }
 
+    void SetEyeAdaptationRate(float rate)
+    {
+        mLuminance.SetAdaptationRate(rate);
+    }
+
+    // Compare the GPU luminance reduction against the CPU reference implementation.
+    // Both read data back from the GPU, so this stalls the pipeline and is meant for validation only.
+    void ValidateLuminance(float& gpuLuminance, float& cpuLuminance)
+    {
+        gpuLuminance = mLuminance.ReadAverageLuminance();
+        cpuLuminance = Dazzle::RenderSystem::GL::LuminanceReduction::CalculateReference(mHDRConfig.mTexture, mHDRConfig.mWidth, mHDRConfig.mHeight);
+    }
+
     void KeyCallback(int key, int scancode, int action, int mods) override {}
     void CursorCallback(double xPosition, double yPosition) override {}
     void FramebufferResizeCallback(int width, int height) override
@@ -158,27 +237,6 @@ public:
 
 private:
 
-    // Calculate the logarithmic average luminance from an HDR texture
-    void CalculateLogarithmicAverageLuminance()
-    {
-        int size = mWidth * mHeight; // Total number of pixels in the texture
-        std::vector<float> textureData(size * 3); // RGB data for each pixel
-        // Bind the HDR texture and read its pixel data
-        // Note: This assumes the texture is in RGB format with floating-point values
-        glGetTextureImage(mHDRConfig.mTexture, 0, GL_RGB, GL_FLOAT, textureData.size() * sizeof(float), textureData.data());
-        float sum = 0.0f;
-        for (int i = 0; i < size * 3; i += 3)
-        {
-            float r = textureData[i];
-            float g = textureData[i + 1];
-            float b = textureData[i + 2];
-            // Calculate luminance using the Rec. 709 formula
-            float luminance = glm::dot(glm::vec3(r, g, b), glm::vec3(0.2126f, 0.7152f, 0.0722f));
-            sum += logf(luminance + 0.00001f); // Avoid log(0)
-        }
-
-        glUniform1f(mShader.mLocations.at("AverageLuminance"), expf(sum / size));
-    }
 
     // Pass #1: Render the scene to an HDR texture
     void Pass1()
@@ -194,19 +252,19 @@ private:
         UpdateUniforms(mCamera->GetTransform());
 
         UpdateMaterial(mWallMaterial);
-        UpdateMatrices(mShader, mFloor->GetTransform());
+        UpdateMatrices(mFloor->GetTransform());
         mFloor->Draw();
-        UpdateMatrices(mShader, mWall->GetTransform());
+        UpdateMatrices(mWall->GetTransform());
         mWall->Draw();
-        UpdateMatrices(mShader, mCeiling->GetTransform());
+        UpdateMatrices(mCeiling->GetTransform());
         mCeiling->Draw();
 
         UpdateMaterial(mSphereMaterial);
-        UpdateMatrices(mShader, mSphere->GetTransform());
+        UpdateMatrices(mSphere->GetTransform());
         mSphere->Draw();
 
         UpdateMaterial(mTorusMaterial);
-        UpdateMatrices(mShader, mTorus->GetTransform());
+        UpdateMatrices(mTorus->GetTransform());
         mTorus->Draw();
     }
 
@@ -224,16 +282,8 @@ private:
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Update Matrices
-        auto model = mQuad->GetTransform();
-        auto view = glm::mat4(1.0f);
-        auto projection = glm::mat4(1.0f);
-        auto modelView = view * model;
-        auto MVP = projection * modelView;
-        auto normal = glm::transpose(glm::inverse(glm::mat3(modelView)));
-        glUniformMatrix4fv(mShader.mLocations.at("ModelView"), 1, GL_FALSE, glm::value_ptr(modelView));
-        glUniformMatrix4fv(mShader.mLocations.at("MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
-        glUniformMatrix3fv(mShader.mLocations.at("Normal"), 1, GL_FALSE, glm::value_ptr(normal));
+        // Update Matrices, the quad is already in clip space
+        UpdateMatrices(mQuad->GetTransform(), glm::mat4(1.0f), glm::mat4(1.0f));
 
         // Draw
         mQuad->Draw();
@@ -279,51 +329,43 @@ private:
         glBindSampler(1, mNearestSampler);
     }
 
-    void UpdateMatrices(const ShaderProgram& shader, glm::mat4 model)
+    void UpdateMatrices(const glm::mat4& model)
     {
-        glm::mat4 view = mCamera->GetTransform();
-        glm::mat4 projection = mCamera->GetProjection();
-
-        mModelView = view * model;
-        mMVP = projection * mModelView;
-        mNormalMtx = glm::transpose(glm::inverse(glm::mat3(mModelView)));
-
-        auto location = shader.mLocations.find("Model");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(model));
-
-        location = shader.mLocations.find("ModelView");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mModelView));
-
-        location = shader.mLocations.find("MVP");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mMVP));
+        UpdateMatrices(model, mCamera->GetTransform(), mCamera->GetProjection());
+    }
 
-        location = shader.mLocations.find("Normal");
-        if (location != shader.mLocations.end())
-           glUniformMatrix3fv(location->second, 1, GL_FALSE, glm::value_ptr(mNormalMtx));
+    void UpdateMatrices(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection)
+    {
+        auto object = Dazzle::RenderSystem::GL::ObjectUniforms::Create(model, view, projection);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kObjectBlockBinding, object);
     }
 
     void UpdateUniforms(const glm::mat4& transform)
     {
-        glm::vec4 lightPosition;
-        lightPosition = transform * glm::vec4(-7.0f, 4.0f, 2.5f, 1.0f);
-        glUniform4fv(mShader.mLocations.at("lights[0].mPosition"), 1, glm::value_ptr(lightPosition));
-
-        lightPosition = transform * glm::vec4(0.0f, 4.0f, 2.5f, 1.0f);
-        glUniform4fv(mShader.mLocations.at("lights[1].mPosition"), 1, glm::value_ptr(lightPosition));
+        const glm::vec4 lightPositions[] = {
+            glm::vec4(-7.0f, 4.0f, 2.5f, 1.0f),
+            glm::vec4(0.0f, 4.0f, 2.5f, 1.0f),
+            glm::vec4(7.0f, 4.0f, 2.5f, 1.0f)
+        };
+
+        Dazzle::RenderSystem::GL::FrameUniforms frame = {};
+        frame.mView = transform;
+        frame.mProjection = mCamera->GetProjection();
+        frame.mLightCount = 3;
+        for (int i = 0; i < frame.mLightCount; i++)
+        {
+            // Light Position in View Coordinates
+            frame.mLights[i].mPosition = transform * lightPositions[i];
+            frame.mLights[i].mAmbient = glm::vec3(0.2f);
+            frame.mLights[i].mIntensity = glm::vec3(1.0f);
+        }
 
-        lightPosition = transform * glm::vec4(7.0f, 4.0f, 2.5f, 1.0f);
-        glUniform4fv(mShader.mLocations.at("lights[2].mPosition"), 1, glm::value_ptr(lightPosition));
+        mUniforms.Push(Dazzle::RenderSystem::GL::kFrameBlockBinding, frame);
     }
 
     void UpdateMaterial(const Material& material)
     {
-        glUniform3fv(mShader.mLocations.at("material.mAmbient"), 1, glm::value_ptr(material.mAmbient));
-        glUniform3fv(mShader.mLocations.at("material.mDiffuse"), 1, glm::value_ptr(material.mDiffuse));
-        glUniform3fv(mShader.mLocations.at("material.mSpecular"), 1, glm::value_ptr(material.mSpecular));
-        glUniform1f(mShader.mLocations.at("material.mShininess"), material.mShininess);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, material);
     }
 
     void UpdateWeights(float newSigmaSquared)
@@ -367,19 +409,6 @@ private:
 
     void InitializeUniforms()
     {
-        // Lights
-        glUniform3fv(mShader.mLocations.at("lights[0].mAmbient"), 1, glm::value_ptr(glm::vec3(0.2f)));
-        glUniform3fv(mShader.mLocations.at("lights[0].mDiffuseSpecular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform4fv(mShader.mLocations.at("lights[0].mPosition"), 1, glm::value_ptr(glm::vec4(-7.0f, 4.0f, 2.5f, 1.0f)));
-
-        glUniform3fv(mShader.mLocations.at("lights[1].mAmbient"), 1, glm::value_ptr(glm::vec3(0.2f)));
-        glUniform3fv(mShader.mLocations.at("lights[1].mDiffuseSpecular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform4fv(mShader.mLocations.at("lights[1].mPosition"), 1, glm::value_ptr(glm::vec4(0.0f, 4.0f, 2.5f, 1.0f)));
-
-        glUniform3fv(mShader.mLocations.at("lights[2].mAmbient"), 1, glm::value_ptr(glm::vec3(0.2f)));
-        glUniform3fv(mShader.mLocations.at("lights[2].mDiffuseSpecular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform4fv(mShader.mLocations.at("lights[2].mPosition"), 1, glm::value_ptr(glm::vec4(7.0f, 4.0f, 2.5f, 1.0f)));
-
         // Initialize Blur Weights
         float sigmaSquared = 25.0f;
         UpdateWeights(sigmaSquared);
@@ -408,41 +437,16 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\Bloom.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\Bloom.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+
+        // Per-frame, per-object and material uniform blocks
+        mUniforms.Initialize(64 * 1024);
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
-        mShader.mLocations["ModelView"] = glGetUniformLocation(handle, "ModelView");
-        mShader.mLocations["MVP"] = glGetUniformLocation(handle, "MVP");
-        mShader.mLocations["Normal"] = glGetUniformLocation(handle, "Normal");
-
-        mShader.mLocations["lights[0].mAmbient"] = glGetUniformLocation(handle, "lights[0].mAmbient");
-        mShader.mLocations["lights[0].mDiffuseSpecular"] = glGetUniformLocation(handle, "lights[0].mDiffuseSpecular");
-        mShader.mLocations["lights[0].mPosition"] = glGetUniformLocation(handle, "lights[0].mPosition");
-
-        mShader.mLocations["lights[1].mAmbient"] = glGetUniformLocation(handle, "lights[1].mAmbient");
-        mShader.mLocations["lights[1].mDiffuseSpecular"] = glGetUniformLocation(handle, "lights[1].mDiffuseSpecular");
-        mShader.mLocations["lights[1].mPosition"] = glGetUniformLocation(handle, "lights[1].mPosition");
-
-        mShader.mLocations["lights[2].mAmbient"] = glGetUniformLocation(handle, "lights[2].mAmbient");
-        mShader.mLocations["lights[2].mDiffuseSpecular"] = glGetUniformLocation(handle, "lights[2].mDiffuseSpecular");
-        mShader.mLocations["lights[2].mPosition"] = glGetUniformLocation(handle, "lights[2].mPosition");
-
-        mShader.mLocations["material.mAmbient"] = glGetUniformLocation(handle, "material.mAmbient");
-        mShader.mLocations["material.mDiffuse"] = glGetUniformLocation(handle, "material.mDiffuse");
-        mShader.mLocations["material.mSpecular"] = glGetUniformLocation(handle, "material.mSpecular");
-        mShader.mLocations["material.mShininess"] = glGetUniformLocation(handle, "material.mShininess");
-
         mShader.mLocations["Pass"] = glGetUniformLocation(handle, "Pass");
-        mShader.mLocations["AverageLuminance"] = glGetUniformLocation(handle, "AverageLuminance");
         mShader.mLocations["Exposure"] = glGetUniformLocation(handle, "Exposure");
         mShader.mLocations["WhitePoint"] = glGetUniformLocation(handle, "WhitePoint");
         mShader.mLocations["LuminanceThreshold"] = glGetUniformLocation(handle, "LuminanceThreshold");
@@ -496,9 +500,9 @@ private:
 
     void CreateTexture(GLuint& texture, GLsizei width, GLsizei height)
     {
-        // Create Texture Object
+        // Create Texture Object, R11F_G11F_B10F unless RGB32F is selected for comparison
         glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-        glTextureStorage2D(texture, 1, GL_RGB32F, width, height);
+        glTextureStorage2D(texture, 1, Utils::Texture::GetInternalFormat(mTargetFormat), width, height);
     }
 
     GLuint CreateFramebufferObject(const FramebufferConfig& config)
@@ -533,11 +537,18 @@ private:
         return fbo;
     }
 
+    Utils::Texture::HDRFormat mTargetFormat;
+    GPUTimer mGPUTimer;
+
     FramebufferConfig mBlurConfig;
     GLuint mBlurFrameBuffer;
     FramebufferConfig mHDRConfig;
     GLuint mHDRFrameBuffer;
+    Dazzle::RenderSystem::GL::LuminanceReduction mLuminance;
+    double mLastTime = 0.0;
+    float mDeltaTime = 0.0f;
     ShaderProgram mShader;
+    Dazzle::RenderSystem::GL::UniformRingBuffer mUniforms;
 
     GLuint mTexture1;
     GLuint mTexture2;
@@ -561,10 +572,6 @@ private:
 
     int mWidth; // Framebuffer Width
     int mHeight; // Framebuffer Height
-
-    glm::mat4 mMVP;
-    glm::mat4 mModelView;
-    glm::mat3 mNormalMtx;
 };
 
 class UIBloom : public IUserInterface
@@ -598,10 +605,30 @@ public:
         ImGui::Text("Exposure:"); ImGui::SameLine(); ImGui::DragFloat("##Exposure", &mExposure, 0.01f, 0.01f, 2.0f, "%.2f");
         ImGui::Text("White Point:"); ImGui::SameLine(); ImGui::DragFloat("##White Point", &mWhitePoint, 0.01f, 0.01f, 2.0f, "%.3f");
         ImGui::Text("Luminance Threshold:"); ImGui::SameLine(); ImGui::DragFloat("##Luminance Threshold", &mLuminanceThreshold, 0.01f, 0.01f, 2.0f, "%.3f");
+        ImGui::Text("Eye Adaptation Rate:"); ImGui::SameLine(); ImGui::DragFloat("##Eye Adaptation Rate", &mEyeAdaptationRate, 0.01f, 0.0f, 10.0f, "%.2f");
 
         if (ImGui::Button("Reset"))
             ResetToDefaults();
 
+        // Luminance
+        ImGui::SeparatorText("Average Luminance");
+        if (ImGui::Button("Validate against CPU reference") && mScene)
+            mScene->ValidateLuminance(mGPULuminance, mCPULuminance);
+        ImGui::Text("GPU: %.5f, CPU: %.5f", mGPULuminance, mCPULuminance);
+
+        // Render targets, RGB32F for comparison with the packed format
+        ImGui::SeparatorText("Render Targets");
+        ImGui::Text("Format:"); ImGui::SameLine(); ImGui::Combo("##TargetFormat", &mTargetFormat, "R11F_G11F_B10F\0" "RGB32F\0");
+        if (mScene)
+        {
+            const double megabyte = 1024.0 * 1024.0;
+            const auto format = mScene->GetTargetFormat();
+            const auto reference = Utils::Texture::HDRFormat::RGB32F;
+            ImGui::Text("Memory: %.2f MB (RGB32F: %.2f MB)", mScene->GetTargetMemory(format) / megabyte, mScene->GetTargetMemory(reference) / megabyte);
+            ImGui::Text("Traffic: %.2f MB/frame (RGB32F: %.2f MB/frame)", mScene->GetTargetTraffic(format) / megabyte, mScene->GetTargetTraffic(reference) / megabyte);
+            ImGui::Text("GPU Time: %.3f ms", mScene->GetGPUTime());
+        }
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
@@ -613,7 +640,9 @@ public:
         {
             mScene->SetExposure(mExposure);
             mScene->SetWhitePoint(mWhitePoint);
+            mScene->SetEyeAdaptationRate(mEyeAdaptationRate);
             mScene->SetLuminanceThreshold(mLuminanceThreshold);
+            mScene->SetTargetFormat(mTargetFormat == 0 ? Utils::Texture::HDRFormat::R11F_G11F_B10F : Utils::Texture::HDRFormat::RGB32F);
         }
     }
 
@@ -622,6 +651,7 @@ private:
     {
         mExposure = 0.35f;
         mWhitePoint = 0.928f;
+        mEyeAdaptationRate = 0.0f;
         mLuminanceThreshold = 1.7f;
     }
 
@@ -630,7 +660,11 @@ private:
 
     float mExposure = 0.35f;
     float mWhitePoint = 0.928f;
+    float mEyeAdaptationRate = 0.0f;
+    float mGPULuminance = 0.0f;
+    float mCPULuminance = 0.0f;
     float mLuminanceThreshold = 1.7f;
+    int mTargetFormat = 0;
 };
 
 int main(int argc, char const *argv[])
@@ -12,24 +12,35 @@ layout(binding = 2) uniform sampler2D BlurTexture2;
 
 struct Light
 {
-    vec3 mAmbient;              // (vec3) Ambient Intensity
-    vec3 mDiffuseSpecular;      // (vec3) Diffuse & Specular Intensity
     vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Ambient Intensity
+    vec3 mIntensity;            // (vec3) Diffuse & Specular Intensity
+};
+
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 View;
+    mat4 Projection;
+    Light lights[4];            // Lights source data
+    int LightCount;
 };
 
-struct Material
+layout(std140, binding = 2) uniform MaterialBlock
 {
     vec3 mAmbient;              // (vec3) Ambient Reflectivity
     vec3 mDiffuse;              // (vec3) Diffuse Reflectivity
     vec3 mSpecular;             // (vec3) Specular Reflectivity
     float mShininess;           // (float) Shininess
-};
+} material; // Material properties
 
-uniform Light lights[3]; // Lights source data
-uniform Material material; // Material properties
+// Written by the luminance reduction compute pass (LuminanceReduction::kResultBinding)
+layout(std430, binding = 7) readonly buffer LuminanceBuffer
+{
+    float AverageLuminance;     // Log-average luminance of the scene
+    float AdaptedLuminance;     // Average luminance after eye adaptation
+};
 
 uniform int Pass;                   // Current pass number, 1 or 2
-uniform float AverageLuminance;     // Average Luminance of the scene
 uniform bool EnableToneMapping;     // Enable or disable tone mapping
 uniform float Exposure;             // Exposure value for tone mapping
 // Reference brightness level that is considered “white” in the final image.
@@ -78,7 +89,7 @@ vec3 BlinnPhongModel(vec3 SurfacePoint, vec3 SurfaceNormal, int idx)
         specular = material.mSpecular * pow( max( dot( halfwayDirection, SurfaceNormal ), 0.0 ), material.mShininess );
     }
 
-    return ambient + lights[idx].mDiffuseSpecular * (diffuse + specular);
+    return ambient + lights[idx].mIntensity * (diffuse + specular);
 }
 
 vec4 Pass1()
@@ -87,7 +98,7 @@ vec4 Pass1()
 
     // Compute shading and store result in a high-resolution framebuffer.
     vec3 HDRColor = vec3(0.0);
-    for (int i = 0; i < 3; ++i)
+    for (int i = 0; i < LightCount; ++i)
         HDRColor += BlinnPhongModel(Position, Normal, i);
 
     return vec4(HDRColor, 1.0);
@@ -141,7 +152,7 @@ vec4 Pass5()
 
     // Apply the tone mapping operator
     // Scale luminance by exposure and average luminance
-    float Luminance = Exposure * xyYColor.z / AverageLuminance;
+    float Luminance = Exposure * xyYColor.z / AdaptedLuminance;
     Luminance = (Luminance * (1 + Luminance / (WhitePoint * WhitePoint))) / (1 + Luminance);
 
     // Convert back to XYZ color space using the new luminance
@@ -1,4 +1,7 @@
-// #include "RenderSystem.hpp"
+#include <chrono>
+#include <iostream>
+
+#include "RenderSystem.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
@@ -17,9 +20,16 @@ App::App(const AppConfig& config, std::unique_ptr<IScene> scene, std::unique_ptr
     // Set up OpenGL Debug Message Callback
     // Dazzle::RenderSystem::GL::SetupDebugMessageCallback();
 
-    // Initialize Scene
+    // Initialize Scene, most of the startup time goes into building its shader programs
+    auto start = std::chrono::steady_clock::now();
     mScene = std::move(scene);
     mScene->Initialize(mCamera);
+    std::chrono::duration<double, std::milli> startupTime = std::chrono::steady_clock::now() - start;
+
+    const auto& shaderCache = Dazzle::RenderSystem::GL::ShaderCache::GetInstance().GetStatistics();
+    std::cout   << "Scene initialized in " << startupTime.count() << " ms. Shader cache: "
+                << shaderCache.mHits << " programs loaded (" << shaderCache.mLoadTime << " ms), "
+                << shaderCache.mMisses << " programs compiled (" << shaderCache.mCompileTime << " ms)" << std::endl;
 
     // Add a Scene and Camera references to the UI
     mWindow.GetUserInterface().SetScene(mScene.get());
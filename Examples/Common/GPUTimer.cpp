@@ -0,0 +1,48 @@
+#include "GPUTimer.hpp"
+
+GPUTimer::GPUTimer() : mQueries(), mIssued(0), mCollected(0), mTiming(false), mTime(0.0)
+{
+
+}
+
+GPUTimer::~GPUTimer()
+{
+    glDeleteQueries(kQueryCount, mQueries.data());
+}
+
+void GPUTimer::Initialize()
+{
+    glCreateQueries(GL_TIME_ELAPSED, kQueryCount, mQueries.data());
+}
+
+void GPUTimer::Begin()
+{
+    // Queries finish in the order they were issued, so the first one still pending ends the collection
+    while (mCollected != mIssued)
+    {
+        const GLuint query = mQueries[mCollected % kQueryCount];
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        mTime = elapsed / 1.0e6;
+        ++mCollected;
+    }
+
+    mTiming = mIssued - mCollected < kQueryCount;
+    if (mTiming)
+        glBeginQuery(GL_TIME_ELAPSED, mQueries[mIssued % kQueryCount]);
+}
+
+void GPUTimer::End()
+{
+    if (!mTiming)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    mTiming = false;
+    ++mIssued;
+}
@@ -0,0 +1,40 @@
+#ifndef _GPU_TIMER_HPP_
+#define _GPU_TIMER_HPP_
+
+#include <array>
+
+#include <GL/gl3w.h>
+
+// GPU time of the commands between Begin() and End(), measured with a ring of GL_TIME_ELAPSED queries. Results are
+// only read once the driver reports them available, so the render thread never waits on the GPU: the time lags a few
+// frames behind, and a frame finding every query still pending is left untimed.
+class GPUTimer
+{
+public:
+    GPUTimer();
+    GPUTimer(const GPUTimer& other) = delete;
+    ~GPUTimer();
+
+    GPUTimer& operator=(const GPUTimer& other) = delete;
+
+    // Creates the queries, needs the GL context.
+    void Initialize();
+
+    // Collects the finished queries, then starts timing with the next free one.
+    void Begin();
+    void End();
+
+    // ms of the latest finished query, 0 until one finishes.
+    double GetTime() const { return mTime; }
+
+private:
+    static const unsigned int kQueryCount = 4;
+
+    std::array<GLuint, kQueryCount> mQueries;
+    unsigned int mIssued;       // Queries begun and ended so far, the next one is mQueries[mIssued % kQueryCount]
+    unsigned int mCollected;    // Queries read so far, the ones in between are still pending
+    bool mTiming;
+    double mTime;
+};
+
+#endif // _GPU_TIMER_HPP_
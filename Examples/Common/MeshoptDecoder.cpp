@@ -0,0 +1,444 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MeshoptDecoder.hpp"
+
+namespace
+{
+    const unsigned char kVertexHeader = 0xa0;       // Version 0
+    const unsigned char kIndexHeader = 0xe1;        // Version 1
+    const unsigned char kSequenceHeader = 0xd1;     // Version 1
+    const int kIndexFifoCodeLimit = 13;             // Edge codes below it read the vertex FIFO
+
+    const size_t kVertexBlockSizeBytes = 8192;
+    const size_t kVertexBlockMaxSize = 256;
+    const size_t kByteGroupSize = 16;
+    const size_t kByteGroupDecodeLimit = 24;        // Largest group: 8 bytes of 4 bit values and 16 extra bytes
+    const size_t kTailMinSize = 32;
+
+    size_t GetVertexBlockSize(size_t stride)
+    {
+        size_t result = (kVertexBlockSizeBytes / stride) & ~(kByteGroupSize - 1);
+        return result < kVertexBlockMaxSize ? result : kVertexBlockMaxSize;
+    }
+
+    unsigned char Unzigzag8(unsigned char v)
+    {
+        return static_cast<unsigned char>(-(v & 1) ^ (v >> 1));
+    }
+
+    // One group of 16 bytes, stored as 2 or 4 bit values (the largest value means "read a whole byte") or raw
+    const unsigned char* DecodeBytesGroup(const unsigned char* data, unsigned char* destination, int bitsLog2)
+    {
+        switch (bitsLog2)
+        {
+            case 0:
+                std::memset(destination, 0, kByteGroupSize);
+                return data;
+            case 1:
+            case 2:
+            {
+                const int bits = 1 << bitsLog2;
+                const unsigned char sentinel = static_cast<unsigned char>((1 << bits) - 1);
+                const size_t packedSize = kByteGroupSize * bits / 8;
+                const unsigned char* extra = data + packedSize;
+                for (size_t i = 0; i < kByteGroupSize; ++i)
+                {
+                    // Values are packed from the most significant bits
+                    unsigned char byte = data[i * bits / 8];
+                    unsigned char value = static_cast<unsigned char>((byte >> (8 - bits - (i * bits) % 8)) & sentinel);
+                    destination[i] = value == sentinel ? *extra++ : value;
+                }
+                return extra;
+            }
+            default:
+                std::memcpy(destination, data, kByteGroupSize);
+                return data + kByteGroupSize;
+        }
+    }
+
+    // The header holds a 2 bit mode per group, the groups follow
+    const unsigned char* DecodeBytes(const unsigned char* data, const unsigned char* end, unsigned char* destination, size_t size)
+    {
+        const size_t headerSize = (size / kByteGroupSize + 3) / 4;
+        if (static_cast<size_t>(end - data) < headerSize)
+            return nullptr;
+
+        const unsigned char* header = data;
+        data += headerSize;
+        for (size_t i = 0; i < size; i += kByteGroupSize)
+        {
+            if (static_cast<size_t>(end - data) < kByteGroupDecodeLimit)
+                return nullptr;
+
+            const size_t group = i / kByteGroupSize;
+            const int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+            data = DecodeBytesGroup(data, destination + i, bitsLog2);
+        }
+
+        return data;
+    }
+
+    const unsigned char* DecodeVertexBlock( const unsigned char* data, const unsigned char* end, unsigned char* destination,
+                                            size_t count, size_t stride, unsigned char* lastVertex)
+    {
+        // Every byte of the vertex is its own stream, delta coded against the same byte of the previous vertex
+        unsigned char buffer[kVertexBlockMaxSize];
+        const size_t alignedCount = (count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+        for (size_t k = 0; k < stride; ++k)
+        {
+            data = DecodeBytes(data, end, buffer, alignedCount);
+            if (data == nullptr)
+                return nullptr;
+
+            unsigned char previous = lastVertex[k];
+            for (size_t i = 0; i < count; ++i)
+            {
+                previous = static_cast<unsigned char>(Unzigzag8(buffer[i]) + previous);
+                destination[i * stride + k] = previous;
+            }
+        }
+
+        std::memcpy(lastVertex, destination + stride * (count - 1), stride);
+        return data;
+    }
+
+    unsigned int DecodeVByte(const unsigned char*& data)
+    {
+        unsigned char lead = *data++;
+        if (lead < 128)
+            return lead;
+
+        // Up to 5 bytes of 7 bits, the high bit marks a continuation
+        unsigned int result = lead & 127;
+        unsigned int shift = 7;
+        for (int i = 0; i < 4; ++i)
+        {
+            unsigned char group = *data++;
+            result |= static_cast<unsigned int>(group & 127) << shift;
+            shift += 7;
+
+            if (group < 128)
+                break;
+        }
+
+        return result;
+    }
+
+    unsigned int DecodeIndex(const unsigned char*& data, unsigned int last)
+    {
+        unsigned int v = DecodeVByte(data);
+        unsigned int delta = (v >> 1) ^ (0u - (v & 1));
+        return last + delta;
+    }
+
+    void WriteTriangle(void* destination, size_t offset, size_t indexSize, unsigned int a, unsigned int b, unsigned int c)
+    {
+        if (indexSize == 2)
+        {
+            uint16_t* indices = static_cast<uint16_t*>(destination) + offset;
+            indices[0] = static_cast<uint16_t>(a);
+            indices[1] = static_cast<uint16_t>(b);
+            indices[2] = static_cast<uint16_t>(c);
+        }
+        else
+        {
+            uint32_t* indices = static_cast<uint32_t*>(destination) + offset;
+            indices[0] = a;
+            indices[1] = b;
+            indices[2] = c;
+        }
+    }
+
+    // 16 entry FIFOs of recently seen edges and vertices, referenced by the triangle codes
+    struct IndexFifos
+    {
+        unsigned int mEdges[16][2];
+        unsigned int mVertices[16];
+        size_t mEdgeOffset = 0;
+        size_t mVertexOffset = 0;
+
+        IndexFifos()
+        {
+            std::memset(mEdges, -1, sizeof(mEdges));
+            std::memset(mVertices, -1, sizeof(mVertices));
+        }
+
+        void PushEdge(unsigned int a, unsigned int b)
+        {
+            mEdges[mEdgeOffset][0] = a;
+            mEdges[mEdgeOffset][1] = b;
+            mEdgeOffset = (mEdgeOffset + 1) & 15;
+        }
+
+        void PushVertex(unsigned int v, bool condition = true)
+        {
+            mVertices[mVertexOffset] = v;
+            mVertexOffset = (mVertexOffset + (condition ? 1 : 0)) & 15;
+        }
+    };
+
+    template <typename T>
+    void DecodeOctahedral(T* data, size_t count)
+    {
+        const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // z is reconstructed from x and y, the third component encodes 1.0 at the same precision
+            float x = static_cast<float>(data[i * 4 + 0]);
+            float y = static_cast<float>(data[i * 4 + 1]);
+            float z = static_cast<float>(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+
+            // Unfold the lower hemisphere
+            float t = z < 0.0f ? z : 0.0f;
+            x += x >= 0.0f ? t : -t;
+            y += y >= 0.0f ? t : -t;
+
+            float scale = max / std::sqrt(x * x + y * y + z * z);
+            data[i * 4 + 0] = static_cast<T>(static_cast<int>(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+            data[i * 4 + 1] = static_cast<T>(static_cast<int>(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+            data[i * 4 + 2] = static_cast<T>(static_cast<int>(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+        }
+    }
+}
+
+bool Meshopt::DecodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* buffer, size_t size)
+{
+    if (stride == 0 || stride > 256 || stride % 4 != 0)
+        return false;
+
+    const size_t tailSize = stride < kTailMinSize ? kTailMinSize : stride;
+    if (size < 1 + tailSize || buffer[0] != kVertexHeader)
+        return false;
+
+    const unsigned char* data = buffer + 1;
+    const unsigned char* end = buffer + size;
+
+    // The first vertex of the stream is the baseline of the first deltas, stored at the very end
+    unsigned char lastVertex[256];
+    std::memcpy(lastVertex, end - stride, stride);
+
+    unsigned char* output = static_cast<unsigned char*>(destination);
+    const size_t blockSize = GetVertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize)
+    {
+        const size_t blockCount = offset + blockSize < count ? blockSize : count - offset;
+        data = DecodeVertexBlock(data, end, output + offset * stride, blockCount, stride, lastVertex);
+        if (data == nullptr)
+            return false;
+    }
+
+    return static_cast<size_t>(end - data) == tailSize;
+}
+
+bool Meshopt::DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size)
+{
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4))
+        return false;
+
+    // Header, one code per triangle, extra data and a 16 byte table of the most common auxiliary codes
+    const size_t triangleCount = count / 3;
+    if (size < 1 + triangleCount + 16 || buffer[0] != kIndexHeader)
+        return false;
+
+    const unsigned char* codes = buffer + 1;
+    const unsigned char* data = codes + triangleCount;
+    const unsigned char* codeAuxTable = buffer + size - 16;
+    const unsigned char* safeEnd = codeAuxTable;
+
+    IndexFifos fifos;
+    unsigned int next = 0;
+    unsigned int last = 0;
+    for (size_t i = 0; i < count; i += 3)
+    {
+        // Extra data is at most 16 bytes per triangle, the table after it keeps the reads within the buffer
+        if (data > safeEnd)
+            return false;
+
+        const unsigned char code = *codes++;
+        if (code < 0xf0)
+        {
+            // Triangle sharing a recent edge
+            const size_t edge = (fifos.mEdgeOffset - 1 - (code >> 4)) & 15;
+            const unsigned int a = fifos.mEdges[edge][0];
+            const unsigned int b = fifos.mEdges[edge][1];
+            const int fec = code & 15;
+
+            // Version 1 streams keep 13 and 14 for the free index right before and after the last one
+            if (fec < kIndexFifoCodeLimit)
+            {
+                // Third vertex is either the next new vertex or a recent one
+                const unsigned int c = fec == 0 ? next : fifos.mVertices[(fifos.mVertexOffset - 1 - fec) & 15];
+                next += fec == 0 ? 1 : 0;
+
+                WriteTriangle(destination, i, indexSize, a, b, c);
+                fifos.PushVertex(c, fec == 0);
+                fifos.PushEdge(c, b);
+                fifos.PushEdge(a, c);
+            }
+            else
+            {
+                // Third vertex is the last free index -1 (13) or +1 (14), or delta coded against it (15)
+                const unsigned int c = last = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+
+                WriteTriangle(destination, i, indexSize, a, b, c);
+                fifos.PushVertex(c);
+                fifos.PushEdge(c, b);
+                fifos.PushEdge(a, c);
+            }
+        }
+        else if (code < 0xfe)
+        {
+            // New triangle, the auxiliary code comes from the table
+            const unsigned char codeAux = codeAuxTable[code & 15];
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+
+            const unsigned int a = next++;
+            const unsigned int b = feb == 0 ? next : fifos.mVertices[(fifos.mVertexOffset - feb) & 15];
+            next += feb == 0 ? 1 : 0;
+            const unsigned int c = fec == 0 ? next : fifos.mVertices[(fifos.mVertexOffset - fec) & 15];
+            next += fec == 0 ? 1 : 0;
+
+            WriteTriangle(destination, i, indexSize, a, b, c);
+            fifos.PushVertex(a);
+            fifos.PushVertex(b, feb == 0);
+            fifos.PushVertex(c, fec == 0);
+            fifos.PushEdge(b, a);
+            fifos.PushEdge(c, b);
+            fifos.PushEdge(a, c);
+        }
+        else
+        {
+            // New triangle, the auxiliary code is stored in full and any vertex may be a free index
+            const unsigned char codeAux = *data++;
+            const int fea = code == 0xfe ? 0 : 15;
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+
+            if (codeAux == 0)
+                next = 0;
+
+            unsigned int a = fea == 0 ? next++ : 0;
+            unsigned int b = feb == 0 ? next++ : fifos.mVertices[(fifos.mVertexOffset - feb) & 15];
+            unsigned int c = fec == 0 ? next++ : fifos.mVertices[(fifos.mVertexOffset - fec) & 15];
+
+            if (fea == 15)
+                last = a = DecodeIndex(data, last);
+            if (feb == 15)
+                last = b = DecodeIndex(data, last);
+            if (fec == 15)
+                last = c = DecodeIndex(data, last);
+
+            WriteTriangle(destination, i, indexSize, a, b, c);
+            fifos.PushVertex(a);
+            fifos.PushVertex(b, feb == 0 || feb == 15);
+            fifos.PushVertex(c, fec == 0 || fec == 15);
+            fifos.PushEdge(b, a);
+            fifos.PushEdge(c, b);
+            fifos.PushEdge(a, c);
+        }
+    }
+
+    return data == safeEnd;
+}
+
+bool Meshopt::DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size)
+{
+    if (indexSize != 2 && indexSize != 4)
+        return false;
+
+    // Header, one varint per index and 4 bytes of padding
+    if (size < 1 + count + 4 || buffer[0] != kSequenceHeader)
+        return false;
+
+    const unsigned char* data = buffer + 1;
+    const unsigned char* safeEnd = buffer + size - 4;
+
+    unsigned int last[2] = {};
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (data >= safeEnd)
+            return false;
+
+        // The low bit picks the baseline, the rest is a zigzag delta
+        unsigned int v = DecodeVByte(data);
+        const unsigned int baseline = v & 1;
+        v >>= 1;
+
+        const unsigned int index = last[baseline] + ((v >> 1) ^ (0u - (v & 1)));
+        last[baseline] = index;
+
+        if (indexSize == 2)
+            static_cast<uint16_t*>(destination)[i] = static_cast<uint16_t>(index);
+        else
+            static_cast<uint32_t*>(destination)[i] = index;
+    }
+
+    return data == safeEnd;
+}
+
+void Meshopt::DecodeOctahedralFilter(void* data, size_t count, size_t stride)
+{
+    if (stride == 4)
+        DecodeOctahedral(static_cast<int8_t*>(data), count);
+    else if (stride == 8)
+        DecodeOctahedral(static_cast<int16_t*>(data), count);
+}
+
+void Meshopt::DecodeQuaternionFilter(void* data, size_t count, size_t stride)
+{
+    if (stride != 8)
+        return;
+
+    int16_t* components = static_cast<int16_t*>(data);
+    const float scale = 1.0f / std::sqrt(2.0f);
+    for (size_t i = 0; i < count; ++i)
+    {
+        int16_t* q = components + i * 4;
+
+        // The fourth component holds the scale in its high bits and the index of the dropped component in the low 2
+        const int range = q[3] | 3;
+        const float s = scale / static_cast<float>(range);
+        const float x = static_cast<float>(q[0]) * s;
+        const float y = static_cast<float>(q[1]) * s;
+        const float z = static_cast<float>(q[2]) * s;
+
+        // The dropped component is the largest one, rebuilt from unit length
+        const float ww = 1.0f - x * x - y * y - z * z;
+        const float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+        const int dropped = q[3] & 3;
+        const int16_t xs = static_cast<int16_t>(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+        const int16_t ys = static_cast<int16_t>(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+        const int16_t zs = static_cast<int16_t>(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+        const int16_t ws = static_cast<int16_t>(w * 32767.0f + 0.5f);
+
+        q[(dropped + 1) & 3] = xs;
+        q[(dropped + 2) & 3] = ys;
+        q[(dropped + 3) & 3] = zs;
+        q[(dropped + 0) & 3] = ws;
+    }
+}
+
+void Meshopt::DecodeExponentialFilter(void* data, size_t count, size_t stride)
+{
+    uint32_t* values = static_cast<uint32_t*>(data);
+    const size_t valueCount = count * (stride / 4);
+    for (size_t i = 0; i < valueCount; ++i)
+    {
+        // Signed 24 bit mantissa and signed 8 bit exponent, value = mantissa * 2^exponent
+        const uint32_t v = values[i];
+        const int32_t mantissa = static_cast<int32_t>(v << 8) >> 8;
+        const int32_t exponent = static_cast<int32_t>(v) >> 24;
+
+        float power;
+        const uint32_t powerBits = static_cast<uint32_t>(exponent + 127) << 23;
+        std::memcpy(&power, &powerBits, sizeof(float));
+
+        const float result = power * static_cast<float>(mantissa);
+        std::memcpy(&values[i], &result, sizeof(float));
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef _MESHOPT_DECODER_HPP_
+#define _MESHOPT_DECODER_HPP_
+
+#include <cstddef>
+
+// Decoders of the buffer view encodings of EXT_meshopt_compression, implemented after the extension specification.
+// Every function returns false when the encoded data is malformed.
+namespace Meshopt
+{
+    // ATTRIBUTES mode: count elements of stride bytes, byte-wise delta coded and bit packed in blocks.
+    bool DecodeVertexBuffer(void* destination, size_t count, size_t stride, const unsigned char* buffer, size_t size);
+    // TRIANGLES mode: count indices of indexSize (2 or 4) bytes, coded with edge and vertex FIFOs.
+    bool DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size);
+    // INDICES mode: count indices of indexSize (2 or 4) bytes, delta coded against two baselines.
+    bool DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const unsigned char* buffer, size_t size);
+
+    // Filters, applied in place to decoded ATTRIBUTES data.
+    void DecodeOctahedralFilter(void* data, size_t count, size_t stride);  // 4 x int8 or 4 x int16 normals/tangents
+    void DecodeQuaternionFilter(void* data, size_t count, size_t stride);  // 4 x int16 rotations
+    void DecodeExponentialFilter(void* data, size_t count, size_t stride); // Floats stored as 8 bit exponent + 24 bit mantissa
+}
+
+#endif // _MESHOPT_DECODER_HPP_
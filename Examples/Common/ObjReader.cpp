@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "FileManager.hpp"
+#include "ParallelFor.hpp"
+
+#include "ObjReader.hpp"
+
+namespace
+{
+    const size_t kChunksPerThread = 4;      // Lines are not equally expensive, smaller chunks even the load out
+
+    // Attribute index of a corner as read by a chunk. Absolute indices are final, relative ones are counted from the
+    // start of the chunk (and may be negative) until the merge knows how many attributes precede it.
+    struct ChunkCorner
+    {
+        int mIndices[3];                    // Vertex, normal, texture coordinates; kAbsent when not referenced
+        unsigned char mRelative;            // Bit i is set when mIndices[i] is relative
+    };
+
+    const int kAbsent = -1;
+
+    // Name or material change, applied before the corner at mCorner
+    struct ChunkEvent
+    {
+        enum Type { Name, Material };
+
+        Type mType;
+        size_t mCorner;
+        std::string mValue;
+    };
+
+    struct Chunk
+    {
+        const char* mBegin;
+        const char* mEnd;
+
+        std::vector<float> mVertices;
+        std::vector<float> mNormals;
+        std::vector<float> mTextureCoordinates;
+        std::vector<ChunkCorner> mCorners;
+        std::vector<ChunkEvent> mEvents;
+        std::vector<std::string> mMaterialLibraries;
+        size_t mErrorLine = 0;              // 1-based line within the chunk of the first malformed face, 0 if none
+    };
+
+    const double kPowersOf10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    const char* SkipSpaces(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    // Decimal float parser for the plain notation OBJ exporters write. Up to 19 significant digits are accumulated
+    // exactly and scaled once, which is well within float precision. Anything else (inf, nan, hex floats) goes through
+    // strtof on a terminated copy, since the mapped file isn't.
+    const char* ParseFloat(const char* p, const char* end, float& value)
+    {
+        const char* start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        std::uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool any = false;
+        for (; p < end && IsDigit(*p); ++p, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && IsDigit(*p); ++p, any = true)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa != 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if (any && p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* e = p + 1;
+            bool negativeExponent = false;
+            if (e < end && (*e == '-' || *e == '+'))
+                negativeExponent = *e++ == '-';
+
+            if (e < end && IsDigit(*e))
+            {
+                int explicitExponent = 0;
+                for (; e < end && IsDigit(*e); ++e)
+                    explicitExponent = std::min(explicitExponent * 10 + (*e - '0'), 9999);
+                exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                p = e;
+            }
+        }
+
+        if (!any || (p < end && !IsSpace(*p) && *p != '\n' && *p != '/'))
+        {
+            char buffer[64];
+            const char* tokenEnd = start;
+            while (tokenEnd < end && !IsSpace(*tokenEnd) && *tokenEnd != '\n')
+                ++tokenEnd;
+
+            const size_t length = std::min<size_t>(tokenEnd - start, sizeof(buffer) - 1);
+            std::memcpy(buffer, start, length);
+            buffer[length] = '\0';
+            char* parsed = nullptr;
+            value = std::strtof(buffer, &parsed);
+            return parsed == buffer ? start : tokenEnd;
+        }
+
+        double result = static_cast<double>(mantissa);
+        if (exponent < 0)
+            result = -exponent <= 22 ? result / kPowersOf10[-exponent] : result * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            result = exponent <= 22 ? result * kPowersOf10[exponent] : result * std::pow(10.0, exponent);
+
+        value = static_cast<float>(negative ? -result : result);
+        return p;
+    }
+
+    const char* ParseInt(const char* p, const char* end, int& value)
+    {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        const char* digits = p;
+        long long result = 0;
+        for (; p < end && IsDigit(*p); ++p)
+            result = std::min(result * 10 + (*p - '0'), 1ll << 31);
+
+        if (p == digits)
+            return nullptr;
+
+        value = static_cast<int>(negative ? -result : std::min(result, (1ll << 31) - 1));
+        return p;
+    }
+
+    // Rest of the line, without surrounding blanks
+    std::string ParseName(const char* p, const char* end)
+    {
+        p = SkipSpaces(p, end);
+        while (end > p && IsSpace(end[-1]))
+            --end;
+        return std::string(p, end);
+    }
+
+    // Keyword followed by a blank
+    bool IsKeyword(const char* p, const char* end, const char* keyword)
+    {
+        const size_t length = std::strlen(keyword);
+        return static_cast<size_t>(end - p) > length && std::memcmp(p, keyword, length) == 0 && IsSpace(p[length]);
+    }
+
+    // Resolves an OBJ index (1-based, or negative to count back from the last attribute) against the count of
+    // attributes the chunk has read so far
+    void ResolveIndex(ChunkCorner& corner, int attribute, int index, size_t localCount)
+    {
+        if (index > 0)
+        {
+            corner.mIndices[attribute] = index - 1;
+        }
+        else
+        {
+            corner.mIndices[attribute] = static_cast<int>(localCount) + index;
+            corner.mRelative |= 1 << attribute;
+        }
+    }
+
+    // Face corner "v", "v/vt", "v//vn" or "v/vt/vn"
+    const char* ParseCorner(const char* p, const char* end, const Chunk& chunk, ChunkCorner& corner)
+    {
+        corner = {{kAbsent, kAbsent, kAbsent}, 0};
+
+        int index = 0;
+        if (!(p = ParseInt(p, end, index)) || index == 0)
+            return nullptr;
+        ResolveIndex(corner, 0, index, chunk.mVertices.size() / 3);
+
+        if (p < end && *p == '/')
+        {
+            ++p;
+            if (p < end && *p != '/')
+            {
+                if (!(p = ParseInt(p, end, index)) || index == 0)
+                    return nullptr;
+                ResolveIndex(corner, 2, index, chunk.mTextureCoordinates.size() / 2);
+            }
+
+            if (p < end && *p == '/')
+            {
+                if (!(p = ParseInt(p + 1, end, index)) || index == 0)
+                    return nullptr;
+                ResolveIndex(corner, 1, index, chunk.mNormals.size() / 3);
+            }
+        }
+
+        return p;
+    }
+
+    void ParseChunk(Chunk& chunk)
+    {
+        std::vector<ChunkCorner> polygon;
+        size_t line = 0;
+
+        const char* p = chunk.mBegin;
+        while (p < chunk.mEnd)
+        {
+            const char* nextLine = static_cast<const char*>(std::memchr(p, '\n', chunk.mEnd - p));
+            if (!nextLine)
+                nextLine = chunk.mEnd;
+            ++line;
+
+            // Comments run to the end of the line, after any keyword
+            const char* comment = static_cast<const char*>(std::memchr(p, '#', nextLine - p));
+            const char* lineEnd = comment ? comment : nextLine;
+
+            p = SkipSpaces(p, lineEnd);
+            if (p + 1 < lineEnd)
+            {
+                if (p[0] == 'v' && IsSpace(p[1]))
+                {
+                    float position[3] = {};
+                    const char* q = p + 2;
+                    for (int i = 0; i < 3; ++i)
+                        q = ParseFloat(SkipSpaces(q, lineEnd), lineEnd, position[i]);
+                    chunk.mVertices.insert(chunk.mVertices.end(), position, position + 3);
+                }
+                else if (p[0] == 'v' && p[1] == 'n' && IsKeyword(p, lineEnd, "vn"))
+                {
+                    float normal[3] = {};
+                    const char* q = p + 3;
+                    for (int i = 0; i < 3; ++i)
+                        q = ParseFloat(SkipSpaces(q, lineEnd), lineEnd, normal[i]);
+                    chunk.mNormals.insert(chunk.mNormals.end(), normal, normal + 3);
+                }
+                else if (p[0] == 'v' && p[1] == 't' && IsKeyword(p, lineEnd, "vt"))
+                {
+                    // A missing v is 0, w is dropped
+                    float uv[2] = {};
+                    const char* q = p + 3;
+                    for (int i = 0; i < 2; ++i)
+                        q = ParseFloat(SkipSpaces(q, lineEnd), lineEnd, uv[i]);
+                    chunk.mTextureCoordinates.insert(chunk.mTextureCoordinates.end(), uv, uv + 2);
+                }
+                else if (p[0] == 'f' && IsSpace(p[1]))
+                {
+                    polygon.clear();
+                    const char* q = SkipSpaces(p + 2, lineEnd);
+                    while (q && q < lineEnd)
+                    {
+                        ChunkCorner corner;
+                        if ((q = ParseCorner(q, lineEnd, chunk, corner)))
+                        {
+                            polygon.push_back(corner);
+                            q = SkipSpaces(q, lineEnd);
+                        }
+                    }
+
+                    if (!q || polygon.size() < 3)
+                    {
+                        if (chunk.mErrorLine == 0)
+                            chunk.mErrorLine = line;
+                    }
+                    else
+                    {
+                        // Triangle fan around the first corner
+                        for (size_t i = 1; i + 1 < polygon.size(); ++i)
+                        {
+                            chunk.mCorners.push_back(polygon[0]);
+                            chunk.mCorners.push_back(polygon[i]);
+                            chunk.mCorners.push_back(polygon[i + 1]);
+                        }
+                    }
+                }
+                else if ((p[0] == 'o' || p[0] == 'g') && IsSpace(p[1]))
+                {
+                    chunk.mEvents.push_back({ChunkEvent::Name, chunk.mCorners.size(), ParseName(p + 2, lineEnd)});
+                }
+                else if (IsKeyword(p, lineEnd, "usemtl"))
+                {
+                    chunk.mEvents.push_back({ChunkEvent::Material, chunk.mCorners.size(), ParseName(p + 7, lineEnd)});
+                }
+                else if (IsKeyword(p, lineEnd, "mtllib"))
+                {
+                    chunk.mMaterialLibraries.push_back(ParseName(p + 7, lineEnd));
+                }
+            }
+
+            p = nextLine + 1;
+        }
+    }
+}
+
+bool ObjReader::Read(const std::string& path, ObjData& data, unsigned int threadCount, Statistics* statistics, size_t minChunkSize)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    Dazzle::MappedFile file;
+    if (!file.Open(path))
+        return false;
+
+    const char* begin = file.GetData();
+    const char* end = begin + file.GetSize();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // Split into line aligned chunks, each boundary moves forward to the start of the next line
+    const size_t chunkCount = std::max<size_t>(1, std::min(file.GetSize() / std::max<size_t>(1, minChunkSize), threadCount * kChunksPerThread));
+    std::vector<Chunk> chunks(chunkCount);
+    const char* chunkBegin = begin;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char* chunkEnd = begin + file.GetSize() * (i + 1) / chunkCount;
+        if (chunkEnd < chunkBegin)
+            chunkEnd = chunkBegin;
+        if (chunkEnd < end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+
+        chunks[i].mBegin = chunkBegin;
+        chunks[i].mEnd = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    Dazzle::ParallelFor(chunks.size(), threadCount, [&](size_t i) { ParseChunk(chunks[i]); });
+
+    auto parsed = std::chrono::steady_clock::now();
+
+    // Attributes and corners preceding each chunk
+    struct Offsets { size_t mVertices, mNormals, mTextureCoordinates, mCorners; };
+    std::vector<Offsets> offsets(chunks.size() + 1, Offsets{0, 0, 0, 0});
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        const Chunk& chunk = chunks[i];
+        if (chunk.mErrorLine != 0)
+        {
+            const size_t line = std::count(begin, chunk.mBegin, '\n') + chunk.mErrorLine;
+            std::cerr << "ObjReader: " << path << ": malformed face at line " << line << std::endl;
+            return false;
+        }
+
+        offsets[i + 1].mVertices = offsets[i].mVertices + chunk.mVertices.size();
+        offsets[i + 1].mNormals = offsets[i].mNormals + chunk.mNormals.size();
+        offsets[i + 1].mTextureCoordinates = offsets[i].mTextureCoordinates + chunk.mTextureCoordinates.size();
+        offsets[i + 1].mCorners = offsets[i].mCorners + chunk.mCorners.size();
+    }
+
+    const Offsets& totals = offsets.back();
+    data = ObjData();
+    data.mVertices.resize(totals.mVertices);
+    data.mNormals.resize(totals.mNormals);
+    data.mTextureCoordinates.resize(totals.mTextureCoordinates);
+    data.mCorners.resize(totals.mCorners);
+
+    // Chunks copy into disjoint ranges, relative indices are rebased on the attributes read by the previous chunks
+    const int counts[3] = {static_cast<int>(totals.mVertices / 3), static_cast<int>(totals.mNormals / 3), static_cast<int>(totals.mTextureCoordinates / 2)};
+    std::atomic<bool> valid(true);
+    Dazzle::ParallelFor(chunks.size(), threadCount, [&](size_t i)
+    {
+        const Chunk& chunk = chunks[i];
+        std::copy(chunk.mVertices.begin(), chunk.mVertices.end(), data.mVertices.begin() + offsets[i].mVertices);
+        std::copy(chunk.mNormals.begin(), chunk.mNormals.end(), data.mNormals.begin() + offsets[i].mNormals);
+        std::copy(chunk.mTextureCoordinates.begin(), chunk.mTextureCoordinates.end(), data.mTextureCoordinates.begin() + offsets[i].mTextureCoordinates);
+
+        const int bases[3] = {static_cast<int>(offsets[i].mVertices / 3), static_cast<int>(offsets[i].mNormals / 3), static_cast<int>(offsets[i].mTextureCoordinates / 2)};
+        ObjData::Corner* corners = data.mCorners.data() + offsets[i].mCorners;
+        for (const ChunkCorner& chunkCorner : chunk.mCorners)
+        {
+            int resolved[3];
+            for (int attribute = 0; attribute < 3; ++attribute)
+            {
+                int index = chunkCorner.mIndices[attribute];
+                if ((chunkCorner.mRelative >> attribute) & 1)
+                    index += bases[attribute];
+                else if (index == kAbsent)
+                {
+                    resolved[attribute] = kAbsent;
+                    continue;
+                }
+
+                if (index < 0 || index >= counts[attribute])
+                    valid = false;
+                resolved[attribute] = index;
+            }
+
+            *corners++ = {resolved[0], resolved[1], resolved[2]};
+        }
+    });
+
+    if (!valid)
+    {
+        std::cerr << "ObjReader: " << path << ": face references a missing vertex attribute" << std::endl;
+        data = ObjData();
+        return false;
+    }
+
+    // Groups split wherever the name or the material changes between faces
+    std::string name;
+    std::string material;
+    size_t groupStart = 0;
+    auto closeGroup = [&](size_t corner)
+    {
+        if (corner > groupStart)
+            data.mGroups.push_back({name, material, groupStart, corner - groupStart});
+        groupStart = corner;
+    };
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        for (const ChunkEvent& event : chunks[i].mEvents)
+        {
+            closeGroup(offsets[i].mCorners + event.mCorner);
+            (event.mType == ChunkEvent::Name ? name : material) = event.mValue;
+        }
+
+        for (const auto& library : chunks[i].mMaterialLibraries)
+            if (std::find(data.mMaterialLibraries.begin(), data.mMaterialLibraries.end(), library) == data.mMaterialLibraries.end())
+                data.mMaterialLibraries.push_back(library);
+    }
+    closeGroup(totals.mCorners);
+
+    auto merged = std::chrono::steady_clock::now();
+
+    if (statistics)
+    {
+        statistics->mBytes = file.GetSize();
+        statistics->mChunks = chunks.size();
+        statistics->mThreads = static_cast<unsigned int>(std::min<size_t>(threadCount, chunks.size()));
+        statistics->mParseTime = std::chrono::duration<double, std::milli>(parsed - start).count();
+        statistics->mMergeTime = std::chrono::duration<double, std::milli>(merged - parsed).count();
+    }
+
+    return true;
+}
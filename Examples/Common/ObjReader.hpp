@@ -0,0 +1,59 @@
+#ifndef _OBJ_READER_HPP_
+#define _OBJ_READER_HPP_
+
+#include <string>
+#include <vector>
+
+// Geometry of an OBJ file, as written: attributes are not deindexed and polygons are triangulated as fans.
+struct ObjData
+{
+    // 0-based attribute indices of a face corner, -1 when the corner doesn't reference the attribute
+    struct Corner
+    {
+        int mVertex;
+        int mNormal;
+        int mTextureCoordinates;
+    };
+
+    // Consecutive triangles sharing the same object (or group) name and material
+    struct Group
+    {
+        std::string mName;
+        std::string mMaterial;
+        size_t mFirstCorner;
+        size_t mCornerCount;
+    };
+
+    std::vector<float> mVertices;               // xyz
+    std::vector<float> mNormals;                // xyz
+    std::vector<float> mTextureCoordinates;     // uv
+    std::vector<Corner> mCorners;               // 3 per triangle
+    std::vector<Group> mGroups;
+    std::vector<std::string> mMaterialLibraries;
+};
+
+// OBJ reader for very large files: the file is memory mapped, split into line aligned chunks parsed in parallel and
+// the chunks are stitched back together, relative indices included.
+class ObjReader
+{
+public:
+    struct Statistics
+    {
+        size_t mBytes = 0;
+        size_t mChunks = 0;
+        unsigned int mThreads = 0;
+        double mParseTime = 0.0;    // ms
+        double mMergeTime = 0.0;    // ms
+
+        double GetThroughput() const { return mParseTime + mMergeTime > 0.0 ? mBytes / ((mParseTime + mMergeTime) * 1000.0) : 0.0; } // MB/s
+    };
+
+    // Below this a chunk costs more to schedule and merge than to parse
+    static constexpr size_t kMinChunkSize = 1 << 20;
+
+    // threadCount 0 uses every core. Files smaller than two chunks of minChunkSize bytes are read by one thread.
+    static bool Read(const std::string& path, ObjData& data, unsigned int threadCount = 0, Statistics* statistics = nullptr,
+                     size_t minChunkSize = kMinChunkSize);
+};
+
+#endif // _OBJ_READER_HPP_
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "TextureCooker.hpp"
+#include "TextureFile.hpp"
+
+namespace
+{
+    const char* const kCookParametersKey = "DazzleCookParameters";
+
+    // What a cooked file was made from besides its format: the flip, the mip filter and the modification time of every
+    // source image, 0 for one that doesn't exist
+    std::string GetCookParameters(const std::vector<std::string>& faces, bool flip, Utils::Texture::MipFilter filter)
+    {
+        std::string parameters = "flip=" + std::to_string(flip) + " filter=" + std::to_string(static_cast<int>(filter)) + " sources=";
+        for (const auto& face : faces)
+        {
+            std::error_code error;
+            const auto time = std::filesystem::last_write_time(face, error);
+            parameters += std::to_string(error ? 0 : static_cast<long long>(time.time_since_epoch().count())) + ";";
+        }
+        return parameters;
+    }
+
+    // 2x2 box filter of RGB float texels, odd edges repeat their last row or column
+    std::vector<float> DownsampleHDR(const std::vector<float>& texels, int& width, int& height)
+    {
+        const int nextWidth = std::max(1, width / 2), nextHeight = std::max(1, height / 2);
+        std::vector<float> next(static_cast<size_t>(nextWidth) * nextHeight * 3);
+
+        for (int y = 0; y < nextHeight; ++y)
+        {
+            const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (int x = 0; x < nextWidth; ++x)
+            {
+                const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for (int c = 0; c < 3; ++c)
+                {
+                    auto texel = [&](int tx, int ty) { return texels[(static_cast<size_t>(ty) * width + tx) * 3 + c]; };
+                    next[(static_cast<size_t>(y) * nextWidth + x) * 3 + c] = 0.25f * (texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1));
+                }
+            }
+        }
+
+        width = nextWidth;
+        height = nextHeight;
+        return next;
+    }
+
+    void AppendLevel(std::vector<unsigned char>& level, const std::vector<unsigned char>& face)
+    {
+        level.insert(level.end(), face.begin(), face.end());
+    }
+}
+
+bool Utils::Texture::CookTexture(const std::vector<std::string>& faces, const std::string& cookedPath, Dazzle::TextureFormat format, bool flip,
+                                 MipFilter filter, unsigned int threadCount)
+{
+    if (faces.size() != 1 && faces.size() != 6)
+    {
+        std::cerr << "Error: " << cookedPath << " needs one image, or six for a cube map" << std::endl;
+        return false;
+    }
+
+    // Faces of a level are stored one after the other, so every level gathers the faces as they're compressed
+    std::vector<std::vector<unsigned char>> levels;
+    int baseWidth = 0, baseHeight = 0;
+    for (const auto& face : faces)
+    {
+        int width = 0, height = 0;
+        std::vector<float> texels;
+        std::unique_ptr<unsigned char, void(*)(unsigned char*)> imageData(nullptr, nullptr);
+        if (Dazzle::TextureCompressor::IsHDR(format))
+        {
+            auto hdrData = GetHDRTextureData(face, width, height, flip);
+            if (hdrData)
+                texels.assign(hdrData.get(), hdrData.get() + static_cast<size_t>(width) * height * 3);
+        }
+        else
+        {
+            imageData = GetTextureData(face, width, height, flip);
+        }
+
+        if (texels.empty() && !imageData)
+        {
+            std::cerr << "Error: Unable to load " << face << std::endl;
+            return false;
+        }
+
+        if (levels.empty())
+        {
+            baseWidth = width;
+            baseHeight = height;
+            levels.resize(GetMipLevelCount(width, height));
+        }
+        else if (width != baseWidth || height != baseHeight)
+        {
+            std::cerr << "Error: " << face << " is " << width << "x" << height << ", the other faces are " << baseWidth << "x" << baseHeight << std::endl;
+            return false;
+        }
+
+        if (!texels.empty())
+        {
+            AppendLevel(levels[0], Dazzle::TextureCompressor::CompressHDR(texels.data(), width, height, threadCount));
+            for (size_t level = 1; level < levels.size(); ++level)
+            {
+                texels = DownsampleHDR(texels, width, height);
+                AppendLevel(levels[level], Dazzle::TextureCompressor::CompressHDR(texels.data(), width, height, threadCount));
+            }
+        }
+        else
+        {
+            const MipChain chain = GenerateMipChain(imageData.get(), width, height, filter, threadCount);
+            AppendLevel(levels[0], Dazzle::TextureCompressor::Compress(imageData.get(), width, height, format, threadCount));
+            for (size_t level = 0; level < chain.mLevels.size(); ++level)
+            {
+                const auto& mip = chain.mLevels[level];
+                AppendLevel(levels[level + 1], Dazzle::TextureCompressor::Compress(chain.mPixels.data() + mip.mOffset, mip.mWidth, mip.mHeight, format, threadCount));
+            }
+        }
+    }
+
+    return Dazzle::TextureFile::Write(cookedPath, format, baseWidth, baseHeight, static_cast<unsigned int>(faces.size()), levels,
+                                      {{kCookParametersKey, GetCookParameters(faces, flip, filter)}});
+}
+
+GLuint Utils::Texture::LoadCookedTexture(const std::vector<std::string>& faces, const std::string& cookedPath, Dazzle::TextureFormat format, bool flip,
+                                         MipFilter filter, SamplerPreset sampler, size_t* memory)
+{
+    auto start = std::chrono::steady_clock::now();
+    Dazzle::TextureFile file;
+    // Without the sources the cooked file is all there is, so it's only re-cooked when they are all there
+    const bool sourcesExist = std::all_of(faces.begin(), faces.end(), [](const std::string& face) { return std::filesystem::exists(face); });
+    if (!std::filesystem::exists(cookedPath) || !file.Open(cookedPath) || file.GetFormat() != format ||
+        (sourcesExist && file.GetValue(kCookParametersKey) != GetCookParameters(faces, flip, filter)))
+    {
+        file.Close();
+        if (!CookTexture(faces, cookedPath, format, flip, filter) || !file.Open(cookedPath))
+        {
+            std::cerr << "Error: Unable to cook " << cookedPath << std::endl;
+            return 0;
+        }
+
+        std::chrono::duration<double, std::milli> cookTime = std::chrono::steady_clock::now() - start;
+        std::cout << cookedPath << " cooked in " << cookTime.count() << " ms" << std::endl;
+        start = std::chrono::steady_clock::now();
+    }
+
+    GLuint texture = file.CreateTexture();
+    ApplySamplerPreset(texture, sampler);
+
+    if (memory != nullptr)
+    {
+        *memory = 0;
+        for (unsigned int level = 0; level < file.GetHeader().mLevelCount; ++level)
+            *memory += file.GetLevelSize(level);
+    }
+
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+    std::cout << cookedPath << " mapped and uploaded in " << loadTime.count() << " ms" << std::endl;
+    return texture;
+}
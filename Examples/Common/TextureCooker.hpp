@@ -0,0 +1,32 @@
+#ifndef _TEXTURE_COOKER_HPP_
+#define _TEXTURE_COOKER_HPP_
+
+#include <string>
+#include <vector>
+
+#include <GL/gl3w.h>
+
+#include "TextureCompressor.hpp"
+#include "Utils.hpp"
+
+// Kept out of Utils.hpp so only the examples loading cooked textures build the compressor and the KTX2 file sources.
+namespace Utils
+{
+    namespace Texture
+    {
+        // Block compresses the images and their full mip chains into a KTX2 file. faces holds one image, or six for a
+        // cube map in +X, -X, +Y, -Y, +Z, -Z order. BC6H reads HDR images, the other formats 8 bit ones, and filter
+        // only applies to those. The flip, the filter and the source modification times are stored in the file.
+        // threadCount 0 runs one thread per core.
+        bool CookTexture(const std::vector<std::string>& faces, const std::string& cookedPath, Dazzle::TextureFormat format, bool flip,
+                         MipFilter filter = MipFilter::Color, unsigned int threadCount = 0);
+
+        // Maps the cooked file into a texture, cooking it first when it doesn't exist, has another format, or was cooked
+        // with another flip or filter or from older sources. 0 if neither works. memory, when given, receives the bytes
+        // of every level.
+        GLuint LoadCookedTexture(const std::vector<std::string>& faces, const std::string& cookedPath, Dazzle::TextureFormat format, bool flip,
+                                 MipFilter filter = MipFilter::Color, SamplerPreset sampler = SamplerPreset::Anisotropic, size_t* memory = nullptr);
+    }
+}
+
+#endif // _TEXTURE_COOKER_HPP_
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "TextureLoader.hpp"
+#include "Utils.hpp"
+
+namespace
+{
+    const GLbitfield kMapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const int kChannels = 4;    // Images are decoded to RGBA
+
+    std::uint32_t PackColor(const glm::vec4& color)
+    {
+        const glm::vec4 scaled = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return static_cast<std::uint32_t>(scaled.r) | static_cast<std::uint32_t>(scaled.g) << 8 |
+               static_cast<std::uint32_t>(scaled.b) << 16 | static_cast<std::uint32_t>(scaled.a) << 24;
+    }
+
+    double GetElapsed(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TextureLoader::TextureLoader() :    mSampler(Utils::Texture::SamplerPreset::Anisotropic), mDecodeTime(0.0), mStop(false), mBuffer(0),
+                                    mMappedData(nullptr), mStagingSize(0), mFrameBudget(0), mHead(0), mTail(0)
+{
+
+}
+
+TextureLoader::~TextureLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+        mPending.clear();
+    }
+    mCondition.notify_all();
+    for (auto& worker : mWorkers)
+        worker.join();
+
+    for (auto& fence : mFences)
+        glDeleteSync(fence.mFence);
+
+    if (mBuffer > 0)
+    {
+        glUnmapNamedBuffer(mBuffer);
+        glDeleteBuffers(1, &mBuffer);
+    }
+
+    for (const auto& request : mRequests)
+        if (request->mTexture > 0)
+            glDeleteTextures(1, &request->mTexture);
+
+    for (const auto& placeholder : mPlaceholders)
+        glDeleteTextures(1, &placeholder.second);
+}
+
+void TextureLoader::Initialize(Utils::Texture::SamplerPreset sampler, GLsizeiptr stagingSize, GLsizeiptr frameBudget, unsigned int threadCount)
+{
+    mSampler = sampler;
+    mStagingSize = stagingSize;
+    mFrameBudget = std::min(frameBudget, stagingSize);
+    mHead = 0;
+    mTail = 0;
+
+    glCreateBuffers(1, &mBuffer);
+    glNamedBufferStorage(mBuffer, mStagingSize, nullptr, kMapFlags);
+    mMappedData = static_cast<unsigned char*>(glMapNamedBufferRange(mBuffer, 0, mStagingSize, kMapFlags));
+
+    if (mMappedData == nullptr)
+        std::cerr << "TextureLoader: Failed to map the staging buffer, images will be uploaded from client memory" << std::endl;
+
+    if (threadCount == 0)
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+        mWorkers.emplace_back(&TextureLoader::Decode, this);
+}
+
+TextureLoader::Handle TextureLoader::Load(const std::string& path, bool flip, const glm::vec4& placeholder, Utils::Texture::MipFilter filter)
+{
+    auto handle = mHandles.find(path);
+    if (handle != mHandles.end())
+        return handle->second;
+
+    if (mStatistics.mRequested == 0)
+        mFirstRequest = std::chrono::steady_clock::now();
+
+    auto request = std::make_unique<Request>();
+    request->mPath = path;
+    request->mFlip = flip;
+    request->mFilter = filter;
+    request->mPlaceholder = GetPlaceholder(placeholder);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.push_back(request.get());
+    }
+    mCondition.notify_one();
+
+    mRequests.push_back(std::move(request));
+    ++mStatistics.mRequested;
+    return mHandles[path] = mRequests.size() - 1;
+}
+
+TextureLoader::Handle TextureLoader::LoadPlaceholder(const glm::vec4& color)
+{
+    const std::uint32_t pixel = PackColor(color);
+    auto handle = mPlaceholderHandles.find(pixel);
+    if (handle != mPlaceholderHandles.end())
+        return handle->second;
+
+    // Never queued, so it isn't counted in the statistics
+    auto request = std::make_unique<Request>();
+    request->mState = State::PLACEHOLDER;
+    request->mPlaceholder = GetPlaceholder(color);
+
+    mRequests.push_back(std::move(request));
+    return mPlaceholderHandles[pixel] = mRequests.size() - 1;
+}
+
+void TextureLoader::Decode()
+{
+    for (;;)
+    {
+        Request* request = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStop || !mPending.empty(); });
+            if (mStop)
+                return;
+
+            request = mPending.front();
+            mPending.pop_front();
+        }
+
+        // stb's flip setting is global, so the rows are flipped here rather than by stb on another thread's behalf
+        auto start = std::chrono::steady_clock::now();
+        request->mPixels = Utils::Texture::GetTextureData(request->mPath, request->mWidth, request->mHeight, false);
+        if (request->mPixels && request->mFlip)
+        {
+            const size_t rowSize = static_cast<size_t>(request->mWidth) * kChannels;
+            unsigned char* pixels = request->mPixels.get();
+            for (int top = 0, bottom = request->mHeight - 1; top < bottom; ++top, --bottom)
+                std::swap_ranges(pixels + top * rowSize, pixels + (top + 1) * rowSize, pixels + bottom * rowSize);
+        }
+
+        // Images are decoded in parallel already, each one is filtered on a single thread
+        if (request->mPixels)
+            request->mChain = Utils::Texture::GenerateMipChain(request->mPixels.get(), request->mWidth, request->mHeight, request->mFilter, 1);
+        const double time = GetElapsed(start);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDecoded.push_back(request);
+        mDecodeTime += time;
+    }
+}
+
+void TextureLoader::Update()
+{
+    if (IsIdle())
+        return;
+
+    RetireStaging();
+
+    std::vector<Request*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        decoded.swap(mDecoded);
+        mStatistics.mDecodeTime = mDecodeTime;
+    }
+
+    // Storage is allocated as soon as the size is known, the rows follow over the next frames
+    for (Request* request : decoded)
+    {
+        if (!request->mPixels)
+        {
+            std::cerr << "TextureLoader: Unable to load " << request->mPath << std::endl;
+            request->mState = State::FAILED;
+            ++mStatistics.mFailed;
+            continue;
+        }
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &request->mTexture);
+        glTextureStorage2D(request->mTexture, Utils::Texture::GetMipLevelCount(request->mWidth, request->mHeight), GL_RGBA8, request->mWidth, request->mHeight);
+        Utils::Texture::ApplySamplerPreset(request->mTexture, mSampler);
+
+        request->mState = State::UPLOADING;
+        mUploads.push_back(request);
+    }
+
+    // Rows are staged until the frame budget or the free part of the ring runs out
+    GLsizeiptr budget = mFrameBudget;
+    bool staged = false;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+    while (!mUploads.empty())
+    {
+        Request& request = *mUploads.front();
+
+        // Level 0 is the decoded image, the others come from its mip chain
+        int width = request.mWidth, height = request.mHeight;
+        const unsigned char* pixels = request.mPixels.get();
+        if (request.mUploadedLevel > 0)
+        {
+            const auto& level = request.mChain.mLevels[request.mUploadedLevel - 1];
+            width = level.mWidth;
+            height = level.mHeight;
+            pixels = request.mChain.mPixels.data() + level.mOffset;
+        }
+
+        const GLsizeiptr rowSize = static_cast<GLsizeiptr>(width) * kChannels;
+        const unsigned char* rows = pixels + request.mUploadedRows * rowSize;
+        const int remainingRows = height - request.mUploadedRows;
+
+        if (mMappedData == nullptr || rowSize > mStagingSize)
+        {
+            // No staging for this one, the driver copies the level from client memory
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTextureSubImage2D(request.mTexture, request.mUploadedLevel, 0, request.mUploadedRows, width, remainingRows, GL_RGBA, GL_UNSIGNED_BYTE, rows);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffer);
+            request.mUploadedRows = height;
+        }
+        else
+        {
+            // A row at least, however small the budget
+            if (budget <= 0)
+                break;
+
+            const GLsizeiptr size = ReserveStaging(rowSize, std::min(std::max(budget, rowSize), remainingRows * rowSize));
+            if (size == 0)
+                break;
+
+            const GLsizeiptr offset = mHead % mStagingSize;
+            const int rowCount = static_cast<int>(size / rowSize);
+            std::memcpy(mMappedData + offset, rows, size);
+            glTextureSubImage2D(request.mTexture, request.mUploadedLevel, 0, request.mUploadedRows, width, rowCount, GL_RGBA, GL_UNSIGNED_BYTE,
+                                reinterpret_cast<const void*>(offset));
+
+            mHead += size;
+            budget -= size;
+            staged = true;
+            request.mUploadedRows += rowCount;
+        }
+
+        if (request.mUploadedRows < height)
+            continue;
+
+        mStatistics.mUploadedBytes += static_cast<size_t>(height) * rowSize;
+        request.mUploadedRows = 0;
+        if (++request.mUploadedLevel <= static_cast<int>(request.mChain.mLevels.size()))
+            continue;
+
+        ++mStatistics.mResident;
+        request.mPixels.reset();
+        request.mChain = Utils::Texture::MipChain();
+        request.mState = State::RESIDENT;
+        mUploads.pop_front();
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (staged)
+        mFences.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mHead});
+
+    if (IsIdle())
+        mStatistics.mLoadTime = GetElapsed(mFirstRequest);
+}
+
+GLuint TextureLoader::GetTexture(Handle handle) const
+{
+    if (handle >= mRequests.size())
+        return 0;
+
+    const Request& request = *mRequests[handle];
+    // Images that failed to load keep their neutral placeholder, so the material still shades sensibly
+    return request.mState == State::RESIDENT ? request.mTexture : request.mPlaceholder;
+}
+
+bool TextureLoader::IsResident(Handle handle) const
+{
+    return handle < mRequests.size() && mRequests[handle]->mState == State::RESIDENT;
+}
+
+GLuint TextureLoader::GetPlaceholder(const glm::vec4& color)
+{
+    const std::uint32_t pixel = PackColor(color);
+    auto placeholder = mPlaceholders.find(pixel);
+    if (placeholder != mPlaceholders.end())
+        return placeholder->second;
+
+    GLuint texture = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureStorage2D(texture, 1, GL_RGBA8, 1, 1);
+    glTextureSubImage2D(texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &pixel);
+
+    return mPlaceholders[pixel] = texture;
+}
+
+void TextureLoader::RetireStaging()
+{
+    // Without waiting, rows that don't fit are staged on a later frame
+    while (!mFences.empty())
+    {
+        const GLenum result = glClientWaitSync(mFences.front().mFence, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(mFences.front().mFence);
+        mTail = mFences.front().mEnd;
+        mFences.pop_front();
+    }
+}
+
+GLsizeiptr TextureLoader::ReserveStaging(GLsizeiptr rowSize, GLsizeiptr maxSize)
+{
+    GLsizeiptr offset = mHead % mStagingSize;
+    GLsizeiptr free = mStagingSize - (mHead - mTail);
+    const GLsizeiptr toEnd = mStagingSize - offset;
+    if (toEnd < rowSize && free >= toEnd + rowSize)
+    {
+        mHead += toEnd;
+        free -= toEnd;
+        offset = 0;
+    }
+
+    const GLsizeiptr size = std::min({free, mStagingSize - offset, maxSize});
+    return size / rowSize * rowSize;
+}
@@ -0,0 +1,132 @@
+#ifndef _TEXTURE_LOADER_HPP_
+#define _TEXTURE_LOADER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include "Utils.hpp"
+
+// Loads image files into textures without blocking the render thread. stb decodes the images and their mip chains are
+// filtered on worker threads, the render thread copies their rows into a persistently mapped pixel unpack buffer used
+// as a ring, and the driver uploads them from there. A fence per frame of staged rows keeps the ring from being
+// overwritten before the upload is done. Until a texture is resident, its handle resolves to a 1x1 placeholder of the color given to Load().
+class TextureLoader
+{
+public:
+    using Handle = size_t;
+    static const Handle kInvalidHandle = ~static_cast<size_t>(0);
+
+    static const GLsizeiptr kDefaultStagingSize = 64 * 1024 * 1024;
+    static const GLsizeiptr kDefaultFrameBudget = 16 * 1024 * 1024;    // Bytes staged per Update() at most
+
+    struct Statistics
+    {
+        size_t mRequested = 0;
+        size_t mResident = 0;
+        size_t mFailed = 0;
+        size_t mUploadedBytes = 0;
+        double mDecodeTime = 0.0;   // ms decoding and filtering mip levels, summed over the workers
+        double mLoadTime = 0.0;     // ms from the first request until every texture is resident
+    };
+
+    TextureLoader();
+    TextureLoader(const TextureLoader& other) = delete;
+    ~TextureLoader();
+
+    TextureLoader& operator=(const TextureLoader& other) = delete;
+
+    // Maps the staging ring and starts the workers, threadCount 0 leaves a core to the render thread. Every texture is
+    // sampled with the given preset.
+    void Initialize(Utils::Texture::SamplerPreset sampler = Utils::Texture::SamplerPreset::Anisotropic, GLsizeiptr stagingSize = kDefaultStagingSize,
+                    GLsizeiptr frameBudget = kDefaultFrameBudget, unsigned int threadCount = 0);
+
+    // Queues the image for decoding and returns right away, requests of the same path share the texture.
+    Handle Load(const std::string& path, bool flip, const glm::vec4& placeholder = glm::vec4(1.0f),
+                Utils::Texture::MipFilter filter = Utils::Texture::MipFilter::Color);
+    // Handle of a 1x1 texture of the given color, for materials without an image. Nothing is loaded, requests of the
+    // same color share the texture.
+    Handle LoadPlaceholder(const glm::vec4& color);
+    // Render thread, once per frame: allocates the storage of the decoded images and stages up to a frame budget of rows.
+    void Update();
+
+    // The texture once it's resident, its placeholder before and for images that failed to load. 0 for kInvalidHandle.
+    GLuint GetTexture(Handle handle) const;
+    bool IsResident(Handle handle) const;
+    // Every requested image is resident or failed to load.
+    bool IsIdle() const { return mStatistics.mResident + mStatistics.mFailed == mStatistics.mRequested; }
+    const Statistics& GetStatistics() const { return mStatistics; }
+
+private:
+    enum class State { DECODING, UPLOADING, RESIDENT, FAILED, PLACEHOLDER };
+
+    struct Request
+    {
+        std::string mPath;
+        bool mFlip = false;
+        Utils::Texture::MipFilter mFilter = Utils::Texture::MipFilter::Color;
+        State mState = State::DECODING;
+        GLuint mPlaceholder = 0;
+        GLuint mTexture = 0;
+
+        // Written by a worker, read by the render thread once the request is in mDecoded
+        std::unique_ptr<unsigned char, void(*)(unsigned char*)> mPixels{nullptr, nullptr};
+        Utils::Texture::MipChain mChain;
+        int mWidth = 0;
+        int mHeight = 0;
+        int mUploadedLevel = 0;
+        int mUploadedRows = 0;              // Of mUploadedLevel
+    };
+
+    struct StagingFence
+    {
+        GLsync mFence;
+        GLsizeiptr mEnd;            // mHead when the fence was inserted
+    };
+
+    void Decode();
+    GLuint GetPlaceholder(const glm::vec4& color);
+    void RetireStaging();
+    // Bytes of whole rows that can be staged contiguously at mHead, wrapping to the start of the ring if the end is too short
+    GLsizeiptr ReserveStaging(GLsizeiptr rowSize, GLsizeiptr maxSize);
+
+    std::vector<std::unique_ptr<Request>> mRequests;    // Indexed by handle
+    std::unordered_map<std::string, Handle> mHandles;
+    std::unordered_map<std::uint32_t, GLuint> mPlaceholders;
+    std::unordered_map<std::uint32_t, Handle> mPlaceholderHandles;     // Of LoadPlaceholder(), by packed color
+    std::deque<Request*> mUploads;                      // Render thread only
+    Utils::Texture::SamplerPreset mSampler;
+
+    // Shared with the workers
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<Request*> mPending;
+    std::vector<Request*> mDecoded;
+    double mDecodeTime;
+    bool mStop;
+    std::vector<std::thread> mWorkers;
+
+    // Staging ring, mHead and mTail only grow and wrap modulo mStagingSize
+    GLuint mBuffer;
+    unsigned char* mMappedData;
+    GLsizeiptr mStagingSize;
+    GLsizeiptr mFrameBudget;
+    GLsizeiptr mHead;
+    GLsizeiptr mTail;
+    std::deque<StagingFence> mFences;
+
+    Statistics mStatistics;
+    std::chrono::steady_clock::time_point mFirstRequest;
+};
+
+#endif // _TEXTURE_LOADER_HPP_
@@ -1,4 +1,19 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTILS_SSE
+#include <emmintrin.h>
+#endif
 
 #include "glm/glm.hpp"
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -6,6 +21,9 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "MeshOptimizer.hpp"
+#include "ObjReader.hpp"
+#include "ParallelFor.hpp"
 #include "Utils.hpp"
 
 void Utils::Geom::GetMeshDataFromObj(   std::string filePath,
@@ -64,15 +82,855 @@ void Utils::Geom::GetMeshDataFromObj(   std::string filePath,
         }
 }
 
-std::vector<float> Utils::Geom::GenerateNormals()
+namespace
+{
+    const float kObjCreaseAngle = 45.0f;        // Degrees between faces above which generated OBJ normals aren't smoothed
+
+    // Position, normal and texture coordinate indices of a face corner, the key vertices are welded on
+    struct CornerKey
+    {
+        int mVertex;
+        int mNormal;
+        int mTextureCoordinates;
+
+        bool operator==(const CornerKey& other) const
+        {
+            return mVertex == other.mVertex && mNormal == other.mNormal && mTextureCoordinates == other.mTextureCoordinates;
+        }
+    };
+
+    struct CornerKeyHash
+    {
+        size_t operator()(const CornerKey& key) const
+        {
+            uint64_t hash = static_cast<uint32_t>(key.mVertex);
+            hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.mNormal);
+            hash = hash * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(key.mTextureCoordinates);
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+
+    // 1 thread, doubling up to one per core
+    std::vector<unsigned int> GetBenchmarkThreadCounts()
+    {
+        const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned int> threadCounts;
+        for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(maxThreads);
+        return threadCounts;
+    }
+
+    // Runs timed(threads) for every thread count, it returns its time in ms or a negative value to stop. Each run is
+    // printed by report(threads, time, speedup over the first run).
+    template <typename Timed, typename Report>
+    void BenchmarkThreadCounts(const std::vector<unsigned int>& threadCounts, const Timed& timed, const Report& report)
+    {
+        double firstTime = 0.0;
+        for (unsigned int threads : threadCounts)
+        {
+            const double time = timed(threads);
+            if (time < 0.0)
+                return;
+
+            if (firstTime == 0.0)
+                firstTime = time;
+            report(threads, time, time > 0.0 ? firstTime / time : 1.0);
+        }
+    }
+}
+
+bool Utils::Geom::LoadObj(const std::string& filePath, std::vector<ObjShape>& shapes, std::vector<ObjMaterial>& materials)
+{
+    ObjData data;
+    ObjReader::Statistics statistics;
+    if (!ObjReader::Read(filePath, data, 0, &statistics))
+    {
+        std::cerr << "Error: Unable to load " << filePath << std::endl;
+        return false;
+    }
+
+    // Material libraries are tiny next to the geometry, tinyobj reads them
+    const size_t separator = filePath.find_last_of("/\\");
+    const std::string directory = separator != std::string::npos ? filePath.substr(0, separator + 1) : std::string();
+    std::map<std::string, int> materialIndices;
+    std::vector<tinyobj::material_t> objMaterials;
+    for (const auto& library : data.mMaterialLibraries)
+    {
+        std::ifstream inputStream(directory + library);
+        if (inputStream.fail())
+        {
+            std::cout << "Warning: Material library " << directory + library << " not found" << std::endl;
+            continue;
+        }
+
+        std::string warning, error;
+        tinyobj::LoadMtl(&materialIndices, &objMaterials, &inputStream, &warning, &error);
+        if (!error.empty())
+            std::cerr << "Error: " << error << std::endl;
+    }
+
+    // Shapes and materials are appended to what the caller already holds, so the material ids start after its materials
+    const int firstMaterial = static_cast<int>(materials.size());
+    for (const auto& material : objMaterials)
+    {
+        ObjMaterial m;
+        m.mName = material.name;
+        m.mAmbient = {material.ambient[0], material.ambient[1], material.ambient[2]};
+        m.mDiffuse = {material.diffuse[0], material.diffuse[1], material.diffuse[2]};
+        m.mSpecular = {material.specular[0], material.specular[1], material.specular[2]};
+        m.mShininess = material.shininess;
+        m.mDiffuseTexture = material.diffuse_texname;
+        m.mNormalTexture = !material.normal_texname.empty() ? material.normal_texname : material.bump_texname;
+        materials.push_back(std::move(m));
+    }
+
+    const bool hasNormals = !data.mNormals.empty();
+    const bool hasTextureCoordinates = !data.mTextureCoordinates.empty();
+
+    // Consecutive groups with the same name form a shape, split into a part per material
+    std::map<int, size_t> shapeByMaterial;
+    std::vector<std::unordered_map<CornerKey, unsigned int, CornerKeyHash>> welds;   // One per part
+    const size_t firstPart = shapes.size();
+    const std::string* currentName = nullptr;
+    for (const auto& group : data.mGroups)
+    {
+        if (!currentName || group.mName != *currentName)
+            shapeByMaterial.clear();
+        currentName = &group.mName;
+
+        const auto materialIndex = materialIndices.find(group.mMaterial);
+        const int material = materialIndex != materialIndices.end() ? firstMaterial + materialIndex->second : -1;
+        auto part = shapeByMaterial.find(material);
+        if (part == shapeByMaterial.end())
+        {
+            part = shapeByMaterial.emplace(material, shapes.size()).first;
+            welds.emplace_back();
+            shapes.emplace_back();
+            shapes.back().mName = group.mName;
+            shapes.back().mMaterial = material;
+        }
+
+        ObjShape& target = shapes[part->second];
+        auto& weld = welds[part->second - firstPart];
+        for (size_t corner = group.mFirstCorner; corner < group.mFirstCorner + group.mCornerCount; ++corner)
+        {
+            const ObjData::Corner& index = data.mCorners[corner];
+            const CornerKey key = {index.mVertex, index.mNormal, index.mTextureCoordinates};
+
+            auto welded = weld.find(key);
+            if (welded != weld.end())
+            {
+                target.mIndices.push_back(welded->second);
+                continue;
+            }
+
+            const unsigned int vertex = static_cast<unsigned int>(target.mVertices.size() / 3);
+            weld.emplace(key, vertex);
+            target.mIndices.push_back(vertex);
+
+            for (int i = 0; i < 3; ++i)
+                target.mVertices.push_back(data.mVertices[3 * index.mVertex + i]);
+
+            // Corners without a normal or texture coordinates get zeros, so every attribute stays per vertex
+            if (hasNormals)
+                for (int i = 0; i < 3; ++i)
+                    target.mNormals.push_back(index.mNormal >= 0 ? data.mNormals[3 * index.mNormal + i] : 0.0f);
+
+            if (hasTextureCoordinates)
+                for (int i = 0; i < 2; ++i)
+                    target.mTextureCoordinates.push_back(index.mTextureCoordinates >= 0 ? data.mTextureCoordinates[2 * index.mTextureCoordinates + i] : 0.0f);
+        }
+    }
+
+    // Files without normals get smooth ones, split where faces meet at a hard edge
+    if (!hasNormals)
+        for (size_t i = firstPart; i < shapes.size(); ++i)
+            shapes[i].mNormals = GenerateNormals(shapes[i].mVertices, shapes[i].mIndices, {&shapes[i].mTextureCoordinates},
+                                                 NormalWeighting::Angle, kObjCreaseAngle);
+
+    size_t vertexCount = 0;
+    for (const auto& weld : welds)
+        vertexCount += weld.size();
+
+    std::cout << filePath << ": " << shapes.size() << " shapes, " << materials.size() << " materials, "
+              << data.mCorners.size() << " face corners welded into " << vertexCount << " vertices" << std::endl;
+    std::cout << filePath << ": " << statistics.mBytes / (1024.0 * 1024.0) << " MB read in " << statistics.mParseTime + statistics.mMergeTime
+              << " ms on " << statistics.mThreads << " threads (" << statistics.GetThroughput() << " MB/s)" << std::endl;
+    return !shapes.empty();
+}
+
+void Utils::Geom::BenchmarkObj(const std::string& filePath)
 {
-    /// TODO:
-    return std::vector<float>();
+    // Reference: the single threaded tinyobj reader that LoadObj() used before
+    auto start = std::chrono::steady_clock::now();
+    tinyobj::ObjReader reader;
+    if (!reader.ParseFromFile(filePath))
+        return;
+    const double referenceTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    ObjData data;
+    ObjReader::Statistics statistics;
+    if (!ObjReader::Read(filePath, data, 1, &statistics))
+        return;
+
+    // Files smaller than the default chunks, like the example models, are split anyway so every thread gets work
+    const std::vector<unsigned int> threadCounts = GetBenchmarkThreadCounts();
+    const unsigned int maxThreads = threadCounts.back();
+    const size_t chunkSize = std::min<size_t>(ObjReader::kMinChunkSize, std::max<size_t>(1, statistics.mBytes / (maxThreads * 4)));
+
+    const double megabytes = statistics.mBytes / (1024.0 * 1024.0);
+    std::printf("%s: %.1f MB, chunks of at least %.1f KB\n", filePath.c_str(), megabytes, chunkSize / 1024.0);
+    std::printf("    tinyobj            %8.1f ms %8.1f MB/s\n", referenceTime, megabytes * 1000.0 / referenceTime);
+
+    BenchmarkThreadCounts(threadCounts, [&](unsigned int threads)
+    {
+        return ObjReader::Read(filePath, data, threads, &statistics, chunkSize) ? statistics.mParseTime + statistics.mMergeTime : -1.0;
+    },
+    [&](unsigned int threads, double time, double speedup)
+    {
+        std::printf("    ObjReader %2u thr.  %8.1f ms %8.1f MB/s  (parse %.1f ms, merge %.1f ms, %.2fx)\n", threads, time,
+                    statistics.GetThroughput(), statistics.mParseTime, statistics.mMergeTime, speedup);
+    });
+}
+
+Utils::Geom::ObjShape Utils::Geom::MergeObjShapes(const std::vector<ObjShape>& shapes)
+{
+    ObjShape merged;
+    if (shapes.empty())
+        return merged;
+
+    merged.mName = shapes.front().mName;
+    merged.mMaterial = shapes.front().mMaterial;
+    for (const auto& shape : shapes)
+    {
+        const unsigned int baseVertex = static_cast<unsigned int>(merged.mVertices.size() / 3);
+        merged.mVertices.insert(merged.mVertices.end(), shape.mVertices.begin(), shape.mVertices.end());
+        merged.mNormals.insert(merged.mNormals.end(), shape.mNormals.begin(), shape.mNormals.end());
+        merged.mTextureCoordinates.insert(merged.mTextureCoordinates.end(), shape.mTextureCoordinates.begin(), shape.mTextureCoordinates.end());
+        for (unsigned int index : shape.mIndices)
+            merged.mIndices.push_back(baseVertex + index);
+    }
+
+    return merged;
+}
+
+namespace
+{
+    const size_t kBlockSize = 16384;            // Faces or vertices per task of the normal and tangent generation
+    const unsigned int kNoVertex = ~0u;
+
+    // Per face tangent frames, one array per component so four faces are computed and stored at once
+    struct FaceTangents
+    {
+        std::vector<float> mTangent[3];
+        std::vector<float> mBitangent[3];
+        std::vector<float> mAngle[3];           // Corner angles, the weight of the face at each vertex. 0 on degenerate faces
+
+        explicit FaceTangents(size_t faceCount)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                mTangent[i].resize(faceCount);
+                mBitangent[i].resize(faceCount);
+                mAngle[i].resize(faceCount);
+            }
+        }
+    };
+
+    float CornerAngle(float dot, float lengthSquared0, float lengthSquared1)
+    {
+        const float lengths = std::sqrt(lengthSquared0 * lengthSquared1);
+        return lengths > 0.0f ? std::acos(std::clamp(dot / lengths, -1.0f, 1.0f)) : 0.0f;
+    }
+
+    // e1 = p1 - p0, e2 = p2 - p0 and e3 = p2 - p1, the faces without texture space area get no weight
+    void SetCornerAngles(FaceTangents& faces, size_t face, float determinant, float e1e2, float e1e3, float e2e3,
+                         float e1e1, float e2e2, float e3e3)
+    {
+        const bool degenerate = std::fabs(determinant) < 1e-12f;
+        faces.mAngle[0][face] = degenerate ? 0.0f : CornerAngle(e1e2, e1e1, e2e2);
+        faces.mAngle[1][face] = degenerate ? 0.0f : CornerAngle(-e1e3, e1e1, e3e3);
+        faces.mAngle[2][face] = degenerate ? 0.0f : CornerAngle(e2e3, e2e2, e3e3);
+    }
+
+    // Texture space axes of a face. As in MikkTSpace they're only scaled by the sign of the UV area, the vertices
+    // normalize them after projecting them on their normal.
+    void ComputeFaceTangents(FaceTangents& faces, size_t face, const unsigned int* corners, const float* positions,
+                             const float* textureCoords)
+    {
+        const glm::vec3 p0(positions[corners[0] * 3 + 0], positions[corners[0] * 3 + 1], positions[corners[0] * 3 + 2]);
+        const glm::vec3 p1(positions[corners[1] * 3 + 0], positions[corners[1] * 3 + 1], positions[corners[1] * 3 + 2]);
+        const glm::vec3 p2(positions[corners[2] * 3 + 0], positions[corners[2] * 3 + 1], positions[corners[2] * 3 + 2]);
+        const glm::vec2 uv0(textureCoords[corners[0] * 2 + 0], textureCoords[corners[0] * 2 + 1]);
+        const glm::vec2 uv1(textureCoords[corners[1] * 2 + 0], textureCoords[corners[1] * 2 + 1]);
+        const glm::vec2 uv2(textureCoords[corners[2] * 2 + 0], textureCoords[corners[2] * 2 + 1]);
+
+        const glm::vec3 edge1 = p1 - p0;
+        const glm::vec3 edge2 = p2 - p0;
+        const glm::vec3 edge3 = p2 - p1;
+        const glm::vec2 deltaUV1 = uv1 - uv0;
+        const glm::vec2 deltaUV2 = uv2 - uv0;
+
+        const float determinant = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+        const float sign = determinant < 0.0f ? -1.0f : 1.0f;
+        const glm::vec3 tangent = sign * (deltaUV2.y * edge1 - deltaUV1.y * edge2);
+        const glm::vec3 bitangent = sign * (deltaUV1.x * edge2 - deltaUV2.x * edge1);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            faces.mTangent[i][face] = tangent[i];
+            faces.mBitangent[i][face] = bitangent[i];
+        }
+
+        SetCornerAngles(faces, face, determinant, glm::dot(edge1, edge2), glm::dot(edge1, edge3), glm::dot(edge2, edge3),
+                        glm::dot(edge1, edge1), glm::dot(edge2, edge2), glm::dot(edge3, edge3));
+    }
+
+#ifdef UTILS_SSE
+    // ComputeFaceTangents() on faces face .. face + 3, the attributes are gathered into one register per component
+    void ComputeFaceTangents4(FaceTangents& faces, size_t face, const unsigned int* corners, const float* positions,
+                              const float* textureCoords)
+    {
+        auto gather = [&](int corner, int component, int stride, const float* data)
+        {
+            return _mm_setr_ps(data[corners[0 + corner] * stride + component], data[corners[3 + corner] * stride + component],
+                               data[corners[6 + corner] * stride + component], data[corners[9 + corner] * stride + component]);
+        };
+        auto dot = [](const __m128* a, const __m128* b)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+        };
+
+        __m128 edge1[3], edge2[3], edge3[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            const __m128 p0 = gather(0, i, 3, positions);
+            const __m128 p1 = gather(1, i, 3, positions);
+            const __m128 p2 = gather(2, i, 3, positions);
+            edge1[i] = _mm_sub_ps(p1, p0);
+            edge2[i] = _mm_sub_ps(p2, p0);
+            edge3[i] = _mm_sub_ps(p2, p1);
+        }
+
+        const __m128 u0 = gather(0, 0, 2, textureCoords), v0 = gather(0, 1, 2, textureCoords);
+        const __m128 du1 = _mm_sub_ps(gather(1, 0, 2, textureCoords), u0), dv1 = _mm_sub_ps(gather(1, 1, 2, textureCoords), v0);
+        const __m128 du2 = _mm_sub_ps(gather(2, 0, 2, textureCoords), u0), dv2 = _mm_sub_ps(gather(2, 1, 2, textureCoords), v0);
+
+        // Flipping the sign bit scales by the sign of the determinant without a branch
+        const __m128 determinant = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(dv1, du2));
+        const __m128 sign = _mm_and_ps(determinant, _mm_set1_ps(-0.0f));
+        for (int i = 0; i < 3; ++i)
+        {
+            const __m128 tangent = _mm_sub_ps(_mm_mul_ps(dv2, edge1[i]), _mm_mul_ps(dv1, edge2[i]));
+            const __m128 bitangent = _mm_sub_ps(_mm_mul_ps(du1, edge2[i]), _mm_mul_ps(du2, edge1[i]));
+            _mm_storeu_ps(&faces.mTangent[i][face], _mm_xor_ps(tangent, sign));
+            _mm_storeu_ps(&faces.mBitangent[i][face], _mm_xor_ps(bitangent, sign));
+        }
+
+        // acos has no SSE instruction, the angles are taken lane by lane
+        alignas(16) float values[7][4];
+        _mm_store_ps(values[0], determinant);
+        _mm_store_ps(values[1], dot(edge1, edge2));
+        _mm_store_ps(values[2], dot(edge1, edge3));
+        _mm_store_ps(values[3], dot(edge2, edge3));
+        _mm_store_ps(values[4], dot(edge1, edge1));
+        _mm_store_ps(values[5], dot(edge2, edge2));
+        _mm_store_ps(values[6], dot(edge3, edge3));
+        for (int i = 0; i < 4; ++i)
+            SetCornerAngles(faces, face + i, values[0][i], values[1][i], values[2][i], values[3][i], values[4][i], values[5][i], values[6][i]);
+    }
+#endif
+
+    // Any unit vector perpendicular to the normal, for the vertices no face gives a texture direction
+    glm::vec3 GetPerpendicular(const glm::vec3& normal)
+    {
+        const glm::vec3 axis = std::fabs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(normal, axis));
+    }
+
+    // Wavy grid of two triangles per quad, indexed like the meshes the loaders produce
+    void BuildBenchmarkGrid(unsigned int triangleCount, std::vector<float>& vertices, std::vector<float>& normals,
+                            std::vector<float>& textureCoords, std::vector<unsigned int>& indices)
+    {
+        const unsigned int columns = std::max(1u, static_cast<unsigned int>(std::sqrt(triangleCount)));
+        const unsigned int rows = std::max(1u, triangleCount / 2 / columns);
+        vertices.clear();
+        normals.clear();
+        textureCoords.clear();
+        for (unsigned int y = 0; y <= rows; ++y)
+        {
+            for (unsigned int x = 0; x <= columns; ++x)
+            {
+                const float u = static_cast<float>(x) / columns;
+                const float v = static_cast<float>(y) / rows;
+                const float height = 0.05f * std::sin(u * 40.0f) * std::cos(v * 40.0f);
+                const glm::vec3 normal = glm::normalize(glm::vec3(-2.0f * std::cos(u * 40.0f) * std::cos(v * 40.0f),
+                                                                  2.0f * std::sin(u * 40.0f) * std::sin(v * 40.0f), 1.0f));
+                vertices.insert(vertices.end(), {u, v, height});
+                normals.insert(normals.end(), {normal.x, normal.y, normal.z});
+                textureCoords.insert(textureCoords.end(), {u, v});
+            }
+        }
+
+        indices.clear();
+        indices.reserve(static_cast<size_t>(rows) * columns * 6);
+        for (unsigned int y = 0; y < rows; ++y)
+        {
+            for (unsigned int x = 0; x < columns; ++x)
+            {
+                const unsigned int i = y * (columns + 1) + x;
+                indices.insert(indices.end(), {i, i + 1, i + columns + 1, i + 1, i + columns + 2, i + columns + 1});
+            }
+        }
+    }
+
+    const int kMipRowsPerTask = 32;         // Rows of a mip level downsampled by a task
+
+    // sRGB transfer function as tables: 8 bit encoded to linear, and linear quantized to 12 bits back to 8 bit encoded
+    struct SRGBTables
+    {
+        float mToLinear[256];
+        unsigned char mToSRGB[4096];
+
+        SRGBTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                const float c = i / 255.0f;
+                mToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (int i = 0; i < 4096; ++i)
+            {
+                const float c = i / 4095.0f;
+                const float encoded = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                mToSRGB[i] = static_cast<unsigned char>(encoded * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const SRGBTables& GetSRGBTables()
+    {
+        static const SRGBTables tables;
+        return tables;
+    }
+
+#ifdef UTILS_SSE
+    // RGB of a texel in lanes 0 to 2, lane 3 is 0
+    __m128 LoadTexel(const unsigned char* texel)
+    {
+        std::int32_t bits;
+        std::memcpy(&bits, texel, sizeof(bits));
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+        return _mm_cvtepi32_ps(_mm_and_si128(channels, _mm_setr_epi32(-1, -1, -1, 0)));
+    }
+
+    // Same steps as the scalar Normal filter: the four normals are decoded, summed and renormalized in one vector
+    void DownsampleNormalTexel(const unsigned char* const texels[4], unsigned char* out)
+    {
+        const __m128 scale = _mm_set1_ps(2.0f / 255.0f);
+        const __m128 one = _mm_setr_ps(1.0f, 1.0f, 1.0f, 0.0f);
+        __m128 normal = _mm_setzero_ps();
+        for (int i = 0; i < 4; ++i)
+            normal = _mm_add_ps(normal, _mm_sub_ps(_mm_mul_ps(LoadTexel(texels[i]), scale), one));
+
+        // x * x + y * y + z * z, added in glm::dot's order
+        const __m128 squares = _mm_mul_ps(normal, normal);
+        const __m128 sum = _mm_add_ss(_mm_add_ss(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(1, 1, 1, 1))),
+                                      _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 2, 2, 2)));
+        const float length = _mm_cvtss_f32(_mm_sqrt_ss(sum));
+        normal = length > 0.0f ? _mm_div_ps(normal, _mm_set1_ps(length)) : _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 encoded = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(normal, half), half), _mm_set1_ps(255.0f)), half);
+        alignas(16) std::int32_t channels[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(channels), _mm_cvttps_epi32(encoded));
+        for (int c = 0; c < 3; ++c)
+            out[c] = static_cast<unsigned char>(channels[c]);
+    }
+#endif
+
+    // Rows firstRow .. lastRow - 1 of the level below source, each texel the box filter of a 2x2 block. Odd sizes drop
+    // the last row or column, a size of 1 repeats it.
+    void DownsampleRows(const unsigned char* source, int sourceWidth, int sourceHeight, unsigned char* target, int width,
+                        int firstRow, int lastRow, Utils::Texture::MipFilter filter)
+    {
+        const SRGBTables& tables = GetSRGBTables();
+        const size_t sourceRowSize = static_cast<size_t>(sourceWidth) * 4;
+        for (int y = firstRow; y < lastRow; ++y)
+        {
+            const unsigned char* row0 = source + static_cast<size_t>(2 * y) * sourceRowSize;
+            const unsigned char* row1 = source + static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceRowSize;
+            unsigned char* out = target + static_cast<size_t>(y) * width * 4;
+            int x = 0;
+
+#ifdef UTILS_SSE
+            // Four texels at once, the sums of 2x2 blocks fit in 16 bit lanes
+            if (filter == Utils::Texture::MipFilter::Data && sourceWidth > 1)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i rounding = _mm_set1_epi16(2);
+                auto average = [&](__m128i top, __m128i bottom)
+                {
+                    const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                    const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                    const __m128i sums = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+                    return _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+                };
+
+                for (; x + 4 <= width; x += 4)
+                {
+                    const __m128i* top = reinterpret_cast<const __m128i*>(row0 + x * 8);
+                    const __m128i* bottom = reinterpret_cast<const __m128i*>(row1 + x * 8);
+                    const __m128i first = average(_mm_loadu_si128(top), _mm_loadu_si128(bottom));
+                    const __m128i second = average(_mm_loadu_si128(top + 1), _mm_loadu_si128(bottom + 1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(first, second));
+                }
+            }
+#endif
+
+            for (; x < width; ++x)
+            {
+                const unsigned char* texels[4] = {row0 + 8 * x, row0 + 4 * std::min(2 * x + 1, sourceWidth - 1),
+                                                  row1 + 8 * x, row1 + 4 * std::min(2 * x + 1, sourceWidth - 1)};
+                const int alpha = (texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4;
+                out[x * 4 + 3] = static_cast<unsigned char>(alpha);
+
+                if (filter == Utils::Texture::MipFilter::Color)
+                {
+                    // The sRGB table lookups dominate and SSE2 has no gather, this filter stays scalar
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        const float linear = 0.25f * (tables.mToLinear[texels[0][c]] + tables.mToLinear[texels[1][c]] +
+                                                      tables.mToLinear[texels[2][c]] + tables.mToLinear[texels[3][c]]);
+                        out[x * 4 + c] = tables.mToSRGB[static_cast<int>(linear * 4095.0f + 0.5f)];
+                    }
+                }
+                else if (filter == Utils::Texture::MipFilter::Normal)
+                {
+#ifdef UTILS_SSE
+                    DownsampleNormalTexel(texels, out + x * 4);
+#else
+                    glm::vec3 normal(0.0f);
+                    for (const unsigned char* texel : texels)
+                        normal += glm::vec3(texel[0], texel[1], texel[2]) * (2.0f / 255.0f) - 1.0f;
+
+                    const float length = glm::length(normal);
+                    normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                    for (int c = 0; c < 3; ++c)
+                        out[x * 4 + c] = static_cast<unsigned char>((normal[c] * 0.5f + 0.5f) * 255.0f + 0.5f);
+#endif
+                }
+                else
+                {
+                    for (int c = 0; c < 3; ++c)
+                        out[x * 4 + c] = static_cast<unsigned char>((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+                }
+            }
+        }
+    }
+
+    const size_t kHDRTexelsPerTask = 16384;     // Texels packed by a task
+    const float kMaxRGB9E5 = 65408.0f;          // (2^9 - 1) / 2^9 * 2^16
+    const float kMaxFloat11 = 65024.0f;         // Exponent 30, mantissa 63
+    const float kMaxFloat10 = 64512.0f;         // Exponent 30, mantissa 31
+
+    // Rebiases a float's exponent from 127 to 15, its bits are then those of a small float past the mantissa, target
+    // denormals included. The mantissa is rounded to mantissaBits, ties away from zero.
+    std::uint32_t ToSmallFloat(float value, float maxValue, int mantissaBits)
+    {
+        value = std::min(std::max(0.0f, value), maxValue);     // Zero first, so NaN becomes 0
+        value *= 1.9259299e-34f;                // 2^-112
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const int shift = 23 - mantissaBits;
+        return (bits + (1u << (shift - 1))) >> shift;
+    }
+
+    std::uint32_t PackR11G11B10F(const float* rgb)
+    {
+        return ToSmallFloat(rgb[0], kMaxFloat11, 6) | ToSmallFloat(rgb[1], kMaxFloat11, 6) << 11 | ToSmallFloat(rgb[2], kMaxFloat10, 5) << 22;
+    }
+
+    // Shared exponent packing of the GL specification, the largest channel picks the exponent
+    std::uint32_t PackRGB9E5(const float* rgb)
+    {
+        float channels[3];
+        for (int c = 0; c < 3; ++c)
+            channels[c] = std::min(std::max(0.0f, rgb[c]), kMaxRGB9E5);
+
+        const float maxChannel = std::max({channels[0], channels[1], channels[2]});
+        std::uint32_t bits;
+        std::memcpy(&bits, &maxChannel, sizeof(bits));
+        int exponent = std::max(static_cast<int>(bits >> 23) - 127, -16) + 16;
+
+        // 2^(15 + 9 - exponent) scales the channels to 9 bit mantissas, one exponent more if the largest rounds to 512
+        auto scale = [](int e) { return std::ldexp(1.0f, 24 - e); };
+        if (static_cast<int>(maxChannel * scale(exponent) + 0.5f) == 512)
+            ++exponent;
+
+        std::uint32_t packed = static_cast<std::uint32_t>(exponent) << 27;
+        for (int c = 0; c < 3; ++c)
+            packed |= static_cast<std::uint32_t>(channels[c] * scale(exponent) + 0.5f) << (9 * c);
+        return packed;
+    }
+
+#ifdef UTILS_SSE
+    // Float bits of 2^(24 - exponent) for each lane
+    __m128 GetRGB9E5Scale(__m128i exponent)
+    {
+        return _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(151), exponent), 23));
+    }
+
+    // Four texels at once, with the same steps as the scalar versions. The RGB triplets are transposed into a vector
+    // per channel first
+    void PackTexels4(const float* rgb, std::uint32_t* packed, Utils::Texture::HDRFormat format)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 half = _mm_set1_ps(0.5f);
+        __m128 channels[3];
+        for (int c = 0; c < 3; ++c)
+            channels[c] = _mm_setr_ps(rgb[c], rgb[3 + c], rgb[6 + c], rgb[9 + c]);
+
+        __m128i result;
+        if (format == Utils::Texture::HDRFormat::R11F_G11F_B10F)
+        {
+            const float maxValues[3] = {kMaxFloat11, kMaxFloat11, kMaxFloat10};
+            const int shifts[3] = {17, 17, 18};
+            const int offsets[3] = {0, 11, 22};
+            result = _mm_setzero_si128();
+            for (int c = 0; c < 3; ++c)
+            {
+                // _mm_max_ps() returns its second operand for NaN, which clamps it to 0
+                const __m128 clamped = _mm_min_ps(_mm_max_ps(channels[c], zero), _mm_set1_ps(maxValues[c]));
+                const __m128i bits = _mm_castps_si128(_mm_mul_ps(clamped, _mm_set1_ps(1.9259299e-34f)));
+                const __m128i rounded = _mm_add_epi32(bits, _mm_set1_epi32(1 << (shifts[c] - 1)));
+                const __m128i value = _mm_srl_epi32(rounded, _mm_cvtsi32_si128(shifts[c]));
+                result = _mm_or_si128(result, _mm_sll_epi32(value, _mm_cvtsi32_si128(offsets[c])));
+            }
+        }
+        else
+        {
+            for (int c = 0; c < 3; ++c)
+                channels[c] = _mm_min_ps(_mm_max_ps(channels[c], zero), _mm_set1_ps(kMaxRGB9E5));
+
+            // SSE2 has no 32 bit integer max, the exponent is clamped to -16 with a compare and a select
+            const __m128 maxChannel = _mm_max_ps(channels[0], _mm_max_ps(channels[1], channels[2]));
+            const __m128i floorLog2 = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxChannel), 23), _mm_set1_epi32(127));
+            const __m128i above = _mm_cmpgt_epi32(floorLog2, _mm_set1_epi32(-16));
+            __m128i exponent = _mm_add_epi32(_mm_or_si128(_mm_and_si128(above, floorLog2), _mm_andnot_si128(above, _mm_set1_epi32(-16))),
+                                             _mm_set1_epi32(16));
+
+            const __m128i maxMantissa = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(maxChannel, GetRGB9E5Scale(exponent)), half));
+            exponent = _mm_sub_epi32(exponent, _mm_cmpeq_epi32(maxMantissa, _mm_set1_epi32(512)));
+
+            const __m128 scale = GetRGB9E5Scale(exponent);
+            result = _mm_slli_epi32(exponent, 27);
+            for (int c = 0; c < 3; ++c)
+            {
+                const __m128i mantissa = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(channels[c], scale), half));
+                result = _mm_or_si128(result, _mm_sll_epi32(mantissa, _mm_cvtsi32_si128(9 * c)));
+            }
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed), result);
+    }
+#endif
+
+    void PackTexels(const float* rgb, std::uint32_t* packed, size_t count, Utils::Texture::HDRFormat format)
+    {
+        size_t i = 0;
+#ifdef UTILS_SSE
+        for (; i + 4 <= count; i += 4)
+            PackTexels4(rgb + i * 3, packed + i, format);
+#endif
+        for (; i < count; ++i)
+            packed[i] = format == Utils::Texture::HDRFormat::R11F_G11F_B10F ? PackR11G11B10F(rgb + i * 3) : PackRGB9E5(rgb + i * 3);
+    }
+}
+
+std::vector<float> Utils::Geom::GenerateNormals(std::vector<float>& vertices,
+                                                std::vector<unsigned int>& indices,
+                                                const std::vector<std::vector<float>*>& attributes,
+                                                NormalWeighting weighting,
+                                                float creaseAngle,
+                                                unsigned int threadCount)
+{
+    const size_t vertexCount = vertices.size() / 3;
+    const size_t faceCount = indices.size() / 3;
+    if (vertexCount == 0 || faceCount == 0)
+        return std::vector<float>();
+
+    for (unsigned int index : indices)
+        if (index >= vertexCount)
+            return std::vector<float>();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    auto position = [&](size_t vertex) { return glm::vec3(vertices[vertex * 3 + 0], vertices[vertex * 3 + 1], vertices[vertex * 3 + 2]); };
+
+    // Unit normal of every face and its weight at each corner, degenerate faces weigh nothing
+    std::vector<glm::vec3> faceNormals(faceCount);
+    std::vector<float> cornerWeights(faceCount * 3);
+    Dazzle::ParallelFor((faceCount + kBlockSize - 1) / kBlockSize, threadCount, [&](size_t block)
+    {
+        const size_t end = std::min((block + 1) * kBlockSize, faceCount);
+        for (size_t face = block * kBlockSize; face < end; ++face)
+        {
+            const glm::vec3 p[3] = {position(indices[face * 3 + 0]), position(indices[face * 3 + 1]), position(indices[face * 3 + 2])};
+            const glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const float length = glm::length(normal);
+            faceNormals[face] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+            for (size_t corner = 0; corner < 3; ++corner)
+            {
+                float& weight = cornerWeights[face * 3 + corner];
+                if (length == 0.0f || weighting == NormalWeighting::Area)
+                {
+                    weight = length;
+                    continue;
+                }
+
+                const glm::vec3 edge1 = p[(corner + 1) % 3] - p[corner];
+                const glm::vec3 edge2 = p[(corner + 2) % 3] - p[corner];
+                const float lengths = std::sqrt(glm::dot(edge1, edge1) * glm::dot(edge2, edge2));
+                weight = lengths > 0.0f ? std::acos(std::clamp(glm::dot(edge1, edge2) / lengths, -1.0f, 1.0f)) : 0.0f;
+            }
+        }
+    });
+
+    // Vertices split on texture seams are smoothed together, every vertex points to the first one at its position
+    std::vector<unsigned int> welded(vertexCount);
+    {
+        std::unordered_map<glm::vec3, unsigned int, Dazzle::PositionHash> firstVertex;
+        firstVertex.reserve(vertexCount);
+        for (unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+            welded[vertex] = firstVertex.emplace(position(vertex), vertex).first->second;
+    }
+
+    // Corners at each position, so the positions gather their faces instead of the faces scattering into shared vertices
+    std::vector<unsigned int> firstCorner(vertexCount + 1, 0);
+    for (unsigned int index : indices)
+        ++firstCorner[welded[index] + 1];
+    for (size_t i = 0; i < vertexCount; ++i)
+        firstCorner[i + 1] += firstCorner[i];
+
+    std::vector<unsigned int> positionCorners(indices.size());
+    std::vector<unsigned int> cursor(firstCorner.begin(), firstCorner.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        positionCorners[cursor[welded[indices[i]]]++] = static_cast<unsigned int>(i);
+
+    std::vector<float> normals(vertexCount * 3, 0.0f);
+    if (creaseAngle >= 180.0f)
+    {
+        // One normal per position, each position writes only the vertices of its own corners
+        Dazzle::ParallelFor((vertexCount + kBlockSize - 1) / kBlockSize, threadCount, [&](size_t block)
+        {
+            const size_t end = std::min((block + 1) * kBlockSize, vertexCount);
+            for (size_t i = block * kBlockSize; i < end; ++i)
+            {
+                glm::vec3 normal(0.0f);
+                for (unsigned int j = firstCorner[i]; j < firstCorner[i + 1]; ++j)
+                    normal += faceNormals[positionCorners[j] / 3] * cornerWeights[positionCorners[j]];
+
+                const float length = glm::length(normal);
+                if (length > 0.0f)
+                    normal /= length;
+
+                for (unsigned int j = firstCorner[i]; j < firstCorner[i + 1]; ++j)
+                {
+                    const unsigned int vertex = indices[positionCorners[j]];
+                    normals[vertex * 3 + 0] = normal.x;
+                    normals[vertex * 3 + 1] = normal.y;
+                    normals[vertex * 3 + 2] = normal.z;
+                }
+            }
+        });
+
+        return normals;
+    }
+
+    // Each corner only smooths with the faces within the crease angle of its own face
+    const float creaseCosine = std::cos(glm::radians(creaseAngle));
+    std::vector<glm::vec3> cornerNormals(indices.size(), glm::vec3(0.0f));
+    Dazzle::ParallelFor((vertexCount + kBlockSize - 1) / kBlockSize, threadCount, [&](size_t block)
+    {
+        const size_t end = std::min((block + 1) * kBlockSize, vertexCount);
+        for (size_t i = block * kBlockSize; i < end; ++i)
+        {
+            for (unsigned int j = firstCorner[i]; j < firstCorner[i + 1]; ++j)
+            {
+                const glm::vec3& faceNormal = faceNormals[positionCorners[j] / 3];
+                glm::vec3 normal(0.0f);
+                for (unsigned int k = firstCorner[i]; k < firstCorner[i + 1]; ++k)
+                {
+                    const glm::vec3& otherNormal = faceNormals[positionCorners[k] / 3];
+                    if (glm::dot(faceNormal, otherNormal) >= creaseCosine)
+                        normal += otherNormal * cornerWeights[positionCorners[k]];
+                }
+
+                const float length = glm::length(normal);
+                cornerNormals[positionCorners[j]] = length > 0.0f ? normal / length : faceNormal;
+            }
+        }
+    });
+
+    // A vertex keeps the normal of its first corner, corners on the other side of a crease get a copy of the vertex
+    std::vector<size_t> components;
+    for (const auto* attribute : attributes)
+        components.push_back(attribute->size() / vertexCount);
+
+    std::vector<bool> assigned(vertexCount, false);
+    std::vector<unsigned int> nextCopy(vertexCount, kNoVertex);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        const glm::vec3& normal = cornerNormals[i];
+        unsigned int vertex = indices[i];
+        if (!assigned[vertex])
+        {
+            assigned[vertex] = true;
+            normals[vertex * 3 + 0] = normal.x;
+            normals[vertex * 3 + 1] = normal.y;
+            normals[vertex * 3 + 2] = normal.z;
+            continue;
+        }
+
+        // Copies of a vertex are chained, corners reuse the one already holding their normal
+        unsigned int match = kNoVertex;
+        for (unsigned int copy = vertex; copy != kNoVertex && match == kNoVertex; copy = nextCopy[copy])
+            if (glm::dot(normal, glm::vec3(normals[copy * 3 + 0], normals[copy * 3 + 1], normals[copy * 3 + 2])) > 0.99999f)
+                match = copy;
+
+        if (match == kNoVertex)
+        {
+            match = static_cast<unsigned int>(normals.size() / 3);
+            const glm::vec3 p = position(vertex);
+            vertices.insert(vertices.end(), {p.x, p.y, p.z});
+            normals.insert(normals.end(), {normal.x, normal.y, normal.z});
+            for (size_t a = 0; a < attributes.size(); ++a)
+                for (size_t c = 0; c < components[a]; ++c)
+                    attributes[a]->push_back((*attributes[a])[vertex * components[a] + c]);
+
+            while (nextCopy[vertex] != kNoVertex)
+                vertex = nextCopy[vertex];
+            nextCopy[vertex] = match;
+            nextCopy.push_back(kNoVertex);
+        }
+
+        indices[i] = match;
+    }
+
+    return normals;
 }
 
 std::vector<float> Utils::Geom::GenerateTangents(   const std::vector<float>& vertices,
                                                     const std::vector<float>& normals,
-                                                    const std::vector<float>& textureCoords)
+                                                    const std::vector<float>& textureCoords,
+                                                    const std::vector<unsigned int>& indices,
+                                                    unsigned int threadCount)
 {
     // Return if any input is empty
     if (vertices.empty() || textureCoords.empty() || normals.empty())
@@ -86,112 +944,144 @@ std::vector<float> Utils::Geom::GenerateTangents(   const std::vector<float>& ve
     if (verticesCount != normalsCount || verticesCount != textureCoordsCount)
         return std::vector<float>();
 
-    // Vectors storing the accumulated value of tangents
-    std::vector<float> tangents(verticesCount * 4);
-    std::vector<float> bitangents(verticesCount * 3);
-
-    // Iterate through triangles
-    for (size_t i = 0; i < verticesCount - 2; i += 3)
-    {
-        float x, y, z;
-        float u, v;
-
-        // Get positions from vertices
-        // Point 0 of ith triangle
-        x = vertices[((i + 0) * 3 + 0)];
-        y = vertices[((i + 0) * 3 + 1)];
-        z = vertices[((i + 0) * 3 + 2)];
-        glm::vec3 p0(x, y, z);
-        
-        // Point 1 of ith triangle
-        x = vertices[((i + 1) * 3 + 0)];
-        y = vertices[((i + 1) * 3 + 1)];
-        z = vertices[((i + 1) * 3 + 2)];
-        glm::vec3 p1(x, y, z);
-
-        // Point 2 of ith triangle
-        x = vertices[((i + 2) * 3 + 0)];
-        y = vertices[((i + 2) * 3 + 1)];
-        z = vertices[((i + 2) * 3 + 2)];
-        glm::vec3 p2(x, y, z);
-
-        // Get texture coordinates
-        // Coordinate at 0
-        u = textureCoords[((i + 0) * 2 + 0)];
-        v = textureCoords[((i + 0) * 2 + 1)];
-        glm::vec2 uv0(u, v);
-        // Coordinate at 1
-        u = textureCoords[((i + 1) * 2 + 0)];
-        v = textureCoords[((i + 1) * 2 + 1)];
-        glm::vec2 uv1(u, v);
-        // Coordinate at 2
-        u = textureCoords[((i + 2) * 2 + 0)];
-        v = textureCoords[((i + 2) * 2 + 1)];
-        glm::vec2 uv2(u, v);
-
-        // Calculate geometry edges
-        glm::vec3 edge1 = p1 - p0;
-        glm::vec3 edge2 = p2 - p0;
-
-        // Calculate texture deltas
-        glm::vec2 deltaUV1 = uv1 - uv0;
-        glm::vec2 deltaUV2 = uv2 - uv0;
-
-        // Calculate inverse of determinant
-        float determinant = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
-        if (fabs(determinant) < 1e-6f)
-            determinant = 1e-6f;
-        float inverseDeterminant = 1.0f / determinant;
-
-        // Calculate tangent
-        // glm::vec3 tangent = inverseDeterminant * (deltaUV2.y * edge1 - deltaUV1.y * edge2);
-        glm::vec3 tangent;
-        tangent.x = inverseDeterminant * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent.y = inverseDeterminant * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent.z = inverseDeterminant * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-        // Calculate bitangents
-        // glm::vec3 bitangent = inverseDeterminant * (-deltaUV2.x * edge1 + deltaUV1.x * edge2);
-        glm::vec3 bitangent;
-        bitangent.x = inverseDeterminant * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-        bitangent.y = inverseDeterminant * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-        bitangent.z = inverseDeterminant * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-
-        // Accumulate tangents
-        for (size_t j = 0; j < 3; ++j)
-        {
-            tangents[(i + j) * 4 + 0] += tangent.x;
-            tangents[(i + j) * 4 + 1] += tangent.y;
-            tangents[(i + j) * 4 + 2] += tangent.z;
-
-            bitangents[(i + j) * 3 + 0] += bitangent.x;
-            bitangents[(i + j) * 3 + 1] += bitangent.y;
-            bitangents[(i + j) * 3 + 2] += bitangent.z;
-        }
-    }
-
-    // Normalize tangents
+    // A triangle soup is indexed in order
+    std::vector<unsigned int> soup;
+    if (indices.empty())
+    {
+        soup.resize(verticesCount - verticesCount % 3);
+        for (size_t i = 0; i < soup.size(); ++i)
+            soup[i] = static_cast<unsigned int>(i);
+    }
+    const std::vector<unsigned int>& corners = indices.empty() ? soup : indices;
+    const size_t faceCount = corners.size() / 3;
+    for (unsigned int index : corners)
+        if (index >= verticesCount)
+            return std::vector<float>();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // Texture space axes of every face
+    FaceTangents faces(faceCount);
+    Dazzle::ParallelFor((faceCount + kBlockSize - 1) / kBlockSize, threadCount, [&](size_t block)
+    {
+        size_t face = block * kBlockSize;
+        const size_t end = std::min(face + kBlockSize, faceCount);
+#ifdef UTILS_SSE
+        for (; face + 4 <= end; face += 4)
+            ComputeFaceTangents4(faces, face, &corners[face * 3], vertices.data(), textureCoords.data());
+#endif
+        for (; face < end; ++face)
+            ComputeFaceTangents(faces, face, &corners[face * 3], vertices.data(), textureCoords.data());
+    });
+
+    // Corners of each vertex, so the vertices gather their faces instead of the faces scattering into shared vertices
+    std::vector<unsigned int> firstCorner(verticesCount + 1, 0);
+    for (unsigned int index : corners)
+        ++firstCorner[index + 1];
     for (size_t i = 0; i < verticesCount; ++i)
+        firstCorner[i + 1] += firstCorner[i];
+
+    std::vector<unsigned int> vertexCorners(corners.size());
+    std::vector<unsigned int> cursor(firstCorner.begin(), firstCorner.end() - 1);
+    for (size_t i = 0; i < corners.size(); ++i)
+        vertexCorners[cursor[corners[i]]++] = static_cast<unsigned int>(i);
+
+    // Face axes projected on the vertex normal, normalized and weighted by the corner angle as in MikkTSpace. Vertices
+    // aren't split where the handedness changes, the welded mesh keeps its vertex count.
+    std::vector<float> tangents(verticesCount * 4);
+    Dazzle::ParallelFor((verticesCount + kBlockSize - 1) / kBlockSize, threadCount, [&](size_t block)
     {
-        glm::vec3 tangent( tangents[i * 4 + 0], tangents[i * 4 + 1], tangents[i * 4 + 2] );
-        glm::vec3 normal( normals[i * 3 + 0], normals[i * 3 + 1], normals[i * 3 + 2] );
+        const size_t end = std::min((block + 1) * kBlockSize, verticesCount);
+        for (size_t i = block * kBlockSize; i < end; ++i)
+        {
+            const glm::vec3 normal(normals[i * 3 + 0], normals[i * 3 + 1], normals[i * 3 + 2]);
+            glm::vec3 tangent(0.0f);
+            glm::vec3 bitangent(0.0f);
+            for (unsigned int j = firstCorner[i]; j < firstCorner[i + 1]; ++j)
+            {
+                const size_t face = vertexCorners[j] / 3;
+                const float angle = faces.mAngle[vertexCorners[j] % 3][face];
+                if (angle == 0.0f)
+                    continue;
 
-        // Gram-Schmidt orthogonalization
-        tangent = glm::normalize( tangent - glm::dot(tangent, normal) * normal );
+                glm::vec3 faceTangent(faces.mTangent[0][face], faces.mTangent[1][face], faces.mTangent[2][face]);
+                glm::vec3 faceBitangent(faces.mBitangent[0][face], faces.mBitangent[1][face], faces.mBitangent[2][face]);
+                faceTangent -= glm::dot(faceTangent, normal) * normal;
+                faceBitangent -= glm::dot(faceBitangent, normal) * normal;
 
-        // Calculate handedness
-        glm::vec3 bitangent( bitangents[i * 3 + 0], bitangents[i * 3 + 1], bitangents[i * 3 + 2] );
-        float handedness = (glm::dot(bitangent, tangent) < 0.0) ? -1.0f : 1.0f;
+                const float tangentLength = glm::length(faceTangent);
+                const float bitangentLength = glm::length(faceBitangent);
+                if (tangentLength > 0.0f)
+                    tangent += faceTangent * (angle / tangentLength);
+                if (bitangentLength > 0.0f)
+                    bitangent += faceBitangent * (angle / bitangentLength);
+            }
 
-        tangents[i * 4 + 0] = tangent.x;
-        tangents[i * 4 + 1] = tangent.y;
-        tangents[i * 4 + 2] = tangent.z;
-        tangents[i * 4 + 3] = handedness;
-    }
+            // Gram-Schmidt orthogonalization, the accumulated tangents already lie in the normal plane up to rounding
+            tangent -= glm::dot(tangent, normal) * normal;
+            const float length = glm::length(tangent);
+            tangent = length > 1e-12f ? tangent / length : GetPerpendicular(normal);
+
+            // Handedness, the shaders rebuild the bitangent as cross(normal, tangent) * w
+            tangents[i * 4 + 0] = tangent.x;
+            tangents[i * 4 + 1] = tangent.y;
+            tangents[i * 4 + 2] = tangent.z;
+            tangents[i * 4 + 3] = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+        }
+    });
 
     return tangents;
 }
 
+void Utils::Geom::BenchmarkTangents(unsigned int triangleCount)
+{
+    std::vector<float> vertices, normals, textureCoords;
+    std::vector<unsigned int> indices;
+    BuildBenchmarkGrid(triangleCount, vertices, normals, textureCoords, indices);
+
+    const double triangles = indices.size() / 3.0;
+    std::printf("Tangents: %.0f triangles, %zu vertices\n", triangles, vertices.size() / 3);
+
+    BenchmarkThreadCounts(GetBenchmarkThreadCounts(), [&](unsigned int threads)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto tangents = GenerateTangents(vertices, normals, textureCoords, indices, threads);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    },
+    [&](unsigned int threads, double time, double speedup)
+    {
+        std::printf("    %2u thr.  %8.1f ms %8.1f Mtri/s  (%.2fx)\n", threads, time, triangles / (time * 1000.0), speedup);
+    });
+}
+
+void Utils::Geom::BenchmarkNormals(unsigned int minTriangleCount, unsigned int maxTriangleCount)
+{
+    std::vector<float> vertices, normals, textureCoords;
+    std::vector<unsigned int> indices;
+    const std::vector<unsigned int> threadCounts = GetBenchmarkThreadCounts();
+    for (unsigned int triangleCount = minTriangleCount; triangleCount <= maxTriangleCount; triangleCount *= 10)
+    {
+        BuildBenchmarkGrid(triangleCount, vertices, normals, textureCoords, indices);
+        const double triangles = indices.size() / 3.0;
+        std::printf("Normals: %.0f triangles, %zu vertices\n", triangles, vertices.size() / 3);
+
+        BenchmarkThreadCounts(threadCounts, [&](unsigned int threads)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto generated = GenerateNormals(vertices, indices, {&textureCoords}, NormalWeighting::Angle, 180.0f, threads);
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        },
+        [&](unsigned int threads, double time, double speedup)
+        {
+            std::printf("    %2u thr.  %8.1f ms %8.1f Mtri/s  (%.2fx)\n", threads, time, triangles / (time * 1000.0), speedup);
+        });
+
+        if (triangleCount > maxTriangleCount / 10)
+            break;
+    }
+}
+
 std::unique_ptr<unsigned char, void(*)(unsigned char*)> Utils::Texture::GetTextureData(const std::string& filePath, int& width, int& height, bool flip)
 {
     int channels; // Actual number of channels. 1 = Grayscale, 2 = Grayscale + Alpha, 3 = RGB, 4 = RGBA
@@ -218,6 +1108,7 @@ std::unique_ptr<float, void(*)(float*)> Utils::Texture::GetHDRTextureData(const
 {
     int channels;
     const int desiredChannels = 3; // 3 = RGB, 4 = RGBE (E = Exponent)
+    stbi_set_flip_vertically_on_load(flip);
 
     std::unique_ptr<float, void(*)(float*)> image
     (
@@ -232,4 +1123,184 @@ std::unique_ptr<float, void(*)(float*)> Utils::Texture::GetHDRTextureData(const
     );
 
     return image;
-}
\ No newline at end of file
+}
+
+unsigned int Utils::Texture::GetMipLevelCount(int width, int height)
+{
+    unsigned int count = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+        ++count;
+    return count;
+}
+
+Utils::Texture::MipChain Utils::Texture::GenerateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter, unsigned int threadCount)
+{
+    MipChain chain;
+    if (pixels == nullptr || width <= 0 || height <= 0)
+        return chain;
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // Levels are laid out first to last, so the pixels are allocated once
+    size_t size = 0;
+    for (int levelWidth = width, levelHeight = height; levelWidth > 1 || levelHeight > 1;)
+    {
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+        chain.mLevels.push_back({levelWidth, levelHeight, size});
+        size += static_cast<size_t>(levelWidth) * levelHeight * 4;
+    }
+    chain.mPixels.resize(size);
+
+    // Each level is filtered from the previous one, its rows split over the threads
+    const unsigned char* source = pixels;
+    int sourceWidth = width, sourceHeight = height;
+    for (const auto& level : chain.mLevels)
+    {
+        unsigned char* target = chain.mPixels.data() + level.mOffset;
+        const size_t taskCount = (level.mHeight + kMipRowsPerTask - 1) / kMipRowsPerTask;
+        Dazzle::ParallelFor(taskCount, threadCount, [&](size_t task)
+        {
+            const int firstRow = static_cast<int>(task) * kMipRowsPerTask;
+            DownsampleRows(source, sourceWidth, sourceHeight, target, level.mWidth, firstRow, std::min(firstRow + kMipRowsPerTask, level.mHeight), filter);
+        });
+
+        source = target;
+        sourceWidth = level.mWidth;
+        sourceHeight = level.mHeight;
+    }
+
+    return chain;
+}
+
+void Utils::Texture::ApplySamplerPreset(GLuint texture, SamplerPreset preset)
+{
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, preset == SamplerPreset::Bilinear ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+
+    // The limit is queried once, it doesn't change for the lifetime of the context
+    static GLfloat maxAnisotropy = 0.0f;
+    if (preset == SamplerPreset::Anisotropic && maxAnisotropy == 0.0f)
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+
+    glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY, preset == SamplerPreset::Anisotropic ? std::max(1.0f, maxAnisotropy) : 1.0f);
+}
+
+GLuint Utils::Texture::CreateTexture(const std::string& filePath, bool flip, MipFilter filter, SamplerPreset sampler)
+{
+    int width, height;
+    auto imageData = GetTextureData(filePath, width, height, flip);
+    if (!imageData)
+    {
+        std::cerr << "Error: Unable to load " << filePath << std::endl;
+        return 0;
+    }
+
+    const MipChain chain = GenerateMipChain(imageData.get(), width, height, filter);
+
+    GLuint texture = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, GetMipLevelCount(width, height), GL_RGBA8, width, height);
+    glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData.get());
+    for (size_t level = 0; level < chain.mLevels.size(); ++level)
+    {
+        const auto& mip = chain.mLevels[level];
+        glTextureSubImage2D(texture, static_cast<GLint>(level + 1), 0, 0, mip.mWidth, mip.mHeight, GL_RGBA, GL_UNSIGNED_BYTE, chain.mPixels.data() + mip.mOffset);
+    }
+
+    ApplySamplerPreset(texture, sampler);
+    return texture;
+}
+
+GLenum Utils::Texture::GetInternalFormat(HDRFormat format)
+{
+    switch (format)
+    {
+    case HDRFormat::R11F_G11F_B10F:
+        return GL_R11F_G11F_B10F;
+    case HDRFormat::RGB9_E5:
+        return GL_RGB9_E5;
+    default:
+        return GL_RGB32F;
+    }
+}
+
+unsigned int Utils::Texture::GetTexelSize(HDRFormat format)
+{
+    return format == HDRFormat::RGB32F ? 3 * sizeof(float) : sizeof(std::uint32_t);
+}
+
+std::vector<std::uint32_t> Utils::Texture::PackHDRTexels(const float* rgb, size_t texelCount, HDRFormat format, unsigned int threadCount)
+{
+    if (rgb == nullptr || format == HDRFormat::RGB32F)
+        return std::vector<std::uint32_t>();
+
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::uint32_t> packed(texelCount);
+    const size_t taskCount = (texelCount + kHDRTexelsPerTask - 1) / kHDRTexelsPerTask;
+    Dazzle::ParallelFor(taskCount, threadCount, [&](size_t task)
+    {
+        const size_t first = task * kHDRTexelsPerTask;
+        PackTexels(rgb + first * 3, packed.data() + first, std::min(kHDRTexelsPerTask, texelCount - first), format);
+    });
+
+    return packed;
+}
+
+GLuint Utils::Texture::CreateHDRTexture(const std::vector<std::string>& faces, bool flip, HDRFormat format, size_t* memory)
+{
+    if (faces.size() != 1 && faces.size() != 6)
+    {
+        std::cerr << "Error: An HDR texture needs one image, or six for a cube map" << std::endl;
+        return 0;
+    }
+
+    GLuint texture = 0;
+    int baseWidth = 0, baseHeight = 0;
+    for (size_t face = 0; face < faces.size(); ++face)
+    {
+        int width, height;
+        auto imageData = GetHDRTextureData(faces[face], width, height, flip);
+        if (!imageData || (texture > 0 && (width != baseWidth || height != baseHeight)))
+        {
+            std::cerr << "Error: Unable to load " << faces[face] << std::endl;
+            if (texture > 0)
+                glDeleteTextures(1, &texture);
+            return 0;
+        }
+
+        if (texture == 0)
+        {
+            baseWidth = width;
+            baseHeight = height;
+            glCreateTextures(faces.size() == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, 1, &texture);
+            glTextureStorage2D(texture, 1, GetInternalFormat(format), width, height);
+        }
+
+        // Packed on the CPU, the driver gets 4 bytes a texel to copy instead of 12 to convert
+        const void* pixels = imageData.get();
+        GLenum pixelFormat = GL_RGB, pixelType = GL_FLOAT;
+        std::vector<std::uint32_t> packed;
+        if (format != HDRFormat::RGB32F)
+        {
+            packed = PackHDRTexels(imageData.get(), static_cast<size_t>(width) * height, format);
+            pixels = packed.data();
+            pixelType = format == HDRFormat::RGB9_E5 ? GL_UNSIGNED_INT_5_9_9_9_REV : GL_UNSIGNED_INT_10F_11F_11F_REV;
+        }
+
+        if (faces.size() == 6)
+            glTextureSubImage3D(texture, 0, 0, 0, static_cast<GLint>(face), width, height, 1, pixelFormat, pixelType, pixels);
+        else
+            glTextureSubImage2D(texture, 0, 0, 0, width, height, pixelFormat, pixelType, pixels);
+    }
+
+    if (memory != nullptr)
+        *memory = static_cast<size_t>(baseWidth) * baseHeight * faces.size() * GetTexelSize(format);
+
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    return texture;
+}
@@ -1,28 +1,146 @@
 #ifndef _UTILITIES_HPP_
 #define _UTILITIES_HPP_
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <GL/gl3w.h>
+
 namespace Utils
 {
     namespace Geom
     {
+        // Part of an OBJ shape drawn with a single material. Face corners sharing the same position, normal and texture
+        // coordinates are welded into one vertex, so the geometry is indexed.
+        struct ObjShape
+        {
+            std::string mName;
+            std::vector<float> mVertices;
+            std::vector<float> mNormals;                // Empty when the file has no normals
+            std::vector<float> mTextureCoordinates;     // Empty when the file has no texture coordinates
+            std::vector<unsigned int> mIndices;
+            int mMaterial = -1;                         // Index into the materials, -1 without material
+        };
+
+        struct ObjMaterial
+        {
+            std::string mName;
+            std::array<float, 3> mAmbient;
+            std::array<float, 3> mDiffuse;
+            std::array<float, 3> mSpecular;
+            float mShininess;
+            std::string mDiffuseTexture;                // Image file path, relative to the OBJ file
+            std::string mNormalTexture;                 // Image file path, relative to the OBJ file
+        };
+
+        // Loads every shape of the file, split by material, and the materials of its MTL libraries. Both are appended to
+        // shapes and materials, the material ids of the new shapes index the whole materials vector.
+        bool LoadObj(const std::string& filePath, std::vector<ObjShape>& shapes, std::vector<ObjMaterial>& materials);
+        // Times LoadObj()'s reader against tinyobj's on 1 thread up to one per core and prints the throughput.
+        void BenchmarkObj(const std::string& filePath);
+        // Concatenates shapes into a single indexed shape, for meshes drawn with one material.
+        ObjShape MergeObjShapes(const std::vector<ObjShape>& shapes);
+
         void GetMeshDataFromObj(std::string filePath,
                                 std::string& name,
                                 std::vector<float>& vertices,
                                 std::vector<float>& normals,
                                 std::vector<float>& texCoords);
-        std::vector<float> GenerateNormals();
+
+        enum class NormalWeighting
+        {
+            Angle,      // Faces weigh by their angle at the vertex, independent of the tessellation
+            Area        // Faces weigh by their area
+        };
+
+        // Smooth per vertex normals of an indexed triangle list. Faces are accumulated per position, so vertices split on
+        // texture seams stay smooth. Faces meeting at more than creaseAngle degrees don't smooth each other, the vertices
+        // on such creases are copied: vertices and the attributes (any component count) grow and indices are rewritten.
+        // 180 never splits, 0 gives flat normals. threadCount 0 runs one thread per core.
+        std::vector<float> GenerateNormals(std::vector<float>& vertices,
+                                           std::vector<unsigned int>& indices,
+                                           const std::vector<std::vector<float>*>& attributes = {},
+                                           NormalWeighting weighting = NormalWeighting::Angle,
+                                           float creaseAngle = 180.0f,
+                                           unsigned int threadCount = 0);
+        // Times GenerateNormals() on indexed grids of minTriangleCount up to maxTriangleCount triangles, by powers of
+        // ten, on 1 thread up to one per core.
+        void BenchmarkNormals(unsigned int minTriangleCount = 10000, unsigned int maxTriangleCount = 10000000);
+        // Per vertex tangents, xyz and the bitangent sign in w, accumulated through the indices with MikkTSpace's angle
+        // weights. Empty indices read the vertices as a triangle soup, threadCount 0 runs one thread per core.
         std::vector<float> GenerateTangents(const std::vector<float>& vertices,
                                             const std::vector<float>& normals,
-                                            const std::vector<float>& textureCoords);
+                                            const std::vector<float>& textureCoords,
+                                            const std::vector<unsigned int>& indices = {},
+                                            unsigned int threadCount = 0);
+        // Times GenerateTangents() on an indexed grid of about triangleCount triangles, 1 thread up to one per core.
+        void BenchmarkTangents(unsigned int triangleCount = 1u << 20);
     }
 
     namespace Texture
     {
+        enum class MipFilter
+        {
+            Color,      // sRGB encoded colors, averaged in linear space. Alpha is averaged as is
+            Data,       // Averaged as is: masks, occlusion, roughness, metalness
+            Normal      // Tangent space normals, averaged as vectors and renormalized
+        };
+
+        enum class SamplerPreset
+        {
+            Bilinear,       // Nearest level
+            Trilinear,      // Blend of the two nearest levels
+            Anisotropic     // Trilinear, with the highest anisotropy the driver supports
+        };
+
+        // Storage of HDR textures and render targets. The packed formats take 4 bytes a texel instead of 12, only
+        // R11F_G11F_B10F can be rendered to. RGB9_E5 keeps 9 bit mantissas with a shared exponent, so it's the more
+        // precise one for loaded images.
+        enum class HDRFormat
+        {
+            RGB32F,
+            R11F_G11F_B10F,
+            RGB9_E5
+        };
+
+        // Levels 1 and below of an RGBA8 image, packed one after the other.
+        struct MipChain
+        {
+            struct Level
+            {
+                int mWidth;
+                int mHeight;
+                size_t mOffset;     // Into mPixels
+            };
+
+            std::vector<unsigned char> mPixels;
+            std::vector<Level> mLevels;
+        };
+
         std::unique_ptr<unsigned char, void(*)(unsigned char*)> GetTextureData(const std::string& filePath, int& width, int& height, bool flip);
         std::unique_ptr<float, void(*)(float*)> GetHDRTextureData(const std::string& filePath, int& width, int& height, bool flip);
+
+        // Levels of a full chain, down to 1x1.
+        unsigned int GetMipLevelCount(int width, int height);
+        // Box filtered chain of an RGBA8 image, each level from the previous one. threadCount 0 runs one thread per core.
+        MipChain GenerateMipChain(const unsigned char* pixels, int width, int height, MipFilter filter, unsigned int threadCount = 0);
+        void ApplySamplerPreset(GLuint texture, SamplerPreset preset);
+        // Loads the image into an RGBA8 texture with its full mip chain, 0 if it can't be loaded.
+        GLuint CreateTexture(const std::string& filePath, bool flip, MipFilter filter = MipFilter::Color,
+                             SamplerPreset sampler = SamplerPreset::Anisotropic);
+
+        GLenum GetInternalFormat(HDRFormat format);
+        unsigned int GetTexelSize(HDRFormat format);
+        // RGB float texels packed into 32 bits each, in R11F_G11F_B10F or RGB9_E5. Negative and NaN values become 0,
+        // values past the range of the format are clamped. threadCount 0 runs one thread per core.
+        std::vector<std::uint32_t> PackHDRTexels(const float* rgb, size_t texelCount, HDRFormat format, unsigned int threadCount = 0);
+        // Loads one HDR image into a 2D texture, or six into a cube map (+X, -X, +Y, -Y, +Z, -Z), of a single level.
+        // memory receives the bytes of the storage when given. 0 if an image can't be loaded.
+        GLuint CreateHDRTexture(const std::vector<std::string>& faces, bool flip, HDRFormat format = HDRFormat::RGB9_E5,
+                                size_t* memory = nullptr);
     }
 }
 
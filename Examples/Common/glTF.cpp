@@ -1,12 +1,242 @@
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
+#include <glm/gtc/type_ptr.hpp>
+
 #define CGLTF_IMPLEMENTATION
 #include "glTF.hpp"
+#include "FileManager.hpp"
+#include "MeshoptDecoder.hpp"
+#include "ParallelFor.hpp"
+#include "Utils.hpp"
+
+namespace
+{
+    // Start of the first element of accessor within its buffer, nullptr when the data isn't directly addressable
+    // (sparse accessors, accessors without buffer view or with unloaded buffers).
+    const uint8_t* GetAccessorData(const cgltf_accessor* accessor)
+    {
+        if (accessor->is_sparse || accessor->buffer_view == nullptr)
+            return nullptr;
+
+        // Views decoded by an extension (e.g. meshopt compression) carry their own data
+        const cgltf_buffer_view* view = accessor->buffer_view;
+        if (view->data != nullptr)
+            return static_cast<const uint8_t*>(view->data) + accessor->offset;
+        if (view->buffer->data == nullptr)
+            return nullptr;
+
+        return static_cast<const uint8_t*>(view->buffer->data) + view->offset + accessor->offset;
+    }
+
+    // Images embedded in a buffer view (always the case in .glb files) have no uri
+    std::string GetImageURI(const cgltf_texture_view& view)
+    {
+        if (view.texture == nullptr || view.texture->image == nullptr || view.texture->image->uri == nullptr)
+            return "";
+
+        return view.texture->image->uri;
+    }
+
+    bool DecompressBufferView(cgltf_buffer_view* view)
+    {
+        const cgltf_meshopt_compression& compression = view->meshopt_compression;
+        if (compression.buffer == nullptr || compression.buffer->data == nullptr)
+            return false;
+
+        // cgltf_free() releases view->data with the default allocator
+        void* destination = std::malloc(compression.count * compression.stride);
+        if (destination == nullptr)
+            return false;
+
+        const unsigned char* source = static_cast<const unsigned char*>(compression.buffer->data) + compression.offset;
+        bool decoded = false;
+        switch (compression.mode)
+        {
+            case cgltf_meshopt_compression_mode_attributes:
+                decoded = Meshopt::DecodeVertexBuffer(destination, compression.count, compression.stride, source, compression.size);
+                break;
+            case cgltf_meshopt_compression_mode_triangles:
+                decoded = Meshopt::DecodeIndexBuffer(destination, compression.count, compression.stride, source, compression.size);
+                break;
+            case cgltf_meshopt_compression_mode_indices:
+                decoded = Meshopt::DecodeIndexSequence(destination, compression.count, compression.stride, source, compression.size);
+                break;
+            default:
+                break;
+        }
+
+        if (!decoded)
+        {
+            std::free(destination);
+            return false;
+        }
+
+        switch (compression.filter)
+        {
+            case cgltf_meshopt_compression_filter_octahedral:
+                Meshopt::DecodeOctahedralFilter(destination, compression.count, compression.stride);
+                break;
+            case cgltf_meshopt_compression_filter_quaternion:
+                Meshopt::DecodeQuaternionFilter(destination, compression.count, compression.stride);
+                break;
+            case cgltf_meshopt_compression_filter_exponential:
+                Meshopt::DecodeExponentialFilter(destination, compression.count, compression.stride);
+                break;
+            default:
+                break;
+        }
+
+        view->data = destination;
+        return true;
+    }
+
+    // Decodes the EXT_meshopt_compression buffer views into view->data, where every accessor read looks first.
+    // Views are independent, so they are spread over a thread per core.
+    bool DecompressBufferViews(cgltf_data* data)
+    {
+        std::vector<cgltf_buffer_view*> views;
+        for (cgltf_size i = 0; i < data->buffer_views_count; ++i)
+            if (data->buffer_views[i].has_meshopt_compression && data->buffer_views[i].data == nullptr)
+                views.push_back(&data->buffer_views[i]);
+
+        if (views.empty())
+            return true;
+
+        std::atomic<bool> succeeded(true);
+        Dazzle::ParallelFor(views.size(), 0, [&](size_t i)
+        {
+            if (!DecompressBufferView(views[i]))
+                succeeded = false;
+        });
+
+        if (!succeeded)
+            std::printf("Failed to decode EXT_meshopt_compression buffer views\n");
+        return succeeded;
+    }
+
+    GLenum GetComponentType(cgltf_component_type type)
+    {
+        switch (type)
+        {
+            case cgltf_component_type_r_8:      return GL_BYTE;
+            case cgltf_component_type_r_8u:     return GL_UNSIGNED_BYTE;
+            case cgltf_component_type_r_16:     return GL_SHORT;
+            case cgltf_component_type_r_16u:    return GL_UNSIGNED_SHORT;
+            case cgltf_component_type_r_32u:    return GL_UNSIGNED_INT;
+            case cgltf_component_type_r_32f:    return GL_FLOAT;
+            default:                            return GL_NONE;
+        }
+    }
+
+    GLenum GetPrimitiveMode(cgltf_primitive_type type)
+    {
+        switch (type)
+        {
+            case cgltf_primitive_type_points:           return GL_POINTS;
+            case cgltf_primitive_type_lines:            return GL_LINES;
+            case cgltf_primitive_type_line_loop:        return GL_LINE_LOOP;
+            case cgltf_primitive_type_line_strip:       return GL_LINE_STRIP;
+            case cgltf_primitive_type_triangle_strip:   return GL_TRIANGLE_STRIP;
+            case cgltf_primitive_type_triangle_fan:     return GL_TRIANGLE_FAN;
+            case cgltf_primitive_type_triangles:
+            default:                                    return GL_TRIANGLES;
+        }
+    }
+
+    // Unpacks accessor into data, componentCount floats per element. Float data is copied straight from the buffer,
+    // in a single memcpy when tightly packed, anything else (normalized integers, sparse accessors) goes through
+    // cgltf_accessor_unpack_floats().
+    void UnpackFloats(const cgltf_accessor* accessor, cgltf_size componentCount, std::vector<float>& data)
+    {
+        const cgltf_size count = accessor->count;
+        data.resize(count * componentCount);
+
+        const uint8_t* source = GetAccessorData(accessor);
+        const cgltf_size elementSize = componentCount * sizeof(float);
+        if (source != nullptr && accessor->component_type == cgltf_component_type_r_32f)
+        {
+            if (accessor->stride == elementSize)
+            {
+                std::memcpy(data.data(), source, count * elementSize);
+            }
+            else
+            {
+                for (cgltf_size i = 0; i < count; ++i)
+                    std::memcpy(&data[i * componentCount], source + i * accessor->stride, elementSize);
+            }
+            return;
+        }
+
+        cgltf_accessor_unpack_floats(accessor, data.data(), data.size());
+    }
+
+    template <typename T>
+    void CopyIndices(const uint8_t* source, cgltf_size stride, cgltf_size count, std::vector<uint32_t>& indices)
+    {
+        for (cgltf_size i = 0; i < count; ++i)
+        {
+            T index;
+            std::memcpy(&index, source + i * stride, sizeof(T));
+            indices[i] = static_cast<uint32_t>(index);
+        }
+    }
+
+    // Widens the indices of accessor to 32 bits, 32 bit indices are copied in a single memcpy when tightly packed.
+    void UnpackIndices(const cgltf_accessor* accessor, std::vector<uint32_t>& indices)
+    {
+        const cgltf_size count = accessor->count;
+        indices.resize(count);
+
+        const uint8_t* source = GetAccessorData(accessor);
+        if (source == nullptr)
+        {
+            for (cgltf_size i = 0; i < count; ++i)
+                indices[i] = static_cast<uint32_t>(cgltf_accessor_read_index(accessor, i));
+            return;
+        }
+
+        switch (accessor->component_type)
+        {
+            case cgltf_component_type_r_32u:
+                if (accessor->stride == sizeof(uint32_t))
+                    std::memcpy(indices.data(), source, count * sizeof(uint32_t));
+                else
+                    CopyIndices<uint32_t>(source, accessor->stride, count, indices);
+                break;
+            case cgltf_component_type_r_16u:
+                CopyIndices<uint16_t>(source, accessor->stride, count, indices);
+                break;
+            case cgltf_component_type_r_8u:
+                CopyIndices<uint8_t>(source, accessor->stride, count, indices);
+                break;
+            default:
+                indices.clear();
+                std::printf("Invalid index component type: %d\n", accessor->component_type);
+                break;
+        }
+    }
+}
+
+glTF::~glTF()
+{
+    for (const auto& mesh : mDeviceMeshes)
+        for (const auto& primitive : mesh.mPrimitives)
+            glDeleteVertexArrays(1, &primitive.mVertexArray);
+
+    for (const auto& buffer : mBuffers)
+        glDeleteBuffers(1, &buffer.second);
+}
 
 void glTF::LoadGLTF(const char* path)
 {
+    auto start = std::chrono::steady_clock::now();
+
     // Load and parse file
     cgltf_options options{};
     cgltf_data* data = NULL;
@@ -17,15 +247,247 @@ void glTF::LoadGLTF(const char* path)
         return;
     }
 
-    if (cgltf_load_buffers(&options, data, path) != cgltf_result_success)
+    if (cgltf_load_buffers(&options, data, path) != cgltf_result_success || !DecompressBufferViews(data))
     {
         std::printf("Failed to load glTF buffers\n");
         cgltf_free(data);
         return;
     }
 
+    auto loaded = std::chrono::steady_clock::now();
     ProcessData(data);
     cgltf_free(data);
+
+    auto unpacked = std::chrono::steady_clock::now();
+    OptimizeMeshes();
+
+    auto optimized = std::chrono::steady_clock::now();
+    mLoadTime = std::chrono::duration<double, std::milli>(loaded - start).count();
+    mUnpackTime = std::chrono::duration<double, std::milli>(unpacked - loaded).count();
+    mOptimizeTime = std::chrono::duration<double, std::milli>(optimized - unpacked).count();
+
+    size_t vertexCount = 0;
+    for (const auto& mesh : mMeshes)
+        for (const auto& primitive : mesh.mPrimitives)
+            vertexCount += primitive.mVertices.size() / 3;
+
+    std::printf("Loaded %s in %.2f ms: %.2f ms parsing, %.2f ms unpacking %zu vertices, %.2f ms optimizing, %zu nodes\n",
+                path, mLoadTime + mUnpackTime + mOptimizeTime, mLoadTime, mUnpackTime, vertexCount, mOptimizeTime, mNodes.size());
+    std::printf("Vertex cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", mOptimizationReport.mBefore.mACMR, mOptimizationReport.mAfter.mACMR,
+                mOptimizationReport.mBefore.mATVR, mOptimizationReport.mAfter.mATVR);
+}
+
+void glTF::OptimizeMeshes()
+{
+    std::vector<Primitive*> primitives;
+    for (auto& mesh : mMeshes)
+        for (auto& primitive : mesh.mPrimitives)
+            if (primitive.mType == Primitive::Type::TRIANGLES && !primitive.mIndices.empty() && !primitive.mVertices.empty())
+                primitives.push_back(&primitive);
+
+    // Primitives are independent, so they are spread over a thread per core like the buffer views
+    std::vector<Dazzle::MeshOptimizationReport> reports(primitives.size());
+    Dazzle::ParallelFor(primitives.size(), 0, [&](size_t i)
+    {
+        Primitive& primitive = *primitives[i];
+        // The specification asks for flat normals when a primitive has none
+        if (primitive.mNormals.empty())
+            primitive.mNormals = Utils::Geom::GenerateNormals(primitive.mVertices, primitive.mIndices, {&primitive.mTextureCoordinates},
+                                                              Utils::Geom::NormalWeighting::Angle, 0.0f, 1);
+        reports[i] = Dazzle::MeshOptimizer::Optimize(primitive.mIndices, primitive.mVertices, {&primitive.mNormals, &primitive.mTextureCoordinates});
+        primitive.mLODs = Dazzle::MeshOptimizer::GenerateLODs(primitive.mIndices, primitive.mVertices);
+    });
+
+    // Totals weigh ACMR by triangles and ATVR by vertices, as if every primitive was a single index list
+    double triangles = 0.0, vertices = 0.0;
+    double acmrBefore = 0.0, acmrAfter = 0.0, atvrBefore = 0.0, atvrAfter = 0.0;
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+        const double primitiveTriangles = primitives[i]->mIndices.size() / 3.0;
+        const double primitiveVertices = primitives[i]->mVertices.size() / 3.0;
+        acmrBefore += reports[i].mBefore.mACMR * primitiveTriangles;
+        acmrAfter += reports[i].mAfter.mACMR * primitiveTriangles;
+        atvrBefore += reports[i].mBefore.mATVR * primitiveVertices;
+        atvrAfter += reports[i].mAfter.mATVR * primitiveVertices;
+        triangles += primitiveTriangles;
+        vertices += primitiveVertices;
+    }
+
+    mOptimizationReport = Dazzle::MeshOptimizationReport();
+    if (triangles > 0.0)
+    {
+        mOptimizationReport.mBefore.mACMR = static_cast<float>(acmrBefore / triangles);
+        mOptimizationReport.mAfter.mACMR = static_cast<float>(acmrAfter / triangles);
+        mOptimizationReport.mBefore.mATVR = static_cast<float>(atvrBefore / vertices);
+        mOptimizationReport.mAfter.mATVR = static_cast<float>(atvrAfter / vertices);
+    }
+}
+
+bool glTF::LoadGLB(const char* path)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // The mapping only has to outlive the uploads, buffers are copied by the driver
+    Dazzle::MappedFile file;
+    if (!file.Open(path))
+        return false;
+
+    // The binary chunk of a .glb is referenced in place, cgltf_load_buffers() only reads external buffers
+    cgltf_options options{};
+    cgltf_data* data = NULL;
+    if (cgltf_parse(&options, file.GetData(), file.GetSize(), &data) != cgltf_result_success)
+    {
+        std::printf("Failed to parse glTF file\n");
+        return false;
+    }
+
+    if (cgltf_load_buffers(&options, data, path) != cgltf_result_success || !DecompressBufferViews(data))
+    {
+        std::printf("Failed to load glTF buffers\n");
+        cgltf_free(data);
+        return false;
+    }
+
+    auto loaded = std::chrono::steady_clock::now();
+    UploadMeshes(data);
+    ProcessNodes(data);
+    cgltf_free(data);
+
+    auto uploaded = std::chrono::steady_clock::now();
+    mLoadTime = std::chrono::duration<double, std::milli>(loaded - start).count();
+    mUnpackTime = std::chrono::duration<double, std::milli>(uploaded - loaded).count();
+
+    size_t bufferSize = 0;
+    for (const auto& buffer : mBuffers)
+    {
+        GLint64 size = 0;
+        glGetNamedBufferParameteri64v(buffer.second, GL_BUFFER_SIZE, &size);
+        bufferSize += static_cast<size_t>(size);
+    }
+
+    std::printf("Loaded %s in %.2f ms: %.2f ms parsing, %.2f ms uploading %zu buffer views (%zu bytes, %zu of vertex attributes)\n",
+                path, mLoadTime + mUnpackTime, mLoadTime, mUnpackTime, mBuffers.size(), bufferSize, mVertexBufferSize);
+    return true;
+}
+
+void glTF::Draw(const DevicePrimitive& primitive)
+{
+    glBindVertexArray(primitive.mVertexArray);
+    if (primitive.mIndexType == GL_NONE)
+        glDrawArrays(primitive.mMode, 0, primitive.mCount);
+    else
+        glDrawElements(primitive.mMode, primitive.mCount, primitive.mIndexType, reinterpret_cast<const void*>(primitive.mIndexOffset));
+}
+
+void glTF::UploadMeshes(const cgltf_data* data)
+{
+    for (cgltf_size i = 0; i < data->meshes_count; ++i)
+    {
+        DeviceMesh m;
+        const cgltf_mesh* mesh = &data->meshes[i];
+        m.mName = mesh->name ? mesh->name : "Unnamed Mesh";
+
+        for (cgltf_size j = 0; j < mesh->primitives_count; ++j)
+            m.mPrimitives.push_back(UploadPrimitive(data, &mesh->primitives[j]));
+
+        mDeviceMeshes.push_back(std::move(m));
+    }
+}
+
+glTF::DevicePrimitive glTF::UploadPrimitive(const cgltf_data* data, const cgltf_primitive* primitive)
+{
+    DevicePrimitive p;
+    p.mMode = GetPrimitiveMode(primitive->type);
+    glCreateVertexArrays(1, &p.mVertexArray);
+
+    // Every attribute gets its own buffer binding, named after its location, since each one may live in a
+    // different buffer view. The accessor offset becomes the offset of the binding.
+    for (cgltf_size i = 0; i < primitive->attributes_count; ++i)
+    {
+        const cgltf_attribute* attr = &primitive->attributes[i];
+
+        GLuint location = 0;
+        if (attr->type == cgltf_attribute_type_position)
+            location = kPositionLocation;
+        else if (attr->type == cgltf_attribute_type_normal)
+            location = kNormalLocation;
+        else if (attr->type == cgltf_attribute_type_texcoord && attr->index == 0)
+            location = kTextureCoordinatesLocation;
+        else if (attr->type == cgltf_attribute_type_tangent)
+            location = kTangentLocation;
+        else
+            continue;
+
+        const cgltf_accessor* accessor = attr->data;
+        GLuint buffer = GetBuffer(data, accessor->buffer_view);
+        GLenum type = GetComponentType(accessor->component_type);
+        if (accessor->is_sparse || buffer == 0 || type == GL_NONE)
+        {
+            std::printf("Skipping attribute %s, its accessor can't be read in place\n", attr->name ? attr->name : "");
+            continue;
+        }
+
+        // Buffer views shared by several attributes or primitives are only counted once
+        if (mVertexBuffers.insert(buffer).second)
+            mVertexBufferSize += static_cast<size_t>(accessor->buffer_view->size);
+
+        // Integer attributes are converted to float, normalized or not, which is what KHR_mesh_quantization expects
+        glVertexArrayVertexBuffer(p.mVertexArray, location, buffer, accessor->offset, static_cast<GLsizei>(accessor->stride));
+        glVertexArrayAttribFormat(p.mVertexArray, location, static_cast<GLint>(cgltf_num_components(accessor->type)),
+                                  type, accessor->normalized ? GL_TRUE : GL_FALSE, 0);
+        glVertexArrayAttribBinding(p.mVertexArray, location, location);
+        glEnableVertexArrayAttrib(p.mVertexArray, location);
+
+        if (attr->type == cgltf_attribute_type_position && primitive->indices == nullptr)
+            p.mCount = static_cast<GLsizei>(accessor->count);
+    }
+
+    if (primitive->indices)
+    {
+        const cgltf_accessor* accessor = primitive->indices;
+        GLuint buffer = GetBuffer(data, accessor->buffer_view);
+        if (accessor->is_sparse || buffer == 0)
+        {
+            std::printf("Skipping primitive, its indices can't be read in place\n");
+        }
+        else
+        {
+            glVertexArrayElementBuffer(p.mVertexArray, buffer);
+            p.mIndexType = GetComponentType(accessor->component_type);
+            p.mIndexOffset = static_cast<GLintptr>(accessor->offset);
+            p.mCount = static_cast<GLsizei>(accessor->count);
+        }
+    }
+
+    Primitive material;
+    material.FillMaterial(primitive);
+    p.mMaterial = std::move(material.mMaterial);
+
+    return p;
+}
+
+GLuint glTF::GetBuffer(const cgltf_data* data, const cgltf_buffer_view* view)
+{
+    if (view == nullptr)
+        return 0;
+
+    // Buffer views shared by several accessors are uploaded once
+    const cgltf_size index = static_cast<cgltf_size>(view - data->buffer_views);
+    auto it = mBuffers.find(index);
+    if (it != mBuffers.end())
+        return it->second;
+
+    const void* source = view->data;
+    if (source == nullptr && view->buffer->data != nullptr)
+        source = static_cast<const uint8_t*>(view->buffer->data) + view->offset;
+    if (source == nullptr)
+        return 0;
+
+    GLuint buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(view->size), source, 0);
+    mBuffers[index] = buffer;
+    return buffer;
 }
 
 void glTF::ProcessData(const cgltf_data* data)
@@ -55,6 +517,7 @@ void glTF::ProcessData(const cgltf_data* data)
     // Extensions Required
 
     ProcessMeshes(data);
+    ProcessNodes(data);
 }
 
 void glTF::ProcessNodes(const cgltf_data* data)
@@ -62,7 +525,57 @@ void glTF::ProcessNodes(const cgltf_data* data)
     if (data == nullptr)
         return;
 
-    /// TODO:
+    mMeshInstances.assign(data->meshes_count, {});
+
+    // Files without nodes only describe meshes, draw each of them once where it is
+    if (data->nodes_count == 0)
+    {
+        for (auto& instances : mMeshInstances)
+            instances.push_back(glm::mat4(1.0f));
+        return;
+    }
+
+    // Depth first traversal with an explicit stack, deep hierarchies can't overflow the call stack. Each entry is a
+    // node and the index of its parent in mNodes, whose world transform is already known.
+    std::vector<std::pair<const cgltf_node*, int>> stack;
+    const cgltf_scene* scene = data->scene ? data->scene : (data->scenes_count > 0 ? &data->scenes[0] : nullptr);
+    if (scene != nullptr)
+    {
+        for (cgltf_size i = scene->nodes_count; i > 0; --i)
+            stack.emplace_back(scene->nodes[i - 1], -1);
+    }
+    else
+    {
+        for (cgltf_size i = data->nodes_count; i > 0; --i)
+            if (data->nodes[i - 1].parent == nullptr)
+                stack.emplace_back(&data->nodes[i - 1], -1);
+    }
+
+    mNodes.reserve(mNodes.size() + data->nodes_count);
+    while (!stack.empty())
+    {
+        auto [node, parent] = stack.back();
+        stack.pop_back();
+
+        Node n;
+        n.mName = node->name ? node->name : "";
+        n.mParent = parent;
+        n.mMesh = node->mesh ? static_cast<int>(node->mesh - data->meshes) : -1;
+
+        float local[16];
+        cgltf_node_transform_local(node, local);
+        n.mLocalTransform = glm::make_mat4(local);
+        n.mWorldTransform = parent < 0 ? n.mLocalTransform : mNodes[parent].mWorldTransform * n.mLocalTransform;
+
+        if (n.mMesh >= 0)
+            mMeshInstances[n.mMesh].push_back(n.mWorldTransform);
+
+        const int index = static_cast<int>(mNodes.size());
+        mNodes.push_back(std::move(n));
+
+        for (cgltf_size i = node->children_count; i > 0; --i)
+            stack.emplace_back(node->children[i - 1], index);
+    }
 }
 
 void glTF::ProcessMeshes(const cgltf_data* data)
@@ -76,7 +589,7 @@ void glTF::ProcessMeshes(const cgltf_data* data)
         const cgltf_mesh* mesh = &data->meshes[i];
         m.mName = mesh->name ? mesh->name : "Unnamed Mesh";
 
-        m.mPrimitives = std::move(ProcessPrimitives(mesh));
+        m.mPrimitives = ProcessPrimitives(mesh);
         mMeshes.push_back(std::move(m));
     }
 }
@@ -178,76 +691,20 @@ void glTF::Primitive::FillAttributes(const cgltf_primitive* primitive)
     }
 
     // Fill mVertices
-    if (position_accessor)
-    {
-        // Ensure the component type is float and type is vec3
-        if (position_accessor->component_type == cgltf_component_type_r_32f &&
-            position_accessor->type == cgltf_type_vec3)
-        {
-            cgltf_size count = position_accessor->count;
-            mVertices.reserve(count * 3);
-            for (cgltf_size i = 0; i < count; ++i)
-            {
-                std::vector<float> data(3);
-                cgltf_accessor_read_float(position_accessor, i, data.data(), 3);
-                mVertices.insert(mVertices.end(), data.begin(), data.end());
-            }
-        }
-    }
+    if (position_accessor && position_accessor->type == cgltf_type_vec3)
+        UnpackFloats(position_accessor, 3, mVertices);
 
     // Fill mNormals
-    if (normal_accessor)
-    {
-        // Ensure the component type is float and type is vec3
-        if (normal_accessor->component_type == cgltf_component_type_r_32f &&
-            normal_accessor->type == cgltf_type_vec3)
-        {
-            cgltf_size count = normal_accessor->count;
-            mNormals.reserve(count * 3);
-            for (cgltf_size i = 0; i < count; ++i)
-            {
-                std::vector<float> data(3);
-                cgltf_accessor_read_float(normal_accessor, i, data.data(), 3);
-                mNormals.insert(mNormals.end(), data.begin(), data.end());
-            }
-        }
-    }
+    if (normal_accessor && normal_accessor->type == cgltf_type_vec3)
+        UnpackFloats(normal_accessor, 3, mNormals);
 
     // Fill mTextureCoordinates
-    if (uv_accessor)
-    {
-        // Ensure the component type is float and type is vec2
-        if (uv_accessor->component_type == cgltf_component_type_r_32f &&
-            uv_accessor->type == cgltf_type_vec2)
-        {
-            cgltf_size count = uv_accessor->count;
-            mTextureCoordinates.reserve(count * 2);
-            for (cgltf_size i = 0; i < count; ++i)
-            {
-                std::vector<float> data(2);
-                cgltf_accessor_read_float(uv_accessor, i, data.data(), 2);
-                mTextureCoordinates.insert(mTextureCoordinates.end(), data.begin(), data.end());
-            }
-        }
-    }
+    if (uv_accessor && uv_accessor->type == cgltf_type_vec2)
+        UnpackFloats(uv_accessor, 2, mTextureCoordinates);
 
     // Fill mIndices
     if (primitive->indices)
-    {
-        const cgltf_accessor* indices_accessor = primitive->indices;
-        if (indices_accessor != nullptr &&
-            (indices_accessor->component_type == cgltf_component_type_r_32u ||
-            indices_accessor->component_type == cgltf_component_type_r_16u))
-        {
-            cgltf_size count = indices_accessor->count;
-            mIndices.reserve(count);
-            for (cgltf_size i = 0; i < count; ++i)
-            {
-                size_t index = cgltf_accessor_read_index(indices_accessor, i);
-                mIndices.push_back(static_cast<uint32_t>(index));
-            }
-        }
-    }
+        UnpackIndices(primitive->indices, mIndices);
 }
 
 void glTF::Primitive::FillMaterial(const cgltf_primitive* primitive)
@@ -278,10 +735,10 @@ void glTF::Primitive::FillMaterial(const cgltf_primitive* primitive)
         mMaterial.mPBRMetallicRoughness.mRoughnessFactor = pbr->roughness_factor;
 
         if (pbr->base_color_texture.texture)
-            mMaterial.mPBRMetallicRoughness.mBaseColorTexture = pbr->base_color_texture.texture->image->uri;
+            mMaterial.mPBRMetallicRoughness.mBaseColorTexture = GetImageURI(pbr->base_color_texture);
 
         if (pbr->metallic_roughness_texture.texture)
-            mMaterial.mPBRMetallicRoughness.mMetallicRoughnessTexture = pbr->metallic_roughness_texture.texture->image->uri;
+            mMaterial.mPBRMetallicRoughness.mMetallicRoughnessTexture = GetImageURI(pbr->metallic_roughness_texture);
     }
 
     if (mMaterial.mHasPBRSpecularGlossiness)
@@ -297,15 +754,15 @@ void glTF::Primitive::FillMaterial(const cgltf_primitive* primitive)
         mMaterial.mPBRSpecularGlossiness.mGlossinessFactor = pbrsg->glossiness_factor;
 
         if (pbrsg->diffuse_texture.texture)
-            mMaterial.mPBRSpecularGlossiness.mDiffuseTexture = pbrsg->diffuse_texture.texture->image->uri;
+            mMaterial.mPBRSpecularGlossiness.mDiffuseTexture = GetImageURI(pbrsg->diffuse_texture);
 
         if (pbrsg->specular_glossiness_texture.texture)
-            mMaterial.mPBRSpecularGlossiness.mSpecularGlossinessTexture = pbrsg->specular_glossiness_texture.texture->image->uri;
+            mMaterial.mPBRSpecularGlossiness.mSpecularGlossinessTexture = GetImageURI(pbrsg->specular_glossiness_texture);
     }
 
     if (mat->normal_texture.texture)
     {
-        mMaterial.mNormalTexture = mat->normal_texture.texture->image->uri;
+        mMaterial.mNormalTexture = GetImageURI(mat->normal_texture);
     }
 
 }
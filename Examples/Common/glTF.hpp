@@ -4,10 +4,17 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
 #include "cgltf.h"
 
+#include "MeshOptimizer.hpp"
+
 class glTF
 {
 public:
@@ -84,6 +91,7 @@ public:
         std::vector<float> mNormals;
         // std::vector<float> mTangents;
         std::vector<float> mTextureCoordinates;
+        std::vector<Dazzle::MeshLOD> mLODs;     // Simplified indices of the same vertices, coarser with each level
         // std::vector<float> mColor;
         // std::vector<float> mJoints;
         // std::vector<float> mWeights;
@@ -98,22 +106,93 @@ public:
         std::vector<Primitive> mPrimitives;
     };
 
+    // Node of the scene graph. Nodes are flattened in depth first order, so parents come before their children.
+    struct Node
+    {
+        std::string mName;
+        int mParent = -1;                               // Index in GetNodes(), -1 for root nodes
+        int mMesh = -1;                                 // Index in GetMeshes() or GetDeviceMeshes(), -1 without mesh
+        glm::mat4 mLocalTransform = glm::mat4(1.0f);
+        glm::mat4 mWorldTransform = glm::mat4(1.0f);
+    };
+
+    // Attribute locations used by the vertex arrays of the .glb fast path
+    static const GLuint kPositionLocation = 0;
+    static const GLuint kNormalLocation = 1;
+    static const GLuint kTextureCoordinatesLocation = 2;
+    static const GLuint kTangentLocation = 3;
+
+    // Primitive of the .glb fast path, its vertex array reads the attributes straight from the buffer view buffers
+    struct DevicePrimitive
+    {
+        GLuint mVertexArray = 0;
+        GLenum mMode = GL_TRIANGLES;
+        GLsizei mCount = 0;                 // Number of indices, or of vertices when not indexed
+        GLenum mIndexType = GL_NONE;        // GL_NONE when not indexed
+        GLintptr mIndexOffset = 0;          // Offset of the first index in the element buffer, in bytes
+
+        Material mMaterial;
+    };
+
+    struct DeviceMesh
+    {
+        std::string mName;
+        std::vector<DevicePrimitive> mPrimitives;
+    };
+
     glTF() = default;
-    ~glTF() = default;
+    glTF(const glTF& other) = delete;
+    ~glTF();
 
-    void LoadGLTF(const char* path);
+    glTF& operator=(const glTF& other) = delete;
 
-    std::vector<Mesh> GetMeshes() const { return mMeshes; }
+    void LoadGLTF(const char* path);
+    // Binary glTF fast path: the file is memory mapped and every buffer view used by a mesh is uploaded into its
+    // own immutable buffer straight from the mapped bytes. Attributes keep their stored format (normalized, 8 and
+    // 16 bit components included), so nothing is unpacked on the CPU. Returns false if the file can't be loaded.
+    bool LoadGLB(const char* path);
+
+    const std::vector<DeviceMesh>& GetDeviceMeshes() const { return mDeviceMeshes; }
+    // Bytes of the buffer views read by vertex attributes, uploaded as stored by the last LoadGLB() call
+    size_t GetVertexBufferSize() const { return mVertexBufferSize; }
+    static void Draw(const DevicePrimitive& primitive);
+
+    const std::vector<Node>& GetNodes() const { return mNodes; }
+    // World transforms of every node drawing mesh. Meshes referenced by several nodes are stored once, so they can
+    // be drawn instanced with these transforms.
+    const std::vector<glm::mat4>& GetMeshInstances(size_t mesh) const { return mMeshInstances[mesh]; }
+
+    const std::vector<Mesh>& GetMeshes() const { return mMeshes; }
+    // Hands the meshes over to the caller, leaving the loader empty.
+    std::vector<Mesh> TakeMeshes() { return std::move(mMeshes); }
+
+    // Time spent by the last LoadGLTF() call, parsing plus reading buffers, and unpacking the accessors, in ms
+    double GetLoadTime() const { return mLoadTime; }
+    double GetUnpackTime() const { return mUnpackTime; }
+    double GetOptimizeTime() const { return mOptimizeTime; }
+    // Vertex cache efficiency of the triangle primitives, before and after LoadGLTF() reordered them. The primitives
+    // also get their levels of detail then.
+    const Dazzle::MeshOptimizationReport& GetOptimizationReport() const { return mOptimizationReport; }
 
 private:
 
     void ProcessData(const cgltf_data* data);
     void ProcessNodes(const cgltf_data* data);
     void ProcessMeshes(const cgltf_data* data);
+    void OptimizeMeshes();
 
     std::vector<Primitive> ProcessPrimitives(const cgltf_mesh* mesh);
 
+    void UploadMeshes(const cgltf_data* data);
+    DevicePrimitive UploadPrimitive(const cgltf_data* data, const cgltf_primitive* primitive);
+    GLuint GetBuffer(const cgltf_data* data, const cgltf_buffer_view* view);
+
     std::vector<Mesh> mMeshes;
+    std::vector<DeviceMesh> mDeviceMeshes;
+    std::vector<Node> mNodes;
+    std::vector<std::vector<glm::mat4>> mMeshInstances;  // World transforms of the nodes of each mesh
+    std::unordered_map<cgltf_size, GLuint> mBuffers;     // Buffer view index to buffer
+    std::unordered_set<GLuint> mVertexBuffers;          // Buffers read by vertex attributes
     size_t mMeshCount = 0;
     size_t mMaterialCount = 0;
     size_t mImagesCount = 0;
@@ -121,6 +200,11 @@ private:
     size_t mLightsCount = 0;
     size_t mNodesCount = 0;
     size_t mScenesCount = 0;
+    size_t mVertexBufferSize = 0;
+    double mLoadTime = 0.0;
+    double mUnpackTime = 0.0;
+    double mOptimizeTime = 0.0;
+    Dazzle::MeshOptimizationReport mOptimizationReport;
 };
 
 #endif // _GLTF_HPP_
\ No newline at end of file
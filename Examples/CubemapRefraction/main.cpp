@@ -1,5 +1,4 @@
 #include <array>
-#include <filesystem>
 #include <iostream>
 
 #include "glm/glm.hpp"
@@ -15,6 +14,7 @@
 #include "App.hpp"
 #include "Camera.hpp"
 #include "Scene.hpp"
+#include "TextureCooker.hpp"
 #include "UserInterface.hpp"
 #include "Utils.hpp"
 
@@ -27,7 +27,10 @@ public:
         Dazzle::RenderSystem::GL::ProgramObject mProgram;
     };
 
-    SceneCubemapRefraction() :  mMVP(), mModelView(), mNormalMtx(),
+    // Storage of the environment map: BC6H is cooked with its mip chain, the others hold the decoded faces in one level
+    enum class EnvironmentFormat { BC6H, RGB9_E5, R11F_G11F_B10F, RGB32F };
+
+    SceneCubemapRefraction() :  mEnvironmentFormat(EnvironmentFormat::BC6H), mMVP(), mModelView(), mNormalMtx(),
                                 mCameraPosition(), mRefractionIndex(), mReflectionFactor() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
@@ -48,11 +51,7 @@ public:
 
         // -----------------------------------------------------------------------------------------
         // Textures for this scene:
-        GLuint cubemap = CreateCubemap();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+        LoadEnvironment();
 
         // -----------------------------------------------------------------------------------------
         // Shader Program - Skybox
@@ -89,6 +88,19 @@ public:
     void SetRefractionIndex(float index) { mRefractionIndex = index; }
     void SetReflectionFactor(float factor) { mReflectionFactor = factor; }
 
+    void SetEnvironmentFormat(EnvironmentFormat format)
+    {
+        if (format == mEnvironmentFormat)
+            return;
+
+        mEnvironmentFormat = format;
+        LoadEnvironment();
+    }
+
+    size_t GetEnvironmentMemory() const { return mEnvironmentMemory; }
+    // Base level of the six faces as RGB32F, what the map took before it was stored in a compact format
+    size_t GetEnvironmentReferenceMemory() const { return static_cast<size_t>(mEnvironmentSize) * mEnvironmentSize * 6 * 12; }
+
     void KeyCallback(int key, int scancode, int action, int mods) override {}
     void CursorCallback(double xPosition, double yPosition) override {}
     void FramebufferResizeCallback(int width, int height) override { glViewport(0, 0, width, height); }
@@ -98,12 +110,8 @@ private:
     {
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\Skybox.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\Skybox.fs.glsl");
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
         mSkyboxShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mSkyboxShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mSkyboxShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         GLuint handle = mSkyboxShader.mProgram.GetHandle();
         mSkyboxShader.mLocations["MVP"] = glGetUniformLocation(handle, "MVP");
@@ -113,12 +121,8 @@ private:
     {
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\CubemapRefraction.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\CubemapRefraction.fs.glsl");
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
         mRefractionShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mRefractionShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mRefractionShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         GLuint handle = mRefractionShader.mProgram.GetHandle();
         mRefractionShader.mLocations["Model"] = glGetUniformLocation(handle, "Model");
@@ -154,9 +158,21 @@ private:
            glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mNormalMtx));
     }
 
-    GLuint CreateCubemap()
+    void LoadEnvironment()
+    {
+        glDeleteTextures(1, &mCubemap);
+        mCubemap = CreateCubemap(mEnvironmentFormat, mEnvironmentMemory);
+        mEnvironmentSize = 0;
+        if (mCubemap != 0)
+            glGetTextureLevelParameteriv(mCubemap, 0, GL_TEXTURE_WIDTH, &mEnvironmentSize);
+
+        // Skybox and model sample the same map
+        glBindTextureUnit(0, mCubemap);
+        glBindTextureUnit(1, mCubemap);
+    }
+
+    GLuint CreateCubemap(EnvironmentFormat format, size_t& memory)
     {
-        GLuint texture = 0; // OpenGL Texture Object
         const std::vector<std::string> files = {
             "textures\\pisa_posx.hdr",
             "textures\\pisa_negx.hdr",
@@ -166,35 +182,30 @@ private:
             "textures\\pisa_negz.hdr"
         };
 
-        for (const auto& file : files)
+        // Cooked to BC6H with its mip chain on the first run, 1 byte per texel instead of the 12 of RGB32F. The other
+        // formats decode the faces on every load and pack them on the CPU, RGB9_E5 and R11F_G11F_B10F taking 4 bytes
+        GLuint texture = 0;
+        memory = 0;
+        switch (format)
         {
-            if (!std::filesystem::exists(file))
-            {
-                std::cerr << "File not found: " << file << '\n';
-                return texture;
-            }
+        case EnvironmentFormat::BC6H:
+            texture = Utils::Texture::LoadCookedTexture(files, "textures\\pisa.ktx2", Dazzle::TextureFormat::BC6H_UFLOAT, false,
+                                                        Utils::Texture::MipFilter::Color, Utils::Texture::SamplerPreset::Trilinear, &memory);
+            break;
+        case EnvironmentFormat::RGB9_E5:
+            texture = Utils::Texture::CreateHDRTexture(files, false, Utils::Texture::HDRFormat::RGB9_E5, &memory);
+            break;
+        case EnvironmentFormat::R11F_G11F_B10F:
+            texture = Utils::Texture::CreateHDRTexture(files, false, Utils::Texture::HDRFormat::R11F_G11F_B10F, &memory);
+            break;
+        case EnvironmentFormat::RGB32F:
+            texture = Utils::Texture::CreateHDRTexture(files, false, Utils::Texture::HDRFormat::RGB32F, &memory);
+            break;
         }
 
-        // Create texture
-        glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &texture);
-
-        bool once_flag = true;
-        for (size_t i = 0; i < files.size(); ++i)
-        {
-            int width, height;
-            auto data = Utils::Texture::GetHDRTextureData(files[i], width, height, false);
-
-            if (once_flag)
-            {
-                glTextureStorage2D(texture, 1, GL_RGB32F, width, height);
-                once_flag = false;
-            }
+        if (texture == 0)
+            return texture;
 
-            glTextureSubImage3D(texture, 0, 0, 0, (GLint)i, width, height, 1, GL_RGB, GL_FLOAT, data.get());
-        }
-
-        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTextureParameteri(texture, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -205,6 +216,11 @@ private:
     ShaderProgram mSkyboxShader;
     ShaderProgram mRefractionShader;
 
+    EnvironmentFormat mEnvironmentFormat;
+    GLuint mCubemap = 0;
+    size_t mEnvironmentMemory = 0;
+    GLint mEnvironmentSize = 0;
+
     std::shared_ptr<Camera> mCamera;
     std::unique_ptr<Dazzle::Torus> mTorus;
     std::unique_ptr<Dazzle::Skybox> mSkybox;
@@ -253,6 +269,15 @@ public:
         if (ImGui::Button("Reset"))
             ResetToDefaults();
 
+        // Environment map, RGB32F for comparison with the compact formats
+        ImGui::SeparatorText("Environment Map");
+        ImGui::Text("Format:"); ImGui::SameLine(); ImGui::Combo("##EnvironmentFormat", &mEnvironmentFormat, "BC6H\0" "RGB9_E5\0" "R11F_G11F_B10F\0" "RGB32F\0");
+        if (mScene)
+        {
+            const double megabyte = 1024.0 * 1024.0;
+            ImGui::Text("Memory: %.2f MB (RGB32F: %.2f MB)", mScene->GetEnvironmentMemory() / megabyte, mScene->GetEnvironmentReferenceMemory() / megabyte);
+        }
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
@@ -264,6 +289,7 @@ public:
         {
             mScene->SetRefractionIndex(mRefractionIndex);
             mScene->SetReflectionFactor(mReflectionFactor);
+            mScene->SetEnvironmentFormat(static_cast<SceneCubemapRefraction::EnvironmentFormat>(mEnvironmentFormat));
         }
     }
 
@@ -282,6 +308,8 @@ private:
 
     const float mReflectionFactorDefault = 0.1f;
     float mReflectionFactor = mReflectionFactorDefault;
+
+    int mEnvironmentFormat = 0;
 };
 
 int main(int argc, char const *argv[])
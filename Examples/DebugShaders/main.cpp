@@ -75,46 +75,35 @@ public:
         mSelectedObject = mObjects["Cube"].get();
 
         // -----------------------------------------------------------------------------------------
-        // Shader Programs
+        // Shader Programs, built together so the driver can compile them in parallel
+        Dazzle::RenderSystem::GL::AsyncProgramBuilder builder;
 
         // Flat Color
         auto vsscFlatColor = Dazzle::FileManager::ReadFile("shaders\\FlatColor.vs.glsl");
         auto fsscFlatColor = Dazzle::FileManager::ReadFile("shaders\\FlatColor.fs.glsl");
 
-        Dazzle::RenderSystem::GL::ShaderObject vsoFlatColor;
-        Dazzle::RenderSystem::GL::ShaderObject fsoFlatColor;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(vsoFlatColor, GL_VERTEX_SHADER, vsscFlatColor);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(fsoFlatColor, GL_FRAGMENT_SHADER, fsscFlatColor);
-
         mFlatColorProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mFlatColorProgram, {&vsoFlatColor, &fsoFlatColor});
-        mFlatColorUniformLocations.mMVP = glGetUniformLocation(mFlatColorProgram.GetHandle(), "MVP");
-        mFlatColorUniformLocations.mColor = glGetUniformLocation(mFlatColorProgram.GetHandle(), "Color");
+        builder.Add(mFlatColorProgram, {{GL_VERTEX_SHADER, vsscFlatColor}, {GL_FRAGMENT_SHADER, fsscFlatColor}});
 
         // Normals
         auto vsscNormals = Dazzle::FileManager::ReadFile("shaders\\Normals.vs.glsl");
         auto fsscNormals = Dazzle::FileManager::ReadFile("shaders\\Normals.fs.glsl");
 
-        Dazzle::RenderSystem::GL::ShaderObject vsoNormals;
-        Dazzle::RenderSystem::GL::ShaderObject fsoNormals;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(vsoNormals, GL_VERTEX_SHADER, vsscNormals);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(fsoNormals, GL_FRAGMENT_SHADER, fsscNormals);
-
         mNormalsProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mNormalsProgram, {&vsoNormals, &fsoNormals});
-        mNormalsUniformLocations.mMVP = glGetUniformLocation(mNormalsProgram.GetHandle(), "MVP");
+        builder.Add(mNormalsProgram, {{GL_VERTEX_SHADER, vsscNormals}, {GL_FRAGMENT_SHADER, fsscNormals}});
 
         // Texture Coordinates
         auto vsscTextureCoordinates = Dazzle::FileManager::ReadFile("shaders\\TextureCoordinates.vs.glsl");
         auto fsscTextureCoordinates = Dazzle::FileManager::ReadFile("shaders\\TextureCoordinates.fs.glsl");
 
-        Dazzle::RenderSystem::GL::ShaderObject vsoTextureCoordinates;
-        Dazzle::RenderSystem::GL::ShaderObject fsoTextureCoordinates;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(vsoTextureCoordinates, GL_VERTEX_SHADER, vsscTextureCoordinates);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(fsoTextureCoordinates, GL_FRAGMENT_SHADER, fsscTextureCoordinates);
-
         mTextureCoordinatesProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mTextureCoordinatesProgram, {&vsoTextureCoordinates, &fsoTextureCoordinates});
+        builder.Add(mTextureCoordinatesProgram, {{GL_VERTEX_SHADER, vsscTextureCoordinates}, {GL_FRAGMENT_SHADER, fsscTextureCoordinates}});
+
+        // Uniform locations can only be queried once the programs are linked
+        builder.Wait();
+        mFlatColorUniformLocations.mMVP = glGetUniformLocation(mFlatColorProgram.GetHandle(), "MVP");
+        mFlatColorUniformLocations.mColor = glGetUniformLocation(mFlatColorProgram.GetHandle(), "Color");
+        mNormalsUniformLocations.mMVP = glGetUniformLocation(mNormalsProgram.GetHandle(), "MVP");
         mTextureCoordinatesUniformLocations.mMVP = glGetUniformLocation(mTextureCoordinatesProgram.GetHandle(), "MVP");
 
         // Use Program Shader
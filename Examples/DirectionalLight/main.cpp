@@ -64,15 +64,9 @@ public:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\DirectionalLight.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\DirectionalLight.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Get Uniforms
         mLocations.mMVP = glGetUniformLocation(mProgram.GetHandle(), "MVP");                        // (mat4) Model View Projection
@@ -8,6 +8,7 @@
 
 #include "RenderSystem.hpp"
 #include "FileManager.hpp"
+#include "VertexLayout.hpp"
 #include "Plane.hpp"
 #include "Sphere.hpp"
 #include "Torus.hpp"
@@ -36,7 +37,7 @@ public:
                     mKs(), mShininess(),
                     mLa(), mLds(), mLp(),
                     mRenderBufferTexture(), mFBO(),
-                    mQuadVAO(nullptr),
+                    mQuadVAO(nullptr), mQuadIndexType(GL_UNSIGNED_INT),
                     mWidth(), mHeight(), mAngle() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
@@ -55,42 +56,35 @@ public:
         // -----------------------------------------------------------------------------------------
         // 3D Objects for this scene:
         // Full Screen Quad
-        GLfloat vertices[] =
+        std::vector<float> vertices =
         {
             -1.0f, -1.0f, 0.0f, // Bottom Left
             1.0f, -1.0f, 0.0f,  // Bottom Right
             1.0f, 1.0f, 0.0f,   // Top Right
             -1.0f, 1.0f, 0.0f   // Top Left
         };
-        GLfloat normals[] =
+        std::vector<float> normals =
         {
             0.0f, 0.0f, 1.0f,   // Bottom Left
             0.0f, 0.0f, 1.0f,   // Bottom Right
             0.0f, 0.0f, 1.0f,   // Top Right
             0.0f, 0.0f, 1.0f    // Top Left
         };
-        GLint indices[] =
+        std::vector<unsigned int> indices =
         {
             0, 1, 2,
             2, 3, 0
         };
         mQuadVAO = std::make_unique<Dazzle::RenderSystem::GL::VAO>();
         mQuadVBO = std::make_unique<Dazzle::RenderSystem::GL::VBO>();
-        mQuadNVBO = std::make_unique<Dazzle::RenderSystem::GL::VBO>();
         mQuadEBO = std::make_unique<Dazzle::RenderSystem::GL::EBO>();
 
-        glNamedBufferStorage(mQuadVBO->GetHandle(), 12 * sizeof(GLfloat), vertices, 0);
-        glNamedBufferStorage(mQuadNVBO->GetHandle(), 12 * sizeof(GLfloat), normals, 0);
-        glNamedBufferStorage(mQuadEBO->GetHandle(), 6 * sizeof(GLint), indices, 0);
-        glVertexArrayVertexBuffer(mQuadVAO->GetHandle(), 0, mQuadVBO->GetHandle(), 0, 3 * sizeof(GLfloat));
-        glVertexArrayAttribFormat(mQuadVAO->GetHandle(), 0, 3, GL_FLOAT, GL_FALSE, 0);
-        glVertexArrayAttribBinding(mQuadVAO->GetHandle(), 0, 0);
-        glEnableVertexArrayAttrib(mQuadVAO->GetHandle(), 0);
-        glVertexArrayVertexBuffer(mQuadVAO->GetHandle(), 1, mQuadNVBO->GetHandle(), 0, 3 * sizeof(float));
-        glVertexArrayAttribFormat(mQuadVAO->GetHandle(), 1, 3, GL_FLOAT, GL_FALSE, 0);
-        glVertexArrayAttribBinding(mQuadVAO->GetHandle(), 1, 1);
-        glEnableVertexArrayAttrib(mQuadVAO->GetHandle(), 1);
-        glVertexArrayElementBuffer(mQuadVAO->GetHandle(), mQuadEBO->GetHandle());
+        Dazzle::RenderSystem::GL::VertexBufferBuilder builder;
+        builder.SetPositions(vertices)
+               .SetNormals(normals)
+               .SetIndices(indices)
+               .Build(*mQuadVAO, *mQuadVBO, mQuadEBO.get());
+        mQuadIndexType = builder.GetIndexType();
         glBindVertexArray(mQuadVAO->GetHandle());
 
         mPlane = std::make_unique<Dazzle::Plane>(); 
@@ -201,7 +195,7 @@ private:
 
         // Draw
         glBindVertexArray(mQuadVAO->GetHandle());
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, 6, mQuadIndexType, 0);
     }
 
     void UpdateMatrices(const ShaderProgram& shader, glm::mat4 model)
@@ -236,15 +230,9 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\EdgeDetectionFilter.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\EdgeDetectionFilter.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
@@ -302,8 +290,8 @@ private:
 
     std::unique_ptr<Dazzle::RenderSystem::GL::VAO> mQuadVAO;
     std::unique_ptr<Dazzle::RenderSystem::GL::VBO> mQuadVBO;
-    std::unique_ptr<Dazzle::RenderSystem::GL::VBO> mQuadNVBO;
     std::unique_ptr<Dazzle::RenderSystem::GL::EBO> mQuadEBO;
+    GLenum mQuadIndexType;
     GLuint mRenderBufferTexture;
     GLuint mFBO;
     ShaderProgram mShader;
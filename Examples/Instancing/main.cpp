@@ -0,0 +1,442 @@
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui.h"
+
+#include "RenderSystem.hpp"
+#include "FileManager.hpp"
+#include "Cube.hpp"
+#include "Sphere.hpp"
+#include "Torus.hpp"
+#include "RenderQueue.hpp"
+#include "DepthPyramid.hpp"
+#include "CullingPass.hpp"
+#include "UniformBuffer.hpp"
+#include "VertexLayout.hpp"
+
+#include "App.hpp"
+#include "Camera.hpp"
+#include "GPUTimer.hpp"
+#include "Scene.hpp"
+#include "UserInterface.hpp"
+#include "Utils.hpp"
+
+#define WINDOW_WIDTH (int)1280
+#define WINDOW_HEIGHT (int)720
+
+class SceneInstancing : public IScene
+{
+public:
+    // Submission strategies compared by the benchmark
+    enum class DrawMode
+    {
+        Instanced = 0,          // One glDrawElementsInstanced call per shape
+        PerObject = 1,          // One draw call per object, the base instance selects its transform
+        MultiDrawIndirect = 2   // Every object with a single glMultiDrawElementsIndirect call
+    };
+
+    static const unsigned int kShapeCount = 3;
+
+    // std140 layout of the MaterialBlock uniform block
+    struct Material
+    {
+        glm::vec4 mDiffuse;
+    };
+
+    SceneInstancing() : mMaterials() {}
+
+    ~SceneInstancing()
+    {
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteTextures(1, &mColorTexture);
+        glDeleteTextures(1, &mDepthTexture);
+    }
+
+    void Initialize(const std::shared_ptr<Camera>& camera) override
+    {
+        // Set up OpenGL debug message callback
+        Dazzle::RenderSystem::GL::SetupDebugMessageCallback();
+
+        // -----------------------------------------------------------------------------------------
+        // Variables Initialization:
+        mCamera = camera;
+        mMaterials[0].mDiffuse = glm::vec4(0.9f, 0.5f, 0.2f, 1.0f);
+        mMaterials[1].mDiffuse = glm::vec4(0.2f, 0.6f, 0.9f, 1.0f);
+        mMaterials[2].mDiffuse = glm::vec4(0.4f, 0.9f, 0.3f, 1.0f);
+
+        // -----------------------------------------------------------------------------------------
+        // 3D Objects for this scene:
+        mCube = std::make_unique<Dazzle::Cube>(0.5f);
+        mCube->InitializeBuffers();
+
+        mSphere = std::make_unique<Dazzle::Sphere>(0.3f, 16, 16, 0.0f, glm::pi<float>(), 0.0f, glm::two_pi<float>());
+        mSphere->InitializeBuffers();
+
+        mTorus = std::make_unique<Dazzle::Torus>(0.25f, 0.1f, 16, 16, 0.0f, glm::two_pi<float>(), 0.0f, glm::two_pi<float>());
+        mTorus->InitializeBuffers();
+
+        // The render queue keeps its own copy of the geometry, in the same order as the shapes
+        mQueue.Initialize();
+        mQueue.AddGeometry(*mCube);
+        mQueue.AddGeometry(*mSphere);
+        mQueue.AddGeometry(*mTorus);
+
+        SetInstanceCount(1000);
+
+        // -----------------------------------------------------------------------------------------
+        // Shader Program
+        // Get the source code for shaders
+        auto VSSC = Dazzle::FileManager::ReadFile("shaders\\Instancing.vs.glsl");
+        auto FSSC = Dazzle::FileManager::ReadFile("shaders\\Instancing.fs.glsl");
+
+        // Create and build the OpenGL program objects, loaded from the shader cache when possible.
+        // Both are submitted before waiting, so the driver can compile them in parallel.
+        Dazzle::RenderSystem::GL::AsyncProgramBuilder builder;
+        mProgram.Initialize();
+        builder.Add(mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+
+        // Program used by the multi-draw, fetches transforms and materials with gl_BaseInstance
+        VSSC = Dazzle::FileManager::ReadFile("shaders\\MultiDrawIndirect.vs.glsl");
+        FSSC = Dazzle::FileManager::ReadFile("shaders\\MultiDrawIndirect.fs.glsl");
+
+        mMultiDrawProgram.Initialize();
+        builder.Add(mMultiDrawProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+        builder.Submit();
+
+        // Per-frame, per-object and material uniform blocks
+        mUniforms.Initialize(16 * 1024);
+
+        // GPU culling of the multi-draw, the occlusion test reads the depth of the previous frame
+        mCulling.Initialize();
+        InitializeFramebuffer(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+        builder.Wait();
+
+        // GPU timer queries, read back once available to avoid stalling the pipeline
+        mGPUTimer.Initialize();
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    }
+
+    void Update(double time) override {}
+
+    void Render() override
+    {
+        // The scene is rendered offscreen so its depth can be read back into the depth pyramid
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Uniform blocks of this frame are written to its own region of the ring buffer
+        mUniforms.BeginFrame();
+        UpdateUniforms();
+
+        // Object data only changes with the instance count, keep its upload out of the measured submission
+        if (mDrawMode == DrawMode::MultiDrawIndirect)
+            mQueue.Upload();
+
+        mGPUTimer.Begin();
+
+        auto start = std::chrono::steady_clock::now();
+        if (mDrawMode == DrawMode::Instanced)
+        {
+            glUseProgram(mProgram.GetHandle());
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[0]);
+            mCube->DrawInstanced();
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[1]);
+            mSphere->DrawInstanced();
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[2]);
+            mTorus->DrawInstanced();
+            mDrawCalls = kShapeCount;
+        }
+        else if (mDrawMode == DrawMode::PerObject)
+        {
+            glUseProgram(mProgram.GetHandle());
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[0]);
+            for (GLsizei i = 0; i < mCube->GetInstanceCount(); i++)
+                mCube->DrawInstanced(static_cast<GLuint>(i), 1);
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[1]);
+            for (GLsizei i = 0; i < mSphere->GetInstanceCount(); i++)
+                mSphere->DrawInstanced(static_cast<GLuint>(i), 1);
+            mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, mMaterials[2]);
+            for (GLsizei i = 0; i < mTorus->GetInstanceCount(); i++)
+                mTorus->DrawInstanced(static_cast<GLuint>(i), 1);
+            mDrawCalls = mInstanceCount;
+        }
+        else
+        {
+            glUseProgram(mMultiDrawProgram.GetHandle());
+            // Materials as a shader storage array, indexed with ObjectData::mMaterial
+            GLintptr offset = mUniforms.Write(mMaterials.data(), sizeof(mMaterials));
+            mUniforms.Bind(Dazzle::RenderSystem::GL::kMaterialBlockBinding, offset, sizeof(mMaterials), GL_SHADER_STORAGE_BUFFER);
+            if (IsCullingEnabled())
+            {
+                mCulling.Cull(mQueue, mCamera->GetProjection() * mCamera->GetTransform(), &mDepthPyramid);
+                mCulling.Submit(mQueue);
+            }
+            else
+            {
+                mQueue.Submit();
+            }
+            mDrawCalls = 1;
+        }
+        std::chrono::duration<double, std::milli> submitTime = std::chrono::steady_clock::now() - start;
+        mCPUTime = submitTime.count();
+
+        mGPUTimer.End();
+
+        // Depth pyramid tested by the next frame's occlusion culling
+        if (IsCullingEnabled() && mOcclusionCulling)
+            mDepthPyramid.Build(mDepthTexture);
+
+        glBlitNamedFramebuffer(mFBO, 0, 0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        mUniforms.EndFrame();
+    }
+
+    // Lays out count objects on a cubic grid in front of the camera, cycling through the shapes
+    void SetInstanceCount(unsigned int count)
+    {
+        if (count == mInstanceCount)
+            return;
+
+        const float spacing = 1.5f;
+        const unsigned int side = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(count))));
+        const float extent = side * spacing;
+        const glm::vec3 origin = glm::vec3(-0.5f * extent, -0.5f * extent, -2.0f * extent);
+
+        std::array<std::vector<glm::mat4>, kShapeCount> transforms;
+        for (auto& shapeTransforms : transforms)
+            shapeTransforms.reserve(count / kShapeCount + 1);
+
+        mQueue.ClearObjects();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            glm::vec3 cell = glm::vec3(i % side, (i / side) % side, i / (side * side));
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), origin + cell * spacing);
+
+            // Geometry and material ids of the queue match the shape index
+            const unsigned int shape = i % kShapeCount;
+            transforms[shape].push_back(transform);
+            mQueue.AddObject(shape, transform, shape);
+        }
+
+        mCube->SetInstanceTransforms(transforms[0]);
+        mSphere->SetInstanceTransforms(transforms[1]);
+        mTorus->SetInstanceTransforms(transforms[2]);
+        mInstanceCount = count;
+    }
+
+    void SetDrawMode(DrawMode mode) { mDrawMode = mode; }
+    void SetFrustumCulling(bool enabled) { mFrustumCulling = enabled; mCulling.SetFrustumCulling(enabled); }
+    void SetOcclusionCulling(bool enabled) { mOcclusionCulling = enabled; mCulling.SetOcclusionCulling(enabled); }
+    void SetColor(unsigned int shape, const std::array<float, 3>& color) { mMaterials[shape].mDiffuse = glm::vec4(color[0], color[1], color[2], 1.0f); }
+
+    unsigned int GetInstanceCount() const { return mInstanceCount; }
+    unsigned int GetDrawCalls() const { return mDrawCalls; }
+    // Objects drawn out of the objects tested by the culling pass, a few frames behind
+    unsigned int GetVisibleCount() const { return IsCullingEnabled() ? mCulling.GetVisibleCount() : mInstanceCount; }
+    unsigned int GetSubmittedCount() const { return IsCullingEnabled() ? mCulling.GetSubmittedCount() : mInstanceCount; }
+    // Time spent issuing the draw calls of the last frame, in milliseconds
+    double GetCPUTime() const { return mCPUTime; }
+    // Time spent by the GPU on the objects, in milliseconds, a few frames behind
+    double GetGPUTime() const { return mGPUTimer.GetTime(); }
+
+    void KeyCallback(int key, int scancode, int action, int mods) override {}
+    void CursorCallback(double xPosition, double yPosition) override {}
+    void FramebufferResizeCallback(int width, int height) override
+    {
+        glViewport(0, 0, width, height);
+        if (width > 0 && height > 0)
+            InitializeFramebuffer(width, height);
+    }
+
+private:
+    bool IsCullingEnabled() const { return mDrawMode == DrawMode::MultiDrawIndirect && (mFrustumCulling || mOcclusionCulling); }
+
+    void InitializeFramebuffer(int width, int height)
+    {
+        mWidth = width;
+        mHeight = height;
+
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteTextures(1, &mColorTexture);
+        glDeleteTextures(1, &mDepthTexture);
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &mColorTexture);
+        glTextureStorage2D(mColorTexture, 1, GL_RGBA8, width, height);
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &mDepthTexture);
+        glTextureStorage2D(mDepthTexture, 1, GL_DEPTH_COMPONENT32F, width, height);
+        glTextureParameteri(mDepthTexture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(mDepthTexture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glCreateFramebuffers(1, &mFBO);
+        glNamedFramebufferTexture(mFBO, GL_COLOR_ATTACHMENT0, mColorTexture, 0);
+        glNamedFramebufferTexture(mFBO, GL_DEPTH_ATTACHMENT, mDepthTexture, 0);
+
+        if (glCheckNamedFramebufferStatus(mFBO, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "Framebuffer is not complete!" << std::endl;
+
+        mDepthPyramid.Initialize(width, height);
+    }
+
+    void UpdateUniforms()
+    {
+        glm::mat4 view = mCamera->GetTransform();
+
+        Dazzle::RenderSystem::GL::FrameUniforms frame = {};
+        frame.mView = view;
+        frame.mProjection = mCamera->GetProjection();
+        frame.mLightCount = 1;
+        // Light Position in View Coordinates, follows the camera
+        frame.mLights[0].mPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        frame.mLights[0].mAmbient = glm::vec3(0.2f);
+        frame.mLights[0].mIntensity = glm::vec3(0.8f);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kFrameBlockBinding, frame);
+
+        // Instance transforms already place every cube in the scene
+        auto object = Dazzle::RenderSystem::GL::ObjectUniforms::Create(glm::mat4(1.0f), view, mCamera->GetProjection());
+        mUniforms.Push(Dazzle::RenderSystem::GL::kObjectBlockBinding, object);
+    }
+
+    Dazzle::RenderSystem::GL::ProgramObject mProgram;
+    Dazzle::RenderSystem::GL::ProgramObject mMultiDrawProgram;
+    Dazzle::RenderSystem::GL::UniformRingBuffer mUniforms;
+    Dazzle::RenderSystem::GL::RenderQueue mQueue;
+    Dazzle::RenderSystem::GL::CullingPass mCulling;
+    Dazzle::RenderSystem::GL::DepthPyramid mDepthPyramid;
+    std::unique_ptr<Dazzle::Cube> mCube;
+    std::unique_ptr<Dazzle::Sphere> mSphere;
+    std::unique_ptr<Dazzle::Torus> mTorus;
+    std::shared_ptr<Camera> mCamera;
+    std::array<Material, kShapeCount> mMaterials;
+
+    DrawMode mDrawMode = DrawMode::Instanced;
+    bool mFrustumCulling = true;
+    bool mOcclusionCulling = true;
+    GLuint mFBO = 0;
+    GLuint mColorTexture = 0;
+    GLuint mDepthTexture = 0;
+    int mWidth = WINDOW_WIDTH;
+    int mHeight = WINDOW_HEIGHT;
+    unsigned int mInstanceCount = 0;
+    GPUTimer mGPUTimer;
+    unsigned int mDrawCalls = 0;
+    double mCPUTime = 0.0;
+};
+
+class UIInstancing : public IUserInterface
+{
+public:
+
+    void SetScene(IScene* scene) override { mScene = static_cast<SceneInstancing*>(scene); }
+    void SetCamera(Camera* camera) override { mCamera = camera; }
+
+    void Update() override
+    {
+        // Get data from the camera
+        glm::vec3 cameraPosition = glm::vec3();
+        float cameraYaw = 0.0f;
+        float cameraPitch = 0.0f;
+        if (mCamera)
+        {
+            cameraPosition = mCamera->GetPosition();
+            cameraYaw = mCamera->GetYaw();
+            cameraPitch = mCamera->GetPitch();
+        }
+
+        ImGui::Begin("Settings");
+        ImGui::Text("Press ESC to close the application.");
+        ImGui::Text("Press SHIFT to toggle cursor capture mode.");
+
+        // Benchmark
+        ImGui::SeparatorText("Draw Submission");
+
+        ImGui::NewLine();
+        ImGui::Text("Instances:"); ImGui::SameLine(); ImGui::Combo("##Instances", &mInstanceCountIndex, "1K\0" "10K\0" "100K\0" "1M\0");
+        ImGui::Text("Draw Mode:"); ImGui::SameLine(); ImGui::Combo("##DrawMode", &mDrawMode, "Instanced (1 draw call per shape)\0" "Per Object (1 draw call per object)\0" "Multi-Draw Indirect (1 draw call)\0");
+        ImGui::Text("Frustum Culling:"); ImGui::SameLine(); ImGui::Checkbox("##FrustumCulling", &mFrustumCulling);
+        ImGui::Text("Occlusion Culling (Hi-Z):"); ImGui::SameLine(); ImGui::Checkbox("##OcclusionCulling", &mOcclusionCulling);
+        ImGui::Text("Cube Color:"); ImGui::SameLine(); ImGui::ColorEdit3("##CubeColor", mColors[0].data());
+        ImGui::Text("Sphere Color:"); ImGui::SameLine(); ImGui::ColorEdit3("##SphereColor", mColors[1].data());
+        ImGui::Text("Torus Color:"); ImGui::SameLine(); ImGui::ColorEdit3("##TorusColor", mColors[2].data());
+
+        if (ImGui::Button("Reset"))
+            ResetToDefaults();
+
+        // Camera
+        ImGui::SeparatorText("Camera");
+        ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
+        ImGui::Text("Yaw: %.2f, Pitch: %.2f", cameraYaw, cameraPitch);
+
+        // Statistics
+        ImGui::SeparatorText("Statistics");
+        ImGui::Text("Frame Time: %.2f ms (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        if (mScene)
+        {
+            ImGui::Text("Objects: %u", mScene->GetInstanceCount());
+            ImGui::Text("Draw Calls: %u", mScene->GetDrawCalls());
+            ImGui::Text("Visible Objects: %u / %u submitted", mScene->GetVisibleCount(), mScene->GetSubmittedCount());
+            ImGui::Text("Draw Submission CPU Time: %.3f ms", mScene->GetCPUTime());
+            ImGui::Text("Draw GPU Time: %.3f ms", mScene->GetGPUTime());
+        }
+        ImGui::End();
+
+        // Set data to the scene
+        if (mScene)
+        {
+            mScene->SetInstanceCount(kInstanceCounts[mInstanceCountIndex]);
+            mScene->SetDrawMode(static_cast<SceneInstancing::DrawMode>(mDrawMode));
+            mScene->SetFrustumCulling(mFrustumCulling);
+            mScene->SetOcclusionCulling(mOcclusionCulling);
+            for (unsigned int i = 0; i < SceneInstancing::kShapeCount; i++)
+                mScene->SetColor(i, mColors[i]);
+        }
+    }
+
+private:
+    void ResetToDefaults()
+    {
+        mInstanceCountIndex = 0;
+        mDrawMode = 0;
+        mFrustumCulling = true;
+        mOcclusionCulling = true;
+        mColors = kDefaultColors;
+    }
+
+    const std::array<unsigned int, 4> kInstanceCounts = {1000, 10000, 100000, 1000000};
+    const std::array<std::array<float, 3>, SceneInstancing::kShapeCount> kDefaultColors = {{{0.9f, 0.5f, 0.2f}, {0.2f, 0.6f, 0.9f}, {0.4f, 0.9f, 0.3f}}};
+
+    SceneInstancing* mScene = nullptr;
+    Camera* mCamera = nullptr;
+
+    int mInstanceCountIndex = 0;
+    int mDrawMode = 0;
+    bool mFrustumCulling = true;
+    bool mOcclusionCulling = true;
+    std::array<std::array<float, 3>, SceneInstancing::kShapeCount> mColors = kDefaultColors;
+};
+
+int main(int argc, char const *argv[])
+{
+    AppConfig config;
+    config.width = WINDOW_WIDTH; // Window Width
+    config.height = WINDOW_HEIGHT; // Window Height
+    config.title = "Instancing & Multi-Draw Indirect";    // Window Title
+
+    auto sceneInstancing = std::make_unique<SceneInstancing>();
+    auto uiInstancing = std::make_unique<UIInstancing>();
+
+    App app(config, std::move(sceneInstancing), std::move(uiInstancing));
+    app.Run();
+
+    return 0;
+}
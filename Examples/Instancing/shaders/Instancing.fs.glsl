@@ -0,0 +1,35 @@
+#version 460 core
+
+in vec3 Position;
+in vec3 NormalVector;
+
+layout(location = 0) out vec4 FragmentColor;
+
+struct Light
+{
+    vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Ambient Intensity
+    vec3 mIntensity;            // (vec3) Diffuse Intensity
+};
+
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 View;
+    mat4 Projection;
+    Light lights[4];            // Lights source data, only the first one is used
+    int LightCount;
+};
+
+layout(std140, binding = 2) uniform MaterialBlock
+{
+    vec4 mDiffuse;              // (vec4) Diffuse Reflectivity
+} material; // Material properties
+
+void main()
+{
+    vec3 surfacePointToLightPoint = normalize(lights[0].mPosition.xyz - Position);
+    float sDotN = max(dot(surfacePointToLightPoint, normalize(NormalVector)), 0.0); // Lambertian Reflectance
+
+    vec3 color = material.mDiffuse.rgb * (lights[0].mAmbient + lights[0].mIntensity * sDotN);
+    FragmentColor = vec4(color, 1.0);
+}
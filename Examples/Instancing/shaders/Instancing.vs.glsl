@@ -0,0 +1,27 @@
+#version 460 core
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormalVector;
+layout (location = 5) in mat4 InstanceTransform;
+
+out vec3 Position;
+out vec3 NormalVector;
+
+layout(std140, binding = 1) uniform ObjectBlock
+{
+    mat4 Model;         // (mat4) Model
+    mat4 ModelView;     // (mat4) Model View
+    mat4 MVP;           // (mat4) Model View Projection
+    mat3 Normal;        // (mat3) Normal
+};
+
+void main(void)
+{
+    // Instance transforms are only translations, mat3() is enough for normals
+    vec4 InstancePosition = InstanceTransform * vec4(VertexPosition, 1.0);
+
+    Position = (ModelView * InstancePosition).xyz;
+    NormalVector = normalize(Normal * mat3(InstanceTransform) * VertexNormalVector);
+
+    gl_Position = MVP * InstancePosition;
+}
@@ -0,0 +1,41 @@
+#version 460 core
+
+in vec3 Position;
+in vec3 NormalVector;
+flat in uint MaterialIndex;
+
+layout(location = 0) out vec4 FragmentColor;
+
+struct Light
+{
+    vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Ambient Intensity
+    vec3 mIntensity;            // (vec3) Diffuse Intensity
+};
+
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 View;
+    mat4 Projection;
+    Light lights[4];            // Lights source data, only the first one is used
+    int LightCount;
+};
+
+struct Material
+{
+    vec4 mDiffuse;              // (vec4) Diffuse Reflectivity
+};
+
+layout(std430, binding = 2) readonly buffer MaterialBlock
+{
+    Material materials[];
+};
+
+void main()
+{
+    vec3 surfacePointToLightPoint = normalize(lights[0].mPosition.xyz - Position);
+    float sDotN = max(dot(surfacePointToLightPoint, normalize(NormalVector)), 0.0); // Lambertian Reflectance
+
+    vec3 color = materials[MaterialIndex].mDiffuse.rgb * (lights[0].mAmbient + lights[0].mIntensity * sDotN);
+    FragmentColor = vec4(color, 1.0);
+}
@@ -0,0 +1,49 @@
+#version 460 core
+
+layout (location = 0) in vec3 VertexPosition;
+layout (location = 1) in vec3 VertexNormalVector;
+
+out vec3 Position;
+out vec3 NormalVector;
+flat out uint MaterialIndex;
+
+struct Light
+{
+    vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Ambient Intensity
+    vec3 mIntensity;            // (vec3) Diffuse Intensity
+};
+
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 View;
+    mat4 Projection;
+    Light lights[4];
+    int LightCount;
+};
+
+struct ObjectData
+{
+    mat4 Model;
+    mat4 Normal;                // Upper 3x3 is the world space normal matrix
+    uint Material;
+};
+
+// One entry per object of the RenderQueue, the base instance of a draw command is its object id
+layout(std430, binding = 3) readonly buffer ObjectDataBlock
+{
+    ObjectData objects[];
+};
+
+void main(void)
+{
+    ObjectData object = objects[gl_BaseInstance];
+
+    vec4 ViewPosition = View * object.Model * vec4(VertexPosition, 1.0);
+
+    Position = ViewPosition.xyz;
+    NormalVector = normalize(mat3(View) * mat3(object.Normal) * VertexNormalVector);
+    MaterialIndex = object.Material;
+
+    gl_Position = Projection * ViewPosition;
+}
@@ -15,6 +15,7 @@
 #include "App.hpp"
 #include "Camera.hpp"
 #include "Scene.hpp"
+#include "TextureCooker.hpp"
 #include "UserInterface.hpp"
 #include "Utils.hpp"
 
@@ -77,22 +78,21 @@ public:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\NormalMapping.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\NormalMapping.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // -----------------------------------------------------------------------------------------
         // Textures for this scene:
-        mTextures.mOgreDiffuse = CreateTexture("textures\\diffuse.png");
-        mTextures.mOgreNormalMap = CreateTexture("textures\\normalmap.png");
-        mTextures.mBrickDiffuse = CreateTexture("textures\\brick-color.png");
-        mTextures.mBrickNormalMap = CreateTexture("textures\\brick-normal.png");
+        // Cooked to BC1 and BC5 on the first run, the shader rebuilds the Z of the normals BC5 drops
+        mTextures.mOgreDiffuse = Utils::Texture::LoadCookedTexture({"textures\\diffuse.png"}, "textures\\diffuse.ktx2",
+                                                                   Dazzle::TextureFormat::BC1_RGB_UNORM, true);
+        mTextures.mOgreNormalMap = Utils::Texture::LoadCookedTexture({"textures\\normalmap.png"}, "textures\\normalmap.ktx2",
+                                                                     Dazzle::TextureFormat::BC5_UNORM, true, Utils::Texture::MipFilter::Normal);
+        mTextures.mBrickDiffuse = Utils::Texture::LoadCookedTexture({"textures\\brick-color.png"}, "textures\\brick-color.ktx2",
+                                                                    Dazzle::TextureFormat::BC1_RGB_UNORM, true);
+        mTextures.mBrickNormalMap = Utils::Texture::LoadCookedTexture({"textures\\brick-normal.png"}, "textures\\brick-normal.ktx2",
+                                                                      Dazzle::TextureFormat::BC5_UNORM, true, Utils::Texture::MipFilter::Normal);
 
         // Activate and bind a valid texture before glUserProgram
         // Since program expects a valid texture bound to the texture units used.
@@ -185,46 +185,24 @@ private:
         glUniform4f(mLocations.mLp, mLp.x, mLp.y, mLp.z, mLp.w);
     }
 
-    GLuint CreateTexture(const std::string& path, bool flip = true)
-    {
-        int width, height;
-        auto imageData = Utils::Texture::GetTextureData(path, width, height, flip);
-        GLuint texture = 0; // OpenGL Texture Object
-        if (imageData)
-        {
-            // Create texture
-            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-
-            // Set texture parameters
-            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-            // Explicitly state the base and max levels
-            glTextureParameteri(texture, GL_TEXTURE_BASE_LEVEL, 0);
-            glTextureParameteri(texture, GL_TEXTURE_MAX_LEVEL, 0);
-
-            // Set up texture storage
-            glTextureStorage2D(texture, 1, GL_RGBA8, width, height);
-
-            // Upload texture data
-            glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData.get());
-        }
-
-        return texture;
-    }
-
     void InitializeMesh(Dazzle::Mesh& mesh, const std::string& path)
     {
-        std::string name;
-        std::vector<float> vertices, normals, textureCoords;
-        Utils::Geom::GetMeshDataFromObj(path, name, vertices, normals, textureCoords);
-        mesh.SetName(name);
-        mesh.SetVertices(std::move(vertices));
-        mesh.SetNormals(std::move(normals));
-        mesh.SetTextureCoordinates(std::move(textureCoords));
-        mesh.SetTangents( Utils::Geom::GenerateTangents(mesh.GetVertices(),
-                                                        mesh.GetNormals(),
-                                                        mesh.GetTextureCoordinates()));
+        // Every shape of the file, welded into a single indexed mesh
+        std::vector<Utils::Geom::ObjShape> shapes;
+        std::vector<Utils::Geom::ObjMaterial> materials;
+        if (!Utils::Geom::LoadObj(path, shapes, materials))
+            return;
+
+        Utils::Geom::ObjShape shape = Utils::Geom::MergeObjShapes(shapes);
+        mesh.SetName(shape.mName);
+        mesh.SetTangents( Utils::Geom::GenerateTangents(shape.mVertices,
+                                                        shape.mNormals,
+                                                        shape.mTextureCoordinates,
+                                                        shape.mIndices));
+        mesh.SetVertices(std::move(shape.mVertices));
+        mesh.SetNormals(std::move(shape.mNormals));
+        mesh.SetTextureCoordinates(std::move(shape.mTextureCoordinates));
+        mesh.SetIndices(std::move(shape.mIndices));
     }
 
     Dazzle::RenderSystem::GL::ProgramObject mProgram;
@@ -297,6 +275,13 @@ public:
         if (ImGui::Button("Reset"))
             ResetToDefaults();
 
+        // Loading
+        ImGui::SeparatorText("Loading");
+        if (ImGui::Button("Benchmark tangent generation"))
+            Utils::Geom::BenchmarkTangents();
+        if (ImGui::Button("Benchmark normal generation"))
+            Utils::Geom::BenchmarkNormals();
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
@@ -48,9 +48,11 @@ vec3 BlinnPhongModel(vec3 NormalFromMap)
 
 void main()
 {
-    // Look up the normal from the normal map
-    vec3 normalFromMap = texture(NormalMapSampler, TextureCoordinate).xyz;
+    // Look up the normal from the normal map, a two channel BC5 texture
+    vec3 normalFromMap;
     // Convert range from [0, 1] to [-1, 1]
-    normalFromMap.xy = 2.0 * normalFromMap.xy - 1.0;
+    normalFromMap.xy = 2.0 * texture(NormalMapSampler, TextureCoordinate).rg - 1.0;
+    // Rebuild Z from the unit length, it always faces out of the surface in tangent space
+    normalFromMap.z = sqrt(max(1.0 - dot(normalFromMap.xy, normalFromMap.xy), 0.0));
     FragmentColor = vec4(BlinnPhongModel(normalFromMap), 1.0);
 }
@@ -11,6 +11,7 @@
 #include "FileManager.hpp"
 #include "Plane.hpp"
 #include "Cube.hpp"
+#include "UniformBuffer.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
@@ -32,14 +33,15 @@ public:
         Dazzle::RenderSystem::GL::ProgramObject mProgram;
     };
 
+    // std140 layout of the MaterialBlock uniform block
     struct Material
     {
         glm::vec4 mAmbient;
         glm::vec4 mDiffuse;
     };
+    static_assert(sizeof(Material) == 32, "Material must match the std140 layout of MaterialBlock");
 
-    SceneOIT() :  mMVP(), mModelView(), mNormalMtx(),
-                    mWidth(), mHeight() {}
+    SceneOIT() :  mWidth(), mHeight() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
     {
@@ -67,6 +69,8 @@ public:
         mSmallCube = std::make_unique<Dazzle::Cube>(0.45f);
         mSmallCube->InitializeBuffers();
 
+        InitializeInstances();
+
         // -----------------------------------------------------------------------------------------
         // Shader Program
         InitializeShaderProgram();
@@ -81,9 +85,14 @@ public:
 
     void Render() override
     {
+        // Uniform blocks of this frame are written to its own region of the ring buffer
+        mUniforms.BeginFrame();
+
         ClearBuffers();
         Pass1();
         Pass2();
+
+        mUniforms.EndFrame();
     }
 
     void KeyCallback(int key, int scancode, int action, int mods) override {}
@@ -103,62 +112,20 @@ private:
     void DrawScene()
     {
         UpdateUniforms(mCamera->GetTransform(), mCamera->GetProjection());
+        // Instance transforms already place every cube in the scene
+        UpdateMatrices(glm::mat4(1.0f));
+
         UpdateMaterial(mSmallCubeMaterial);
-        for (int i = 0; i <= 6; i++)
-        {
-            for (int j = 0; j <= 6; j++)
-            {
-                for (int k = 0; k <= 6; k++)
-                {
-                    if ((i + j + k) % 2 == 0)
-                    {
-                        mSmallCube->SetPosition(glm::vec3(i - 3.0, j - 3.0, k - 3.0));
-                        UpdateMatrices(mShader, mSmallCube->GetTransform());
-                        mSmallCube->Draw();
-                    }
-                }
-            }
-        }
+        mSmallCube->DrawInstanced();
 
         UpdateMaterial(mBigCubeMaterial);
-        mBigCube->SetPosition(glm::vec3(-1.75f, -1.75f, 1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(-1.75f, -1.75f, -1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(-1.75f, 1.75f, 1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(-1.75f, 1.75f, -1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(1.75f, 1.75f, 1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(1.75f, 1.75f, -1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(1.75f, -1.75f, 1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
-        mBigCube->SetPosition(glm::vec3(1.75f, -1.75f, -1.75f));
-        UpdateMatrices(mShader, mBigCube->GetTransform());
-        mBigCube->Draw();
+        mBigCube->DrawInstanced();
     }
 
     void DrawQuad()
     {
-        // Update Matrices
-        auto model = mQuad->GetTransform();
-        auto view = glm::mat4(1.0f);
-        auto projection = glm::mat4(1.0f);
-        auto modelView = view * model;
-        auto MVP = projection * modelView;
-        auto normal = glm::transpose(glm::inverse(glm::mat3(modelView)));
-        glUniformMatrix4fv(mShader.mLocations.at("ModelView"), 1, GL_FALSE, glm::value_ptr(modelView));
-        glUniformMatrix4fv(mShader.mLocations.at("MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
-        glUniformMatrix3fv(mShader.mLocations.at("Normal"), 1, GL_FALSE, glm::value_ptr(normal));
+        // Update Matrices, the quad is already in clip space
+        UpdateMatrices(mQuad->GetTransform(), glm::mat4(1.0f), glm::mat4(1.0f));
 
         // Draw
         mQuad->Draw();
@@ -188,43 +155,33 @@ private:
         DrawQuad();
     }
 
-    void UpdateMatrices(const ShaderProgram& shader, glm::mat4 model)
+    void UpdateMatrices(const glm::mat4& model)
     {
-        glm::mat4 view = mCamera->GetTransform();
-        glm::mat4 projection = mCamera->GetProjection();
-
-        mModelView = view * model;
-        mMVP = projection * mModelView;
-        mNormalMtx = glm::transpose(glm::inverse(glm::mat3(mModelView)));
-
-        auto location = shader.mLocations.find("Model");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(model));
-
-        location = shader.mLocations.find("ModelView");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mModelView));
-
-        location = shader.mLocations.find("MVP");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mMVP));
+        UpdateMatrices(model, mCamera->GetTransform(), mCamera->GetProjection());
+    }
 
-        location = shader.mLocations.find("Normal");
-        if (location != shader.mLocations.end())
-           glUniformMatrix3fv(location->second, 1, GL_FALSE, glm::value_ptr(mNormalMtx));
+    void UpdateMatrices(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection)
+    {
+        auto object = Dazzle::RenderSystem::GL::ObjectUniforms::Create(model, view, projection);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kObjectBlockBinding, object);
     }
 
     void UpdateUniforms(const glm::mat4& viewTransform, const glm::mat4& viewProjection)
     {
-        glm::vec4 lightPosition;
-        lightPosition = viewTransform * mLightPosition;
-        glUniform4fv(mShader.mLocations.at("light.mPosition"), 1, glm::value_ptr(lightPosition));
+        Dazzle::RenderSystem::GL::FrameUniforms frame = {};
+        frame.mView = viewTransform;
+        frame.mProjection = viewProjection;
+        frame.mLightCount = 1;
+        // Light Position in View Coordinates
+        frame.mLights[0].mPosition = viewTransform * mLightPosition;
+        frame.mLights[0].mIntensity = glm::vec3(0.9f);
+
+        mUniforms.Push(Dazzle::RenderSystem::GL::kFrameBlockBinding, frame);
     }
 
     void UpdateMaterial(const Material& material)
     {
-        glUniform4fv(mShader.mLocations.at("material.mAmbient"), 1, glm::value_ptr(material.mAmbient));
-        glUniform4fv(mShader.mLocations.at("material.mDiffuse"), 1, glm::value_ptr(material.mDiffuse));
+        mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, material);
     }
 
     void ClearBuffers()
@@ -242,28 +199,15 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\OIT.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\OIT.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+
+        // Per-frame, per-object and material uniform blocks
+        mUniforms.Initialize(64 * 1024);
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
-        mShader.mLocations["ModelView"] = glGetUniformLocation(handle, "ModelView");
-        mShader.mLocations["MVP"] = glGetUniformLocation(handle, "MVP");
-        mShader.mLocations["Normal"] = glGetUniformLocation(handle, "Normal");
-
-        mShader.mLocations["light.mIntensity"] = glGetUniformLocation(handle, "light.mIntensity");
-        mShader.mLocations["light.mPosition"] = glGetUniformLocation(handle, "light.mPosition");
-
-        mShader.mLocations["material.mAmbient"] = glGetUniformLocation(handle, "material.mAmbient");
-        mShader.mLocations["material.mDiffuse"] = glGetUniformLocation(handle, "material.mDiffuse");
-
         mShader.mLocations["MaxNodes"] = glGetUniformLocation(handle, "MaxNodes");
         mSubroutinePass1 = glGetSubroutineIndex(handle, GL_FRAGMENT_SHADER, "Pass1");
         mSubroutinePass2 = glGetSubroutineIndex(handle, GL_FRAGMENT_SHADER, "Pass2");
@@ -275,10 +219,6 @@ private:
 
     void InitializeUniforms()
     {
-        // Lights
-        glUniform3fv(mShader.mLocations.at("light.mIntensity"), 1, glm::value_ptr(glm::vec3(0.9f)));
-        glUniform4fv(mShader.mLocations.at("light.mPosition"), 1, glm::value_ptr(glm::vec4(10.0f, 10.0f, 10.0f, 1.0f)));
-
         // Materials
         mBigCubeMaterial.mAmbient = glm::vec4(0.0f);
         mBigCubeMaterial.mDiffuse = glm::vec4(0.9f, 0.2f, 0.2f, 0.4f);
@@ -287,6 +227,36 @@ private:
         mSmallCubeMaterial.mDiffuse = glm::vec4(0.2f, 0.2f, 0.9f, 0.55f);
     }
 
+    void InitializeInstances()
+    {
+        // Small cubes on every other cell of a 7x7x7 grid
+        std::vector<glm::mat4> transforms;
+        for (int i = 0; i <= 6; i++)
+        {
+            for (int j = 0; j <= 6; j++)
+            {
+                for (int k = 0; k <= 6; k++)
+                {
+                    if ((i + j + k) % 2 == 0)
+                        transforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(i - 3.0f, j - 3.0f, k - 3.0f)));
+                }
+            }
+        }
+        mSmallCube->SetInstanceTransforms(transforms);
+
+        // Big cubes on the corners of the grid
+        transforms.clear();
+        for (float x : {-1.75f, 1.75f})
+        {
+            for (float y : {-1.75f, 1.75f})
+            {
+                for (float z : {1.75f, -1.75f})
+                    transforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)));
+            }
+        }
+        mBigCube->SetInstanceTransforms(transforms);
+    }
+
     void InitializeShaderStorage()
     {
         GLuint maxNodes = mWidth * mHeight * 20;
@@ -317,6 +287,7 @@ private:
 
     // Shading Programs
     ShaderProgram mShader;
+    Dazzle::RenderSystem::GL::UniformRingBuffer mUniforms;
     // Subroutine Indices
     GLuint mSubroutinePass1 = 0;
     GLuint mSubroutinePass2 = 0;
@@ -340,10 +311,6 @@ private:
     GLuint mClearBuffer;
 
     glm::vec4 mLightPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-    glm::mat4 mMVP;
-    glm::mat4 mModelView;
-    glm::mat3 mNormalMtx;
 };
 
 class UIOIT : public IUserInterface
@@ -7,18 +7,24 @@ layout(location = 0) out vec4 FragmentColor;
 
 struct Light
 {
-    vec3 mIntensity;            // (vec3) Ambient Intensity
     vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Not used by this shader
+    vec3 mIntensity;            // (vec3) Diffuse Intensity
 };
 
-struct Material
+layout(std140, binding = 0) uniform FrameBlock
 {
-    vec4 mAmbient;              // (vec3) Ambient Reflectivity
-    vec4 mDiffuse;              // (vec3) Diffuse Reflectivity
+    mat4 View;
+    mat4 Projection;
+    Light lights[4];            // Lights source data, only the first one is used
+    int LightCount;
 };
 
-uniform Light light; // Lights source data
-uniform Material material; // Material properties
+layout(std140, binding = 2) uniform MaterialBlock
+{
+    vec4 mAmbient;              // (vec4) Ambient Reflectivity
+    vec4 mDiffuse;              // (vec4) Diffuse Reflectivity, alpha is the opacity
+} material; // Material properties
 
 
 
@@ -41,6 +47,7 @@ layout( binding = 0, std430 ) buffer LinkedLists { NodeType mNodes[]; };
 
 vec3 Diffuse()
 {
+    Light light = lights[0];
     vec3 surfacePointToLightPoint = normalize(light.mPosition.xyz - Position);
     vec3 surfaceNormal = normalize(NormalVector);
 
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -9,8 +11,10 @@
 #include "RenderSystem.hpp"
 #include "FileManager.hpp"
 #include "Plane.hpp"
+#include "RenderQueue.hpp"
 #include "Sphere.hpp"
 #include "Torus.hpp"
+#include "UniformBuffer.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
@@ -20,30 +24,14 @@
 class ScenePBR : public IScene
 {
 public:
-    struct LightUniforms
+    // Submission strategies compared by the statistics
+    enum class DrawMode
     {
-        GLuint mPosition;   // (vec4) Light Position In View Coordinates
-        GLuint mIntensity;  // (vec3) Intensity
+        PerObject = 0,          // The plane and the torus one draw call each, the spheres one instanced draw call
+        MultiDrawIndirect = 1   // Every object of the render queue with a single glMultiDrawElementsIndirect call
     };
 
-    struct UniformLocations
-    {
-        GLuint mMVP;        // (mat4) Model View Projection
-        GLuint mModelView;  // (mat4) Model View
-        GLuint mNormal;     // (mat3) Normal
-
-        // Lights
-        LightUniforms mLights[3];
-
-        // Material
-        GLuint mRoughness;     // (float) Material's Roughness
-        GLuint mMetal;         // (bool) Metal or Dielectric
-        GLuint mColor;         // (vec3) Material's Color
-    };
-
-
-    ScenePBR() :    mMVP(), mModelView(), mNormalMtx(), mLocations(),
-                    mLights(), mTorusMaterial() {}
+    ScenePBR() :    mLights(), mTorusMaterial() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
     {
@@ -62,46 +50,37 @@ public:
 
         mSphere = std::make_unique<Dazzle::Sphere>(0.5f, 128, 128, 0.0f, glm::pi<float>(), 0.0f, glm::two_pi<float>());
         mSphere->SetPosition(glm::vec3(0.0f, 0.0f, 0.0f));
+        mSphere->GenerateLODs();
         mSphere->InitializeBuffers();
+        InitializeSphereInstances();
 
         mTorus = std::make_unique<Dazzle::Torus>(0.5f, 0.25f, 128, 128, 0.0f, glm::two_pi<float>(), 0.0f, glm::two_pi<float>());
         mTorus->SetPosition(glm::vec3(0.0f, 0.0f, 1.0f));
         mTorus->InitializeBuffers();
 
+        InitializeRenderQueue();
+
         // -----------------------------------------------------------------------------------------
         // Shader Program
         // Get the source code for shaders
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\PBR.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\PBR.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program objects, loaded from the shader cache when possible.
+        // Both are submitted before waiting, so the driver can compile them in parallel.
+        Dazzle::RenderSystem::GL::AsyncProgramBuilder builder;
         mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {&glVSO, &glFSO});
-
-        // Get Uniforms
-        mLocations.mMVP = glGetUniformLocation(mProgram.GetHandle(), "MVP");
-        mLocations.mModelView = glGetUniformLocation(mProgram.GetHandle(), "ModelView");
-        mLocations.mNormal = glGetUniformLocation(mProgram.GetHandle(), "Normal");
-        // Uniforms - Lights
-        mLocations.mLights[0].mPosition = glGetUniformLocation(mProgram.GetHandle(), "light[0].Position");
-        mLocations.mLights[0].mIntensity = glGetUniformLocation(mProgram.GetHandle(), "light[0].Intensity");
-        mLocations.mLights[1].mPosition = glGetUniformLocation(mProgram.GetHandle(), "light[1].Position");
-        mLocations.mLights[1].mIntensity = glGetUniformLocation(mProgram.GetHandle(), "light[1].Intensity");
-        mLocations.mLights[2].mPosition = glGetUniformLocation(mProgram.GetHandle(), "light[2].Position");
-        mLocations.mLights[2].mIntensity = glGetUniformLocation(mProgram.GetHandle(), "light[2].Intensity");
-        // Uniforms - Material
-        mLocations.mRoughness = glGetUniformLocation(mProgram.GetHandle(), "material.Roughness");
-        mLocations.mMetal = glGetUniformLocation(mProgram.GetHandle(), "material.Metal");
-        mLocations.mColor = glGetUniformLocation(mProgram.GetHandle(), "material.Color");
-
-        // Use Program Shader
-        glUseProgram(mProgram.GetHandle());
+        builder.Add(mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+
+        // Program used by the multi-draw, fetches transforms and material indices with gl_BaseInstance
+        auto multiDrawVSSC = Dazzle::FileManager::ReadFile("shaders\\PBRMultiDraw.vs.glsl");
+        mMultiDrawProgram.Initialize();
+        builder.Add(mMultiDrawProgram, {{GL_VERTEX_SHADER, multiDrawVSSC}, {GL_FRAGMENT_SHADER, FSSC}});
+        builder.Wait();
+
+        // Per-frame, per-object and material uniform blocks
+        mUniforms.Initialize(64 * 1024);
+
         glEnable(GL_DEPTH_TEST);
         glEnable(GL_CULL_FACE);
         glCullFace(GL_BACK);
@@ -113,60 +92,22 @@ public:
     {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::mat4 model;
+        // Uniform blocks of this frame are written to its own region of the ring buffer
+        mUniforms.BeginFrame();
 
-        // Lights
+        // Camera and Lights
         UpdateLights();
 
-        // Plane
-        const glm::vec3 planeColor(0.2f);
-        const float planeRoughness = 0.9f;
-        UpdateMaterial(planeRoughness, false, planeColor);
-        UpdateMatrices(mPlane->GetTransform());
-        mPlane->Draw();
-
-        // Dielectric Objects
-        const bool isMetal = false;
-        const unsigned int numObjects = 9;
-        const glm::vec3 baseColor(0.1f, 0.33f, 0.17f);
-        for (unsigned int i = 0; i < numObjects; i++)
-        {
-            float roughness = (i + 1) * (1.0f / numObjects);
-            UpdateMaterial(roughness, isMetal, baseColor);
+        // The whole submission is timed on the CPU to compare the draw modes
+        auto start = std::chrono::steady_clock::now();
+        if (mDrawMode == DrawMode::PerObject)
+            DrawPerObject();
+        else
+            DrawMultiDrawIndirect();
+        std::chrono::duration<double, std::micro> submitTime = std::chrono::steady_clock::now() - start;
+        mSubmitTime = submitTime.count();
 
-            float deltaX = i * (10.0f / (numObjects - 1)) - 5.0f;
-            model = mSphere->GetTransform();
-            model = glm::translate(model, glm::vec3(deltaX, 2.0f, -2.0f));
-            UpdateMatrices(model);
-
-            mSphere->Draw();
-        }
-
-        // Metallic Objects
-        model = mSphere->GetTransform();
-        UpdateMaterial(kGold);
-        UpdateMatrices(glm::translate(model, glm::vec3(-3.0f, 1.0f, -1.0f)));
-        mSphere->Draw();
-
-        UpdateMaterial(kCopper);
-        UpdateMatrices(glm::translate(model, glm::vec3(-1.5f, 1.0f, -1.0f)));
-        mSphere->Draw();
-
-        UpdateMaterial(kAluminum);
-        UpdateMatrices(glm::translate(model, glm::vec3(0.0f, 1.0f, -1.0f)));
-        mSphere->Draw();
-
-        UpdateMaterial(kTitanium);
-        UpdateMatrices(glm::translate(model, glm::vec3(1.5f, 1.0f, -1.0f)));
-        mSphere->Draw();
-
-        UpdateMaterial(kSilver);
-        UpdateMatrices(glm::translate(model, glm::vec3(3.0f, 1.0f, -1.0f)));
-        mSphere->Draw();
-
-        UpdateMaterial(mTorusMaterial);
-        UpdateMatrices(mTorus->GetTransform());
-        mTorus->Draw();
+        mUniforms.EndFrame();
     }
 
     void SetLight(float position[3], float intensity[3], int type, size_t idx)
@@ -177,6 +118,8 @@ public:
             mLights[idx].mPosition.w = 0.0f;
     }
 
+    void SetDrawMode(DrawMode mode) { mDrawMode = mode; }
+
     void SetTorusMaterial(float color[3], float roughness, bool isMetal)
     {
         mTorusMaterial.mColor = glm::vec3(color[0], color[1], color[2]);
@@ -184,6 +127,16 @@ public:
         mTorusMaterial.mIsMetal = isMetal;
     }
 
+    // Average CPU time (in microseconds) spent per sphere during the last frame, drawn per object
+    double GetSphereDrawTime() const { return mSphereDrawTime; }
+    // CPU time (in microseconds) spent submitting the whole scene during the last frame
+    double GetSubmitTime() const { return mSubmitTime; }
+    unsigned int GetDrawCalls() const { return mDrawCalls; }
+    GLsizei GetObjectCount() const { return mQueue.GetObjectCount(); }
+    const Dazzle::RenderSystem::GL::VertexMemoryReport& GetSphereMemoryReport() const { return mSphere->GetMemoryReport(); }
+    unsigned int GetSphereLOD() const { return mSphere->GetLOD(); }
+    unsigned int GetSphereLODCount() const { return mSphere->GetLODCount(); }
+
     void KeyCallback(int key, int scancode, int action, int mods) override {}
     void CursorCallback(double xPosition, double yPosition) override {}
     void FramebufferResizeCallback(int width, int height) override { glViewport(0, 0, width, height); }
@@ -195,72 +148,183 @@ private:
         glm::vec3 mIntensity;
     };
 
+    // std430 layout of an element of the MaterialBlock storage buffer
     struct Material
     {
         glm::vec3 mColor;
         float mRoughness;
-        bool mIsMetal;
+        GLint mIsMetal;
+        GLint mPadding[3];
     };
+    static_assert(sizeof(Material) == 32, "Material must match the std430 layout of the shader's Material");
+
+    void DrawPerObject()
+    {
+        glUseProgram(mProgram.GetHandle());
+
+        // Plane
+        UpdateMaterial(kPlaneMaterial);
+        UpdateMatrices(mPlane->GetTransform());
+        mPlane->Draw();
+
+        // Sphere draws are timed on the CPU to track the per-draw submission cost.
+        auto sphereStart = std::chrono::steady_clock::now();
+
+        // Dielectric and Metallic Objects, a single instanced draw with one material per instance
+        UpdateMaterials(mSphereMaterials);
+        UpdateMatrices(mSphere->GetTransform());
+        SelectSphereLOD();
+        mSphere->DrawInstanced();
+
+        std::chrono::duration<double, std::micro> sphereTime = std::chrono::steady_clock::now() - sphereStart;
+        mSphereDrawTime = sphereTime.count() / mSphere->GetInstanceCount();
+
+        UpdateMaterial(mTorusMaterial);
+        UpdateMatrices(mTorus->GetTransform());
+        mTorus->Draw();
+
+        mDrawCalls = 3;
+    }
+
+    // The materials of the queue follow its objects: the plane, the spheres, then the torus. The queue keeps the
+    // full resolution spheres, the LODs only apply to the per object draws.
+    void DrawMultiDrawIndirect()
+    {
+        glUseProgram(mMultiDrawProgram.GetHandle());
+
+        mQueueMaterials.back() = mTorusMaterial;
+        UpdateMaterials(mQueueMaterials);
+        mQueue.Upload();
+        mQueue.Submit();
+
+        mDrawCalls = 1;
+    }
+
+    void InitializeRenderQueue()
+    {
+        mQueue.Initialize();
+        const unsigned int plane = mQueue.AddGeometry(*mPlane);
+        const unsigned int sphere = mQueue.AddGeometry(*mSphere);
+        const unsigned int torus = mQueue.AddGeometry(*mTorus);
+
+        mQueueMaterials.clear();
+        mQueue.AddObject(plane, mPlane->GetTransform(), static_cast<GLuint>(mQueueMaterials.size()));
+        mQueueMaterials.push_back(kPlaneMaterial);
+        for (size_t i = 0; i < mSphereTransforms.size(); i++)
+        {
+            mQueue.AddObject(sphere, mSphere->GetTransform() * mSphereTransforms[i], static_cast<GLuint>(mQueueMaterials.size()));
+            mQueueMaterials.push_back(mSphereMaterials[i]);
+        }
+        mQueue.AddObject(torus, mTorus->GetTransform(), static_cast<GLuint>(mQueueMaterials.size()));
+        mQueueMaterials.push_back(mTorusMaterial);
+    }
 
     void UpdateMaterial(float roughness, bool isMetal, glm::vec3 color)
     {
-        glUniform1f(mLocations.mRoughness, roughness);
-        glUniform1i(mLocations.mMetal, isMetal);
-        glUniform3f(mLocations.mColor, color.r, color.g, color.b);
+        UpdateMaterial({color, roughness, isMetal});
     }
 
-    void UpdateMaterial(Material material)
+    void UpdateMaterial(const Material& material)
     {
-        glUniform1f(mLocations.mRoughness, material.mRoughness);
-        glUniform1i(mLocations.mMetal, material.mIsMetal);
-        glUniform3f(mLocations.mColor, material.mColor.r, material.mColor.g, material.mColor.b);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, material, GL_SHADER_STORAGE_BUFFER);
     }
 
-    void UpdateLights()
+    // Instance i of the next instanced draw is shaded with materials[i]
+    void UpdateMaterials(const std::vector<Material>& materials)
     {
-        glm::mat4 view = mCamera->GetTransform();
+        GLsizeiptr size = static_cast<GLsizeiptr>(materials.size() * sizeof(Material));
+        GLintptr offset = mUniforms.Write(materials.data(), size);
+        mUniforms.Bind(Dazzle::RenderSystem::GL::kMaterialBlockBinding, offset, size, GL_SHADER_STORAGE_BUFFER);
+    }
 
-        // Light Position in View Coordinates
-        for (size_t i = 0; i < mLights.size(); i++)
-            mLights[i].mPosition = view * mLights[i].mPosition;
+    void InitializeSphereInstances()
+    {
+        std::vector<glm::mat4> transforms;
 
-        for (size_t i = 0; i < mLights.size(); i++)
+        // Dielectric Objects
+        const bool isMetal = false;
+        const unsigned int numObjects = 9;
+        const glm::vec3 baseColor(0.1f, 0.33f, 0.17f);
+        for (unsigned int i = 0; i < numObjects; i++)
         {
-            glUniform4f(mLocations.mLights[i].mPosition, mLights[i].mPosition.x, mLights[i].mPosition.y, mLights[i].mPosition.z, mLights[i].mPosition.w);
-            glUniform3f(mLocations.mLights[i].mIntensity, mLights[i].mIntensity.r, mLights[i].mIntensity.g, mLights[i].mIntensity.b);
+            float roughness = (i + 1) * (1.0f / numObjects);
+            float deltaX = i * (10.0f / (numObjects - 1)) - 5.0f;
+            transforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(deltaX, 2.0f, -2.0f)));
+            mSphereMaterials.push_back({baseColor, roughness, isMetal});
         }
+
+        // Metallic Objects
+        const Material metals[] = {kGold, kCopper, kAluminum, kTitanium, kSilver};
+        for (unsigned int i = 0; i < 5; i++)
+        {
+            transforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f + i * 1.5f, 1.0f, -1.0f)));
+            mSphereMaterials.push_back(metals[i]);
+        }
+
+        mSphere->SetInstanceTransforms(transforms);
+        mSphereTransforms = transforms;
     }
 
-    void UpdateMatrices(glm::mat4 model)
+    // All the instances are drawn at the level the closest one needs
+    void SelectSphereLOD()
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        const glm::mat4 modelView = mCamera->GetTransform() * mSphere->GetTransform();
+        unsigned int level = mSphere->GetLODCount();
+        for (const auto& transform : mSphereTransforms)
+            level = std::min(level, mSphere->SelectLOD(modelView * transform, mCamera->GetProjection(), static_cast<float>(viewport[3])));
+        mSphere->SetLOD(level);
+    }
+
+    void UpdateLights()
     {
         glm::mat4 view = mCamera->GetTransform();
-        glm::mat4 projection = mCamera->GetProjection();
 
-        mModelView = view * model;
-        mMVP = projection * mModelView;
-        mNormalMtx = glm::transpose(glm::inverse(mModelView));
+        Dazzle::RenderSystem::GL::FrameUniforms frame = {};
+        frame.mView = view;
+        frame.mProjection = mCamera->GetProjection();
+        frame.mLightCount = static_cast<GLint>(mLights.size());
+        for (size_t i = 0; i < mLights.size(); i++)
+        {
+            // Light Position in View Coordinates
+            frame.mLights[i].mPosition = view * mLights[i].mPosition;
+            frame.mLights[i].mIntensity = mLights[i].mIntensity;
+        }
+
+        mUniforms.Push(Dazzle::RenderSystem::GL::kFrameBlockBinding, frame);
+    }
 
-        glUniformMatrix4fv(mLocations.mMVP, 1, GL_FALSE, glm::value_ptr(mMVP));
-        glUniformMatrix4fv(mLocations.mModelView, 1, GL_FALSE, glm::value_ptr(mModelView));
-        glUniformMatrix3fv(mLocations.mNormal, 1, GL_FALSE, glm::value_ptr(mNormalMtx));
+    void UpdateMatrices(glm::mat4 model)
+    {
+        auto object = Dazzle::RenderSystem::GL::ObjectUniforms::Create(model, mCamera->GetTransform(), mCamera->GetProjection());
+        mUniforms.Push(Dazzle::RenderSystem::GL::kObjectBlockBinding, object);
     }
 
     Dazzle::RenderSystem::GL::ProgramObject mProgram;
+    Dazzle::RenderSystem::GL::ProgramObject mMultiDrawProgram;
+    Dazzle::RenderSystem::GL::RenderQueue mQueue;
     std::unique_ptr<Dazzle::Sphere> mSphere;
     std::unique_ptr<Dazzle::Plane> mPlane;
     std::unique_ptr<Dazzle::Torus> mTorus;
     std::shared_ptr<Camera> mCamera;
-    UniformLocations mLocations;
+    Dazzle::RenderSystem::GL::UniformRingBuffer mUniforms;
 
-    glm::mat4 mMVP;
-    glm::mat4 mModelView;
-    glm::mat3 mNormalMtx;
+    DrawMode mDrawMode = DrawMode::PerObject;
+    unsigned int mDrawCalls = 0;
+    double mSphereDrawTime = 0.0;
+    double mSubmitTime = 0.0;
+    std::vector<glm::mat4> mSphereTransforms;   // One per sphere instance
 
     // Lights
     std::array<Light, 3> mLights;
 
     // Materials
     Material mTorusMaterial;
+    std::vector<Material> mSphereMaterials;     // One per sphere instance
+    std::vector<Material> mQueueMaterials;      // One per object of the render queue
+    const Material kPlaneMaterial = { glm::vec3(0.2f), 0.9f, false };
     const Material kGold = { glm::vec3(1.0f, 0.71f, 0.29f), 0.43f, true };
     const Material kCopper = { glm::vec3(0.95f, 0.64f, 0.54f), 0.43f, true };
     const Material kAluminum = { glm::vec3(0.91f, 0.92f, 0.92f), 0.43f, true };
@@ -298,6 +362,8 @@ public:
         ImGui::SeparatorText("Physically Based Rendering");
         ImGui::NewLine();
 
+        ImGui::Text("Draw Mode:"); ImGui::SameLine(); ImGui::Combo("##DrawMode", &mDrawMode, "Per Object (3 draw calls, instanced spheres)\0" "Multi-Draw Indirect (1 draw call)\0");
+
         if (ImGui::CollapsingHeader("Lights"))
         {
             ImGui::Text("L[0] Position:"); ImGui::SameLine();  ImGui::DragFloat3("##Light[0] Position", mLights[0].mPosition.data(), 0.1f, -10.0f, 10.0f);
@@ -321,6 +387,20 @@ public:
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
         ImGui::Text("Yaw: %.2f, Pitch: %.2f", cameraYaw, cameraPitch);
+
+        // Statistics
+        ImGui::SeparatorText("Statistics");
+        if (mScene)
+        {
+            const auto& memory = mScene->GetSphereMemoryReport();
+            ImGui::Text("Objects: %d, Draw Calls: %u", mScene->GetObjectCount(), mScene->GetDrawCalls());
+            ImGui::Text("Scene Submission CPU Time: %.2f us", mScene->GetSubmitTime());
+            ImGui::Text("Sphere (128x128) Draw CPU Time: %.2f us", mScene->GetSphereDrawTime());
+            ImGui::Text("Sphere LOD: %u of %u", mScene->GetSphereLOD(), mScene->GetSphereLODCount());
+            ImGui::Text("Sphere Vertex Memory: %.1f KB (%u buffers) -> %.1f KB (%u buffers)",
+                        memory.mBytesBefore / 1024.0, memory.mBufferObjectsBefore,
+                        memory.mBytesAfter / 1024.0, memory.mBufferObjectsAfter);
+        }
         ImGui::End();
 
         // Set data to the scene
@@ -332,6 +412,8 @@ public:
                 mScene->SetLight(mLights[i].mPosition.data(), mLights[i].mIntensity.data(), mLights[i].mType, i);
             }
 
+            mScene->SetDrawMode(static_cast<ScenePBR::DrawMode>(mDrawMode));
+
             // Torus
             mScene->SetTorusMaterial(mTorusMaterial.mColor.data(), mTorusMaterial.mRoughness, mTorusMaterial.mIsMetal);
         }
@@ -369,6 +451,7 @@ private:
     ScenePBR* mScene = nullptr;
     Camera* mCamera = nullptr;
     std::once_flag mInitFlag;
+    int mDrawMode = 0;
 
     struct Light
     {
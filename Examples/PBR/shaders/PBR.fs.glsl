@@ -2,22 +2,40 @@
 
 in vec3 Position;
 in vec3 NormalVector;
+flat in int InstanceID;
 out vec4 FragmentColor;
 
 const float PI = 3.14159265358979323846;
 
-uniform struct Light
+struct Light
 {
-    vec4 Position;
-    vec3 Intensity; // Intensity + Color
-} light[3];
+    vec4 mPosition;     // Light Position In View Coordinates
+    vec3 mAmbient;      // Not used by this shader
+    vec3 mIntensity;    // Intensity + Color
+};
 
-uniform struct Material
+layout(std140, binding = 0) uniform FrameBlock
 {
+    mat4 View;
+    mat4 Projection;
+    Light light[4];
+    int LightCount;
+};
+
+struct Material
+{
+    vec3 Color;
     float Roughness;
     bool Metal;
-    vec3 Color;
-} material;
+};
+
+// One material per instance, non-instanced draws bind a single one
+layout(std430, binding = 2) readonly buffer MaterialBlock
+{
+    Material materials[];
+};
+
+Material material;  // Material of the current instance
 
 // (D) Microgeometry Normal Distribution Function: Based on Trowbridge and Reitz a.k.a GGX
 // Approximates the amount the surface's microfacets are aligned to the halfway vector,
@@ -58,17 +76,17 @@ vec3 MicrofacetModel(vec3 position, vec3 n, int idx)
         diffuseBRDF = material.Color;
 
     vec3 l = vec3(0.0);
-    vec3 lightIntensity = light[idx].Intensity;
+    vec3 lightIntensity = light[idx].mIntensity;
 
     // Directional Light
-    if (light[idx].Position.w == 0.0)
+    if (light[idx].mPosition.w == 0.0)
     {
-        l = normalize(light[idx].Position.xyz);
+        l = normalize(light[idx].mPosition.xyz);
     }
     // Positional Light
     else
     {
-        l = light[idx].Position.xyz - position; // Surface Point to Light Point
+        l = light[idx].mPosition.xyz - position; // Surface Point to Light Point
         float dist = length(l);                 // Distance from Surface Point to Light Point
         l = normalize(l);
         lightIntensity /= (dist * dist);        // Attenuation according distance
@@ -87,9 +105,11 @@ vec3 MicrofacetModel(vec3 position, vec3 n, int idx)
 
 void main()
 {
+    material = materials[InstanceID];
+
     vec3 summation = vec3(0.0);
     vec3 normal = normalize(NormalVector);
-    for (int i = 0; i < 3; i++)
+    for (int i = 0; i < LightCount; i++)
     {
         summation += MicrofacetModel(Position, normal, i);
     }
@@ -2,18 +2,28 @@
 
 layout (location = 0) in vec3 VertexPosition;
 layout (location = 1) in vec3 VertexNormalVector;
+layout (location = 5) in mat4 InstanceTransform;  // Identity when the object isn't instanced
 
 out vec3 Position;
 out vec3 NormalVector;
+flat out int InstanceID;
 
-uniform mat4 MVP;        // (mat4) Model View Projection
-uniform mat4 ModelView;  // (mat4) Model View
-uniform mat3 Normal;     // (mat3) Normal
+layout(std140, binding = 1) uniform ObjectBlock
+{
+    mat4 Model;         // (mat4) Model
+    mat4 ModelView;     // (mat4) Model View
+    mat4 MVP;           // (mat4) Model View Projection
+    mat3 Normal;        // (mat3) Normal
+};
 
 void main(void)
 {
-    NormalVector = normalize( Normal * VertexNormalVector);
-    Position = (ModelView * vec4(VertexPosition,1.0)).xyz;
+    // Instance transforms are made of translations, rotations and uniform scales, mat3() is enough for normals
+    vec4 InstancePosition = InstanceTransform * vec4(VertexPosition, 1.0);
+
+    NormalVector = normalize( Normal * mat3(InstanceTransform) * VertexNormalVector);
+    Position = (ModelView * InstancePosition).xyz;
+    InstanceID = gl_InstanceID;
 
-    gl_Position = MVP * vec4(VertexPosition,1.0);
+    gl_Position = MVP * InstancePosition;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "App.hpp"
 #include "Camera.hpp"
 #include "Scene.hpp"
+#include "TextureCooker.hpp"
 #include "UserInterface.hpp"
 #include "Utils.hpp"
 
@@ -63,12 +64,8 @@ public:
 
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\ParallaxMapping.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\ParallaxMapping.fs.glsl");
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
         mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Uniforms - Parallax Mapping Shader Program
         mLocations.mMVP = glGetUniformLocation(mProgram.GetHandle(), "MVP");
@@ -85,9 +82,13 @@ public:
 
         // -----------------------------------------------------------------------------------------
         // Textures for this scene:
-        GLuint bricksDiffuse = CreateTexture("textures\\brick-color.png");
-        GLuint bricksNormalMap = CreateTexture("textures\\brick-normal.png");
-        GLuint bricksHeightMap = CreateTexture("textures\\brick-height.png");
+        // Cooked to BC1, BC5 and BC4 on the first run, the shader rebuilds the Z of the normals BC5 drops
+        GLuint bricksDiffuse = Utils::Texture::LoadCookedTexture({"textures\\brick-color.png"}, "textures\\brick-color.ktx2",
+                                                                 Dazzle::TextureFormat::BC1_RGB_UNORM, true);
+        GLuint bricksNormalMap = Utils::Texture::LoadCookedTexture({"textures\\brick-normal.png"}, "textures\\brick-normal.ktx2",
+                                                                   Dazzle::TextureFormat::BC5_UNORM, true, Utils::Texture::MipFilter::Normal);
+        GLuint bricksHeightMap = Utils::Texture::LoadCookedTexture({"textures\\brick-height.png"}, "textures\\brick-height.ktx2",
+                                                                   Dazzle::TextureFormat::BC4_UNORM, true, Utils::Texture::MipFilter::Data);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, bricksDiffuse);
         glActiveTexture(GL_TEXTURE1);
@@ -170,34 +171,6 @@ private:
         glUniform1i(mLocations.mMappingMode, mMappingMode);
     }
 
-    GLuint CreateTexture(const std::string& path, bool flip = true)
-    {
-        int width, height;
-        auto imageData = Utils::Texture::GetTextureData(path, width, height, flip);
-        GLuint texture = 0; // OpenGL Texture Object
-        if (imageData)
-        {
-            // Create texture
-            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-
-            // Set texture parameters
-            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-            // Explicitly state the base and max levels
-            glTextureParameteri(texture, GL_TEXTURE_BASE_LEVEL, 0);
-            glTextureParameteri(texture, GL_TEXTURE_MAX_LEVEL, 0);
-
-            // Set up texture storage
-            glTextureStorage2D(texture, 1, GL_RGBA8, width, height);
-
-            // Upload texture data
-            glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData.get());
-        }
-
-        return texture;
-    }
-
     Dazzle::RenderSystem::GL::ProgramObject mProgram;
     UniformLocations mLocations;
     std::shared_ptr<Camera> mCamera;
@@ -29,12 +29,12 @@ const int PARALLAX = 0;
 const int STEEP_PARALLAX = 1;
 uniform int MappingMode; // 0 = Parallax, 1 = Steep Parallax
 
-vec2 FindOffset(vec3 viewDirection, vec2 TexCoord, out float height)
+vec2 FindOffset(vec3 viewDirection, vec2 TexCoord, vec2 dx, vec2 dy, out float height)
 {
     if (MappingMode == PARALLAX) // Parallax
     {
         // Height value from Height Map
-        float heightFromMap = texture(HeightMapSampler, TexCoord).r;
+        float heightFromMap = textureGrad(HeightMapSampler, TexCoord, dx, dy).r;
         height = 1 - heightFromMap;
 
         // Calculate texture delta and apply offset to texture coordinates
@@ -54,18 +54,18 @@ vec2 FindOffset(vec3 viewDirection, vec2 TexCoord, out float height)
         // Initial Texture Coordinate value
         vec2 tc = TexCoord;
         // Initializing height
-        height = texture(HeightMapSampler, tc).r;
+        height = textureGrad(HeightMapSampler, tc, dx, dy).r;
         while (height < ht && ht > 0.0)
         {
             ht -= heightStep;
             tc -= deltaTexCoord;
-            height = texture(HeightMapSampler, tc).r;
+            height = textureGrad(HeightMapSampler, tc, dx, dy).r;
         }
         return tc;
     }
 }
 
-bool IsOccluded(vec3 lightDirection, vec2 TexCoord, float height)
+bool IsOccluded(vec3 lightDirection, vec2 TexCoord, vec2 dx, vec2 dy, float height)
 {
     const int nShadowSteps = int( mix(Steps, 10, abs(lightDirection.z) ) );
     // Value of the differential of each height delta
@@ -80,7 +80,7 @@ bool IsOccluded(vec3 lightDirection, vec2 TexCoord, float height)
     {
         ht += heightStep;
         tc += deltaTexCoord;
-        height = texture(HeightMapSampler, tc).r;
+        height = textureGrad(HeightMapSampler, tc, dx, dy).r;
     }
 
     return ht < 1.0;
@@ -92,17 +92,23 @@ vec3 BlinnPhongModel()
     vec3 surfacePointToCamera = normalize(ViewDirection);
     vec3 surfacePointToLightPoint = normalize(LightDirection);
 
+    // Derivatives of the original Texture Coordinates, implicit derivatives are undefined inside the
+    // non-uniform loops and jump across the offset Texture Coordinates
+    vec2 dx = dFdx(TextureCoordinates);
+    vec2 dy = dFdy(TextureCoordinates);
+
     // Calculate Texture Coordinates offset and height
     float height = 1.0;
-    vec2 textureCoord = FindOffset(surfacePointToCamera, TextureCoordinates, height);
+    vec2 textureCoord = FindOffset(surfacePointToCamera, TextureCoordinates, dx, dy, height);
 
     // Color from Diffuse Texture using modified Texture Coordinates
-    vec3 textureColor = texture(ColorTextureSampler, textureCoord).rgb;
+    vec3 textureColor = textureGrad(ColorTextureSampler, textureCoord, dx, dy).rgb;
 
     // Normal vector from Normal Map using modified Texture Coordinates
-    vec3 normalFromMap = texture(NormalMapSampler, textureCoord).xyz;
-    normalFromMap.xy = 2.0 * normalFromMap.xy - 1.0; // Convert range from [0, 1] to [-1, 1]
-    normalFromMap = normalize(normalFromMap);
+    // The map is BC5, two channels only, Z is rebuilt from the unit length
+    vec3 normalFromMap;
+    normalFromMap.xy = 2.0 * textureGrad(NormalMapSampler, textureCoord, dx, dy).rg - 1.0; // Convert range from [0, 1] to [-1, 1]
+    normalFromMap.z = sqrt(max(1.0 - dot(normalFromMap.xy, normalFromMap.xy), 0.0));
 
     // Lambertian Reflectance
     float sDotN = max( dot( surfacePointToLightPoint, normalFromMap ), 0.0 );
@@ -114,7 +120,7 @@ vec3 BlinnPhongModel()
     // Calculate Specular
     vec3 specular = vec3(0.0);
     // Only when using Steep Parallax: Check if fragment is occluded by another surface from the height map
-    bool isOccluded = (MappingMode == STEEP_PARALLAX) && IsOccluded(surfacePointToLightPoint, textureCoord, height);
+    bool isOccluded = (MappingMode == STEEP_PARALLAX) && IsOccluded(surfacePointToLightPoint, textureCoord, dx, dy, height);
     if (sDotN <= 0.0 || isOccluded)
     {
         // Light is not facing the surface or fragment is occluded. So, diffuse is zero
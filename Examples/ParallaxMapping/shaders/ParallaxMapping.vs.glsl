@@ -26,7 +26,7 @@ void main(void)
     vec3 normal = normalize( Normal * VertexNormalVector);
     vec3 tangent = normalize( Normal * vec3(VertexTangent));
     // Calculate Bitangent
-    vec3 bitangent = normalize( cross(normal, tangent) );
+    vec3 bitangent = normalize( cross(normal, tangent) ) * VertexTangent.w;
 
     // TBN: Matrix for transformation to tangent space.
     mat3 TBN = transpose(mat3( tangent, bitangent, normal ));
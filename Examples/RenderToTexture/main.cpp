@@ -238,13 +238,22 @@ private:
 
     void InitializeMesh(Dazzle::Mesh& mesh, const std::string& path)
     {
-        std::string name;
-        std::vector<float> vertices, normals, textureCoords;
-        Utils::Geom::GetMeshDataFromObj(path, name, vertices, normals, textureCoords);
-        mesh.SetName(name);
-        mesh.SetVertices(std::move(vertices));
-        mesh.SetNormals(std::move(normals));
-        mesh.SetTextureCoordinates(std::move(textureCoords));
+        // Every shape of the file, welded into a single indexed mesh
+        std::vector<Utils::Geom::ObjShape> shapes;
+        std::vector<Utils::Geom::ObjMaterial> materials;
+        if (!Utils::Geom::LoadObj(path, shapes, materials))
+            return;
+
+        Utils::Geom::ObjShape shape = Utils::Geom::MergeObjShapes(shapes);
+        mesh.SetName(shape.mName);
+        mesh.SetVertices(std::move(shape.mVertices));
+        mesh.SetNormals(std::move(shape.mNormals));
+        mesh.SetTextureCoordinates(std::move(shape.mTextureCoordinates));
+        mesh.SetIndices(std::move(shape.mIndices));
+
+        const Dazzle::MeshOptimizationReport& report = mesh.Optimize();
+        std::cout << path << ": ACMR " << report.mBefore.mACMR << " -> " << report.mAfter.mACMR
+                  << ", ATVR " << report.mBefore.mATVR << " -> " << report.mAfter.mATVR << std::endl;
     }
 
     void InitializeShaderProgram()
@@ -253,15 +262,9 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\RenderToTexture.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\RenderToTexture.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
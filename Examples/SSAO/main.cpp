@@ -1,4 +1,6 @@
 #include <array>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 #include <random>
 
@@ -11,8 +13,10 @@
 #include "FileManager.hpp"
 #include "Mesh.hpp"
 #include "Plane.hpp"
+#include "ShaderManager.hpp"
 #include "Sphere.hpp"
 #include "Torus.hpp"
+#include "UniformBuffer.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
@@ -71,14 +75,19 @@ public:
         Dazzle::RenderSystem::GL::ProgramObject mProgram;
     };
 
+    // std140 layout of the MaterialBlock uniform block
     struct Material
     {
         glm::vec3 mAmbient;
+        float mPadding0;
         glm::vec3 mDiffuse;
+        float mPadding1;
         glm::vec3 mSpecular;
         float mShininess;
-        bool mUseTexture;
+        GLint mUseTexture;
+        GLint mPadding2[3];
     };
+    static_assert(sizeof(Material) == 64, "Material must match the std140 layout of MaterialBlock");
 
     struct FramebufferConfig
     {
@@ -89,8 +98,7 @@ public:
         bool mUseDepthComponent;
     };
 
-    SceneSSAO() :  mMVP(), mModelView(), mNormalMtx(),
-                    mWidth(), mHeight() {}
+    SceneSSAO() :  mWidth(), mHeight() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
     {
@@ -114,8 +122,7 @@ public:
 
         mSuzanne = std::make_unique<Dazzle::Mesh>();
         mSuzanne->SetPosition(glm::vec3(0.0f, -1.0f, -5.0f));
-        InitializeMesh(*mSuzanne, "models\\suzanne.obj");
-        mSuzanne->InitializeBuffers();
+        LoadMesh(*mSuzanne, "models\\suzanne.obj", "models\\suzanne.dzmesh");
 
         mFloor = std::make_unique<Dazzle::Plane>(5.0f, 5.0f, 1, 1);
         mFloor->SetPosition(glm::vec3(0.0f, -2.5f, -5.0f));
@@ -134,8 +141,8 @@ public:
 
         // -----------------------------------------------------------------------------------------
         // Textures:
-        mWoodTexture = LoadTexture("textures\\hardwood.jpg");
-        mBrickTexture = LoadTexture("textures\\brick.jpg");
+        mWoodTexture = Utils::Texture::CreateTexture("textures\\hardwood.jpg", true);
+        mBrickTexture = Utils::Texture::CreateTexture("textures\\brick.jpg", true);
         mRandomTexture = CreateRandomRotationTexture();
 
         CreateTexture(mPositionTexture, GL_RGB32F, mWidth, mHeight);
@@ -184,15 +191,21 @@ public:
 
     void Update(double time) override
     {
-
+        // Swaps in the program once an edit of SSAO.vs.glsl or SSAO.fs.glsl has been rebuilt
+        mShaderManager.Update();
     }
 
     void Render() override
     {
+        // Uniform blocks of this frame are written to its own region of the ring buffer
+        mUniforms.BeginFrame();
+
         Pass1(); // Render Scene
         Pass2(); // SSAO Pass
         Pass3(); // Blur Pass
         Pass4(); // Lighting Pass
+
+        mUniforms.EndFrame();
     }
 
     void KeyCallback(int key, int scancode, int action, int mods) override {}
@@ -217,32 +230,25 @@ private:
         // Draw Floor
         glBindTextureUnit(5, mWoodTexture);
         UpdateMaterial(mWallsMaterial);
-        UpdateMatrices(mShader, mFloor->GetTransform());
+        UpdateMatrices(mFloor->GetTransform());
         mFloor->Draw();
 
         glBindTextureUnit(5, mBrickTexture);
-        UpdateMatrices(mShader, mLeftWall->GetTransform());
+        UpdateMatrices(mLeftWall->GetTransform());
         mLeftWall->Draw();
-        UpdateMatrices(mShader, mRightWall->GetTransform());
+        UpdateMatrices(mRightWall->GetTransform());
         mRightWall->Draw();
 
         UpdateMaterial(mSuzanneMaterial);
-        UpdateMatrices(mShader, mSuzanne->GetTransform());
+        UpdateMatrices(mSuzanne->GetTransform());
+        mSuzanne->SelectLOD(mCamera->GetTransform() * mSuzanne->GetTransform(), mCamera->GetProjection(), static_cast<float>(mHeight));
         mSuzanne->Draw();
     }
 
     void DrawQuad()
     {
-        // Update Matrices
-        auto model = mQuad->GetTransform();
-        auto view = glm::mat4(1.0f);
-        auto projection = glm::mat4(1.0f);
-        auto modelView = view * model;
-        auto MVP = projection * modelView;
-        auto normal = glm::transpose(glm::inverse(glm::mat3(modelView)));
-        glUniformMatrix4fv(mShader.mLocations.at("ModelView"), 1, GL_FALSE, glm::value_ptr(modelView));
-        glUniformMatrix4fv(mShader.mLocations.at("MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
-        glUniformMatrix3fv(mShader.mLocations.at("Normal"), 1, GL_FALSE, glm::value_ptr(normal));
+        // Update Matrices, the quad is already in clip space
+        UpdateMatrices(mQuad->GetTransform(), glm::mat4(1.0f), glm::mat4(1.0f));
 
         // Draw
         mQuad->Draw();
@@ -312,57 +318,38 @@ private:
         mQuad->Draw();
     }
 
-    void UpdateMatrices(const ShaderProgram& shader, glm::mat4 model)
+    void UpdateMatrices(const glm::mat4& model)
     {
-        glm::mat4 view = mCamera->GetTransform();
-        glm::mat4 projection = mCamera->GetProjection();
-
-        mModelView = view * model;
-        mMVP = projection * mModelView;
-        mNormalMtx = glm::transpose(glm::inverse(glm::mat3(mModelView)));
-
-        auto location = shader.mLocations.find("Model");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(model));
-
-        location = shader.mLocations.find("ModelView");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mModelView));
-
-        location = shader.mLocations.find("MVP");
-        if (location != shader.mLocations.end())
-           glUniformMatrix4fv(location->second, 1, GL_FALSE, glm::value_ptr(mMVP));
+        UpdateMatrices(model, mCamera->GetTransform(), mCamera->GetProjection());
+    }
 
-        location = shader.mLocations.find("Normal");
-        if (location != shader.mLocations.end())
-           glUniformMatrix3fv(location->second, 1, GL_FALSE, glm::value_ptr(mNormalMtx));
+    void UpdateMatrices(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection)
+    {
+        auto object = Dazzle::RenderSystem::GL::ObjectUniforms::Create(model, view, projection);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kObjectBlockBinding, object);
     }
 
     void UpdateUniforms(const glm::mat4& viewTransform, const glm::mat4& viewProjection)
     {
-        glm::vec4 lightPosition;
-        lightPosition = viewTransform * glm::vec4(3.0f, 3.0f, 1.5f, 1.0f);
-        glUniform4fv(mShader.mLocations.at("light.mPosition"), 1, glm::value_ptr(lightPosition));
-
-        glUniformMatrix4fv(mShader.mLocations.at("ProjectionMatrix"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+        Dazzle::RenderSystem::GL::FrameUniforms frame = {};
+        frame.mView = viewTransform;
+        frame.mProjection = viewProjection;
+        frame.mLightCount = 1;
+        // Light Position in View Coordinates
+        frame.mLights[0].mPosition = viewTransform * glm::vec4(3.0f, 3.0f, 1.5f, 1.0f);
+        frame.mLights[0].mAmbient = glm::vec3(0.2f);
+        frame.mLights[0].mIntensity = glm::vec3(1.0f);
+
+        mUniforms.Push(Dazzle::RenderSystem::GL::kFrameBlockBinding, frame);
     }
 
     void UpdateMaterial(const Material& material)
     {
-        glUniform3fv(mShader.mLocations.at("material.mAmbient"), 1, glm::value_ptr(material.mAmbient));
-        glUniform3fv(mShader.mLocations.at("material.mDiffuse"), 1, glm::value_ptr(material.mDiffuse));
-        glUniform3fv(mShader.mLocations.at("material.mSpecular"), 1, glm::value_ptr(material.mSpecular));
-        glUniform1f(mShader.mLocations.at("material.mShininess"), material.mShininess);
-        glUniform1i(mShader.mLocations.at("material.mUseTexture"), material.mUseTexture);
+        mUniforms.Push(Dazzle::RenderSystem::GL::kMaterialBlockBinding, material);
     }
 
     void InitializeUniforms()
     {
-        // Lights
-        glUniform3fv(mShader.mLocations.at("light.mAmbient"), 1, glm::value_ptr(glm::vec3(0.2f)));
-        glUniform3fv(mShader.mLocations.at("light.mDiffuseSpecular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform4fv(mShader.mLocations.at("light.mPosition"), 1, glm::value_ptr(glm::vec4(-7.0f, 4.0f, 2.5f, 1.0f)));
-
         // Materials
         mSuzanneMaterial.mAmbient = glm::vec3(0.0f);
         mSuzanneMaterial.mDiffuse = glm::vec3(0.9f, 0.5f, 0.2f);
@@ -385,38 +372,29 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\SSAO.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\SSAO.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
-        // Get Uniforms
-        GLuint handle = mShader.mProgram.GetHandle();
-        mShader.mLocations["ModelView"] = glGetUniformLocation(handle, "ModelView");
-        mShader.mLocations["MVP"] = glGetUniformLocation(handle, "MVP");
-        mShader.mLocations["Normal"] = glGetUniformLocation(handle, "Normal");
+        // Per-frame, per-object and material uniform blocks
+        mUniforms.Initialize(64 * 1024);
 
-        mShader.mLocations["light.mAmbient"] = glGetUniformLocation(handle, "light.mAmbient");
-        mShader.mLocations["light.mDiffuseSpecular"] = glGetUniformLocation(handle, "light.mDiffuseSpecular");
-        mShader.mLocations["light.mPosition"] = glGetUniformLocation(handle, "light.mPosition");
+        InitializeLocations();
 
-        mShader.mLocations["material.mAmbient"] = glGetUniformLocation(handle, "material.mAmbient");
-        mShader.mLocations["material.mDiffuse"] = glGetUniformLocation(handle, "material.mDiffuse");
-        mShader.mLocations["material.mSpecular"] = glGetUniformLocation(handle, "material.mSpecular");
-        mShader.mLocations["material.mShininess"] = glGetUniformLocation(handle, "material.mShininess");
-        mShader.mLocations["material.mUseTexture"] = glGetUniformLocation(handle, "material.mUseTexture");
+        glUseProgram(mShader.mProgram.GetHandle());
+
+        // Hot reload, the kernel and radius carry over to the rebuilt program but its locations may change
+        mShaderManager.Watch(mShader.mProgram, {{GL_VERTEX_SHADER, "shaders\\SSAO.vs.glsl"}, {GL_FRAGMENT_SHADER, "shaders\\SSAO.fs.glsl"}},
+                             [this](Dazzle::RenderSystem::GL::ProgramObject&) { InitializeLocations(); });
+    }
 
+    void InitializeLocations()
+    {
+        // Get Uniforms
+        GLuint handle = mShader.mProgram.GetHandle();
         mShader.mLocations["Pass"] = glGetUniformLocation(handle, "Pass");
-        mShader.mLocations["ProjectionMatrix"] = glGetUniformLocation(handle, "ProjectionMatrix");
         mShader.mLocations["SampleKernel"] = glGetUniformLocation(handle, "SampleKernel");
         mShader.mLocations["Radius"] = glGetUniformLocation(handle, "Radius");
-
-        glUseProgram(mShader.mProgram.GetHandle());
     }
 
     void CreateTexture(GLuint& texture, const GLenum& format, GLsizei width, GLsizei height)
@@ -430,34 +408,6 @@ private:
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
     }
 
-    GLuint LoadTexture(const std::string& path, bool flip = true)
-    {
-        int width, height;
-        auto imageData = Utils::Texture::GetTextureData(path, width, height, flip);
-        GLuint texture = 0; // OpenGL Texture Object
-        if (imageData)
-        {
-            // Create texture
-            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-
-            // Set texture parameters
-            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-            // Explicitly state the base and max levels
-            glTextureParameteri(texture, GL_TEXTURE_BASE_LEVEL, 0);
-            glTextureParameteri(texture, GL_TEXTURE_MAX_LEVEL, 0);
-
-            // Set up texture storage
-            glTextureStorage2D(texture, 1, GL_RGBA8, width, height);
-
-            // Upload texture data
-            glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData.get());
-        }
-
-        return texture;
-    }
-
     void CheckFBOCompleteness(GLuint fbo)
     {
         GLenum status = glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER);
@@ -513,19 +463,58 @@ private:
         return texture;
     }
 
+    // Loads the precooked mesh when there is one, otherwise parses the OBJ file and cooks it for the next run.
+    void LoadMesh(Dazzle::Mesh& mesh, const std::string& objPath, const std::string& cookedPath)
+    {
+        // The cooked mesh is stale once the .obj is modified, without the .obj it's all there is
+        std::error_code error;
+        const bool upToDate = std::filesystem::exists(cookedPath) && (!std::filesystem::exists(objPath) ||
+                              std::filesystem::last_write_time(cookedPath, error) >= std::filesystem::last_write_time(objPath, error));
+
+        auto start = std::chrono::steady_clock::now();
+        if (upToDate && mesh.Load(cookedPath))
+        {
+            std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+            std::cout << cookedPath << " mapped and uploaded in " << loadTime.count() << " ms" << std::endl;
+            return;
+        }
+
+        InitializeMesh(mesh, objPath);
+        mesh.InitializeBuffers();
+
+        std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - start;
+        std::cout << objPath << " parsed and uploaded in " << loadTime.count() << " ms" << std::endl;
+
+        if (!mesh.Save(cookedPath))
+            std::cerr << "Unable to cook " << cookedPath << std::endl;
+    }
+
     void InitializeMesh(Dazzle::Mesh& mesh, const std::string& path)
     {
-        std::string name;
-        std::vector<float> vertices, normals, textureCoords;
-        Utils::Geom::GetMeshDataFromObj(path, name, vertices, normals, textureCoords);
-        mesh.SetName(name);
-        mesh.SetVertices(std::move(vertices));
-        mesh.SetNormals(std::move(normals));
-        mesh.SetTextureCoordinates(std::move(textureCoords));
+        // Every shape of the file, welded into a single indexed mesh
+        std::vector<Utils::Geom::ObjShape> shapes;
+        std::vector<Utils::Geom::ObjMaterial> materials;
+        if (!Utils::Geom::LoadObj(path, shapes, materials))
+            return;
+
+        Utils::Geom::ObjShape shape = Utils::Geom::MergeObjShapes(shapes);
+        mesh.SetName(shape.mName);
+        mesh.SetVertices(std::move(shape.mVertices));
+        mesh.SetNormals(std::move(shape.mNormals));
+        mesh.SetTextureCoordinates(std::move(shape.mTextureCoordinates));
+        mesh.SetIndices(std::move(shape.mIndices));
+
+        // Cooked into the .dzmesh as well, so the optimized order and the levels of detail are only computed once
+        const Dazzle::MeshOptimizationReport& report = mesh.Optimize();
+        std::cout << path << ": ACMR " << report.mBefore.mACMR << " -> " << report.mAfter.mACMR
+                  << ", ATVR " << report.mBefore.mATVR << " -> " << report.mAfter.mATVR << std::endl;
+        mesh.GenerateLODs();
     }
 
     // Shading Programs
     ShaderProgram mShader;
+    Dazzle::ShaderManager mShaderManager;
+    Dazzle::RenderSystem::GL::UniformRingBuffer mUniforms;
 
     // Framebuffer Objects
     GLuint mDeferredFBO; // Deferred Rendering Framebuffer
@@ -557,10 +546,6 @@ private:
     int mHeight; // Framebuffer Height
 
     RandomHelper mRandomHelper;
-
-    glm::mat4 mMVP;
-    glm::mat4 mModelView;
-    glm::mat3 mNormalMtx;
 };
 
 class UISSAO : public IUserInterface
@@ -596,6 +581,11 @@ public:
         if (ImGui::Button("Reset"))
             ResetToDefaults();
 
+        // Loading
+        ImGui::SeparatorText("Loading");
+        if (ImGui::Button("Benchmark OBJ readers"))
+            Utils::Geom::BenchmarkObj("models\\suzanne.obj");
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
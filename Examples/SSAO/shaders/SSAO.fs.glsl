@@ -19,37 +19,43 @@ layout(binding = 5) uniform sampler2D DiffuseTexture;
 
 struct Light
 {
-    vec3 mAmbient;              // (vec3) Ambient Intensity
-    vec3 mDiffuseSpecular;      // (vec3) Diffuse & Specular Intensity
     vec4 mPosition;             // (vec4) Light Position In View Coordinates
+    vec3 mAmbient;              // (vec3) Ambient Intensity
+    vec3 mIntensity;            // (vec3) Diffuse & Specular Intensity
+};
+
+layout(std140, binding = 0) uniform FrameBlock
+{
+    mat4 View;
+    mat4 Projection;            // Used to project the SSAO samples back to screen space
+    Light lights[4];            // Lights source data, only the first one is used
+    int LightCount;
 };
 
-struct Material
+layout(std140, binding = 2) uniform MaterialBlock
 {
     vec3 mAmbient;              // (vec3) Ambient Reflectivity
     vec3 mDiffuse;              // (vec3) Diffuse Reflectivity
     vec3 mSpecular;             // (vec3) Specular Reflectivity
     float mShininess;           // (float) Shininess
     bool mUseTexture;           // (bool) Whether to use texture or not
-};
+} material; // Material properties
 
 const int kKernelSize = 64; // Size of the SSAO sample kernel
 const vec2 RandomScale = vec2(1280.0 / 4.0, 720.0 / 4.0); // Scale for random texture coordinates, directly related to the resolution of the screen/buffer
 
-uniform Light light; // Lights source data
-uniform Material material; // Material properties
 uniform int Pass; // Current pass number
-uniform mat4 ProjectionMatrix;
 uniform vec3 SampleKernel[kKernelSize]; // Sample kernel for SSAO
 uniform float Radius = 0.55; // Radius for SSAO
 
 vec3 AmbientAndDiffuse(vec3 SurfacePoint, vec3 SurfaceNormal, vec3 DiffuseColor, float AO)
 {
     AO = pow(AO, 4.0);
+    Light light = lights[0];
     vec3 ambient = light.mAmbient * DiffuseColor * AO;
     vec3 surfacePointToLightPoint = normalize(vec3(light.mPosition.xyz - SurfacePoint));
     float sDotN = max(dot(surfacePointToLightPoint, SurfaceNormal), 0.0); // Lambertian Reflectance
-    return ambient + light.mDiffuseSpecular * (DiffuseColor * sDotN);
+    return ambient + light.mIntensity * (DiffuseColor * sDotN);
 } 
 
 void Pass1()
@@ -81,7 +87,7 @@ void Pass2()
         vec3 samplePosition = cameraPosition + Radius * (TBN * SampleKernel[i]);
         
         // Project point
-        vec4 point = ProjectionMatrix * vec4(samplePosition, 1.0);
+        vec4 point = Projection * vec4(samplePosition, 1.0);
         point *= 1.0 / point.w; // Perspective divide
         point.xyz = point.xyz * 0.5 + 0.5; // Convert to [0, 1] range
 
@@ -8,9 +8,13 @@ out vec3 Position;
 out vec3 NormalVector;
 out vec2 TextureCoordinates;
 
-uniform mat4 MVP;        // (mat4) Model View Projection
-uniform mat4 ModelView;  // (mat4) Model View
-uniform mat3 Normal;     // (mat3) Normal
+layout(std140, binding = 1) uniform ObjectBlock
+{
+    mat4 Model;         // (mat4) Model
+    mat4 ModelView;     // (mat4) Model View
+    mat4 MVP;           // (mat4) Model View Projection
+    mat3 Normal;        // (mat3) Normal
+};
 
 void main(void)
 {
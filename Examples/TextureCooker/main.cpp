@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "TextureCompressor.hpp"
+#include "TextureCooker.hpp"
+
+// Offline counterpart of Utils::Texture::LoadCookedTexture(), cooks the KTX2 files the examples would cook on their first run:
+//
+//     TextureCooker <format> <output.ktx2> <image> [<image> x5] [--flip] [--normal | --data] [--threads <count>]
+namespace
+{
+    struct FormatName
+    {
+        const char* mName;
+        Dazzle::TextureFormat mFormat;
+    };
+
+    const FormatName kFormats[] = {
+        {"bc1", Dazzle::TextureFormat::BC1_RGB_UNORM},
+        {"bc1-srgb", Dazzle::TextureFormat::BC1_RGB_SRGB},
+        {"bc4", Dazzle::TextureFormat::BC4_UNORM},
+        {"bc5", Dazzle::TextureFormat::BC5_UNORM},
+        {"bc6h", Dazzle::TextureFormat::BC6H_UFLOAT},
+        {"bc7", Dazzle::TextureFormat::BC7_UNORM},
+        {"bc7-srgb", Dazzle::TextureFormat::BC7_SRGB}
+    };
+
+    int PrintUsage()
+    {
+        std::cerr << "Usage: TextureCooker <format> <output.ktx2> <image> [<image> x5] [--flip] [--normal | --data] [--threads <count>]\n"
+                  << "Formats: bc1, bc1-srgb, bc4, bc5, bc6h (HDR images), bc7, bc7-srgb. Six images make a cube map." << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+        return PrintUsage();
+
+    const FormatName* format = nullptr;
+    for (const auto& candidate : kFormats)
+        if (std::strcmp(argv[1], candidate.mName) == 0)
+            format = &candidate;
+
+    if (format == nullptr)
+        return PrintUsage();
+
+    const std::string output = argv[2];
+    std::vector<std::string> faces;
+    bool flip = false;
+    Utils::Texture::MipFilter filter = Utils::Texture::MipFilter::Color;
+    unsigned int threadCount = 0;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--flip") == 0)
+            flip = true;
+        else if (std::strcmp(argv[i], "--normal") == 0)
+            filter = Utils::Texture::MipFilter::Normal;
+        else if (std::strcmp(argv[i], "--data") == 0)
+            filter = Utils::Texture::MipFilter::Data;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadCount = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        else
+            faces.push_back(argv[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!Utils::Texture::CookTexture(faces, output, format->mFormat, flip, filter, threadCount))
+        return EXIT_FAILURE;
+
+    std::chrono::duration<double, std::milli> cookTime = std::chrono::steady_clock::now() - start;
+    std::cout << output << " (" << format->mName << ") cooked in " << cookTime.count() << " ms" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -8,12 +8,14 @@
 
 #include "RenderSystem.hpp"
 #include "FileManager.hpp"
+#include "LuminanceReduction.hpp"
 #include "Plane.hpp"
 #include "Sphere.hpp"
 #include "Torus.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
+#include "GPUTimer.hpp"
 #include "Scene.hpp"
 #include "UserInterface.hpp"
 #include "Utils.hpp"
@@ -40,7 +42,7 @@ public:
         float mShininess;
     };
 
-    SceneToneMapping() :  mMVP(), mModelView(), mNormalMtx(),
+    SceneToneMapping() :  mTargetFormat(Utils::Texture::HDRFormat::R11F_G11F_B10F), mMVP(), mModelView(), mNormalMtx(),
                     mWidth(), mHeight() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
@@ -63,6 +65,9 @@ public:
 
         mHDRFrameBuffer = CreateFramebufferObject(mHDRConfig);
 
+        // GPU reduction of the HDR texture's log-average luminance
+        mLuminance.Initialize(mHDRConfig.mWidth, mHDRConfig.mHeight);
+
         // -----------------------------------------------------------------------------------------
         // 3D Objects for this scene:
         // Full Screen Quad
@@ -92,6 +97,9 @@ public:
         mTorus->SetPosition(glm::vec3(2.0f, -3.0f, 2.0f));
         mTorus->InitializeBuffers();
 
+        // GPU timer queries, read back once available to avoid stalling the pipeline
+        mGPUTimer.Initialize();
+
         // -----------------------------------------------------------------------------------------
         // Textures for this scene:
         // Bind Texture Unit 0 to Texture Object
@@ -105,16 +113,50 @@ public:
 
     void Update(double time) override
     {
-
+        mDeltaTime = (mLastTime > 0.0) ? static_cast<float>(time - mLastTime) : 0.0f;
+        mLastTime = time;
     }
 
     void Render() override
     {
+        mGPUTimer.Begin();
+
         Pass1(); // Render Scene to Texture
-        CalculateLogarithmicAverageLuminance();
+        mLuminance.Compute(mHDRConfig.mTexture, mDeltaTime); // Calculate average luminance from HDR texture
         Pass2(); // Apply Tone Mapping and Render Scene
+
+        mGPUTimer.End();
+    }
+
+    // Recreates the HDR render target in format, the framebuffer and texture unit are pointed at the new one
+    void SetTargetFormat(Utils::Texture::HDRFormat format)
+    {
+        if (format == mTargetFormat)
+            return;
+
+        mTargetFormat = format;
+        glDeleteTextures(1, &mHDRConfig.mTexture);
+        CreateTexture(mHDRConfig.mTexture, mHDRConfig.mWidth, mHDRConfig.mHeight);
+        glNamedFramebufferTexture(mHDRFrameBuffer, GL_COLOR_ATTACHMENT0, mHDRConfig.mTexture, mHDRConfig.mMipmapLevel);
+        glBindTextureUnit(0, mHDRConfig.mTexture);
     }
 
+    Utils::Texture::HDRFormat GetTargetFormat() const { return mTargetFormat; }
+
+    size_t GetTargetMemory(Utils::Texture::HDRFormat format) const
+    {
+        return static_cast<size_t>(mHDRConfig.mWidth) * mHDRConfig.mHeight * Utils::Texture::GetTexelSize(format);
+    }
+
+    // Estimate of the render target bytes written and read in a frame: written by pass 1, read by the luminance
+    // reduction and by pass 2, each touching every texel once
+    size_t GetTargetTraffic(Utils::Texture::HDRFormat format) const
+    {
+        return 3 * GetTargetMemory(format);
+    }
+
+    double GetGPUTime() const { return mGPUTimer.GetTime(); }
+
     void SetExposure(float exposure)
     {
         glUniform1f(mShader.mLocations.at("Exposure"), exposure);
@@ -130,6 +172,19 @@ public:
         glUniform1i(mShader.mLocations.at("EnableToneMapping"), enable ? 1 : 0);
     }
 
+    void SetEyeAdaptationRate(float rate)
+    {
+        mLuminance.SetAdaptationRate(rate);
+    }
+
+    // Compare the GPU luminance reduction against the CPU reference implementation.
+    // Both read data back from the GPU, so this stalls the pipeline and is meant for validation only.
+    void ValidateLuminance(float& gpuLuminance, float& cpuLuminance)
+    {
+        gpuLuminance = mLuminance.ReadAverageLuminance();
+        cpuLuminance = Dazzle::RenderSystem::GL::LuminanceReduction::CalculateReference(mHDRConfig.mTexture, mHDRConfig.mWidth, mHDRConfig.mHeight);
+    }
+
     void KeyCallback(int key, int scancode, int action, int mods) override {}
     void CursorCallback(double xPosition, double yPosition) override {}
     void FramebufferResizeCallback(int width, int height) override
@@ -170,28 +225,6 @@ private:
         mTorus->Draw();
     }
 
-    // Calculate the logarithmic average luminance from an HDR texture
-    void CalculateLogarithmicAverageLuminance()
-    {
-        int size = mWidth * mHeight; // Total number of pixels in the texture
-        std::vector<float> textureData(size * 3); // RGB data for each pixel
-        // Bind the HDR texture and read its pixel data
-        // Note: This assumes the texture is in RGB format with floating-point values
-        glGetTextureImage(mHDRConfig.mTexture, 0, GL_RGB, GL_FLOAT, textureData.size() * sizeof(float), textureData.data());
-        float sum = 0.0f;
-        for (int i = 0; i < size * 3; i += 3)
-        {
-            float r = textureData[i];
-            float g = textureData[i + 1];
-            float b = textureData[i + 2];
-            // Calculate luminance using the Rec. 709 formula
-            float luminance = glm::dot(glm::vec3(r, g, b), glm::vec3(0.2126f, 0.7152f, 0.0722f));
-            sum += logf(luminance + 0.00001f); // Avoid log(0)
-        }
-
-        glUniform1f(mShader.mLocations.at("AverageLuminance"), expf(sum / size));
-    }
-
     // Pass #2:
     void Pass2()
     {
@@ -303,15 +336,9 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\ToneMapping.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\ToneMapping.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
@@ -337,7 +364,6 @@ private:
         mShader.mLocations["material.mShininess"] = glGetUniformLocation(handle, "material.mShininess");
 
         mShader.mLocations["Pass"] = glGetUniformLocation(handle, "Pass");
-        mShader.mLocations["AverageLuminance"] = glGetUniformLocation(handle, "AverageLuminance");
         mShader.mLocations["EnableToneMapping"] = glGetUniformLocation(handle, "EnableToneMapping");
         mShader.mLocations["Exposure"] = glGetUniformLocation(handle, "Exposure");
         mShader.mLocations["WhitePoint"] = glGetUniformLocation(handle, "WhitePoint");
@@ -356,9 +382,9 @@ private:
 
     void CreateTexture(GLuint& texture, GLsizei width, GLsizei height)
     {
-        // Create Texture Object
+        // Create Texture Object, R11F_G11F_B10F unless RGB32F is selected for comparison
         glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-        glTextureStorage2D(texture, 1, GL_RGB32F, width, height);
+        glTextureStorage2D(texture, 1, Utils::Texture::GetInternalFormat(mTargetFormat), width, height);
         glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     }
@@ -395,8 +421,14 @@ private:
         return fbo;
     }
 
+    Utils::Texture::HDRFormat mTargetFormat;
+    GPUTimer mGPUTimer;
+
     FramebufferConfig mHDRConfig;
     GLuint mHDRFrameBuffer;
+    Dazzle::RenderSystem::GL::LuminanceReduction mLuminance;
+    double mLastTime = 0.0;
+    float mDeltaTime = 0.0f;
     ShaderProgram mShader;
 
     std::unique_ptr<Dazzle::Plane> mQuad;
@@ -450,10 +482,30 @@ public:
         ImGui::Text("Toggle Tone Mapping:"); ImGui::SameLine(); ImGui::Checkbox("##Enable Tone Mapping", &mEnableToneMapping);
         ImGui::Text("Exposure:"); ImGui::SameLine(); ImGui::DragFloat("##Exposure", &mExposure, 0.01f, 0.01f, 2.0f, "%.2f");
         ImGui::Text("White Point:"); ImGui::SameLine(); ImGui::DragFloat("##White Point", &mWhitePoint, 0.01f, 0.01f, 2.0f, "%.3f");
+        ImGui::Text("Eye Adaptation Rate:"); ImGui::SameLine(); ImGui::DragFloat("##Eye Adaptation Rate", &mEyeAdaptationRate, 0.01f, 0.0f, 10.0f, "%.2f");
 
         if (ImGui::Button("Reset"))
             ResetToDefaults();
 
+        // Luminance
+        ImGui::SeparatorText("Average Luminance");
+        if (ImGui::Button("Validate against CPU reference") && mScene)
+            mScene->ValidateLuminance(mGPULuminance, mCPULuminance);
+        ImGui::Text("GPU: %.5f, CPU: %.5f", mGPULuminance, mCPULuminance);
+
+        // Render target, RGB32F for comparison with the packed format
+        ImGui::SeparatorText("Render Target");
+        ImGui::Text("Format:"); ImGui::SameLine(); ImGui::Combo("##TargetFormat", &mTargetFormat, "R11F_G11F_B10F\0" "RGB32F\0");
+        if (mScene)
+        {
+            const double megabyte = 1024.0 * 1024.0;
+            const auto format = mScene->GetTargetFormat();
+            const auto reference = Utils::Texture::HDRFormat::RGB32F;
+            ImGui::Text("Memory: %.2f MB (RGB32F: %.2f MB)", mScene->GetTargetMemory(format) / megabyte, mScene->GetTargetMemory(reference) / megabyte);
+            ImGui::Text("Traffic: %.2f MB/frame (RGB32F: %.2f MB/frame)", mScene->GetTargetTraffic(format) / megabyte, mScene->GetTargetTraffic(reference) / megabyte);
+            ImGui::Text("GPU Time: %.3f ms", mScene->GetGPUTime());
+        }
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
@@ -465,7 +517,9 @@ public:
         {
             mScene->SetExposure(mExposure);
             mScene->SetWhitePoint(mWhitePoint);
+            mScene->SetEyeAdaptationRate(mEyeAdaptationRate);
             mScene->EnableToneMapping(mEnableToneMapping);
+            mScene->SetTargetFormat(mTargetFormat == 0 ? Utils::Texture::HDRFormat::R11F_G11F_B10F : Utils::Texture::HDRFormat::RGB32F);
         }
     }
 
@@ -475,6 +529,7 @@ private:
         mEnableToneMapping = true;
         mExposure = 0.35f;
         mWhitePoint = 0.928f;
+        mEyeAdaptationRate = 0.0f;
     }
 
     SceneToneMapping* mScene = nullptr;
@@ -483,6 +538,10 @@ private:
     bool mEnableToneMapping = true;
     float mExposure = 0.35f;
     float mWhitePoint = 0.928f;
+    float mEyeAdaptationRate = 0.0f;
+    float mGPULuminance = 0.0f;
+    float mCPULuminance = 0.0f;
+    int mTargetFormat = 0;
 };
 
 int main(int argc, char const *argv[])
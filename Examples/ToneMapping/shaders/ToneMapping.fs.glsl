@@ -27,8 +27,14 @@ struct Material
 uniform Light lights[3]; // Lights source data
 uniform Material material; // Material properties
 
+// Written by the luminance reduction compute pass (LuminanceReduction::kResultBinding)
+layout(std430, binding = 7) readonly buffer LuminanceBuffer
+{
+    float AverageLuminance;     // Log-average luminance of the scene
+    float AdaptedLuminance;     // Average luminance after eye adaptation
+};
+
 uniform int Pass; // Current pass number, 1 or 2
-uniform float AverageLuminance; // Average Luminance of the scene
 uniform bool EnableToneMapping; // Enable or disable tone mapping
 uniform float Exposure;         // Exposure value for tone mapping
 // Reference brightness level that is considered “white” in the final image.
@@ -96,7 +102,7 @@ void Pass2()
 
     // Apply the tone mapping operator
     // Scale luminance by exposure and average luminance
-    float Luminance = Exposure * xyYColor.z / AverageLuminance;
+    float Luminance = Exposure * xyYColor.z / AdaptedLuminance;
     Luminance = (Luminance * (1 + Luminance / (WhitePoint * WhitePoint))) / (1 + Luminance);
 
     // Convert back to XYZ color space using the new luminance
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <iostream>
 #include <unordered_map>
 
@@ -12,14 +14,17 @@
 
 #include "RenderSystem.hpp"
 #include "FileManager.hpp"
+#include "VertexLayout.hpp"
 
 #include "App.hpp"
 #include "Camera.hpp"
 #include "Scene.hpp"
 #include "UserInterface.hpp"
 #include "glTF.hpp"
+#include "TextureLoader.hpp"
 #include "Utils.hpp"
 #include "Mesh.hpp"
+#include "MeshFile.hpp"
 
 class SceneglTF : public IScene
 {
@@ -37,10 +42,46 @@ public:
         glm::vec3 mIntensity;
     };
 
-    SceneglTF() :  mMVP() {}
+    // Per-instance normal matrices, after the instance transform (locations 5 to 8) and its binding
+    static const GLuint kInstanceNormalLocation = 9;
+    static const GLuint kInstanceNormalBindingIndex = 2;
+
+    // Buffers and textures of a glTF primitive, drawn once per node referencing its mesh
+    struct Primitive
+    {
+        Dazzle::RenderSystem::GL::VAO mVAO;
+        Dazzle::RenderSystem::GL::VBO mVBO;
+        Dazzle::RenderSystem::GL::EBO mEBO;
+        Dazzle::RenderSystem::GL::InstanceBuffer mInstances;   // World transforms of the nodes
+        Dazzle::RenderSystem::GL::VBO mNormalTransforms;        // transpose(inverse(mat3(transform))) of every node
+        std::vector<glm::mat4> mTransforms;                     // Same transforms, for the level of detail selection
+        std::vector<Dazzle::MeshFileLOD> mLODs;                 // Index ranges in mEBO, level 0 is the full resolution
+        Dazzle::BoundingVolume mBounds;
+        GLenum mIndexType = GL_UNSIGNED_INT;
+
+        TextureLoader::Handle mAlbedoTexture = TextureLoader::kInvalidHandle;
+        TextureLoader::Handle mNormalTexture = TextureLoader::kInvalidHandle;
+        TextureLoader::Handle mARMTexture = TextureLoader::kInvalidHandle;
+    };
+
+    // Primitive of the .glb fast path, its vertex array reads the buffer views as stored in the file. It is drawn
+    // once per node referencing its mesh, at full resolution.
+    struct DevicePrimitive
+    {
+        const glTF::DevicePrimitive* mPrimitive = nullptr;
+        std::vector<glm::mat4> mTransforms;
+
+        TextureLoader::Handle mAlbedoTexture = TextureLoader::kInvalidHandle;
+        TextureLoader::Handle mNormalTexture = TextureLoader::kInvalidHandle;
+        TextureLoader::Handle mARMTexture = TextureLoader::kInvalidHandle;
+    };
+
+    explicit SceneglTF(const std::string& path) : mPath(path), mMVP() {}
 
     void Initialize(const std::shared_ptr<Camera>& camera) override
     {
+        mStartTime = std::chrono::steady_clock::now();
+
         // Set up OpenGL debug message callback
         Dazzle::RenderSystem::GL::SetupDebugMessageCallback();
 
@@ -48,29 +89,16 @@ public:
         // Variables Initialization:
         mCamera = camera;
 
+        // Images are decoded and uploaded in the background, the scene is drawn with placeholders meanwhile
+        mTextureLoader.Initialize();
+
         // -----------------------------------------------------------------------------------------
-        // 3D Objects used by this scene:
-        mWoodenTable.LoadGLTF("models/round_wooden_table_02_4k.gltf/round_wooden_table_02_4k.gltf");
-
-        auto meshes = mWoodenTable.GetMeshes();
-        auto primitive = meshes[0].mPrimitives[0];
-        mWoodenTableVAO = InitializeBuffers(primitive.GetPositions(),
-                                            primitive.GetNormals(),
-                                            primitive.GetTextureCoordinates(),
-                                            Utils::Geom::GenerateTangents(primitive.GetPositions(), primitive.GetNormals(), primitive.GetTextureCoordinates()),
-                                            primitive.GetIndices());
-
-        // Create Textures
-        mAlbedoTexture = CreateTexture("models/round_wooden_table_02_4k.gltf/" + 
-                                       primitive.mMaterial.mPBRMetallicRoughness.mBaseColorTexture, false);
-        mARMTexture = CreateTexture("models/round_wooden_table_02_4k.gltf/" + 
-                                       primitive.mMaterial.mPBRMetallicRoughness.mMetallicRoughnessTexture, false);
-        mNormalTexture = CreateTexture("models/round_wooden_table_02_4k.gltf/" + 
-                                       primitive.mMaterial.mNormalTexture, false);
-
-        glBindTextureUnit(0, mAlbedoTexture);
-        glBindTextureUnit(1, mNormalTexture);
-        glBindTextureUnit(2, mARMTexture);
+        // 3D Objects used by this scene: .glb files take the memory mapped fast path, anything else goes through cgltf
+        const size_t separator = mPath.find_last_of("/\\");
+        const std::string directory = separator == std::string::npos ? "" : mPath.substr(0, separator + 1);
+        const bool isBinary = mPath.size() > 4 && mPath.compare(mPath.size() - 4, 4, ".glb") == 0;
+        if (!isBinary || !InitializeBinaryModel(directory))
+            InitializeModel(directory);
 
         // -----------------------------------------------------------------------------------------
         // Shader Program
@@ -78,11 +106,29 @@ public:
         InitializeUniforms();
     }
 
-    void Update(double time) override {}
+    void Update(double time) override
+    {
+        mTextureLoader.Update();
+        if (!mTexturesReported && mTextureLoader.IsIdle())
+        {
+            const auto& statistics = mTextureLoader.GetStatistics();
+            std::cout << statistics.mResident << " textures resident after " << GetElapsed() << " ms: "
+                      << statistics.mUploadedBytes / (1024.0 * 1024.0) << " MB streamed in " << statistics.mLoadTime
+                      << " ms, " << statistics.mDecodeTime << " ms decoding over every worker" << std::endl;
+            mTexturesResidentTime = GetElapsed();
+            mTexturesReported = true;
+        }
+    }
 
     void Render() override
     {
         DrawScene();
+
+        if (mFirstFrameTime == 0.0)
+        {
+            mFirstFrameTime = GetElapsed();
+            std::cout << "First frame after " << mFirstFrameTime << " ms" << std::endl;
+        }
     }
 
     void KeyCallback(int key, int scancode, int action, int mods) override {}
@@ -91,6 +137,24 @@ public:
 
     void SetLightPosition(const std::array<float, 3> pos) { mLightPosition = glm::vec3(pos[0], pos[1], pos[2]); }
 
+    size_t GetNodeCount() const { return mModel.GetNodes().size(); }
+    size_t GetMeshCount() const { return IsBinary() ? mModel.GetDeviceMeshes().size() : mModel.GetMeshes().size(); }
+    size_t GetDrawCount() const { return mPrimitives.size() + mDeviceDrawCount; }
+    size_t GetInstanceCount() const { return mInstanceCount; }
+    size_t GetTriangleCount() const { return mTriangleCount; }
+    size_t GetDrawnTriangleCount() const { return mDrawnTriangleCount; }
+    const Dazzle::MeshOptimizationReport& GetOptimizationReport() const { return mModel.GetOptimizationReport(); }
+    const TextureLoader::Statistics& GetTextureStatistics() const { return mTextureLoader.GetStatistics(); }
+    double GetFirstFrameTime() const { return mFirstFrameTime; }
+    double GetTexturesResidentTime() const { return mTexturesResidentTime; }
+    // Geometry load time (parsing plus unpacking or uploading) of the drawn model, and of the cgltf path for .glb files
+    bool IsBinary() const { return !mDevicePrimitives.empty(); }
+    double GetLoadTime() const { return mLoadTime; }
+    double GetReferenceLoadTime() const { return mReferenceLoadTime; }
+    // Vertex attribute bytes uploaded by the .glb fast path, and the same attributes unpacked to floats by cgltf
+    size_t GetVertexBufferSize() const { return mModel.GetVertexBufferSize(); }
+    size_t GetReferenceVertexBufferSize() const { return mReferenceVertexBufferSize; }
+
 private:
 
     void DrawScene()
@@ -99,8 +163,69 @@ private:
         //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         UpdateMatrices(mShader, glm::mat4(1.0f));
         UpdateUniforms();
-        glBindVertexArray(mWoodenTableVAO);
-        glDrawElements(GL_TRIANGLES, 12762, GL_UNSIGNED_INT, nullptr);
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        mDrawnTriangleCount = 0;
+
+        for (const auto& primitive : mPrimitives)
+        {
+            glBindTextureUnit(0, mTextureLoader.GetTexture(primitive->mAlbedoTexture));
+            glBindTextureUnit(1, mTextureLoader.GetTexture(primitive->mNormalTexture));
+            glBindTextureUnit(2, mTextureLoader.GetTexture(primitive->mARMTexture));
+
+            const Dazzle::MeshFileLOD& lod = primitive->mLODs[SelectLOD(*primitive, static_cast<float>(viewport[3]))];
+            const size_t indexSize = primitive->mIndexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+            const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(lod.mFirstIndex) * indexSize);
+
+            glBindVertexArray(primitive->mVAO.GetHandle());
+            glDrawElementsInstanced(GL_TRIANGLES, lod.mIndexCount, primitive->mIndexType, offset, primitive->mInstances.GetCount());
+            mDrawnTriangleCount += lod.mIndexCount / 3 * primitive->mTransforms.size();
+        }
+
+        if (!mDevicePrimitives.empty())
+            DrawDevicePrimitives();
+    }
+
+    // The vertex arrays of the fast path have no instance attributes, the node transform goes through uModelMatrix.
+    // Files without TANGENT get a zero tangent, the fragment shader then derives the frame from screen space derivatives.
+    void DrawDevicePrimitives()
+    {
+        Dazzle::RenderSystem::GL::InstanceBuffer::SetIdentityDefault();
+        for (GLuint column = 0; column < 3; ++column)
+            glVertexAttrib3fv(kInstanceNormalLocation + column, glm::value_ptr(glm::mat3(1.0f)[column]));
+        glVertexAttrib4f(glTF::kTangentLocation, 0.0f, 0.0f, 0.0f, 0.0f);
+
+        for (const auto& primitive : mDevicePrimitives)
+        {
+            glBindTextureUnit(0, mTextureLoader.GetTexture(primitive.mAlbedoTexture));
+            glBindTextureUnit(1, mTextureLoader.GetTexture(primitive.mNormalTexture));
+            glBindTextureUnit(2, mTextureLoader.GetTexture(primitive.mARMTexture));
+
+            for (const auto& transform : primitive.mTransforms)
+            {
+                UpdateMatrices(mShader, transform);
+                glTF::Draw(*primitive.mPrimitive);
+            }
+            mDrawnTriangleCount += primitive.mPrimitive->mCount / 3 * primitive.mTransforms.size();
+        }
+
+        // Back to the shared matrices of the instanced draws
+        UpdateMatrices(mShader, glm::mat4(1.0f));
+    }
+
+    // Coarsest level whose error stays under a pixel on screen, for the instance closest to the camera
+    unsigned int SelectLOD(const Primitive& primitive, float viewportHeight) const
+    {
+        const glm::mat4 view = mCamera->GetTransform();
+        float pixels = 0.0f;
+        for (const auto& transform : primitive.mTransforms)
+            pixels = std::max(pixels, primitive.mBounds.mRadius * primitive.mBounds.GetProjectedScale(view * transform, mCamera->GetProjection(), viewportHeight));
+
+        unsigned int level = 0;
+        while (level + 1 < primitive.mLODs.size() && primitive.mLODs[level + 1].mError * pixels <= kLODThreshold)
+            ++level;
+        return level;
     }
 
     void InitializeShaderProgram()
@@ -109,15 +234,9 @@ private:
         auto VSSC = Dazzle::FileManager::ReadFile("shaders\\glTF.vs.glsl");
         auto FSSC = Dazzle::FileManager::ReadFile("shaders\\glTF.fs.glsl");
 
-        // Create OpenGL shader objects and build them using the respecting source code.
-        Dazzle::RenderSystem::GL::ShaderObject glVSO;
-        Dazzle::RenderSystem::GL::ShaderObject glFSO;
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glVSO, GL_VERTEX_SHADER, VSSC);
-        Dazzle::RenderSystem::GL::ShaderBuilder::Build(glFSO, GL_FRAGMENT_SHADER, FSSC);
-
-        // Create and build the OpenGL program object.
+        // Create and build the OpenGL program object, loaded from the shader cache when possible.
         mShader.mProgram.Initialize();
-        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {&glVSO, &glFSO});
+        Dazzle::RenderSystem::GL::ProgramBuilder::Build(mShader.mProgram, {{GL_VERTEX_SHADER, VSSC}, {GL_FRAGMENT_SHADER, FSSC}});
 
         // Get Uniforms
         GLuint handle = mShader.mProgram.GetHandle();
@@ -140,88 +259,161 @@ private:
     {
     }
 
-    GLuint InitializeBuffers(   const std::vector<float>& positions,
-                                const std::vector<float>& normals,
-                                const std::vector<float>& uvs,
-                                const std::vector<float>& tangents,
-                                const std::vector<uint32_t>& indices)
+    // Node transforms may scale non-uniformly, their normal matrices are inverted once here rather than per vertex
+    void AttachNormalTransforms(const Primitive& primitive, const std::vector<glm::mat4>& instances)
     {
-        const GLintptr kOffset = 0;
-        const GLintptr kStride = 0;
-        const GLuint kSize = 3; // The number of values per vertex that are stored in the array.
-        const GLuint kTexSize = 2; // Number of values per vertex texture coordinate
-        const GLenum kDataType = GL_FLOAT;
-        const GLboolean kNormalized = GL_FALSE;
-
-        // Vertices
-        const GLuint kPosAttribIndex = 0;
-        const GLuint kPosBindingIndex = 0;
-        // Normals
-        const GLuint kNormAttribIndex = 1;
-        const GLuint kNormBindingIndex = 1;
-        // Texture Coordinates
-        const GLuint kTexAttribIndex = 2;
-        const GLuint kTexBindingIndex = 2;
-        // Tangents
-        const GLuint kTangAttribIndex = 3;
-        const GLuint kTangBindingIndex = 3;
-        // Bitangents
-        const GLuint kBitanAttribIndex = 4;
-        const GLuint kBitanBindingIndex = 4;
-
-        GLuint VAO, VBO, NVBO, TCVBO, TVBO, EBO;
-        glCreateVertexArrays(1, &VAO);
-
-        glCreateBuffers(1, &VBO);
-        glCreateBuffers(1, &NVBO);
-        glCreateBuffers(1, &TCVBO);
-        glCreateBuffers(1, &TVBO);
-        glCreateBuffers(1, &EBO);
-
-        // Set up the data store for the Vertex Buffer Object for Vertices
-        glNamedBufferStorage(VBO, positions.size() * sizeof(float), positions.data(), 0);
-
-        // Set up the data store for the Vertex Buffer Object for Normals
-        glNamedBufferStorage(NVBO, normals.size() * sizeof(float), normals.data(), 0);
-
-        // Set up the data store for the Vertex Buffer Object for Texture Coordinates
-        glNamedBufferStorage(TCVBO, uvs.size() * sizeof(float), uvs.data(), 0);
-
-        // Set up the data store for the Vertex Buffer Object for Tangents
-        glNamedBufferStorage(TVBO, tangents.size() * sizeof(float), tangents.data(), 0);
-
-        // Set up the data store for the Element Buffer Object for Indices
-        glNamedBufferStorage(EBO, indices.size() * sizeof(uint32_t), indices.data(), 0);
-
-        // VBO
-        glVertexArrayVertexBuffer(VAO, kPosBindingIndex, VBO, kOffset, 3 * sizeof(float));
-        glVertexArrayAttribFormat(VAO, kPosAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding(VAO, kPosAttribIndex, kPosBindingIndex);
-        glEnableVertexArrayAttrib(VAO, kPosAttribIndex);
-
-        // Normals
-        glVertexArrayVertexBuffer(VAO, kNormBindingIndex, NVBO, kOffset, 3 * sizeof(float));
-        glVertexArrayAttribFormat(VAO, kNormAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding(VAO, kNormAttribIndex, kNormBindingIndex);
-        glEnableVertexArrayAttrib(VAO, kNormAttribIndex);
-
-        // Texture Coordinates
-        glVertexArrayVertexBuffer(VAO, kTexBindingIndex, TCVBO, kOffset, 2 * sizeof(float));
-        glVertexArrayAttribFormat(VAO, kTexAttribIndex, kTexSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding(VAO, kTexAttribIndex, kTexBindingIndex);
-        glEnableVertexArrayAttrib(VAO, kTexAttribIndex);
-
-        // Tangents
-        glVertexArrayVertexBuffer(VAO, kTangBindingIndex, TVBO, kOffset, 4 * sizeof(float));
-        glVertexArrayAttribFormat(VAO, kTangAttribIndex, kSize, kDataType, kNormalized, kOffset);
-        glVertexArrayAttribBinding(VAO, kTangAttribIndex, kTangBindingIndex);
-        glEnableVertexArrayAttrib(VAO, kTangAttribIndex);
-
-        // EBO
-        glVertexArrayElementBuffer(VAO, EBO);
-
-        glBindVertexArray(VAO);
-        return VAO;
+        std::vector<glm::mat3> normalTransforms;
+        normalTransforms.reserve(instances.size());
+        for (const auto& transform : instances)
+            normalTransforms.push_back(glm::transpose(glm::inverse(glm::mat3(transform))));
+
+        glNamedBufferData(primitive.mNormalTransforms.GetHandle(), normalTransforms.size() * sizeof(glm::mat3), normalTransforms.data(), GL_STATIC_DRAW);
+
+        // A mat3 attribute takes three consecutive locations, one per column
+        Dazzle::RenderSystem::GL::VertexLayout layout;
+        for (GLuint column = 0; column < 3; ++column)
+            layout.Add(kInstanceNormalLocation + column, 3, GL_FLOAT);
+
+        glVertexArrayVertexBuffer(primitive.mVAO.GetHandle(), kInstanceNormalBindingIndex, primitive.mNormalTransforms.GetHandle(), 0, layout.GetStride());
+        glVertexArrayBindingDivisor(primitive.mVAO.GetHandle(), kInstanceNormalBindingIndex, 1);
+        layout.Apply(primitive.mVAO.GetHandle(), kInstanceNormalBindingIndex);
+    }
+
+    void InitializeModel(const std::string& directory)
+    {
+        mModel.LoadGLTF(mPath.c_str());
+        mLoadTime = mModel.GetLoadTime() + mModel.GetUnpackTime();
+
+        // Every primitive of every mesh is uploaded once, and drawn instanced for all the nodes referencing its mesh
+        const auto& meshes = mModel.GetMeshes();
+        for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+        {
+            const auto& instances = mModel.GetMeshInstances(mesh);
+            if (instances.empty())
+                continue;
+
+            for (const auto& primitive : meshes[mesh].mPrimitives)
+                InitializePrimitive(primitive, instances, directory);
+
+            mInstanceCount += instances.size();
+        }
+    }
+
+    // Loads the .glb with the memory mapped fast path, the cgltf path loads it too to compare their load times
+    bool InitializeBinaryModel(const std::string& directory)
+    {
+        if (!mModel.LoadGLB(mPath.c_str()))
+            return false;
+        mLoadTime = mModel.GetLoadTime() + mModel.GetUnpackTime();
+
+        glTF reference;
+        reference.LoadGLTF(mPath.c_str());
+        mReferenceLoadTime = reference.GetLoadTime() + reference.GetUnpackTime();
+        std::cout << "Geometry loaded in " << mLoadTime << " ms by the .glb fast path (parse + upload), "
+                  << mReferenceLoadTime << " ms by the cgltf path (parse + unpack)" << std::endl;
+
+        // The cgltf path widens every attribute to 32 bit floats, the fast path keeps KHR_mesh_quantization formats
+        for (const auto& mesh : reference.GetMeshes())
+            for (const auto& primitive : mesh.mPrimitives)
+                mReferenceVertexBufferSize += (primitive.GetPositions().size() + primitive.GetNormals().size() +
+                                               primitive.GetTextureCoordinates().size()) * sizeof(float);
+        std::cout << "Vertex attributes: " << mReferenceVertexBufferSize << " bytes as floats, "
+                  << mModel.GetVertexBufferSize() << " bytes as stored" << std::endl;
+
+        const auto& meshes = mModel.GetDeviceMeshes();
+        for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+        {
+            const auto& instances = mModel.GetMeshInstances(mesh);
+            if (instances.empty())
+                continue;
+
+            for (const auto& source : meshes[mesh].mPrimitives)
+            {
+                if (source.mMode != GL_TRIANGLES || source.mCount == 0)
+                    continue;
+
+                DevicePrimitive primitive;
+                primitive.mPrimitive = &source;
+                primitive.mTransforms = instances;
+
+                const auto& material = source.mMaterial;
+                primitive.mAlbedoTexture = GetTexture(directory, material.mPBRMetallicRoughness.mBaseColorTexture, glm::vec4(1.0f), Utils::Texture::MipFilter::Color);
+                primitive.mARMTexture = GetTexture(directory, material.mPBRMetallicRoughness.mMetallicRoughnessTexture, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),
+                                                   Utils::Texture::MipFilter::Data);
+                primitive.mNormalTexture = GetTexture(directory, material.mNormalTexture, glm::vec4(0.5f, 0.5f, 1.0f, 1.0f), Utils::Texture::MipFilter::Normal);
+
+                mTriangleCount += source.mCount / 3 * instances.size();
+                mDeviceDrawCount += instances.size();
+                mDevicePrimitives.push_back(std::move(primitive));
+            }
+
+            mInstanceCount += instances.size();
+        }
+
+        return true;
+    }
+
+    void InitializePrimitive(const glTF::Primitive& source, const std::vector<glm::mat4>& instances, const std::string& directory)
+    {
+        // Only indexed triangles are drawn
+        if (source.mType != glTF::Primitive::Type::TRIANGLES || source.GetIndices().empty())
+            return;
+
+        auto primitive = std::make_unique<Primitive>();
+        auto tangents = Utils::Geom::GenerateTangents(source.GetPositions(), source.GetNormals(), source.GetTextureCoordinates(), source.GetIndices());
+
+        // Levels of detail follow the full resolution indices in the same element buffer
+        std::vector<uint32_t> indices = source.GetIndices();
+        primitive->mLODs.push_back({0, static_cast<std::uint32_t>(indices.size()), 0.0f, 0});
+        for (const auto& lod : source.mLODs)
+        {
+            primitive->mLODs.push_back({static_cast<std::uint32_t>(indices.size()), static_cast<std::uint32_t>(lod.mIndices.size()), lod.mError, 0});
+            indices.insert(indices.end(), lod.mIndices.begin(), lod.mIndices.end());
+        }
+
+        // Interleave every attribute into a single Vertex Buffer Object
+        Dazzle::RenderSystem::GL::VertexBufferBuilder builder;
+        builder.SetPositions(source.GetPositions())
+               .SetNormals(source.GetNormals())
+               .SetTextureCoordinates(source.GetTextureCoordinates())
+               .SetTangents(tangents)
+               .SetIndices(indices)
+               .Build(primitive->mVAO, primitive->mVBO, &primitive->mEBO);
+
+        primitive->mIndexType = builder.GetIndexType();
+        primitive->mBounds = Dazzle::BoundingVolume::Compute(source.GetPositions());
+        mTriangleCount += source.GetIndices().size() / 3 * instances.size();
+
+        primitive->mInstances.Attach(primitive->mVAO);
+        primitive->mInstances.SetTransforms(instances);
+        primitive->mTransforms = instances;
+        AttachNormalTransforms(*primitive, instances);
+
+        // Request Textures, shared by the primitives using the same images. Placeholders are neutral: white albedo, full
+        // occlusion and roughness without metal, and a flat normal
+        const auto& material = source.mMaterial;
+        primitive->mAlbedoTexture = GetTexture(directory, material.mPBRMetallicRoughness.mBaseColorTexture, glm::vec4(1.0f), Utils::Texture::MipFilter::Color);
+        primitive->mARMTexture = GetTexture(directory, material.mPBRMetallicRoughness.mMetallicRoughnessTexture, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f),
+                                            Utils::Texture::MipFilter::Data);
+        primitive->mNormalTexture = GetTexture(directory, material.mNormalTexture, glm::vec4(0.5f, 0.5f, 1.0f, 1.0f), Utils::Texture::MipFilter::Normal);
+
+        mPrimitives.push_back(std::move(primitive));
+    }
+
+    TextureLoader::Handle GetTexture(const std::string& directory, const std::string& image, const glm::vec4& placeholder,
+                                     Utils::Texture::MipFilter filter)
+    {
+        // Materials without the image are shaded with its neutral placeholder, like images that failed to load
+        if (image.empty())
+            return mTextureLoader.LoadPlaceholder(placeholder);
+
+        return mTextureLoader.Load(directory + image, false, placeholder, filter);
+    }
+
+    // Milliseconds since Initialize() started
+    double GetElapsed() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
     }
 
     void UpdateMatrices(const ShaderProgram& shader, glm::mat4 model)
@@ -255,35 +447,8 @@ private:
         glUniform3fv(mShader.mLocations.at("uLightColor"), 1, glm::value_ptr(mLightColor));
     }
 
-    GLuint CreateTexture(const std::string& path, bool flip = true)
-    {
-        int width, height;
-        auto imageData = Utils::Texture::GetTextureData(path, width, height, flip);
-        GLuint texture = 0; // OpenGL Texture Object
-        if (imageData)
-        {
-            // Create texture
-            glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-
-            // Set texture parameters
-            glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-            // Explicitly state the base and max levels
-            glTextureParameteri(texture, GL_TEXTURE_BASE_LEVEL, 0);
-            glTextureParameteri(texture, GL_TEXTURE_MAX_LEVEL, 0);
-
-            // Set up texture storage
-            glTextureStorage2D(texture, 1, GL_RGBA8, width, height);
-
-            // Upload texture data
-            glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, imageData.get());
-        }
-
-        return texture;
-    }
-
-    glTF mWoodenTable;
+    std::string mPath;
+    glTF mModel;
     ShaderProgram mShader;
     glm::vec3 mLightPosition = glm::vec3(1.0f, 1.0f, 1.0f);
     glm::vec3 mLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
@@ -291,11 +456,22 @@ private:
     std::shared_ptr<Camera> mCamera;
     glm::mat4 mMVP;
 
-    GLuint mAlbedoTexture;
-    GLuint mNormalTexture;
-    GLuint mARMTexture;
-
-    GLuint mWoodenTableVAO;
+    std::vector<std::unique_ptr<Primitive>> mPrimitives;
+    std::vector<DevicePrimitive> mDevicePrimitives;     // Primitives of the .glb fast path
+    size_t mDeviceDrawCount = 0;        // One draw per node of every fast path primitive
+    TextureLoader mTextureLoader;
+    size_t mInstanceCount = 0;
+    size_t mTriangleCount = 0;          // Full resolution triangles of every instance
+    size_t mDrawnTriangleCount = 0;     // Triangles drawn by the last frame, at the selected levels of detail
+    const float kLODThreshold = 1.0f;   // Screen space error allowed, in pixels
+
+    std::chrono::steady_clock::time_point mStartTime;
+    double mFirstFrameTime = 0.0;       // ms from Initialize() to the end of the first Render()
+    double mTexturesResidentTime = 0.0; // ms from Initialize() until every texture is resident
+    double mLoadTime = 0.0;             // ms parsing and unpacking, or uploading, the geometry of the drawn model
+    double mReferenceLoadTime = 0.0;    // ms the cgltf path takes on the same .glb
+    size_t mReferenceVertexBufferSize = 0;
+    bool mTexturesReported = false;
 };
 
 class UIglTF : public IUserInterface
@@ -308,8 +484,29 @@ public:
     void Update() override
     {
         // Get data from the scene
+        size_t nodeCount = 0, meshCount = 0, drawCount = 0, instanceCount = 0, triangleCount = 0, drawnTriangleCount = 0;
+        Dazzle::MeshOptimizationReport optimization;
+        TextureLoader::Statistics textures;
+        double firstFrameTime = 0.0, texturesResidentTime = 0.0, loadTime = 0.0, referenceLoadTime = 0.0;
+        size_t vertexBufferSize = 0, referenceVertexBufferSize = 0;
+        bool isBinary = false;
         if (mScene)
         {
+            nodeCount = mScene->GetNodeCount();
+            meshCount = mScene->GetMeshCount();
+            drawCount = mScene->GetDrawCount();
+            instanceCount = mScene->GetInstanceCount();
+            optimization = mScene->GetOptimizationReport();
+            triangleCount = mScene->GetTriangleCount();
+            drawnTriangleCount = mScene->GetDrawnTriangleCount();
+            textures = mScene->GetTextureStatistics();
+            firstFrameTime = mScene->GetFirstFrameTime();
+            texturesResidentTime = mScene->GetTexturesResidentTime();
+            loadTime = mScene->GetLoadTime();
+            referenceLoadTime = mScene->GetReferenceLoadTime();
+            isBinary = mScene->IsBinary();
+            vertexBufferSize = mScene->GetVertexBufferSize();
+            referenceVertexBufferSize = mScene->GetReferenceVertexBufferSize();
         }
 
         // Get data from the camera
@@ -335,6 +532,28 @@ public:
         ImGui::Text("Light Position:"); ImGui::SameLine();
         ImGui::DragFloat3("##LightPosition", mLightPosition.data(), 0.01f, -10.0f, 10.0f);
 
+        // Scene graph
+        ImGui::SeparatorText("Scene");
+        ImGui::Text("Nodes: %zu, Meshes: %zu", nodeCount, meshCount);
+        ImGui::Text("Mesh Instances: %zu in %zu instanced draws", instanceCount, drawCount);
+        ImGui::Text("ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f", optimization.mBefore.mACMR, optimization.mAfter.mACMR,
+                    optimization.mBefore.mATVR, optimization.mAfter.mATVR);
+        ImGui::Text("Triangles: %zu of %zu at the selected LODs", drawnTriangleCount, triangleCount);
+
+        // Loading
+        ImGui::SeparatorText("Loading");
+        if (isBinary)
+        {
+            ImGui::Text("Geometry: %.2f ms .glb fast path, %.2f ms cgltf path", loadTime, referenceLoadTime);
+            ImGui::Text("Vertex attributes: %.1f KB as stored, %.1f KB as floats", vertexBufferSize / 1024.0, referenceVertexBufferSize / 1024.0);
+        }
+        else
+            ImGui::Text("Geometry: %.2f ms cgltf path", loadTime);
+        ImGui::Text("First frame: %.1f ms", firstFrameTime);
+        ImGui::Text("Textures: %zu of %zu resident, %.1f MB", textures.mResident, textures.mRequested, textures.mUploadedBytes / (1024.0 * 1024.0));
+        if (texturesResidentTime > 0.0)
+            ImGui::Text("All resident: %.1f ms (decode %.1f ms over every worker)", texturesResidentTime, textures.mDecodeTime);
+
         // Camera
         ImGui::SeparatorText("Camera");
         ImGui::Text("Position - X: %.2f, Y: %.2f, Z: %.2f", cameraPosition.x, cameraPosition.y, cameraPosition.z);
@@ -362,7 +581,10 @@ int main(int argc, char const *argv[])
     config.height = 720;        // Window Height
     config.title = "glTF + PBR + NormalMapping";   // Window Title
 
-    auto sceneglTF = std::make_unique<SceneglTF>();
+    // The model can be given on the command line, .glb files are loaded with the memory mapped fast path. The default
+    // is the wooden table with KHR_mesh_quantization attributes: 16 bit positions and texture coordinates, 8 bit normals.
+    const std::string path = argc > 1 ? argv[1] : "models/round_wooden_table_02_4k.gltf/round_wooden_table_02_4k_quantized.glb";
+    auto sceneglTF = std::make_unique<SceneglTF>(path);
     auto uiglTF = std::make_unique<UIglTF>();
 
     App app(config, std::move(sceneglTF), std::move(uiglTF));
@@ -56,6 +56,22 @@ float geometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
     return ggx1 * ggx2;
 }
 
+// Tangent frame from the screen space derivatives of the position and texture coordinates, for primitives without tangents
+mat3 cotangentFrame(vec3 N, vec3 position, vec2 uv) {
+    vec3 dp1 = dFdx(position);
+    vec3 dp2 = dFdy(position);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, N);
+    vec3 dp1perp = cross(N, dp1);
+    vec3 T = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 B = dp2perp * duv1.y + dp1perp * duv2.y;
+
+    float invmax = inversesqrt(max(max(dot(T, T), dot(B, B)), 1e-20));
+    return mat3(T * invmax, B * invmax, N);
+}
+
 void main() {
     // Sample textures
     vec3 albedo = texture(uAlbedoMap, TextureCoordinates).rgb;
@@ -67,7 +83,8 @@ void main() {
     // Sample and process normal map
     vec3 normalSample = texture(uNormalMap, TextureCoordinates).rgb;
     vec3 normal = normalize(normalSample * 2.0 - 1.0);
-    vec3 N = normalize(TBN * normal);
+    mat3 derivedTBN = cotangentFrame(normalize(TBN[2]), FragmentPosition, TextureCoordinates);
+    vec3 N = normalize((dot(TBN[0], TBN[0]) == 0.0 ? derivedTBN : TBN) * normal);
     
     // View direction (from fragment to camera) in world space
     vec3 V = normalize(uCameraPosition - FragmentPosition);
@@ -4,6 +4,8 @@ layout (location = 0) in vec3 vPosition;
 layout (location = 1) in vec3 vNormalVector;
 layout (location = 2) in vec2 vTextureCoordinates;
 layout (location = 3) in vec4 vTangent;
+layout (location = 5) in mat4 InstanceTransform;    // World transform of the glTF node
+layout (location = 9) in mat3 InstanceNormal;       // transpose(inverse(mat3(InstanceTransform))), computed on the CPU
 
 out vec3 FragmentPosition;
 out vec2 TextureCoordinates;
@@ -24,22 +26,23 @@ void main()
     TextureCoordinates = vTextureCoordinates;
 
     // Calculate Fragment Position in world space
-    vec4 WorldPosition = uModelMatrix *  vec4(vPosition, 1.0);
+    vec4 WorldPosition = uModelMatrix * InstanceTransform * vec4(vPosition, 1.0);
     FragmentPosition = WorldPosition.xyz;
 
-    // Transform normal and tangent to world space
-    vec3 N = normalize(uNormalMatrix * vNormalVector);
-    vec3 T = normalize(uNormalMatrix * vTangent.xyz);
+    // Transform normal and tangent to world space. Node transforms may scale non-uniformly: normals need the inverse
+    // transpose, while tangents lie on the surface and follow the model matrix
+    vec3 N = normalize(uNormalMatrix * InstanceNormal * vNormalVector);
+    vec3 T = normalize(mat3(uModelMatrix) * mat3(InstanceTransform) * vTangent.xyz);
 
     // // Calculate bitangent
     // vec3 B = normalize(cross(N, T));
 
-    // Gram-Schmidt process to ensure orthogonality
+    // Gram-Schmidt process to ensure orthogonality. w is the handedness of the frame, -1 for mirrored texture coordinates
     T = normalize(T - dot(T, N) * N);
-    vec3 B = normalize(cross(N, T));
+    vec3 B = normalize(cross(N, T)) * vTangent.w;
 
-    // Create the TBN matrix
-    TBN = mat3(T, B, N);
+    // Create the TBN matrix. Primitives without tangents (w = 0) only pass N, the fragment shader builds their frame
+    TBN = vTangent.w == 0.0 ? mat3(vec3(0.0), vec3(0.0), N) : mat3(T, B, N);
 
     // Final position
     gl_Position = uProjectionMatrix * uViewMatrix * WorldPosition;
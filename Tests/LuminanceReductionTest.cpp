@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include "LuminanceReduction.hpp"
+
+namespace
+{
+    const int kSkipped = 77;        // ctest reports the test as skipped, see SKIP_RETURN_CODE
+    const float kTolerance = 1.0e-3f;
+
+    using LuminanceReduction = Dazzle::RenderSystem::GL::LuminanceReduction;
+
+    bool Check(bool condition, const char* message)
+    {
+        if (!condition)
+            std::cerr << "LuminanceReductionTest: " << message << std::endl;
+        return condition;
+    }
+
+    bool IsClose(float value, float reference)
+    {
+        return std::abs(value - reference) <= kTolerance * std::abs(reference);
+    }
+
+    // RGB texels spanning a few orders of magnitude, with black ones to exercise the log(0) guard
+    std::vector<float> GenerateImage(int width, int height)
+    {
+        std::vector<float> rgb(static_cast<size_t>(width) * height * 3);
+        unsigned int state = 12345u;
+        for (size_t i = 0; i < rgb.size(); ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            const float unit = (state >> 8) / 16777216.0f;
+            rgb[i] = (i % 97 == 0) ? 0.0f : std::pow(10.0f, unit * 4.0f - 2.0f);
+        }
+        return rgb;
+    }
+
+    // Sizes that aren't multiples of the 16x16 tiles, so partial tiles and several partial sums per invocation are reduced
+    bool TestReduction(GLenum internalFormat, int width, int height)
+    {
+        const std::vector<float> rgb = GenerateImage(width, height);
+
+        GLuint texture = 0;
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureStorage2D(texture, 1, internalFormat, width, height);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, rgb.data());
+
+        LuminanceReduction reduction;
+        reduction.Initialize(width, height);
+        bool passed = Check(reduction.IsValid(), "The reduction programs failed to build");
+        if (passed)
+        {
+            reduction.Compute(texture);
+            const float gpu = reduction.ReadAverageLuminance();
+            const float reference = LuminanceReduction::CalculateReference(texture, width, height);
+            if (!IsClose(gpu, reference))
+                std::cerr << "LuminanceReductionTest: " << width << "x" << height << " GPU " << gpu << ", CPU " << reference << std::endl;
+            passed = Check(IsClose(gpu, reference), "The GPU reduction differs from the CPU reference");
+
+            // A float target reads back exactly what was uploaded
+            if (internalFormat == GL_RGBA32F)
+                passed = Check(IsClose(reference, LuminanceReduction::CalculateReference(rgb.data(), rgb.size() / 3)),
+                               "The texture reference differs from the image reference") && passed;
+        }
+
+        glDeleteTextures(1, &texture);
+        return passed;
+    }
+}
+
+int main()
+{
+    // Needs a GL 4.6 context, machines without one skip the test rather than fail it
+    if (!glfwInit())
+    {
+        std::cerr << "LuminanceReductionTest: No display, skipped" << std::endl;
+        return kSkipped;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "LuminanceReductionTest", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cerr << "LuminanceReductionTest: No OpenGL 4.6 context, skipped" << std::endl;
+        glfwTerminate();
+        return kSkipped;
+    }
+
+    glfwMakeContextCurrent(window);
+    if (gl3wInit() != 0)
+    {
+        std::cerr << "LuminanceReductionTest: Unable to load the OpenGL functions, skipped" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return kSkipped;
+    }
+
+    bool passed = TestReduction(GL_RGBA32F, 1, 1);
+    passed = TestReduction(GL_RGBA32F, 333, 217) && passed;
+    passed = TestReduction(GL_RGBA32F, 1280, 720) && passed;
+    passed = TestReduction(GL_RGBA16F, 1280, 720) && passed;
+    passed = TestReduction(GL_R11F_G11F_B10F, 1280, 720) && passed;
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,45 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "MeshoptDecoder.hpp"
+
+namespace
+{
+    bool Check(bool condition, const char* message)
+    {
+        if (!condition)
+            std::cerr << "MeshoptDecoderTest: " << message << std::endl;
+        return condition;
+    }
+
+    // Version 1 stream of 4 triangles: a new triangle from the code table, then edge codes whose third vertex is the
+    // last free index +1 (fec 14), +1 again and -1 (fec 13). Neither 13 nor 14 reads the vertex FIFO.
+    bool TestIndexBufferFreeIndexCodes()
+    {
+        std::vector<unsigned char> buffer = {
+            0xe1,                       // Header, version 1
+            0xf0, 0x0e, 0x0e, 0x0d      // Codes, no extra data follows
+        };
+        buffer.resize(buffer.size() + 16, 0);   // Auxiliary code table, entry 0: two new vertices
+
+        const std::vector<unsigned int> expected = {0, 1, 2, 0, 2, 1, 0, 1, 2, 0, 2, 1};
+        std::vector<unsigned int> indices(expected.size());
+        bool passed = Check(Meshopt::DecodeIndexBuffer(indices.data(), indices.size(), sizeof(unsigned int), buffer.data(), buffer.size()),
+                            "DecodeIndexBuffer rejected a valid stream");
+        passed = passed && Check(indices == expected, "DecodeIndexBuffer decoded codes 13 and 14 to the wrong triangles");
+
+        std::vector<unsigned short> shortIndices(expected.size());
+        passed = passed && Check(Meshopt::DecodeIndexBuffer(shortIndices.data(), shortIndices.size(), sizeof(unsigned short), buffer.data(), buffer.size()),
+                                 "DecodeIndexBuffer rejected a valid stream of 16 bit indices");
+        passed = passed && Check(std::vector<unsigned int>(shortIndices.begin(), shortIndices.end()) == expected,
+                                 "DecodeIndexBuffer decoded 16 bit indices differently");
+        return passed;
+    }
+}
+
+int main()
+{
+    bool passed = TestIndexBufferFreeIndexCodes();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}